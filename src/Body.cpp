@@ -11,7 +11,6 @@
 #include "Missile.h"
 #include "Planet.h"
 #include "Player.h"
-#include "Projectile.h"
 #include "Ship.h"
 #include "Space.h"
 #include "SpaceStation.h"
@@ -122,7 +121,6 @@ void Body::ToJson(Json &jsonObj, Space *space)
 	case ObjectType::PLAYER:
 	case ObjectType::MISSILE:
 	case ObjectType::CARGOBODY:
-	case ObjectType::PROJECTILE:
 	case ObjectType::HYPERSPACECLOUD:
 		SaveToJson(jsonObj, space);
 		break;
@@ -168,9 +166,6 @@ Body *Body::FromJson(const Json &jsonObj, Space *space)
 	case ObjectType::MISSILE:
 		body = new Missile(jsonObj, space);
 		break;
-	case ObjectType::PROJECTILE:
-		body = new Projectile(jsonObj, space);
-		break;
 	case ObjectType::CARGOBODY:
 		body = new CargoBody(jsonObj, space);
 		break;
@@ -98,6 +98,14 @@ public:
 	// as you can't test for collisions if different objects are on different 'steps'
 	virtual void StaticUpdate(const float timeStep) {}
 	virtual void TimeStepUpdate(const float timeStep) {}
+	// Integrates motion over the timestep; called for every body after all
+	// TimeStepUpdate calls. Space may run this for many bodies concurrently,
+	// so it must only modify this body's own state. Anything that touches Lua,
+	// Space or other bodies belongs in TimeStepUpdate or PostTimeStepUpdate.
+	virtual void TimeStepIntegrate(const float timeStep) {}
+	// called for every body after all TimeStepIntegrate calls, for anything
+	// that has to see where the bodies ended up this step
+	virtual void PostTimeStepUpdate(const float timeStep) {}
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) = 0;
 
 	virtual void SetFrame(FrameId f) { m_frame = f; }
@@ -9,6 +9,7 @@
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
+#include "Projectile.h"
 #include "Sfx.h"
 #include "Space.h"
 #include "galaxy/StarSystem.h"
@@ -302,6 +303,7 @@ void Camera::Draw(const Body *excludeBody)
 		m_renderer->DrawBuffer(&billboards, m_billboardMaterial.get());
 	}
 
+	ProjectileManager::RenderAll(m_renderer, this, rootFrameId, camFrameId);
 	SfxManager::RenderAll(m_renderer, rootFrameId, camFrameId);
 }
 
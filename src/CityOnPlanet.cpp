@@ -26,6 +26,8 @@
 
 #include "utils.h"
 
+#include <algorithm>
+
 std::vector<CityOnPlanet::CityFlavourType> CityOnPlanet::s_cityFlavours;
 std::unique_ptr<Graphics::Material> CityOnPlanet::s_debugMat;
 
@@ -73,6 +75,34 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 		}
 	}
 
+	// sort them into clusters for culling, and work out their transforms
+	// relative to the whole city once rather than every frame
+	m_clusters.clear();
+	m_buildingTransforms.clear();
+	if (!m_enabledBuildings.empty()) {
+		m_clusters.emplace_back();
+		BuildClusters(0, 0, m_enabledBuildings.size(), 0, 0, m_citySize);
+
+		const matrix4x4d orient = m_orient;
+		matrix4x4f rot[4];
+		for (int i = 0; i < 4; i++) {
+			rot[i] = matrix4x4f(orient * matrix4x4d::RotateYMatrix(M_PI * 0.5 * double(i)));
+		}
+
+		const vector3d &centre = m_clusters[0].centre;
+		m_buildingTransforms.reserve(m_enabledBuildings.size());
+		for (const auto &building : m_enabledBuildings) {
+			matrix4x4f transform = rot[building.rotation];
+			transform.SetTranslate(vector3f(building.pos - centre));
+			m_buildingTransforms.push_back(transform);
+		}
+	}
+
+	m_visibleClusters.clear();
+	m_prevVisibleClusters.clear();
+	m_instanceTransforms.assign(numBuildingTypes, {});
+	m_viewTransforms.resize(numBuildingTypes);
+
 	// reset the reset flag
 	m_detailLevel = Pi::detail.cities;
 }
@@ -80,12 +110,102 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 void CityOnPlanet::RemoveStaticGeomsFromCollisionSpace()
 {
 	m_enabledBuildings.clear();
+	m_clusters.clear();
+	m_buildingTransforms.clear();
 	for (unsigned int i = 0; i < m_buildings.size(); i++) {
 		Frame *f = Frame::GetFrame(m_frame);
 		f->RemoveStaticGeom(m_buildings[i].geom);
 	}
 }
 
+void CityOnPlanet::BuildClusters(Uint32 nodeIndex, Uint32 begin, Uint32 end, Uint32 cellX, Uint32 cellY, Uint32 cells)
+{
+	const auto first = m_enabledBuildings.begin() + begin;
+	const auto last = m_enabledBuildings.begin() + end;
+
+	// bounding sphere around the buildings' own spheres
+	vector3d min(DBL_MAX), max(-DBL_MAX);
+	for (auto it = first; it != last; ++it) {
+		min.x = std::min(min.x, it->pos.x);
+		min.y = std::min(min.y, it->pos.y);
+		min.z = std::min(min.z, it->pos.z);
+		max.x = std::max(max.x, it->pos.x);
+		max.y = std::max(max.y, it->pos.y);
+		max.z = std::max(max.z, it->pos.z);
+	}
+
+	const vector3d centre = (min + max) * 0.5;
+	double radius = 0.0;
+	float maxClipRadius = 0.0f;
+	for (auto it = first; it != last; ++it) {
+		radius = std::max(radius, (it->pos - centre).Length() + it->clipRadius);
+		maxClipRadius = std::max(maxClipRadius, it->clipRadius);
+	}
+
+	m_clusters[nodeIndex] = { centre, radius, maxClipRadius, 0, begin, end };
+
+	if (end - begin <= CLUSTER_MAX_BUILDINGS || cells <= CLUSTER_MIN_CELLS)
+		return;
+
+	// split the buildings between the four quarters of the node's cells
+	const Uint32 half = (cells + 1) / 2;
+	const auto midY = std::partition(first, last, [=](const BuildingInstance &b) { return b.cellY < cellY + half; });
+	const auto midX0 = std::partition(first, midY, [=](const BuildingInstance &b) { return b.cellX < cellX + half; });
+	const auto midX1 = std::partition(midY, last, [=](const BuildingInstance &b) { return b.cellX < cellX + half; });
+
+	const Uint32 bounds[5] = {
+		begin,
+		Uint32(midX0 - m_enabledBuildings.begin()),
+		Uint32(midY - m_enabledBuildings.begin()),
+		Uint32(midX1 - m_enabledBuildings.begin()),
+		end
+	};
+
+	// children are added together, the vector may move while building them
+	const Uint32 firstChild = m_clusters.size();
+	m_clusters[nodeIndex].firstChild = firstChild;
+	m_clusters.resize(firstChild + 4);
+
+	for (Uint32 i = 0; i < 4; i++) {
+		const Uint32 childX = cellX + (i & 1) * half;
+		const Uint32 childY = cellY + (i >> 1) * half;
+		if (bounds[i] == bounds[i + 1])
+			m_clusters[firstChild + i] = { vector3d(0.0), 0.0, 0.0f, 0, bounds[i], bounds[i] };
+		else
+			BuildClusters(firstChild + i, bounds[i], bounds[i + 1], childX, childY, half);
+	}
+}
+
+void CityOnPlanet::CullClusters(const Graphics::Frustum &frustum, const matrix4x4d &viewTransform, Uint32 nodeIndex, bool inside)
+{
+	const ClusterNode &node = m_clusters[nodeIndex];
+	if (node.begin == node.end)
+		return;
+
+	const vector3d pos = viewTransform * node.centre;
+
+	// once a node is wholly in view, so is everything below it
+	if (!inside) {
+		if (!frustum.TestPoint(pos, node.radius))
+			return;
+		inside = frustum.TestPointInside(pos, node.radius);
+	}
+
+	// skip nodes where even the largest building would be under a pixel or so across
+	const double dist = pos.Length() - node.radius;
+	if (node.maxClipRadius < dist * BUILDING_CULL_RATIO)
+		return;
+
+	if (!node.firstChild) {
+		m_visibleClusters.push_back(nodeIndex);
+		return;
+	}
+
+	for (Uint32 i = 0; i < 4; i++) {
+		CullClusters(frustum, viewTransform, node.firstChild + i, inside);
+	}
+}
+
 void CityOnPlanet::GetModelSize(const Aabb &aabb, uint8_t size[2])
 {
 	vector3d aabbSize = aabb.max - aabb.min;
@@ -391,6 +511,7 @@ void CityOnPlanet::Generate(SpaceStation *station)
 	// ==========================================
 
 	// precalc orientation transforms (to rotate buildings to face north/south/east/west)
+	m_orient = station->GetOrient();
 	const matrix4x4d &m = station->GetOrient();
 
 	matrix4x4d orientcalc[4];
@@ -534,7 +655,8 @@ void CityOnPlanet::Generate(SpaceStation *station)
 			Geom *geom = new Geom(cmesh->GetGeomTree(), orientcalc[orient], pos, GetPlanet());
 
 			// add it to the list of buildings to render
-			m_buildings.push_back({ typeIndex, float(cmesh->GetRadius()), orient, pos, geom });
+			m_buildings.push_back({ typeIndex, float(cmesh->GetRadius()), orient, pos, geom,
+				Uint16(buildingPos.x), Uint16(buildingPos.y) });
 
 		}
 	}
@@ -652,11 +774,6 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 	if (!frustum.TestPoint(stationPos, m_clipRadius))
 		return;
 
-	// Precalculate building orientation matrices
-	matrix4x4d rot[4];
-	matrix4x4f rotf[4];
-	rot[0] = station->GetOrient();
-
 	// change detail level if necessary
 	const bool bDetailChanged = m_detailLevel != Pi::detail.cities;
 	if (bDetailChanged) {
@@ -664,15 +781,8 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		AddStaticGeomsToCollisionSpace();
 	}
 
-	rot[0] = viewTransform * rot[0];
-	for (int i = 1; i < 4; i++) {
-		rot[i] = rot[0] * matrix4x4d::RotateYMatrix(M_PI * 0.5 * double(i));
-	}
-	for (int i = 0; i < 4; i++) {
-		for (int e = 0; e < 16; e++) {
-			rotf[i][e] = float(rot[i][e]);
-		}
-	}
+	if (m_clusters.empty())
+		return;
 
 	// update any idle animations
 	// TODO: this is kind of a horrible idea in many ways
@@ -687,34 +797,46 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		}
 	}
 
-	uint32_t uCount = 0;
-	uint32_t numBuildings = m_cityType->buildingTypes.size();
-
-	std::vector<std::vector<matrix4x4f>> transform;
-
-	transform.resize(numBuildings);
+	// find the visible leaves, and only gather their buildings again if
+	// they've changed since last frame
+	std::swap(m_visibleClusters, m_prevVisibleClusters);
+	m_visibleClusters.clear();
+	CullClusters(frustum, viewTransform, 0, false);
+
+	const uint32_t numBuildings = m_cityType->buildingTypes.size();
+	if (m_visibleClusters != m_prevVisibleClusters) {
+		for (uint32_t i = 0; i < numBuildings; i++) {
+			m_instanceTransforms[i].clear();
+			m_instanceTransforms[i].reserve(m_buildingCounts[i]);
+		}
 
-	for (uint32_t i = 0; i < numBuildings; i++) {
-		transform[i].reserve(m_buildingCounts[i]);
+		for (Uint32 nodeIndex : m_visibleClusters) {
+			const ClusterNode &node = m_clusters[nodeIndex];
+			for (Uint32 i = node.begin; i < node.end; i++) {
+				m_instanceTransforms[m_enabledBuildings[i].instIndex].push_back(m_buildingTransforms[i]);
+			}
+		}
 	}
 
-	for (const auto &building : m_enabledBuildings) {
-		const vector3d pos = viewTransform * building.pos;
+	// the models pick LODs from the instances' view space positions,
+	// so those still have to be worked out every frame
+	const matrix4x4f cityTransform = matrix4x4f(viewTransform * matrix4x4d::Translation(m_clusters[0].centre));
 
-		if (!frustum.TestPoint(pos, building.clipRadius))
+	uint32_t uCount = 0;
+	for (uint32_t i = 0; i < numBuildings; i++) {
+		const std::vector<matrix4x4f> &instances = m_instanceTransforms[i];
+		std::vector<matrix4x4f> &transform = m_viewTransforms[i];
+		if (instances.empty())
 			continue;
 
-		matrix4x4f instanceRot = matrix4x4f(rotf[building.rotation]);
-		instanceRot.SetTranslate(vector3f(pos));
-
-		transform[building.instIndex].push_back(instanceRot);
-		++uCount;
-	}
+		transform.resize(instances.size());
+		for (size_t j = 0; j < instances.size(); j++) {
+			transform[j] = cityTransform * instances[j];
+		}
 
-	// render the building models using instancing
-	for (Uint32 i = 0; i < numBuildings; i++) {
-		if (!transform[i].empty())
-			m_cityType->buildingTypes[i].model->Render(transform[i]);
+		// render the building models using instancing
+		m_cityType->buildingTypes[i].model->Render(transform);
+		uCount += instances.size();
 	}
 
 	// Draw debug extents
@@ -120,8 +120,29 @@ private:
 		int rotation; // 0-3
 		vector3d pos;
 		Geom *geom;
+		Uint16 cellX, cellY; // grid cell the building is centred on
 	};
 
+	// The enabled buildings are sorted into a quadtree over the city grid,
+	// so every node's buildings are a contiguous range of m_enabledBuildings.
+	struct ClusterNode {
+		vector3d centre; // bounding sphere of the buildings, in frame space
+		double radius;
+		float maxClipRadius; // largest building within
+		Uint32 firstChild; // first of four consecutive children, 0 for a leaf
+		Uint32 begin, end; // buildings within
+	};
+
+	// leaves hold at most this many buildings, unless they're this few cells across
+	static constexpr Uint32 CLUSTER_MAX_BUILDINGS = 64;
+	static constexpr Uint32 CLUSTER_MIN_CELLS = 4;
+	// nodes are skipped once their largest building is smaller than this
+	// fraction of the distance to them, about a pixel on a typical screen
+	static constexpr double BUILDING_CULL_RATIO = 1.0 / 2000.0;
+
+	void BuildClusters(Uint32 nodeIndex, Uint32 begin, Uint32 end, Uint32 cellX, Uint32 cellY, Uint32 cells);
+	void CullClusters(const Graphics::Frustum &frustum, const matrix4x4d &viewTransform, Uint32 nodeIndex, bool inside);
+
 	const SystemBody *m_body;
 	Planet *m_planet;
 
@@ -136,6 +157,17 @@ private:
 	std::vector<BuildingInstance> m_enabledBuildings;
 	std::vector<Uint32> m_buildingCounts;
 
+	std::vector<ClusterNode> m_clusters;
+	// parallel to m_enabledBuildings, relative to the centre of the root cluster
+	std::vector<matrix4x4f> m_buildingTransforms;
+	// leaves drawn last frame, and the transforms of their buildings by type.
+	// These are only gathered again when the visible leaves change.
+	std::vector<Uint32> m_visibleClusters;
+	std::vector<Uint32> m_prevVisibleClusters;
+	std::vector<std::vector<matrix4x4f>> m_instanceTransforms;
+	// the above in view space, rewritten every frame
+	std::vector<std::vector<matrix4x4f>> m_viewTransforms;
+
 	// bitmask occupancy grid for quick population of the city
 	std::unique_ptr<uint8_t[]> m_gridBitset;
 	// width of a single grid row in bytes
@@ -146,6 +178,7 @@ private:
 	float m_clipRadius;
 	vector3d m_realCentre;
 	vector3d m_gridOrigin;
+	matrix3x3d m_orient;
 
 	CityFlavourType *m_cityType;
 
@@ -0,0 +1,224 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DiskCache.h"
+
+#include "FileSystem.h"
+#include "core/FNV1a.h"
+#include "core/LZ4Format.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const std::string CACHE_EXTENSION(".lz4");
+
+DiskCache::DiskCache(const std::string &dir, Uint32 magic, size_t byteBudget) :
+	m_dir(dir),
+	m_magic(magic),
+	m_byteBudget(byteBudget),
+	m_totalSize(0)
+{
+	ScanDirectory();
+}
+
+std::string DiskCache::MakeFilename(const Uint64 hash) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64, hash);
+	return FileSystem::JoinPath(m_dir, name + CACHE_EXTENSION);
+}
+
+size_t DiskCache::GetTotalSize() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_totalSize;
+}
+
+// Files are the magic, the key length and key, then the data, all LZ4 compressed.
+// The data is whatever the caller stored, the cache isn't meant to be shared between machines.
+bool DiskCache::Load(const std::string &key, std::string &data)
+{
+	PROFILE_SCOPED()
+	const Uint64 hash = hash_64_fnv1a(key.data(), key.size());
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_entries.find(hash) == m_entries.end())
+			return false;
+	}
+
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(MakeFilename(hash));
+	if (!file) {
+		Forget(hash);
+		return false;
+	}
+
+	std::string contents;
+	try {
+		contents = lz4::DecompressLZ4(std::string_view(file->GetData(), file->GetSize()));
+	} catch (lz4::DecompressionFailedException &e) {
+		// most likely truncated by a crash part way through writing it
+		Log::Info("DiskCache: discarding {}: {}\n", file->GetInfo().GetPath(), e.what());
+		Forget(hash);
+		return false;
+	}
+
+	const size_t headerSize = sizeof(Uint32) + sizeof(Uint32) + key.size();
+	Uint32 magic = 0, keyLen = 0;
+	if (contents.size() >= headerSize) {
+		memcpy(&magic, &contents[0], sizeof(Uint32));
+		memcpy(&keyLen, &contents[sizeof(Uint32)], sizeof(Uint32));
+	}
+	if (magic != m_magic || keyLen != key.size() || contents.compare(2 * sizeof(Uint32), keyLen, key) != 0) {
+		// a hash collision or a stale entry, it's replaced once the data is regenerated
+		return false;
+	}
+
+	data = contents.substr(headerSize);
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto it = m_entries.find(hash);
+	if (it != m_entries.end())
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+	return true;
+}
+
+void DiskCache::Store(const std::string &key, std::string_view data, int lz4Preset)
+{
+	PROFILE_SCOPED()
+	const Uint64 hash = hash_64_fnv1a(key.data(), key.size());
+
+	std::string contents;
+	contents.reserve(2 * sizeof(Uint32) + key.size() + data.size());
+	const Uint32 keyLen = key.size();
+	contents.append(reinterpret_cast<const char *>(&m_magic), sizeof(Uint32));
+	contents.append(reinterpret_cast<const char *>(&keyLen), sizeof(Uint32));
+	contents.append(key);
+	contents.append(data);
+
+	std::string compressed;
+	try {
+		compressed = lz4::CompressLZ4(contents, lz4Preset);
+	} catch (lz4::CompressionFailedException &e) {
+		Log::Warning("DiskCache: failed to compress {} entry: {}\n", m_dir, e.what());
+		return;
+	}
+
+	const std::string filename = MakeFilename(hash);
+	FILE *f = FileSystem::userFiles.OpenWriteStream(filename);
+	if (!f)
+		return;
+	const bool written = fwrite(compressed.data(), compressed.size(), 1, f) == 1;
+	fclose(f);
+	if (!written) {
+		// probably out of disk space, don't leave a partial entry behind
+		FileSystem::userFiles.RemoveFile(filename);
+		return;
+	}
+
+	Insert(hash, compressed.size());
+}
+
+void DiskCache::ScanDirectory()
+{
+	PROFILE_SCOPED()
+	FileSystem::userFiles.MakeDirectory(m_dir);
+
+	struct Found {
+		Time::DateTime modTime;
+		Uint64 hash;
+		size_t size;
+	};
+	std::vector<Found> found;
+	for (FileSystem::FileEnumerator files(FileSystem::userFiles, m_dir); !files.Finished(); files.Next()) {
+		const FileSystem::FileInfo &info = files.Current();
+		const std::string name = info.GetName();
+		if (!info.IsFile() || !ends_with_ci(name, CACHE_EXTENSION))
+			continue;
+
+		FILE *f = FileSystem::userFiles.OpenReadStream(info.GetPath());
+		if (!f)
+			continue;
+		fseek(f, 0, SEEK_END);
+		const long size = ftell(f);
+		fclose(f);
+		if (size <= 0)
+			continue;
+
+		found.push_back({ info.GetModificationTime(), strtoull(name.c_str(), nullptr, 16), size_t(size) });
+	}
+
+	// the newest entries go to the front of the queue
+	std::sort(found.begin(), found.end(), [](const Found &a, const Found &b) { return b.modTime < a.modTime; });
+
+	std::vector<Uint64> victims;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (const Found &f : found) {
+			if (m_entries.count(f.hash))
+				continue;
+			m_lru.push_back(f.hash);
+			m_entries[f.hash] = { f.size, std::prev(m_lru.end()) };
+			m_totalSize += f.size;
+		}
+		Evict(victims);
+	}
+	for (const Uint64 hash : victims)
+		FileSystem::userFiles.RemoveFile(MakeFilename(hash));
+
+	Log::Verbose("DiskCache: {} has {} entries, {} KB of {} KB\n", m_dir, m_entries.size(), m_totalSize / 1024, m_byteBudget / 1024);
+}
+
+void DiskCache::Insert(const Uint64 hash, const size_t size)
+{
+	std::vector<Uint64> victims;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto it = m_entries.find(hash);
+		if (it != m_entries.end()) {
+			m_totalSize -= it->second.size;
+			it->second.size = size;
+			m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+		} else {
+			m_lru.push_front(hash);
+			m_entries[hash] = { size, m_lru.begin() };
+		}
+		m_totalSize += size;
+		Evict(victims);
+	}
+	for (const Uint64 victim : victims)
+		FileSystem::userFiles.RemoveFile(MakeFilename(victim));
+}
+
+void DiskCache::Forget(const Uint64 hash)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto it = m_entries.find(hash);
+		if (it == m_entries.end())
+			return;
+		m_totalSize -= it->second.size;
+		m_lru.erase(it->second.lru);
+		m_entries.erase(it);
+	}
+	FileSystem::userFiles.RemoveFile(MakeFilename(hash));
+}
+
+void DiskCache::Evict(std::vector<Uint64> &victims)
+{
+	// never evict the entry that was just added
+	while (m_totalSize > m_byteBudget && m_lru.size() > 1) {
+		const Uint64 hash = m_lru.back();
+		auto it = m_entries.find(hash);
+		assert(it != m_entries.end());
+		m_totalSize -= it->second.size;
+		m_entries.erase(it);
+		m_lru.pop_back();
+		victims.push_back(hash);
+	}
+}
@@ -0,0 +1,64 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _DISKCACHE_H
+#define _DISKCACHE_H
+
+#include <SDL_stdinc.h>
+
+#include "RefCounted.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Persistent on-disk cache of generated data.
+//
+// Each entry is stored as one LZ4 compressed file in a directory under the
+// user's data directory, named after a hash of its key. The key should be the
+// full description of whatever went into generating the data; it is stored
+// in the file too, so hash collisions read as misses.
+// Once the total size on disk goes over budget the least recently used
+// entries are deleted.
+//
+// Load and Store are THREAD SAFE, they're meant to be called from jobs.
+class DiskCache : public RefCounted {
+public:
+	DiskCache(const std::string &dir, Uint32 magic, size_t byteBudget);
+
+	// on a hit the stored data is returned in data and true is returned
+	bool Load(const std::string &key, std::string &data);
+	// lz4Preset as for lz4::CompressLZ4
+	void Store(const std::string &key, std::string_view data, int lz4Preset);
+
+	size_t GetTotalSize() const;
+
+private:
+	struct Entry {
+		size_t size;
+		std::list<Uint64>::iterator lru;
+	};
+
+	std::string MakeFilename(const Uint64 hash) const;
+
+	void ScanDirectory();
+	void Insert(const Uint64 hash, const size_t size);
+	void Forget(const Uint64 hash);
+	// must be called with m_lock held, returns the files that should be deleted
+	void Evict(std::vector<Uint64> &victims);
+
+	const std::string m_dir;
+	const Uint32 m_magic;
+	const size_t m_byteBudget;
+
+	mutable std::mutex m_lock;
+	// most recently used at the front
+	std::list<Uint64> m_lru;
+	std::unordered_map<Uint64, Entry> m_entries;
+	size_t m_totalSize;
+};
+
+#endif /* _DISKCACHE_H */
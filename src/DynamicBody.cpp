@@ -227,9 +227,8 @@ void DynamicBody::CalcExternalForce()
 	}
 }
 
-void DynamicBody::TimeStepUpdate(const float timeStep)
+void DynamicBody::TimeStepIntegrate(const float timeStep)
 {
-	m_oldPos = GetPosition();
 	if (m_isMoving) {
 		m_force += m_externalForce;
 
@@ -259,8 +258,6 @@ void DynamicBody::TimeStepUpdate(const float timeStep)
 	} else {
 		m_oldAngDisplacement = vector3d(0.0);
 	}
-
-	ModelBody::TimeStepUpdate(timeStep);
 }
 
 void DynamicBody::UpdateInterpTransform(double alpha)
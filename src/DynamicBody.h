@@ -35,7 +35,10 @@ public:
 	void SetMoving(bool isMoving);
 	bool IsMoving() const { return m_isMoving; }
 	virtual double GetMass() const override { return m_mass; } // XXX don't override this
-	virtual void TimeStepUpdate(const float timeStep) override;
+	virtual void TimeStepIntegrate(const float timeStep) override;
+	// remember where the body starts the step, to interpolate from; called
+	// before any body's TimeStepUpdate, as stations move docked ships there
+	void StoreOldPosition() { m_oldPos = GetPosition(); }
 	double CalcAtmosphericDrag(double velSqr, double area, double coeff) const;
 	void CalcExternalForce();
 
@@ -12,7 +12,8 @@
 
 namespace FileSystem {
 
-	static FileSourceFS dataFilesApp(GetDataDir(), true);
+	// the installed game data is only written to by the tools, never the game
+	static FileSourceFS dataFilesApp(GetDataDir(), true, true);
 	static FileSourceFS dataFilesUser(JoinPath(GetUserDir(), "data"));
 	FileSourceUnion gameDataFiles;
 	FileSourceFS userFiles(GetUserDir());
@@ -226,7 +227,8 @@ namespace FileSystem {
 	}
 
 	FileSourceUnion::FileSourceUnion() :
-		FileSource(":union:") {}
+		FileSource(":union:"),
+		m_generation(0) {}
 	FileSourceUnion::~FileSourceUnion() {}
 
 	void FileSourceUnion::PrependSource(FileSource *fs)
@@ -247,6 +249,7 @@ namespace FileSystem {
 	{
 		std::vector<FileSource *>::iterator nend = std::remove(m_sources.begin(), m_sources.end(), fs);
 		m_sources.erase(nend, m_sources.end());
+		++m_generation;
 	}
 
 	FileInfo FileSourceUnion::Lookup(const std::string &path)
@@ -287,6 +290,17 @@ namespace FileSystem {
 		return RefCountedPtr<FileData>();
 	}
 
+	RefCountedPtr<FileData> FileSourceUnion::MapFile(const std::string &path)
+	{
+		for (FileSource *source : m_sources) {
+			RefCountedPtr<FileData> data = source->MapFile(path);
+			if (data) {
+				return data;
+			}
+		}
+		return RefCountedPtr<FileData>();
+	}
+
 	// Merge two sets of FileInfo's, by path.
 	// Input vectors must be sorted. Output will be sorted.
 	// Where a path is present in both inputs, directories are selected
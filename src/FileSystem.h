@@ -204,6 +204,10 @@ namespace FileSystem {
 
 		virtual FileInfo Lookup(const std::string &path) = 0;
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path) = 0;
+		// Like ReadFile, but the data may be mapped from the file rather than
+		// copied out of it, so the file mustn't be written to while the
+		// FileData is held (replacing it by renaming another over it is fine).
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path) { return ReadFile(path); }
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output) = 0;
 
 		bool IsTrusted() const { return m_trusted; }
@@ -219,14 +223,21 @@ namespace FileSystem {
 
 	class FileSourceFS : public FileSource {
 	public:
-		explicit FileSourceFS(const std::string &root, bool trusted = false);
+		// mapFiles makes ReadFile map files too, for directories which nothing
+		// writes to while the game runs
+		explicit FileSourceFS(const std::string &root, bool trusted = false, bool mapFiles = false);
 		~FileSourceFS();
 
 		virtual FileInfo Lookup(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
 
 		bool MakeDirectory(const std::string &path);
+		// deletes a single file; returns false if it couldn't be removed
+		bool RemoveFile(const std::string &path);
+		// moves a file, replacing any file already at newPath (atomically where the OS allows)
+		bool RenameFile(const std::string &oldPath, const std::string &newPath);
 
 		enum WriteFlags {
 			WRITE_TEXT = 1
@@ -236,6 +247,14 @@ namespace FileSystem {
 		FILE *OpenReadStream(const std::string &path);
 		// similar to fopen(path, "wb")
 		FILE *OpenWriteStream(const std::string &path, int flags = 0);
+
+	private:
+		// smaller files are cheaper to copy than to map
+		static const size_t MAP_MIN_SIZE = 64 * 1024;
+
+		RefCountedPtr<FileData> ReadFileCopy(const std::string &path);
+
+		bool m_mapFiles;
 	};
 
 	class FileSourceUnion : public FileSource {
@@ -250,13 +269,19 @@ namespace FileSystem {
 		void AppendSource(FileSource *fs);
 		void RemoveSource(FileSource *fs);
 
+		// changes whenever the sources do, so anything built from their
+		// contents can tell it's out of date
+		unsigned GetGeneration() const { return m_generation; }
+
 		virtual FileInfo Lookup(const std::string &path);
 		std::vector<FileInfo> LookupAll(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
 
 	private:
 		std::vector<FileSource *> m_sources;
+		unsigned m_generation;
 	};
 
 	class FileEnumerator {
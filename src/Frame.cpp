@@ -5,6 +5,7 @@
 
 #include "GameSaveError.h"
 #include "JsonUtils.h"
+#include "Projectile.h"
 #include "Sfx.h"
 #include "Space.h"
 #include "collider/CollisionSpace.h"
@@ -34,10 +35,6 @@ Frame::Frame(const Dummy &d, FrameId parent, const char *label, unsigned int fla
 
 	s_collisionSpaces.emplace_back();
 	m_collisionSpace = s_collisionSpaces.size() - 1;
-	// TODO: this hacks around TraceRay being called on an uninitialized collision space and crashing
-	// Need to further evaluate the impact of this and whether it should be called in the CollisionSpace constructor instead
-	// FIXME: this causes a crash when resizing the collisionSpace array because a collision space double-frees when move constructing
-	// s_collisionSpaces.back().RebuildObjectTrees();
 
 	if (m_parent.valid())
 		Frame::GetFrame(m_parent)->AddChild(m_thisId);
@@ -71,6 +68,7 @@ Frame::Frame(const Dummy &d, FrameId parent) :
 
 Frame::Frame(Frame &&other) noexcept :
 	m_sfx(std::move(other.m_sfx)),
+	m_projectiles(std::move(other.m_projectiles)),
 	m_thisId(other.m_thisId),
 	m_parent(other.m_parent),
 	m_children(std::move(other.m_children)),
@@ -102,6 +100,7 @@ Frame::Frame(Frame &&other) noexcept :
 Frame &Frame::operator=(Frame &&other)
 {
 	m_sfx = std::move(other.m_sfx);
+	m_projectiles = std::move(other.m_projectiles);
 	m_thisId = other.m_thisId;
 	m_parent = other.m_parent;
 	m_children = std::move(other.m_children);
@@ -156,6 +155,7 @@ void Frame::ToJson(Json &frameObj, FrameId fId, Space *space)
 
 	// Add sfx array to supplied object.
 	SfxManager::ToJson(frameObj, f->m_thisId);
+	ProjectileManager::ToJson(frameObj, f->m_thisId, space);
 }
 
 Frame::~Frame()
@@ -226,6 +226,7 @@ FrameId Frame::FromJson(const Json &frameObj, Space *space, FrameId parent, doub
 	}
 
 	SfxManager::FromJson(frameObj, f->m_thisId);
+	ProjectileManager::FromJson(frameObj, f->m_thisId);
 
 	f->ClearMovement();
 	return f->GetId();
@@ -290,6 +291,7 @@ void Frame::PostUnserializeFixup(FrameId fId, Space *space)
 	Frame *f = Frame::GetFrame(fId);
 	f->UpdateRootRelativeVars();
 	f->m_astroBody = space->GetBodyByIndex(f->m_astroBodyIndex);
+	ProjectileManager::PostLoadFixup(fId, space);
 	// build the object trees once after loading so they're initialized while paused.
 	f->GetCollisionSpace()->RebuildObjectTrees();
 	for (FrameId kid : f->GetChildren())
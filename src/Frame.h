@@ -18,6 +18,7 @@ class Body;
 class CollisionSpace;
 class Geom;
 class SystemBody;
+class ProjectileManager;
 class SfxManager;
 class Space;
 
@@ -131,6 +132,7 @@ public:
 	static void GetFrameTransform(FrameId fFrom, FrameId fTo, matrix4x4d &m);
 
 	std::unique_ptr<SfxManager> m_sfx; // the last survivor. actually m_children is pretty grim too.
+	std::unique_ptr<ProjectileManager> m_projectiles;
 
 private:
 	FrameId m_thisId;
@@ -11,9 +11,11 @@
 #include "GameLog.h"
 #include "GameSaveError.h"
 #include "HyperspaceCloud.h"
+#include "JobQueue.h"
+#include "JsonUtils.h"
+#include "Lang.h"
 #include "MathUtil.h"
 #include "collider/CollisionSpace.h"
-#include "core/GZipFormat.h"
 #include "galaxy/Economy.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaSerializer.h"
@@ -26,13 +28,54 @@
 #include "Sfx.h"
 #include "Space.h"
 #include "SpaceStation.h"
+#include "StringF.h"
 #include "SystemView.h"
 #include "WorldView.h"
+#include "core/TaskGraph.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "pigui/PiGuiView.h"
 #include "ship/PlayerShipController.h"
 
-static const int s_saveVersion = 88;
+#include <optional>
+
+static const int s_saveVersion = 89;
+
+namespace {
+	// a save being written in the background, owned by the main thread
+	struct AsyncSave {
+		enum Result {
+			WRITTEN,
+			COULD_NOT_OPEN,
+			COULD_NOT_WRITE
+		};
+
+		std::string filename;
+		Json rootNode;
+		// only touched by the writing task until it completes
+		Result result = WRITTEN;
+		std::optional<TaskSet::Handle> handle;
+	};
+
+	std::unique_ptr<AsyncSave> s_asyncSave;
+} // namespace
+
+// The save is written to a temporary file which then replaces the old one,
+// so a failed or interrupted write never leaves a truncated save behind.
+static void WriteSaveFile(const std::string &filename, const Json &rootNode, TaskGraph *graph)
+{
+	const std::string path = FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename);
+	const std::string tempPath = path + ".tmp";
+	FILE *f = FileSystem::userFiles.OpenWriteStream(tempPath);
+	if (!f) throw CouldNotOpenFileException();
+
+	const bool written = JsonUtils::WriteJsonSaveFile(f, rootNode, graph);
+	// fclose flushes the last of the data, so it can fail too
+	const bool closed = (fclose(f) == 0);
+	if (!written || !closed || !FileSystem::userFiles.RenameFile(tempPath, path)) {
+		FileSystem::userFiles.RemoveFile(tempPath);
+		throw CouldNotWriteToFileException();
+	}
+}
 
 Game::Game(const SystemPath &path, const double startDateTime) :
 	m_galaxy(GalaxyGenerator::Create()),
@@ -44,7 +87,8 @@ Game::Game(const SystemPath &path, const double startDateTime) :
 	m_hyperspaceEndTime(0),
 	m_timeAccel(TIMEACCEL_1X),
 	m_requestedTimeAccel(TIMEACCEL_1X),
-	m_forceTimeAccel(false)
+	m_forceTimeAccel(false),
+	m_jobs(new JobSet(Pi::GetAsyncJobQueue()))
 {
 	PROFILE_SCOPED()
 	// Now that we have a Galaxy, check the starting location
@@ -93,6 +137,7 @@ Game::Game(const SystemPath &path, const double startDateTime) :
 
 Game::~Game()
 {
+	m_jobs.reset();
 	DestroyViews();
 
 	// XXX this shutdown sequence is critical:
@@ -120,7 +165,8 @@ Game::~Game()
 Game::Game(const Json &jsonObj) :
 	m_timeAccel(TIMEACCEL_PAUSED),
 	m_requestedTimeAccel(TIMEACCEL_PAUSED),
-	m_forceTimeAccel(false)
+	m_forceTimeAccel(false),
+	m_jobs(new JobSet(Pi::GetAsyncJobQueue()))
 {
 	PROFILE_SCOPED()
 	try {
@@ -866,9 +912,10 @@ void Game::EmitPauseState(bool paused)
 	LuaEvent::Emit();
 }
 
-Json Game::LoadGameToJson(const std::string &filename)
+Json Game::LoadGameToJson(const std::string &filename, const std::vector<std::string> *onlySections)
 {
-	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles);
+	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles,
+		Pi::GetApp()->GetTaskGraph(), onlySections);
 	if (!rootNode.is_object()) {
 		Output("Loading saved game '%s' failed.\n", filename.c_str());
 		throw SavedGameCorruptException();
@@ -920,30 +967,84 @@ void Game::SaveGame(const std::string &filename, Game *game)
 		throw CouldNotOpenFileException();
 	}
 
+	// an async save might still be writing the same temporary file
+	UpdateSaveGame(true);
+
 	Json rootNode;
 	game->ToJson(rootNode); // Encode the game data as JSON and give to the root value.
-	std::vector<uint8_t> jsonData;
-	{
-		PROFILE_SCOPED_DESC("json.to_cbor");
-		jsonData = Json::to_cbor(rootNode); // Convert the JSON data to CBOR.
-	}
 
-	FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME);
-	FILE *f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
-	if (!f) throw CouldNotOpenFileException();
+	// CBOR encode and compress each part of the game on the worker threads
+	WriteSaveFile(filename, rootNode, Pi::GetApp()->GetTaskGraph());
 
-	try {
-		// Compress the CBOR data.
-		const std::string comressed_data = gzip::CompressGZip(
-			std::string(reinterpret_cast<const char *>(jsonData.data()), jsonData.size()),
-			filename + ".json");
-		size_t nwritten = fwrite(comressed_data.data(), comressed_data.size(), 1, f);
-		fclose(f);
-		if (nwritten != 1) throw CouldNotWriteToFileException();
-	} catch (gzip::CompressionFailedException) {
-		fclose(f);
-		throw CouldNotWriteToFileException();
+	Pi::GetApp()->RequestProfileFrame("SaveGame");
+}
+
+void Game::SaveGameAsync(const std::string &filename, Game *game)
+{
+	PROFILE_SCOPED()
+	assert(game);
+
+	if (game->IsHyperspace())
+		throw CannotSaveInHyperspace();
+
+	if (game->GetPlayer()->IsDead())
+		throw CannotSaveDeadPlayer();
+
+	if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME)) {
+		throw CouldNotOpenFileException();
 	}
 
-	Pi::GetApp()->RequestProfileFrame("SaveGame");
+	// one save at a time, the next one might be to the same file
+	UpdateSaveGame(true);
+
+	// the snapshot is the only part which has to see the game, everything
+	// after works on the copy while the game carries on
+	s_asyncSave.reset(new AsyncSave());
+	s_asyncSave->filename = filename;
+	game->ToJson(s_asyncSave->rootNode);
+
+	AsyncSave *save = s_asyncSave.get();
+	TaskSet *set = new TaskSet();
+	set->AddTaskLambda(TaskRange{ 0, 1 }, [save](TaskRange) {
+		PROFILE_SCOPED_DESC("SaveGameAsync")
+		try {
+			// already on a worker thread, so encode the sections serially
+			WriteSaveFile(save->filename, save->rootNode, nullptr);
+		} catch (CouldNotOpenFileException) {
+			save->result = AsyncSave::COULD_NOT_OPEN;
+		} catch (CouldNotWriteToFileException) {
+			save->result = AsyncSave::COULD_NOT_WRITE;
+		}
+	});
+	s_asyncSave->handle.emplace(Pi::GetApp()->GetTaskGraph()->QueueTaskSet(set));
+}
+
+void Game::UpdateSaveGame(bool wait)
+{
+	if (!s_asyncSave)
+		return;
+
+	TaskGraph *graph = Pi::GetApp()->GetTaskGraph();
+	if (wait)
+		graph->WaitForTaskSet(*s_asyncSave->handle);
+	else if (!graph->CompleteTaskSet(*s_asyncSave->handle))
+		return;
+
+	const std::string filename = s_asyncSave->filename;
+	const AsyncSave::Result result = s_asyncSave->result;
+	s_asyncSave.reset();
+
+	const std::string path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), filename);
+	switch (result) {
+	case AsyncSave::WRITTEN:
+		LuaEvent::Queue("onGameSaved", filename, path);
+		break;
+	case AsyncSave::COULD_NOT_OPEN:
+		LuaEvent::Queue("onGameSaveFailed", filename, stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path)));
+		break;
+	case AsyncSave::COULD_NOT_WRITE:
+		LuaEvent::Queue("onGameSaveFailed", filename, std::string(Lang::GAME_SAVE_CANNOT_WRITE));
+		break;
+	}
+	LuaEvent::Emit();
 }
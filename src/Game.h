@@ -12,6 +12,7 @@
 
 class GameLog;
 class HyperspaceCloud;
+class JobSet;
 class Player;
 class Space;
 
@@ -37,13 +38,22 @@ class ObjectViewerView;
 
 class Game {
 public:
-	static Json LoadGameToJson(const std::string &filename);
+	// only loads the named top level parts of the game if given a list, where the file allows it
+	static Json LoadGameToJson(const std::string &filename, const std::vector<std::string> *onlySections = nullptr);
 	// LoadGame and SaveGame throw exceptions on failure
 	static Game *LoadGame(const std::string &filename);
 	static bool CanLoadGame(const std::string &filename);
 	// XXX game arg should be const, and this should probably be a member function
 	// (or LoadGame/SaveGame should be somewhere else entirely)
 	static void SaveGame(const std::string &filename, Game *game);
+	// Snapshots the game on the calling thread and leaves encoding and writing
+	// to the job threads. Throws like SaveGame if the game can't be saved now,
+	// file errors are reported by an onGameSaveFailed event instead of
+	// onGameSaved. Waits for any earlier background save to finish first.
+	static void SaveGameAsync(const std::string &filename, Game *game);
+	// Call from the main thread to deliver the events of a finished background
+	// save. If wait is set, blocks until a save in progress is written.
+	static void UpdateSaveGame(bool wait = false);
 
 	// start docked in station referenced by path or nearby to body if it is no station
 	Game(const SystemPath &path, const double startDateTime = 0.0);
@@ -123,6 +133,10 @@ public:
 	/* Only use #if WITH_OBJECTVIEWER */
 	ObjectViewerView *GetObjectViewerView() const;
 
+	// for background jobs whose results only matter to this game, such as
+	// route searches; they are cancelled when the game ends
+	JobSet *GetJobs() const { return m_jobs.get(); }
+
 	GameLog *log;
 
 private:
@@ -180,6 +194,9 @@ private:
 	TimeAccel m_timeAccel;
 	TimeAccel m_requestedTimeAccel;
 	bool m_forceTimeAccel;
+
+	std::unique_ptr<JobSet> m_jobs;
+
 	static const float s_timeAccelRates[];
 	static const float s_timeInvAccelRates[];
 };
@@ -40,6 +40,11 @@ GameConfig::GameConfig(const map_string &override_)
 	map["VSync"] = "1";
 	map["UseTextureCompression"] = "1";
 	map["WorkerThreads"] = "0";
+	map["ParallelBodyUpdate"] = "1";
+	map["GeoPatchCacheSize"] = "256"; // MB of terrain patches kept on disk, 0 to disable
+	map["GasGiantCacheSize"] = "128"; // MB of gas giant textures kept on disk, 0 to disable
+	map["SectorCacheSize"] = "64"; // MB of generated sectors kept in memory, 0 for no limit
+	map["StarSystemCacheSize"] = "128"; // MB of generated star systems kept in memory, 0 for no limit
 	map["SpeedLines"] = "0";
 	map["EnableCockpit"] = "0";
 	map["HudTrails"] = "0";
@@ -51,6 +56,7 @@ GameConfig::GameConfig(const map_string &override_)
 	map["EnableGLDebug"] = "0";
 	map["EnableGPUJobs"] = "1";
 	map["GL3ForwardCompatible"] = "1";
+	map["SortDrawCommands"] = "1";
 	map["LogVerbose"] = "1";
 	map["ProfileSlowFrames"] = "0";
 	map["ProfilerZoneOutput"] = "0";
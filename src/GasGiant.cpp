@@ -20,7 +20,10 @@
 #include "utils.h"
 #include "vcacheopt/vcacheopt.h"
 
+#include <list>
+
 RefCountedPtr<GasPatchContext> GasGiant::s_patchContext;
+RefCountedPtr<DiskCache> GasGiant::s_textureCache;
 Graphics::RenderTarget *GasGiant::s_renderTarget;
 
 namespace {
@@ -32,6 +35,28 @@ namespace {
 	static float s_initialGPUDelayTime = 5.0f;	// (perhaps) 5 seconds seems like a reasonable default
 	static std::vector<GasGiant *> s_allGasGiants;
 
+	// rows of a cubemap face generated by each job
+	static const Sint32 TEXTURE_TILE_ROWS = 64;
+	// the preview is this much smaller than the finished texture
+	static const Sint32 TEXTURE_PREVIEW_DIVISOR = 4;
+
+	static const std::string TEXTURE_CACHE_DIR("gasgiant_cache");
+	static const Uint32 TEXTURE_CACHE_MAGIC = 0x43544747; // 'GGTC'
+	// bump this whenever the gas giant colour fractals change their output
+	static const Uint32 TEXTURE_GENERATOR_VERSION = 1;
+
+	// Finished textures are kept around, so coming back to a gas giant or to a
+	// detail level doesn't have to generate them again.
+	struct CachedTexture {
+		SystemPath path;
+		Sint32 uvDims;
+		RefCountedPtr<Graphics::Texture> texture;
+	};
+	// most recently used at the front
+	static std::list<CachedTexture> s_cachedTextures;
+	static size_t s_cachedTexturesSize = 0;
+	static size_t s_cachedTexturesBudget = 0;
+
 	static const std::string GGJupiter("GGJupiter");
 	static const std::string GGNeptune("GGNeptune");
 	static const std::string GGNeptune2("GGNeptune2");
@@ -81,6 +106,60 @@ namespace {
 
 		return i == 4;
 	}
+
+	size_t CubemapSize(const Sint32 uvDims)
+	{
+		// six RGBA faces, and a third again for the mipmaps
+		return size_t(uvDims) * uvDims * 4 * NUM_PATCHES * 4 / 3;
+	}
+
+	RefCountedPtr<Graphics::Texture> FindCachedTexture(const SystemPath &path, const Sint32 uvDims)
+	{
+		for (auto it = s_cachedTextures.begin(); it != s_cachedTextures.end(); ++it) {
+			if (it->uvDims == uvDims && it->path == path) {
+				s_cachedTextures.splice(s_cachedTextures.begin(), s_cachedTextures, it);
+				return it->texture;
+			}
+		}
+		return RefCountedPtr<Graphics::Texture>();
+	}
+
+	void CacheTexture(const SystemPath &path, const Sint32 uvDims, Graphics::Texture *texture)
+	{
+		if (!s_cachedTexturesBudget)
+			return;
+
+		s_cachedTextures.push_front({ path, uvDims, RefCountedPtr<Graphics::Texture>(texture) });
+		s_cachedTexturesSize += CubemapSize(uvDims);
+
+		// never evict the texture that was just added
+		while (s_cachedTexturesSize > s_cachedTexturesBudget && s_cachedTextures.size() > 1) {
+			s_cachedTexturesSize -= CubemapSize(s_cachedTextures.back().uvDims);
+			s_cachedTextures.pop_back();
+		}
+	}
+
+	RefCountedPtr<Graphics::Texture> CreateCubemap(const GasGiantJobs::STextureCubeBuffer *buffer, const bool mipmaps)
+	{
+		const Sint32 uvDims = buffer->UVDims();
+		const vector2f texSize(1.0f, 1.0f);
+		const vector3f dataSize(uvDims, uvDims, 0.0f);
+		const Graphics::TextureDescriptor texDesc(
+			Graphics::TEXTURE_RGBA_8888,
+			dataSize, texSize, Graphics::LINEAR_CLAMP,
+			mipmaps, false, false, 0, Graphics::TEXTURE_CUBE_MAP);
+		RefCountedPtr<Graphics::Texture> texture(Pi::renderer->CreateTexture(texDesc));
+
+		Graphics::TextureCubeData tcd;
+		tcd.posX = buffer->Face(0);
+		tcd.negX = buffer->Face(1);
+		tcd.posY = buffer->Face(2);
+		tcd.negY = buffer->Face(3);
+		tcd.posZ = buffer->Face(4);
+		tcd.negZ = buffer->Face(5);
+		texture->Update(tcd, dataSize, Graphics::TEXTURE_RGBA_8888);
+		return texture;
+	}
 } // namespace
 
 class GasPatchContext : public RefCounted {
@@ -300,15 +379,13 @@ GasGiant::GasGiant(const SystemBody *body) :
 	BaseSphere(body),
 	m_hasTempCampos(false),
 	m_tempCampos(0.0),
+	m_jobTilesLeft(0),
+	m_jobs(Pi::GetAsyncJobQueue()),
 	m_hasGpuJobRequest(false),
 	m_timeDelay(s_initialCPUDelayTime)
 {
 	s_allGasGiants.push_back(this);
 
-	for (int i = 0; i < NUM_PATCHES; i++) {
-		m_hasJobRequest[i] = false;
-	}
-
 	Random rng(GetSystemBody()->GetSeed() + 4609837);
 
 	const bool bEnableGPUJobs = (Pi::config->Int("EnableGPUJobs") == 1);
@@ -329,13 +406,10 @@ GasGiant::~GasGiant()
 
 void GasGiant::Reset()
 {
-	{
-		for (int i = 0; i < NUM_PATCHES; i++) {
-			if (m_hasJobRequest[i] && m_job[i].HasJob())
-				m_job[i].GetJob()->OnCancel();
-			m_hasJobRequest[i] = false;
-		}
-	}
+	// cancel whatever is still queued, tiles already running finish into a buffer nobody wants
+	m_jobs = JobSet(Pi::GetAsyncJobQueue());
+	m_jobBuffer.Reset();
+	m_jobTilesLeft = 0;
 
 	for (int p = 0; p < NUM_PATCHES; p++) {
 		// delete patches
@@ -367,6 +441,18 @@ bool GasGiant::OnAddTextureFaceResult(const SystemPath &path, GasGiantJobs::STex
 	return false;
 }
 
+//static
+bool GasGiant::OnLoadCachedTexture(const SystemPath &path, GasGiantJobs::STextureCubeBuffer *buffer, bool found)
+{
+	for (GasGiant *gg : s_allGasGiants) {
+		if (path == gg->GetSystemBody()->GetPath()) {
+			gg->LoadCachedTexture(buffer, found);
+			return true;
+		}
+	}
+	return false;
+}
+
 //static
 bool GasGiant::OnAddGPUGenResult(const SystemPath &path, GasGiantJobs::SGPUGenResult *res)
 {
@@ -409,64 +495,129 @@ void textureDump(const char *destFile, const int width, const int height, const
 
 bool GasGiant::AddTextureFaceResult(GasGiantJobs::STextureFaceResult *res)
 {
-	bool result = false;
 	assert(res);
 	assert(res->face() >= 0 && res->face() < NUM_PATCHES);
-	m_jobColorBuffers[res->face()].reset(res->data().colors);
-	m_hasJobRequest[res->face()] = false;
-	const Sint32 uvDims = res->data().uvDims;
-	assert(uvDims > 0 && uvDims <= 4096);
 
-	// tidyup
+	// tiles of a texture we've since given up on
+	RefCountedPtr<GasGiantJobs::STextureCubeBuffer> buffer(res->buffer());
+	res->OnCancel();
 	delete res;
+	if (buffer.Get() != m_jobBuffer.Get())
+		return false;
 
-	bool bCreateTexture = true;
-	for (int i = 0; i < NUM_PATCHES; i++) {
-		bCreateTexture = bCreateTexture & (!m_hasJobRequest[i]);
-	}
-
-	if (bCreateTexture) {
-		// create texture
-		const vector2f texSize(1.0f, 1.0f);
-		const vector3f dataSize(uvDims, uvDims, 0.0f);
-		const Graphics::TextureDescriptor texDesc(
-			Graphics::TEXTURE_RGBA_8888,
-			dataSize, texSize, Graphics::LINEAR_CLAMP,
-			true, false, false, 0, Graphics::TEXTURE_CUBE_MAP);
-		m_surfaceTexture.Reset(Pi::renderer->CreateTexture(texDesc));
+	assert(m_jobTilesLeft > 0);
+	if (--m_jobTilesLeft > 0)
+		return false;
 
-		// update with buffer from above
-		Graphics::TextureCubeData tcd;
-		tcd.posX = m_jobColorBuffers[0].get();
-		tcd.negX = m_jobColorBuffers[1].get();
-		tcd.posY = m_jobColorBuffers[2].get();
-		tcd.negY = m_jobColorBuffers[3].get();
-		tcd.posZ = m_jobColorBuffers[4].get();
-		tcd.negZ = m_jobColorBuffers[5].get();
-		m_surfaceTexture->Update(tcd, dataSize, Graphics::TEXTURE_RGBA_8888);
+	m_jobBuffer.Reset();
+	const Sint32 uvDims = buffer->UVDims();
+	assert(uvDims > 0 && uvDims <= 4096);
 
 #if DUMP_TO_TEXTURE
-		for (int iFace = 0; iFace < NUM_PATCHES; iFace++) {
-			char filename[1024];
-			snprintf(filename, 1024, "%s%d.png", GetSystemBody()->GetName().c_str(), iFace);
-			textureDump(filename, uvDims, uvDims, m_jobColorBuffers[iFace].get());
-		}
+	for (int iFace = 0; iFace < NUM_PATCHES; iFace++) {
+		char filename[1024];
+		snprintf(filename, 1024, "%s%d.png", GetSystemBody()->GetName().c_str(), iFace);
+		textureDump(filename, uvDims, uvDims, buffer->Face(iFace));
+	}
 #endif
 
-		// cleanup the temporary color buffer storage
-		for (int i = 0; i < NUM_PATCHES; i++) {
-			m_jobColorBuffers[i].reset();
-		}
+	// change the planet texture for the new higher resolution texture
+	RefCountedPtr<Graphics::Texture> texture = CreateCubemap(buffer.Get(), true);
+	SetSurfaceTexture(texture.Get());
 
-		// change the planet texture for the new higher resolution texture
-		if (m_surfaceMaterial.Get()) {
-			m_surfaceMaterial->SetTexture("texture0"_hash,
-				m_surfaceTexture.Get());
-			m_surfaceTextureSmall.Reset();
+	const Sint32 textureSize = GetTextureSize();
+	if (uvDims < textureSize) {
+		// that was the preview, carry on with the real thing
+		QueueTextureFaceJobs(textureSize);
+		return true;
+	}
+
+	CacheTexture(GetSystemBody()->GetPath(), uvDims, texture.Get());
+	if (s_textureCache)
+		m_jobs.Order(new GasGiantJobs::StoreTextureCacheJob(s_textureCache.Get(), GetTextureCacheKey(uvDims), buffer.Get()));
+
+	return true;
+}
+
+bool GasGiant::LoadCachedTexture(GasGiantJobs::STextureCubeBuffer *buffer, bool found)
+{
+	if (buffer != m_jobBuffer.Get())
+		return false;
+	m_jobBuffer.Reset();
+
+	if (!found) {
+		GenerateTextureFaces();
+		return false;
+	}
+
+	RefCountedPtr<Graphics::Texture> texture = CreateCubemap(buffer, true);
+	SetSurfaceTexture(texture.Get());
+	CacheTexture(GetSystemBody()->GetPath(), buffer->UVDims(), texture.Get());
+	return true;
+}
+
+void GasGiant::GenerateTextureFaces()
+{
+	// a preview isn't worth it if it's hardly better than the small texture
+	const Sint32 textureSize = GetTextureSize();
+	const Sint32 previewSize = textureSize / TEXTURE_PREVIEW_DIVISOR;
+	QueueTextureFaceJobs(previewSize > Sint32(s_texture_size_small) ? previewSize : textureSize);
+}
+
+void GasGiant::QueueTextureFaceJobs(const Sint32 uvDims)
+{
+	PROFILE_SCOPED()
+	assert(!m_jobBuffer.Valid());
+	m_jobBuffer.Reset(new GasGiantJobs::STextureCubeBuffer(uvDims));
+	m_jobTilesLeft = 0;
+
+	const SystemPath &path = GetSystemBody()->GetPath();
+	for (int i = 0; i < NUM_PATCHES; i++) {
+		for (Sint32 row = 0; row < uvDims; row += TEXTURE_TILE_ROWS) {
+			const Sint32 rowEnd = std::min(row + TEXTURE_TILE_ROWS, uvDims);
+			GasGiantJobs::STextureFaceRequest *ssrd = new GasGiantJobs::STextureFaceRequest(&GasGiantJobs::GetPatchFaces(i, 0), path, i, row, rowEnd, m_jobBuffer.Get(), GetTerrain());
+			m_jobs.Order(new GasGiantJobs::SingleTextureFaceJob(ssrd));
+			++m_jobTilesLeft;
 		}
 	}
+}
 
-	return result;
+Sint32 GasGiant::GetTextureSize() const
+{
+	const bool bEnableGPUJobs = (Pi::config->Int("EnableGPUJobs") == 1);
+	return bEnableGPUJobs ? s_texture_size_gpu[Pi::detail.planets] : s_texture_size_cpu[Pi::detail.planets];
+}
+
+// The key is everything that goes into generating the texture.
+// Only the CPU generated ones are stored, the GPU ones never leave the GPU.
+std::string GasGiant::GetTextureCacheKey(const Sint32 uvDims) const
+{
+	const SystemPath &path = GetSystemBody()->GetPath();
+	const Terrain *terrain = GetTerrain();
+	const Uint32 values[] = {
+		TEXTURE_GENERATOR_VERSION,
+		Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ),
+		path.systemIndex, path.bodyIndex,
+		Uint32(uvDims), terrain->GetSeed()
+	};
+	std::string key(reinterpret_cast<const char *>(values), sizeof(values));
+	// the path alone doesn't identify the body if the galaxy generator changes
+	const Uint64 paramsHash = terrain->GetParamsHash();
+	key.append(reinterpret_cast<const char *>(&paramsHash), sizeof(paramsHash));
+	const double scales[] = { terrain->GetMaxHeightInMeters(), terrain->GetPlanetEarthRadii() };
+	key.append(reinterpret_cast<const char *>(scales), sizeof(scales));
+	key.append(terrain->GetColorFractalName());
+	return key;
+}
+
+void GasGiant::SetSurfaceTexture(Graphics::Texture *texture)
+{
+	m_surfaceTexture.Reset(texture);
+	if (m_surfaceMaterial.Get()) {
+		m_surfaceMaterial->SetTexture("texture0"_hash,
+			m_surfaceTexture.Get());
+		m_surfaceTextureSmall.Reset();
+	}
 }
 
 bool GasGiant::AddGPUGenResult(GasGiantJobs::SGPUGenResult *res)
@@ -499,18 +650,13 @@ bool GasGiant::AddGPUGenResult(GasGiantJobs::SGPUGenResult *res)
 	delete res;
 
 	if (m_builtTexture.Valid()) {
-		m_surfaceTexture = m_builtTexture;
-		m_builtTexture.Reset();
-
 		// these won't be automatically generated otherwise since we used it as a render target
-		m_surfaceTexture->BuildMipmaps();
+		m_builtTexture->BuildMipmaps();
 
 		// change the planet texture for the new higher resolution texture
-		if (m_surfaceMaterial.Get()) {
-			m_surfaceMaterial->SetTexture("texture0"_hash,
-				m_surfaceTexture.Get());
-			m_surfaceTextureSmall.Reset();
-		}
+		SetSurfaceTexture(m_builtTexture.Get());
+		CacheTexture(GetSystemBody()->GetPath(), m_builtTexture->GetDescriptor().dataSize.x, m_builtTexture.Get());
+		m_builtTexture.Reset();
 	}
 
 	return result;
@@ -525,13 +671,19 @@ inline vector3d GetSpherePointFromCorners(const double x, const double y, const
 void GasGiant::GenerateTexture()
 {
 	using namespace GasGiantJobs;
-	for (int i = 0; i < NUM_PATCHES; i++) {
-		if (m_hasGpuJobRequest || m_hasJobRequest[i])
-			return;
-	}
+	if (m_hasGpuJobRequest || m_jobBuffer.Valid())
+		return;
 
 	const bool bEnableGPUJobs = (Pi::config->Int("EnableGPUJobs") == 1);
 
+	// seen it before, maybe in an earlier visit or at another detail level
+	const Sint32 textureSize = GetTextureSize();
+	RefCountedPtr<Graphics::Texture> cached = FindCachedTexture(GetSystemBody()->GetPath(), textureSize);
+	if (cached.Valid()) {
+		SetSurfaceTexture(cached.Get());
+		return;
+	}
+
 	// scope the small texture generation
 	{
 		const vector2f texSize(1.0f, 1.0f);
@@ -545,29 +697,33 @@ void GasGiant::GenerateTexture()
 		const Terrain *pTerrain = GetTerrain();
 		const double fracStep = 1.0 / double(s_texture_size_small - 1);
 
+		// the whole face at once, so the terrain evaluates its colours in one go
+		const Uint32 numTexels = s_texture_size_small * s_texture_size_small;
+		std::vector<vector3d> points(numTexels);
+		std::vector<double> heights(numTexels, 0.0);
+		std::vector<vector3d> colours(numTexels);
+
 		Graphics::TextureCubeData tcd;
 		std::unique_ptr<Color[]> bufs[NUM_PATCHES];
 		for (int i = 0; i < NUM_PATCHES; i++) {
-			Color *colors = new Color[(s_texture_size_small * s_texture_size_small)];
 			for (Uint32 v = 0; v < s_texture_size_small; v++) {
 				for (Uint32 u = 0; u < s_texture_size_small; u++) {
-					// where in this row & column are we now.
-					const double ustep = double(u) * fracStep;
-					const double vstep = double(v) * fracStep;
-
 					// get point on the surface of the sphere
-					const vector3d p = GetSpherePointFromCorners(ustep, vstep, &GetPatchFaces(i, 0));
-					// get colour using `p`
-					const vector3d colour = pTerrain->GetColor(p, 0.0, p);
-
-					// convert to ubyte and store
-					Color *col = colors + (u + (v * s_texture_size_small));
-					col[0].r = Uint8(colour.x * 255.0);
-					col[0].g = Uint8(colour.y * 255.0);
-					col[0].b = Uint8(colour.z * 255.0);
-					col[0].a = 255;
+					points[u + (v * s_texture_size_small)] = GetSpherePointFromCorners(double(u) * fracStep, double(v) * fracStep, &GetPatchFaces(i, 0));
 				}
 			}
+
+			// get colours using `p`
+			pTerrain->GetColors(points.data(), heights.data(), points.data(), colours.data(), numTexels);
+
+			// convert to ubyte and store
+			Color *colors = new Color[numTexels];
+			for (Uint32 t = 0; t < numTexels; t++) {
+				colors[t].r = Uint8(colours[t].x * 255.0);
+				colors[t].g = Uint8(colours[t].y * 255.0);
+				colors[t].b = Uint8(colours[t].z * 255.0);
+				colors[t].a = 255;
+			}
 			bufs[i].reset(colors);
 		}
 
@@ -583,12 +739,12 @@ void GasGiant::GenerateTexture()
 
 	// create small texture
 	if (!bEnableGPUJobs) {
-		for (int i = 0; i < NUM_PATCHES; i++) {
-			assert(!m_hasJobRequest[i]);
-			assert(!m_job[i].HasJob());
-			m_hasJobRequest[i] = true;
-			GasGiantJobs::STextureFaceRequest *ssrd = new GasGiantJobs::STextureFaceRequest(&GetPatchFaces(i, 0), GetSystemBody()->GetPath(), i, s_texture_size_cpu[Pi::detail.planets], GetTerrain());
-			m_job[i] = Pi::GetAsyncJobQueue()->Queue(new GasGiantJobs::SingleTextureFaceJob(ssrd));
+		// try the disk first, the preview and then the full texture are generated if it isn't there
+		if (s_textureCache) {
+			m_jobBuffer.Reset(new STextureCubeBuffer(textureSize));
+			m_jobs.Order(new LoadTextureCacheJob(s_textureCache.Get(), GetTextureCacheKey(textureSize), GetSystemBody()->GetPath(), m_jobBuffer.Get()));
+		} else {
+			GenerateTextureFaces();
 		}
 	} else {
 		// use m_surfaceTexture texture?
@@ -791,6 +947,12 @@ void GasGiant::Init()
 	s_initialCPUDelayTime = Clamp(cfg.Float("cpu_delay_time", 60.0f), 0.0f, 120.0f);
 	s_initialGPUDelayTime = Clamp(cfg.Float("gpu_delay_time", 5.0f), 0.0f, 120.0f);
 
+	// in megabytes, zero disables them
+	s_cachedTexturesBudget = size_t(Clamp(cfg.Int("texture_cache_size", 128), 0, 4096)) * 1024 * 1024;
+	const int cacheSize = Pi::config->Int("GasGiantCacheSize");
+	if (cacheSize > 0)
+		s_textureCache.Reset(new DiskCache(TEXTURE_CACHE_DIR, TEXTURE_CACHE_MAGIC, size_t(cacheSize) * 1024 * 1024));
+
 	if (s_patchContext.Get() == nullptr) {
 		s_patchContext.Reset(new GasPatchContext(127));
 	}
@@ -800,6 +962,10 @@ void GasGiant::Init()
 void GasGiant::Uninit()
 {
 	s_patchContext.Reset();
+	s_cachedTextures.clear();
+	s_cachedTexturesSize = 0;
+	// any jobs still running hold their own reference
+	s_textureCache.Reset();
 }
 
 //static
@@ -5,11 +5,13 @@
 #define _GASGIANT_H
 
 #include "BaseSphere.h"
+#include "DiskCache.h"
 #include "GasGiantJobs.h"
 #include "JobQueue.h"
 #include "vector3.h"
 
 #include <deque>
+#include <string>
 
 namespace Graphics {
 	class Renderer;
@@ -46,6 +48,7 @@ public:
 	virtual void Reset() override;
 
 	static bool OnAddTextureFaceResult(const SystemPath &path, GasGiantJobs::STextureFaceResult *res);
+	static bool OnLoadCachedTexture(const SystemPath &path, GasGiantJobs::STextureCubeBuffer *buffer, bool found);
 	static bool OnAddGPUGenResult(const SystemPath &path, GasGiantJobs::SGPUGenResult *res);
 	static void Init();
 	static void Uninit();
@@ -62,8 +65,17 @@ private:
 	void GenerateTexture();
 	bool AddTextureFaceResult(GasGiantJobs::STextureFaceResult *res);
 	bool AddGPUGenResult(GasGiantJobs::SGPUGenResult *res);
+	bool LoadCachedTexture(GasGiantJobs::STextureCubeBuffer *buffer, bool found);
+
+	// generate the cubemap in tiles on the job threads, a smaller preview first when there's room for one
+	void GenerateTextureFaces();
+	void QueueTextureFaceJobs(const Sint32 uvDims);
+	Sint32 GetTextureSize() const;
+	std::string GetTextureCacheKey(const Sint32 uvDims) const;
+	void SetSurfaceTexture(Graphics::Texture *texture);
 
 	static RefCountedPtr<GasPatchContext> s_patchContext;
+	static RefCountedPtr<DiskCache> s_textureCache;
 
 	static Graphics::RenderTarget *s_renderTarget;
 
@@ -77,9 +89,10 @@ private:
 	RefCountedPtr<Graphics::Texture> m_surfaceTexture;
 	RefCountedPtr<Graphics::Texture> m_builtTexture;
 
-	std::unique_ptr<Color[]> m_jobColorBuffers[NUM_PATCHES];
-	Job::Handle m_job[NUM_PATCHES];
-	bool m_hasJobRequest[NUM_PATCHES];
+	// the cubemap being loaded or generated on the job threads, and how many of its tiles are still to come
+	RefCountedPtr<GasGiantJobs::STextureCubeBuffer> m_jobBuffer;
+	Uint32 m_jobTilesLeft;
+	JobSet m_jobs;
 
 	Job::Handle m_gpuJob;
 	bool m_hasGpuJobRequest;
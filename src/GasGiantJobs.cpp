@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <deque>
 
 namespace GasGiantJobs {
@@ -33,41 +34,62 @@ namespace GasGiantJobs {
 	};
 	const vector3d &GetPatchFaces(const Uint32 patch, const Uint32 face) { return s_patchFaces[patch][face]; }
 
-	STextureFaceRequest::STextureFaceRequest(const vector3d *v_, const SystemPath &sysPath_, const Sint32 face_, const Sint32 uvDIMs_, Terrain *pTerrain_) :
+	STextureCubeBuffer::STextureCubeBuffer(const Sint32 uvDims_) :
+		uvDims(uvDims_)
+	{
+		colors.reset(new Color[NUM_PATCHES * uvDims * uvDims]);
+	}
+
+	size_t STextureCubeBuffer::NumBytes() const
+	{
+		return NUM_PATCHES * uvDims * uvDims * sizeof(Color);
+	}
+
+	STextureFaceRequest::STextureFaceRequest(const vector3d *v_, const SystemPath &sysPath_, const Sint32 face_, const Sint32 rowBegin_, const Sint32 rowEnd_, STextureCubeBuffer *buffer_, Terrain *pTerrain_) :
 		corners(v_),
 		sysPath(sysPath_),
 		face(face_),
-		uvDIMs(uvDIMs_),
+		rowBegin(rowBegin_),
+		rowEnd(rowEnd_),
+		buffer(buffer_),
 		pTerrain(pTerrain_)
 	{
-		colors = new Color[NumTexels()];
+		assert(rowBegin >= 0 && rowBegin < rowEnd && rowEnd <= UVDims());
 	}
 
 	// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
-	// Use only data local to this object
+	// Use only data local to this object, and only our rows of the buffer
 	void STextureFaceRequest::OnRun()
 	{
 		PROFILE_SCOPED()
 
 		assert(corners != nullptr);
-		double fracStep = 1.0 / double(UVDims() - 1);
-		for (Sint32 v = 0; v < UVDims(); v++) {
-			for (Sint32 u = 0; u < UVDims(); u++) {
-				// where in this row & column are we now.
-				const double ustep = double(u) * fracStep;
-				const double vstep = double(v) * fracStep;
-
+		const Sint32 uvDims = UVDims();
+		const double fracStep = 1.0 / double(uvDims - 1);
+
+		// a row at a time, so the terrain evaluates its colours in one go
+		std::vector<vector3d> points(uvDims);
+		std::vector<double> heights(uvDims, 0.0);
+		std::vector<vector3d> colours(uvDims);
+
+		Color *faceColors = buffer->Face(face);
+		for (Sint32 v = rowBegin; v < rowEnd; v++) {
+			const double vstep = double(v) * fracStep;
+			for (Sint32 u = 0; u < uvDims; u++) {
 				// get point on the surface of the sphere
-				const vector3d p = GetSpherePoint(ustep, vstep);
-				// get colour using `p`
-				const vector3d colour = pTerrain->GetColor(p, 0.0, p);
-
-				// convert to ubyte and store
-				Color *col = colors + (u + (v * UVDims()));
-				col[0].r = Uint8(colour.x * 255.0);
-				col[0].g = Uint8(colour.y * 255.0);
-				col[0].b = Uint8(colour.z * 255.0);
-				col[0].a = 255;
+				points[u] = GetSpherePoint(double(u) * fracStep, vstep);
+			}
+
+			// get colours using `p`
+			pTerrain->GetColors(points.data(), heights.data(), points.data(), colours.data(), uvDims);
+
+			// convert to ubyte and store
+			Color *col = faceColors + v * uvDims;
+			for (Sint32 u = 0; u < uvDims; u++) {
+				col[u].r = Uint8(colours[u].x * 255.0);
+				col[u].g = Uint8(colours[u].y * 255.0);
+				col[u].b = Uint8(colours[u].z * 255.0);
+				col[u].a = 255;
 			}
 		}
 	}
@@ -90,12 +112,8 @@ namespace GasGiantJobs {
 		PROFILE_SCOPED()
 		mData->OnRun();
 
-		// add this patches data
-		STextureFaceResult *sr = new STextureFaceResult(mData->Face());
-		sr->addResult(mData->Colors(), mData->UVDims());
-
 		// store the result
-		mpResults = sr;
+		mpResults = new STextureFaceResult(mData->Face(), mData->Buffer());
 	}
 
 	void SingleTextureFaceJob::OnFinish() // runs in primary thread of the context
@@ -105,6 +123,48 @@ namespace GasGiantJobs {
 		mpResults = nullptr;
 	}
 
+	// ********************************************************************************
+	LoadTextureCacheJob::LoadTextureCacheJob(DiskCache *cache_, const std::string &key_, const SystemPath &sysPath_, STextureCubeBuffer *buffer_) :
+		mCache(cache_),
+		mKey(key_),
+		mSysPath(sysPath_),
+		mBuffer(buffer_),
+		mFound(false)
+	{
+	}
+
+	void LoadTextureCacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	{
+		PROFILE_SCOPED()
+		std::string data;
+		if (!mCache->Load(mKey, data) || data.size() != mBuffer->NumBytes())
+			return;
+
+		memcpy(mBuffer->Colors(), data.data(), data.size());
+		mFound = true;
+	}
+
+	void LoadTextureCacheJob::OnFinish() // runs in primary thread of the context
+	{
+		PROFILE_SCOPED()
+		GasGiant::OnLoadCachedTexture(mSysPath, mBuffer.Get(), mFound);
+	}
+
+	// ********************************************************************************
+	StoreTextureCacheJob::StoreTextureCacheJob(DiskCache *cache_, const std::string &key_, STextureCubeBuffer *buffer_) :
+		mCache(cache_),
+		mKey(key_),
+		mBuffer(buffer_)
+	{
+	}
+
+	void StoreTextureCacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	{
+		PROFILE_SCOPED()
+		// fast preset, the gas giant bands compress well enough without trying harder
+		mCache->Store(mKey, std::string_view(reinterpret_cast<const char *>(mBuffer->Colors()), mBuffer->NumBytes()), 0);
+	}
+
 	// ********************************************************************************
 
 	struct GenFaceDataBlock {
@@ -6,6 +6,7 @@
 
 #include <SDL_stdinc.h>
 
+#include "DiskCache.h"
 #include "JobQueue.h"
 #include "graphics/Material.h"
 #include "graphics/VertexBuffer.h"
@@ -14,6 +15,8 @@
 #include "vector3.h"
 
 #include <deque>
+#include <memory>
+#include <string>
 
 namespace Graphics {
 	class Renderer;
@@ -44,70 +47,70 @@ namespace GasGiantJobs {
 
 	const vector3d &GetPatchFaces(const Uint32 patch, const Uint32 face);
 
+	// A whole cubemap's worth of colours, the six faces one after another.
+	// The face jobs each fill in a few rows of it.
+	class STextureCubeBuffer : public RefCounted {
+	public:
+		explicit STextureCubeBuffer(const Sint32 uvDims_);
+
+		inline Sint32 UVDims() const { return uvDims; }
+		inline Color *Face(const Sint32 face) const { return colors.get() + face * uvDims * uvDims; }
+		inline Color *Colors() const { return colors.get(); }
+		size_t NumBytes() const;
+
+	protected:
+		// deliberately prevent copy constructor access
+		STextureCubeBuffer(const STextureCubeBuffer &r) = delete;
+
+		const Sint32 uvDims;
+		std::unique_ptr<Color[]> colors;
+	};
+
 	class STextureFaceRequest {
 	public:
-		STextureFaceRequest(const vector3d *v_, const SystemPath &sysPath_, const Sint32 face_, const Sint32 uvDIMs_, Terrain *pTerrain_);
+		STextureFaceRequest(const vector3d *v_, const SystemPath &sysPath_, const Sint32 face_, const Sint32 rowBegin_, const Sint32 rowEnd_, STextureCubeBuffer *buffer_, Terrain *pTerrain_);
 
 		// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
-		// Use only data local to this object
+		// Use only data local to this object, and only our rows of the buffer
 		void OnRun();
 
 		Sint32 Face() const { return face; }
-		inline Sint32 UVDims() const { return uvDIMs; }
-		Color *Colors() const { return colors; }
+		inline Sint32 UVDims() const { return buffer->UVDims(); }
+		STextureCubeBuffer *Buffer() const { return buffer.Get(); }
 		const SystemPath &SysPath() const { return sysPath; }
 
 	protected:
 		// deliberately prevent copy constructor access
 		STextureFaceRequest(const STextureFaceRequest &r) = delete;
 
-		inline Sint32 NumTexels() const { return uvDIMs * uvDIMs; }
-
 		// in patch surface coords, [0,1]
 		inline vector3d GetSpherePoint(const double x, const double y) const
 		{
 			return (corners[0] + x * (1.0 - y) * (corners[1] - corners[0]) + x * y * (corners[2] - corners[0]) + (1.0 - x) * y * (corners[3] - corners[0])).Normalized();
 		}
 
-		// these are created with the request and are given to the resulting patches
-		Color *colors;
-
 		const vector3d *corners;
 		const SystemPath sysPath;
 		const Sint32 face;
-		const Sint32 uvDIMs;
+		const Sint32 rowBegin;
+		const Sint32 rowEnd;
+		// shared with the other tiles, and kept alive by each of them in case the gas giant gives up on it
+		RefCountedPtr<STextureCubeBuffer> buffer;
 		RefCountedPtr<Terrain> pTerrain;
 	};
 
 	class STextureFaceResult {
 	public:
-		struct STextureFaceData {
-			STextureFaceData() {}
-			STextureFaceData(Color *c_, Sint32 uvDims_) :
-				colors(c_),
-				uvDims(uvDims_) {}
-			Color *colors;
-			Sint32 uvDims;
-		};
-
-		STextureFaceResult(const int32_t face_) :
-			mFace(face_) {}
+		STextureFaceResult(const int32_t face_, STextureCubeBuffer *buffer_) :
+			mFace(face_),
+			mBuffer(buffer_) {}
 
-		void addResult(Color *c_, Sint32 uvDims_)
-		{
-			PROFILE_SCOPED()
-			mData = STextureFaceData(c_, uvDims_);
-		}
-
-		inline const STextureFaceData &data() const { return mData; }
+		inline STextureCubeBuffer *buffer() const { return mBuffer.Get(); }
 		inline int32_t face() const { return mFace; }
 
 		void OnCancel()
 		{
-			if (mData.colors) {
-				delete[] mData.colors;
-				mData.colors = NULL;
-			}
+			mBuffer.Reset();
 		}
 
 	protected:
@@ -115,7 +118,7 @@ namespace GasGiantJobs {
 		STextureFaceResult(const STextureFaceResult &r) = delete;
 
 		const int32_t mFace;
-		STextureFaceData mData;
+		RefCountedPtr<STextureCubeBuffer> mBuffer;
 	};
 
 	// ********************************************************************************
@@ -142,6 +145,48 @@ namespace GasGiantJobs {
 		STextureFaceResult *mpResults;
 	};
 
+	// ********************************************************************************
+	// Reads a finished cubemap back from the disk cache into the buffer
+	// ********************************************************************************
+	class LoadTextureCacheJob : public Job {
+	public:
+		LoadTextureCacheJob(DiskCache *cache_, const std::string &key_, const SystemPath &sysPath_, STextureCubeBuffer *buffer_);
+
+		virtual void OnRun();
+		virtual void OnFinish();
+		virtual void OnCancel() {}
+
+	private:
+		// deliberately prevent copy constructor access
+		LoadTextureCacheJob(const LoadTextureCacheJob &r) = delete;
+
+		RefCountedPtr<DiskCache> mCache;
+		const std::string mKey;
+		const SystemPath mSysPath;
+		RefCountedPtr<STextureCubeBuffer> mBuffer;
+		bool mFound;
+	};
+
+	// ********************************************************************************
+	// Writes a finished cubemap to the disk cache
+	// ********************************************************************************
+	class StoreTextureCacheJob : public Job {
+	public:
+		StoreTextureCacheJob(DiskCache *cache_, const std::string &key_, STextureCubeBuffer *buffer_);
+
+		virtual void OnRun();
+		virtual void OnFinish() {}
+		virtual void OnCancel() {}
+
+	private:
+		// deliberately prevent copy constructor access
+		StoreTextureCacheJob(const StoreTextureCacheJob &r) = delete;
+
+		RefCountedPtr<DiskCache> mCache;
+		const std::string mKey;
+		RefCountedPtr<STextureCubeBuffer> mBuffer;
+	};
+
 	// ********************************************************************************
 	// a quad with reversed winding
 	class GenFaceQuad {
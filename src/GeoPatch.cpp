@@ -37,12 +37,10 @@ GeoPatch::GeoPatch(const RefCountedPtr<GeoPatchContext> &ctx_, GeoSphere *gs,
 	m_v1(v1_),
 	m_v2(v2_),
 	m_v3(v3_),
-	m_heights(nullptr),
-	m_normals(nullptr),
-	m_colors(nullptr),
 	m_parent(nullptr),
 	m_geosphere(gs),
 	m_depth(depth),
+	m_hasHeightData(false),
 	m_PatchID(ID_),
 	m_HasJobRequest(false)
 {
@@ -70,15 +68,15 @@ GeoPatch::~GeoPatch()
 	for (int i = 0; i < NUM_KIDS; i++) {
 		m_kids[i].reset();
 	}
-	m_heights.reset();
-	m_normals.reset();
-	m_colors.reset();
+	m_data.Reset();
 }
 
 void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 {
 	PROFILE_SCOPED()
-	if (m_needUpdateVBOs) {
+	// root patches have nothing to fall back on so they're always uploaded,
+	// everything else waits for a frame with some of the budget left
+	if (m_needUpdateVBOs && (!m_parent || m_geosphere->HasUploadBudget())) {
 		assert(renderer);
 		m_needUpdateVBOs = false;
 
@@ -93,9 +91,9 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 
 		const Sint32 edgeLen = m_ctx->GetEdgeLen();
 		const double frac = m_ctx->GetFrac();
-		const double *pHts = m_heights.get();
-		const vector3f *pNorm = m_normals.get();
-		const Color3ub *pColr = m_colors.get();
+		const double *pHts = m_data.heights();
+		const vector3f *pNorm = m_data.normals();
+		const Color3ub *pColr = m_data.colors();
 
 		double minh = DBL_MAX;
 
@@ -234,9 +232,8 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 		// use the new vertex buffer and the shared index buffer
 		m_patchMesh.reset(renderer->CreateMeshObject(vtxBuffer, m_ctx->GetIndexBuffer()));
 
-		// Don't need this anymore so throw it away
-		m_normals.reset();
-		m_colors.reset();
+		// Don't need this anymore so give it back to the pool
+		m_data.Reset();
 
 #ifdef DEBUG_BOUNDING_SPHERES
 		RefCountedPtr<Graphics::Material> mat(Pi::renderer->CreateMaterial("unlit", Graphics::MaterialDescriptor(), Graphics::RenderStateDesc()));
@@ -254,14 +251,10 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 
 // the default sphere we do the horizon culling against
 static const SSphere s_sph;
-void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum)
+bool GeoPatch::IsVisible(const vector3d &campos, const Graphics::Frustum &frustum) const
 {
-	PROFILE_SCOPED()
-	// must update the VBOs to calculate the clipRadius...
-	UpdateVBOs(renderer);
-	// ...before doing the furstum culling that relies on it.
 	if (!frustum.TestPoint(m_clipCentroid, m_clipRadius))
-		return; // nothing below this patch is visible
+		return false;
 
 	// only want to horizon cull patches that can actually be over the horizon!
 	const vector3d camDir(campos - m_clipCentroid);
@@ -275,14 +268,32 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 		obj.m_radius = m_clipRadius;
 
 		if (!s_sph.HorizonCulling(campos, obj)) {
-			return; // nothing below this patch is visible
+			return false;
 		}
 	}
+	return true;
+}
+
+void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum)
+{
+	PROFILE_SCOPED()
+	// must update the VBOs to calculate the clipRadius...
+	UpdateVBOs(renderer);
+	// ...before doing the furstum culling that relies on it.
+	if (!IsVisible(campos, frustum))
+		return; // nothing below this patch is visible
+
+	// uploads are budgeted, so keep drawing this patch until all of the kids are ready
+	bool kidsReady = bool(m_kids[0]);
+	for (int i = 0; kidsReady && i < NUM_KIDS; i++) {
+		m_kids[i]->UpdateVBOs(renderer);
+		kidsReady = bool(m_kids[i]->m_patchMesh);
+	}
 
-	if (m_kids[0]) {
+	if (kidsReady) {
 		for (int i = 0; i < NUM_KIDS; i++)
 			m_kids[i]->Render(renderer, campos, modelView, frustum);
-	} else if (m_heights) {
+	} else if (m_patchMesh) {
 		const vector3d relpos = m_clipCentroid - campos;
 		renderer->SetTransform(matrix4x4f(modelView * matrix4x4d::Translation(relpos)));
 
@@ -327,24 +338,12 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 	if (canSplit) {
 		if (!m_kids[0]) {
 			// Test if this patch is visible
-			if (!frustum.TestPoint(m_clipCentroid, m_clipRadius))
+			if (!IsVisible(campos, frustum))
 				return; // nothing below this patch is visible
 
-			// only want to horizon cull patches that can actually be over the horizon!
-			const vector3d camDir(campos - m_clipCentroid);
-			const vector3d camDirNorm(camDir.Normalized());
-			const vector3d cenDir(m_clipCentroid.Normalized());
-			const double dotProd = camDirNorm.Dot(cenDir);
-
-			if (dotProd < 0.25 && (camDir.LengthSqr() > (m_clipRadius * m_clipRadius))) {
-				SSphere obj;
-				obj.m_centre = m_clipCentroid;
-				obj.m_radius = m_clipRadius;
-
-				if (!s_sph.HorizonCulling(campos, obj)) {
-					return; // nothing below this patch is visible
-				}
-			}
+			// this patch is drawn in place of its kids until they're uploaded, so it needs a mesh first
+			if (!m_patchMesh)
+				return;
 
 			// we can see this patch so submit the jobs!
 			assert(!m_HasJobRequest);
@@ -352,10 +351,10 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 
 			SQuadSplitRequest *ssrd = new SQuadSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
 				m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2,
-				m_ctx->GetFrac(), m_geosphere->GetTerrain());
+				m_ctx->GetFrac(), m_geosphere->GetTerrain(), GeoSphere::GetPatchCache(), m_ctx->GetDataPool());
 
-			// add to the GeoSphere to be processed at end of all LODUpdate requests
-			m_geosphere->AddQuadSplitRequest(centroidDist, ssrd, this);
+			// add to the GeoSphere to be scheduled at end of all LODUpdate requests
+			m_geosphere->AddQuadSplitRequest(m_parent ? (m_roughLength / centroidDist) : DBL_MAX, ssrd, this);
 		} else {
 			for (int i = 0; i < NUM_KIDS; i++) {
 				m_kids[i]->LODUpdate(campos, frustum);
@@ -373,13 +372,39 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 	}
 }
 
+bool GeoPatch::UpdateSplitPriority(const vector3d &campos, const Graphics::Frustum &frustum, double &priority) const
+{
+	assert(m_HasJobRequest);
+	// the root patches are always split
+	if (!m_parent) {
+		priority = DBL_MAX;
+		return true;
+	}
+
+	const double centroidDist = (campos - m_centroid).Length();
+	if (centroidDist >= m_roughLength || !IsVisible(campos, frustum))
+		return false;
+
+	// how far inside its split distance the camera is, which is proportional
+	// to how large the patch's error appears on screen
+	priority = m_roughLength / centroidDist;
+	return true;
+}
+
+void GeoPatch::CancelSplitRequest()
+{
+	assert(m_HasJobRequest);
+	assert(!m_job.HasJob());
+	m_HasJobRequest = false;
+}
+
 void GeoPatch::RequestSinglePatch()
 {
-	if (!m_heights) {
+	if (!m_hasHeightData) {
 		assert(!m_HasJobRequest);
 		m_HasJobRequest = true;
 		SSingleSplitRequest *ssrd = new SSingleSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
-			m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2, m_ctx->GetFrac(), m_geosphere->GetTerrain());
+			m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2, m_ctx->GetFrac(), m_geosphere->GetTerrain(), GeoSphere::GetPatchCache(), m_ctx->GetDataPool());
 		m_job = Pi::GetAsyncJobQueue()->Queue(new SinglePatchJob(ssrd));
 	}
 }
@@ -411,10 +436,8 @@ void GeoPatch::ReceiveHeightmaps(SQuadSplitResult *psr)
 		m_kids[0]->m_parent = m_kids[1]->m_parent = m_kids[2]->m_parent = m_kids[3]->m_parent = this;
 
 		for (int i = 0; i < NUM_KIDS; i++) {
-			const SQuadSplitResult::SSplitResultData &data = psr->data(i);
-			m_kids[i]->m_heights.reset(data.heights);
-			m_kids[i]->m_normals.reset(data.normals);
-			m_kids[i]->m_colors.reset(data.colors);
+			m_kids[i]->m_data = std::move(psr->data(i).block);
+			m_kids[i]->m_hasHeightData = true;
 		}
 		for (int i = 0; i < NUM_KIDS; i++) {
 			m_kids[i]->NeedToUpdateVBOs();
@@ -423,18 +446,14 @@ void GeoPatch::ReceiveHeightmaps(SQuadSplitResult *psr)
 	}
 }
 
-void GeoPatch::ReceiveHeightmap(const SSingleSplitResult *psr)
+void GeoPatch::ReceiveHeightmap(SSingleSplitResult *psr)
 {
 	PROFILE_SCOPED()
 	assert(nullptr == m_parent);
 	assert(nullptr != psr);
 	assert(m_HasJobRequest);
-	{
-		const SSingleSplitResult::SSplitResultData &data = psr->data();
-		m_heights.reset(data.heights);
-		m_normals.reset(data.normals);
-		m_colors.reset(data.colors);
-	}
+	m_data = std::move(psr->data().block);
+	m_hasHeightData = true;
 	m_HasJobRequest = false;
 }
 
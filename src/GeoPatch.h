@@ -7,6 +7,7 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchDataPool.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
 #include "RefCounted.h"
@@ -46,7 +47,7 @@ public:
 
 	inline void NeedToUpdateVBOs()
 	{
-		m_needUpdateVBOs = (nullptr != m_heights);
+		m_needUpdateVBOs = bool(m_data);
 	}
 
 	void UpdateVBOs(Graphics::Renderer *renderer);
@@ -82,21 +83,27 @@ public:
 
 	void LODUpdate(const vector3d &campos, const Graphics::Frustum &frustum);
 
+	// for a split request that hasn't been dispatched yet, returns false if the patch
+	// no longer needs splitting and otherwise its current priority (higher is more urgent)
+	bool UpdateSplitPriority(const vector3d &campos, const Graphics::Frustum &frustum, double &priority) const;
+	void CancelSplitRequest();
+
 	void RequestSinglePatch();
 	void ReceiveHeightmaps(SQuadSplitResult *psr);
-	void ReceiveHeightmap(const SSingleSplitResult *psr);
+	void ReceiveHeightmap(SSingleSplitResult *psr);
 	void ReceiveJobHandle(Job::Handle job);
 
-	inline bool HasHeightData() const { return (m_heights.get() != nullptr); }
+	inline bool HasHeightData() const { return m_hasHeightData; }
 
 private:
 	static const int NUM_KIDS = 4;
 
+	bool IsVisible(const vector3d &campos, const Graphics::Frustum &frustum) const;
+
 	RefCountedPtr<GeoPatchContext> m_ctx;
 	const vector3d m_v0, m_v1, m_v2, m_v3;
-	std::unique_ptr<double[]> m_heights;
-	std::unique_ptr<vector3f[]> m_normals;
-	std::unique_ptr<Color3ub[]> m_colors;
+	// generated heights, normals and colours, only held until they're uploaded
+	GeoPatchDataPool::Block m_data;
 	std::unique_ptr<Graphics::MeshObject> m_patchMesh;
 	std::unique_ptr<GeoPatch> m_kids[NUM_KIDS];
 	GeoPatch *m_parent;
@@ -106,6 +113,7 @@ private:
 	double m_clipRadius;
 	Sint32 m_depth;
 	bool m_needUpdateVBOs;
+	bool m_hasHeightData;
 
 	const GeoPatchID m_PatchID;
 	Job::Handle m_job;
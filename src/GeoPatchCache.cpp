@@ -0,0 +1,112 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchCache.h"
+
+#include "GeoPatchJobs.h"
+#include "profiler/Profiler.h"
+
+#include <cstring>
+
+static const std::string CACHE_DIR("geopatch_cache");
+static const Uint32 CACHE_MAGIC = 0x48435047; // 'GPCH'
+
+// fast preset, this is on the patch generation path
+static const int LZ4_PRESET = 0;
+
+template <typename T>
+static void append(std::string &out, const T &value)
+{
+	out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+GeoPatchCache::GeoPatchCache(size_t byteBudget) :
+	m_cache(CACHE_DIR, CACHE_MAGIC, byteBudget)
+{
+}
+
+// The key is the full description of the generated data.
+// Tiles are raw native-endian data, the cache isn't meant to be shared between machines.
+// static
+std::string GeoPatchCache::MakeKey(const SBaseRequest &req, const int numTiles)
+{
+	std::string key;
+	append(key, GENERATOR_VERSION);
+	append(key, req.sysPath.sectorX);
+	append(key, req.sysPath.sectorY);
+	append(key, req.sysPath.sectorZ);
+	append(key, req.sysPath.systemIndex);
+	append(key, req.sysPath.bodyIndex);
+	append(key, req.patchID.GetID());
+	append(key, req.depth);
+	append(key, req.edgeLen);
+	append(key, req.fracStep);
+	append(key, numTiles);
+	append(key, req.pTerrain->GetSeed());
+	append(key, req.pTerrain->GetParamsHash());
+	append(key, req.pTerrain->GetMaxHeight());
+	key.append(req.pTerrain->GetHeightFractalName());
+	key.push_back('\0');
+	key.append(req.pTerrain->GetColorFractalName());
+	key.push_back('\0');
+	return key;
+}
+
+bool GeoPatchCache::Load(const SSingleSplitRequest &req)
+{
+	return LoadTiles(req, 1, &req.heights, &req.normals, &req.colors);
+}
+
+bool GeoPatchCache::Load(const SQuadSplitRequest &req)
+{
+	return LoadTiles(req, 4, req.heights, req.normals, req.colors);
+}
+
+void GeoPatchCache::Store(const SSingleSplitRequest &req)
+{
+	StoreTiles(req, 1, &req.heights, &req.normals, &req.colors);
+}
+
+void GeoPatchCache::Store(const SQuadSplitRequest &req)
+{
+	StoreTiles(req, 4, req.heights, req.normals, req.colors);
+}
+
+bool GeoPatchCache::LoadTiles(const SBaseRequest &req, const int numTiles, double *const *heights, vector3f *const *normals, Color3ub *const *colors)
+{
+	PROFILE_SCOPED()
+	std::string data;
+	if (!m_cache.Load(MakeKey(req, numTiles), data))
+		return false;
+
+	const size_t numVerts = req.NUMVERTICES(req.edgeLen);
+	const size_t tileSize = numVerts * (sizeof(double) + sizeof(vector3f) + sizeof(Color3ub));
+	if (data.size() != tileSize * numTiles)
+		return false;
+
+	const char *src = data.data();
+	for (int i = 0; i < numTiles; i++) {
+		memcpy(heights[i], src, numVerts * sizeof(double));
+		src += numVerts * sizeof(double);
+		memcpy(normals[i], src, numVerts * sizeof(vector3f));
+		src += numVerts * sizeof(vector3f);
+		memcpy(colors[i], src, numVerts * sizeof(Color3ub));
+		src += numVerts * sizeof(Color3ub);
+	}
+	return true;
+}
+
+void GeoPatchCache::StoreTiles(const SBaseRequest &req, const int numTiles, const double *const *heights, const vector3f *const *normals, const Color3ub *const *colors)
+{
+	PROFILE_SCOPED()
+	const size_t numVerts = req.NUMVERTICES(req.edgeLen);
+	std::string data;
+	data.reserve(numTiles * numVerts * (sizeof(double) + sizeof(vector3f) + sizeof(Color3ub)));
+	for (int i = 0; i < numTiles; i++) {
+		data.append(reinterpret_cast<const char *>(heights[i]), numVerts * sizeof(double));
+		data.append(reinterpret_cast<const char *>(normals[i]), numVerts * sizeof(vector3f));
+		data.append(reinterpret_cast<const char *>(colors[i]), numVerts * sizeof(Color3ub));
+	}
+
+	m_cache.Store(MakeKey(req, numTiles), data, LZ4_PRESET);
+}
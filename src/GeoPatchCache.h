@@ -0,0 +1,52 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHCACHE_H
+#define _GEOPATCHCACHE_H
+
+#include <SDL_stdinc.h>
+
+#include "Color.h"
+#include "DiskCache.h"
+#include "RefCounted.h"
+#include "vector3.h"
+
+#include <string>
+
+class SBaseRequest;
+class SQuadSplitRequest;
+class SSingleSplitRequest;
+
+// Persistent on-disk cache of generated patch heights, normals and colours.
+//
+// Each job result is stored as one entry in a DiskCache under the user's data
+// directory, keyed by everything that went into generating it (body, patch,
+// detail level and terrain generator version).
+//
+// Load and Store are called from the patch jobs so they MUST BE THREAD SAFE!
+class GeoPatchCache : public RefCounted {
+public:
+	// bump this whenever the terrain fractals or patch generation change their output
+	static const Uint32 GENERATOR_VERSION = 1;
+
+	explicit GeoPatchCache(size_t byteBudget);
+
+	// on a hit the request's heights, normals and colours are filled in and true is returned
+	bool Load(const SSingleSplitRequest &req);
+	bool Load(const SQuadSplitRequest &req);
+
+	void Store(const SSingleSplitRequest &req);
+	void Store(const SQuadSplitRequest &req);
+
+	size_t GetTotalSize() const { return m_cache.GetTotalSize(); }
+
+private:
+	static std::string MakeKey(const SBaseRequest &req, const int numTiles);
+
+	bool LoadTiles(const SBaseRequest &req, const int numTiles, double *const *heights, vector3f *const *normals, Color3ub *const *colors);
+	void StoreTiles(const SBaseRequest &req, const int numTiles, const double *const *heights, const vector3f *const *normals, const Color3ub *const *colors);
+
+	DiskCache m_cache;
+};
+
+#endif /* _GEOPATCHCACHE_H */
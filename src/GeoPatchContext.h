@@ -7,6 +7,7 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchDataPool.h"
 #include "graphics/VertexBuffer.h"
 #include "vector3.h"
 
@@ -24,7 +25,8 @@ public:
 		vector2f uv;
 	};
 
-	GeoPatchContext(const int _edgeLen)
+	GeoPatchContext(const int _edgeLen) :
+		m_dataPool(new GeoPatchDataPool(_edgeLen * _edgeLen)) // the generated data has no skirt
 	{
 		m_edgeLen = _edgeLen + 2; // +2 for the skirt
 		Init();
@@ -45,6 +47,9 @@ public:
 	static inline int GetNumTris() { return m_numTris; }
 	static inline double GetFrac() { return m_frac; }
 
+	// storage for the heights, normals and colours generated for each patch
+	inline GeoPatchDataPool *GetDataPool() const { return m_dataPool.Get(); }
+
 private:
 	static int m_edgeLen;
 	static int m_numTris;
@@ -58,6 +63,8 @@ private:
 	static inline int IDX_VBO_LO_OFFSET(const int i) { return i * sizeof(Uint32) * 3 * (m_edgeLen / 2); }
 	static inline int IDX_VBO_HI_OFFSET(const int i) { return (i * sizeof(Uint32) * VBO_COUNT_HI_EDGE()) + IDX_VBO_LO_OFFSET(4); }
 
+	RefCountedPtr<GeoPatchDataPool> m_dataPool;
+
 	static RefCountedPtr<Graphics::IndexBuffer> m_indices;
 	static int m_prevEdgeLen;
 
@@ -0,0 +1,80 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchDataPool.h"
+
+#include <algorithm>
+
+// keep every block, and so every array within it, 16 byte aligned
+static inline size_t AlignBlock(const size_t size)
+{
+	return (size + 15) & ~size_t(15);
+}
+
+GeoPatchDataPool::GeoPatchDataPool(const int numVerts) :
+	m_numVerts(numVerts),
+	m_normalsOffset(AlignBlock(numVerts * sizeof(double))),
+	m_colorsOffset(m_normalsOffset + AlignBlock(numVerts * sizeof(vector3f))),
+	m_blockSize(m_colorsOffset + AlignBlock(numVerts * sizeof(Color3ub))),
+	m_numInUse(0),
+	m_peakInUse(0)
+{
+}
+
+GeoPatchDataPool::Block GeoPatchDataPool::Allocate()
+{
+	Block block;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_freeBlocks.empty()) {
+			char *slab = new char[m_blockSize * BLOCKS_PER_SLAB];
+			m_slabs.emplace_back(slab);
+			// hand them out from the start of the slab
+			for (size_t i = BLOCKS_PER_SLAB; i > 0; i--)
+				m_freeBlocks.push_back(slab + (i - 1) * m_blockSize);
+		}
+		block.m_data = m_freeBlocks.back();
+		m_freeBlocks.pop_back();
+
+		m_numInUse++;
+		m_peakInUse = std::max(m_peakInUse, m_numInUse);
+	}
+	block.m_pool.Reset(this);
+	return block;
+}
+
+void GeoPatchDataPool::Free(char *data)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	assert(m_numInUse > 0);
+	m_freeBlocks.push_back(data);
+	m_numInUse--;
+}
+
+Uint32 GeoPatchDataPool::GetNumBlocksInUse() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_numInUse;
+}
+
+Uint32 GeoPatchDataPool::GetPeakBlocksInUse() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_peakInUse;
+}
+
+size_t GeoPatchDataPool::GetReservedSize() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_slabs.size() * m_blockSize * BLOCKS_PER_SLAB;
+}
+
+void GeoPatchDataPool::Block::Reset()
+{
+	if (m_data) {
+		m_pool->Free(m_data);
+		m_data = nullptr;
+	}
+	// must come last, this may be the final reference to the pool
+	m_pool.Reset();
+}
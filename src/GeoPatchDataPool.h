@@ -0,0 +1,95 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHDATAPOOL_H
+#define _GEOPATCHDATAPOOL_H
+
+#include <SDL_stdinc.h>
+
+#include "Color.h"
+#include "RefCounted.h"
+#include "vector3.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fixed size block allocator for the heights, normals and colours of a patch.
+//
+// Patches are split and merged constantly while flying around a planet, so rather
+// than three heap allocations per patch each one gets a single block carved out of
+// a larger slab, and the block is recycled when the patch is merged or uploaded.
+// Slabs are only released when the pool itself is destroyed (on detail change).
+//
+// Allocate and free are thread safe, blocks can be released from the job threads.
+class GeoPatchDataPool : public RefCounted {
+public:
+	// One patch worth of data in a single allocation.
+	// Move only, the memory goes back to the pool when it is destroyed or Reset.
+	class Block {
+	public:
+		Block() :
+			m_data(nullptr) {}
+		Block(Block &&other) :
+			m_pool(std::move(other.m_pool)),
+			m_data(other.m_data)
+		{
+			other.m_data = nullptr;
+		}
+		Block &operator=(Block &&other)
+		{
+			if (this != &other) {
+				Reset();
+				m_pool = std::move(other.m_pool);
+				m_data = other.m_data;
+				other.m_data = nullptr;
+			}
+			return *this;
+		}
+		~Block() { Reset(); }
+
+		Block(const Block &) = delete;
+		Block &operator=(const Block &) = delete;
+
+		void Reset();
+		explicit operator bool() const { return m_data != nullptr; }
+
+		double *heights() const { return reinterpret_cast<double *>(m_data); }
+		vector3f *normals() const { return reinterpret_cast<vector3f *>(m_data + m_pool->m_normalsOffset); }
+		Color3ub *colors() const { return reinterpret_cast<Color3ub *>(m_data + m_pool->m_colorsOffset); }
+
+	private:
+		friend class GeoPatchDataPool;
+		RefCountedPtr<GeoPatchDataPool> m_pool;
+		char *m_data;
+	};
+
+	explicit GeoPatchDataPool(const int numVerts);
+
+	Block Allocate();
+
+	int GetNumVertices() const { return m_numVerts; }
+	size_t GetBlockSize() const { return m_blockSize; }
+
+	Uint32 GetNumBlocksInUse() const;
+	Uint32 GetPeakBlocksInUse() const;
+	size_t GetReservedSize() const;
+
+private:
+	void Free(char *data);
+
+	static const size_t BLOCKS_PER_SLAB = 32;
+
+	const int m_numVerts;
+	const size_t m_normalsOffset;
+	const size_t m_colorsOffset;
+	const size_t m_blockSize;
+
+	mutable std::mutex m_lock;
+	std::vector<std::unique_ptr<char[]>> m_slabs;
+	std::vector<char *> m_freeBlocks;
+	Uint32 m_numInUse;
+	Uint32 m_peakInUse;
+};
+
+#endif /* _GEOPATCHDATAPOOL_H */
@@ -21,6 +21,16 @@ inline vector3d GetSpherePoint(const vector3d &v0, const vector3d &v1, const vec
 	return (v0 + x * (1.0 - y) * (v1 - v0) + x * y * (v2 - v0) + (1.0 - x) * y * (v3 - v0)).Normalized();
 }
 
+// Evaluates the heights for a run of unit sphere points in one batch and displaces them
+inline void DisplaceVertices(const Terrain *pTerrain, vector3d *vrts, double *hts, const int numVerts)
+{
+	pTerrain->GetHeights(vrts, hts, numVerts);
+	for (int i = 0; i < numVerts; i++) {
+		assert(hts[i] >= 0.0f && hts[i] <= 1.0f);
+		vrts[i] = vrts[i] * (hts[i] + 1.0);
+	}
+}
+
 // ********************************************************************************
 // Overloaded PureJob class to handle generating the mesh for each patch
 // ********************************************************************************
@@ -30,32 +40,30 @@ void SSingleSplitRequest::GenerateMesh() const
 {
 	PROFILE_SCOPED()
 	const int borderedEdgeLen = edgeLen + (BORDER_SIZE * 2);
-#ifndef NDEBUG
 	const int numBorderedVerts = borderedEdgeLen * borderedEdgeLen;
-#endif
 
 	// generate heights plus a 1 unit border
-	double *bhts = borderHeights.get();
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
 		const double yfrac = double(y) * fracStep;
 		for (int x = -BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			const double xfrac = double(x) * fracStep;
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
-			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
 		}
 	}
-	assert(bhts == &borderHeights.get()[numBorderedVerts]);
+	assert(vrts == &borderVertexs.get()[numBorderedVerts]);
+	DisplaceVertices(pTerrain.Get(), borderVertexs.get(), borderHeights.get(), numBorderedVerts);
 
 	// Generate normals & colors for non-edge vertices since they never change
+	std::unique_ptr<vector3d[]> rowPoints(new vector3d[edgeLen * 3]);
+	vector3d *rowNormals = &rowPoints[edgeLen];
+	vector3d *rowColors = &rowPoints[edgeLen * 2];
 	Color3ub *col = colors;
 	vector3f *nrm = normals;
 	double *hts = heights;
 	vrts = borderVertexs.get();
 	for (int y = BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
+		double *rowHeights = hts;
 		for (int x = BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			// height
 			const double height = borderHeights[x + y * borderedEdgeLen];
@@ -71,11 +79,16 @@ void SSingleSplitRequest::GenerateMesh() const
 			assert(nrm != &normals[edgeLen * edgeLen]);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
+			// color inputs
+			rowPoints[x - BORDER_SIZE] = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
+			rowNormals[x - BORDER_SIZE] = n;
+		}
+
+		// color
+		pTerrain->GetColors(rowPoints.get(), rowHeights, rowNormals, rowColors, edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
 			assert(col != &colors[edgeLen * edgeLen]);
-			++col;
+			setColour(*(col++), rowColors[x]);
 		}
 	}
 	assert(hts == &heights[edgeLen * edgeLen]);
@@ -100,12 +113,17 @@ void SinglePatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 
 	const SSingleSplitRequest &srd = *mData;
 
-	// fill out the data
-	mData->GenerateMesh();
+	// fill out the data, from the patch cache if we've generated it before
+	GeoPatchCache *cache = srd.pCache.Get();
+	if (!cache || !cache->Load(srd)) {
+		mData->GenerateMesh();
+		if (cache)
+			cache->Store(srd);
+	}
 
 	// add this patches data
 	SSingleSplitResult *sr = new SSingleSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
-	sr->addResult(srd.heights, srd.normals, srd.colors,
+	sr->addResult(std::move(mData->block),
 		srd.v0, srd.v1, srd.v2, srd.v3,
 		srd.patchID.NextPatchID(srd.depth + 1, 0));
 	// store the result
@@ -138,7 +156,11 @@ void QuadPatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 
 	const SQuadSplitRequest &srd = *mData;
 
-	mData->GenerateBorderedData();
+	// all four sub-patches are cached together
+	GeoPatchCache *cache = srd.pCache.Get();
+	const bool cached = cache && cache->Load(srd);
+	if (!cached)
+		mData->GenerateBorderedData();
 
 	const vector3d v01 = (srd.v0 + srd.v1).Normalized();
 	const vector3d v12 = (srd.v1 + srd.v2).Normalized();
@@ -163,16 +185,20 @@ void QuadPatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	SQuadSplitResult *sr = new SQuadSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
 	for (int i = 0; i < 4; i++) {
 		// fill out the data
-		mData->GenerateSubPatchData(i,
-			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
-			srd.edgeLen, offxy[i][0], offxy[i][1],
-			borderedEdgeLen);
+		if (!cached) {
+			mData->GenerateSubPatchData(i,
+				vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
+				srd.edgeLen, offxy[i][0], offxy[i][1],
+				borderedEdgeLen);
+		}
 
 		// add this patches data
-		sr->addResult(i, srd.heights[i], srd.normals[i], srd.colors[i],
+		sr->addResult(i, std::move(mData->blocks[i]),
 			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
 			srd.patchID.NextPatchID(srd.depth + 1, i));
 	}
+	if (!cached && cache)
+		cache->Store(srd);
 	mpResults = sr;
 }
 
@@ -190,25 +216,19 @@ void SQuadSplitRequest::GenerateBorderedData() const
 {
 	PROFILE_SCOPED()
 	const int borderedEdgeLen = (edgeLen * 2) + (BORDER_SIZE * 2) - 1;
-#ifndef NDEBUG
 	const int numBorderedVerts = borderedEdgeLen * borderedEdgeLen;
-#endif
 
 	// generate heights plus a N=BORDER_SIZE unit border
-	double *bhts = borderHeights.get();
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < (borderedEdgeLen - BORDER_SIZE); y++) {
 		const double yfrac = double(y) * (fracStep * 0.5);
 		for (int x = -BORDER_SIZE; x < (borderedEdgeLen - BORDER_SIZE); x++) {
 			const double xfrac = double(x) * (fracStep * 0.5);
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
-			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
 		}
 	}
-	assert(bhts == &borderHeights[numBorderedVerts]);
+	assert(vrts == &borderVertexs[numBorderedVerts]);
+	DisplaceVertices(pTerrain.Get(), borderVertexs.get(), borderHeights.get(), numBorderedVerts);
 }
 
 void SQuadSplitRequest::GenerateSubPatchData(
@@ -224,6 +244,9 @@ void SQuadSplitRequest::GenerateSubPatchData(
 {
 	PROFILE_SCOPED()
 	// Generate normals & colors for vertices
+	std::unique_ptr<vector3d[]> rowPoints(new vector3d[edgeLen * 3]);
+	vector3d *rowNormals = &rowPoints[edgeLen];
+	vector3d *rowColors = &rowPoints[edgeLen * 2];
 	vector3d *vrts = borderVertexs.get();
 	Color3ub *col = colors[quadrantIndex];
 	vector3f *nrm = normals[quadrantIndex];
@@ -232,6 +255,7 @@ void SQuadSplitRequest::GenerateSubPatchData(
 	// step over the small square
 	for (int y = 0; y < edgeLen; y++) {
 		const int by = (y + BORDER_SIZE) + yoff;
+		double *rowHeights = hts;
 		for (int x = 0; x < edgeLen; x++) {
 			const int bx = (x + BORDER_SIZE) + xoff;
 
@@ -249,11 +273,16 @@ void SQuadSplitRequest::GenerateSubPatchData(
 			assert(nrm != &normals[quadrantIndex][edgeLen * edgeLen]);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
+			// color inputs
+			rowPoints[x] = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
+			rowNormals[x] = n;
+		}
+
+		// color
+		pTerrain->GetColors(rowPoints.get(), rowHeights, rowNormals, rowColors, edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
 			assert(col != &colors[quadrantIndex][edgeLen * edgeLen]);
-			++col;
+			setColour(*(col++), rowColors[x]);
 		}
 	}
 	assert(hts == &heights[quadrantIndex][edgeLen * edgeLen]);
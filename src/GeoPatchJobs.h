@@ -7,6 +7,8 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchCache.h"
+#include "GeoPatchDataPool.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
 #include "vector3.h"
@@ -20,7 +22,7 @@ class SBaseRequest {
 public:
 	SBaseRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
+		Terrain *pTerrain_, GeoPatchCache *pCache_) :
 		v0(v0_),
 		v1(v1_),
 		v2(v2_),
@@ -31,7 +33,8 @@ public:
 		patchID(patchID_),
 		edgeLen(edgeLen_),
 		fracStep(fracStep_),
-		pTerrain(pTerrain_)
+		pTerrain(pTerrain_),
+		pCache(pCache_)
 	{
 	}
 
@@ -45,6 +48,7 @@ public:
 	const int edgeLen;
 	const double fracStep;
 	RefCountedPtr<Terrain> pTerrain;
+	RefCountedPtr<GeoPatchCache> pCache; // may be null if the cache is disabled
 
 protected:
 	// deliberately prevent copy constructor access
@@ -55,14 +59,15 @@ class SQuadSplitRequest : public SBaseRequest {
 public:
 	SQuadSplitRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
-		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
+		Terrain *pTerrain_, GeoPatchCache *pCache_, GeoPatchDataPool *pPool_) :
+		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_, pCache_)
 	{
-		const int numVerts = NUMVERTICES(edgeLen_);
+		assert(pPool_->GetNumVertices() == NUMVERTICES(edgeLen_));
 		for (int i = 0; i < 4; ++i) {
-			heights[i] = new double[numVerts];
-			normals[i] = new vector3f[numVerts];
-			colors[i] = new Color3ub[numVerts];
+			blocks[i] = pPool_->Allocate();
+			heights[i] = blocks[i].heights();
+			normals[i] = blocks[i].normals();
+			colors[i] = blocks[i].colors();
 		}
 		const int numBorderedVerts = NUMVERTICES((edgeLen_ * 2) + (BORDER_SIZE * 2) - 1);
 		borderHeights.reset(new double[numBorderedVerts]);
@@ -77,6 +82,7 @@ public:
 		const int edgeLen, const int xoff, const int yoff, const int borderedEdgeLen) const;
 
 	// these are created with the request and are given to the resulting patches
+	GeoPatchDataPool::Block blocks[4];
 	vector3f *normals[4];
 	Color3ub *colors[4];
 	double *heights[4];
@@ -94,13 +100,14 @@ class SSingleSplitRequest : public SBaseRequest {
 public:
 	SSingleSplitRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
-		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
+		Terrain *pTerrain_, GeoPatchCache *pCache_, GeoPatchDataPool *pPool_) :
+		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_, pCache_)
 	{
-		const int numVerts = NUMVERTICES(edgeLen_);
-		heights = new double[numVerts];
-		normals = new vector3f[numVerts];
-		colors = new Color3ub[numVerts];
+		assert(pPool_->GetNumVertices() == NUMVERTICES(edgeLen_));
+		block = pPool_->Allocate();
+		heights = block.heights();
+		normals = block.normals();
+		colors = block.colors();
 
 		const int numBorderedVerts = NUMVERTICES(edgeLen_ + (BORDER_SIZE * 2));
 		borderHeights.reset(new double[numBorderedVerts]);
@@ -111,6 +118,7 @@ public:
 	void GenerateMesh() const;
 
 	// these are created with the request and are given to the resulting patches
+	GeoPatchDataPool::Block block;
 	vector3f *normals;
 	Color3ub *colors;
 	double *heights;
@@ -129,10 +137,8 @@ public:
 	struct SSplitResultData {
 		SSplitResultData() :
 			patchID(0) {}
-		SSplitResultData(double *heights_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
-			heights(heights_),
-			normals(n_),
-			colors(c_),
+		SSplitResultData(GeoPatchDataPool::Block &&block_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
+			block(std::move(block_)),
 			v0(v0_),
 			v1(v1_),
 			v2(v2_),
@@ -140,9 +146,8 @@ public:
 			patchID(patchID_)
 		{}
 
-		double *heights;
-		vector3f *normals;
-		Color3ub *colors;
+		// the heights, normals and colours
+		GeoPatchDataPool::Block block;
 		vector3d v0, v1, v2, v3;
 		GeoPatchID patchID;
 	};
@@ -176,29 +181,19 @@ public:
 	{
 	}
 
-	void addResult(const int kidIdx, double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(const int kidIdx, GeoPatchDataPool::Block &&block_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
 		assert(kidIdx >= 0 && kidIdx < NUM_RESULT_DATA);
-		mData[kidIdx] = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData[kidIdx] = (SSplitResultData(std::move(block_), v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data(const int32_t idx) const { return mData[idx]; }
+	inline SSplitResultData &data(const int32_t idx) { return mData[idx]; }
 
 	virtual void OnCancel()
 	{
 		for (int i = 0; i < NUM_RESULT_DATA; ++i) {
-			if (mData[i].heights) {
-				delete[] mData[i].heights;
-				mData[i].heights = NULL;
-			}
-			if (mData[i].normals) {
-				delete[] mData[i].normals;
-				mData[i].normals = NULL;
-			}
-			if (mData[i].colors) {
-				delete[] mData[i].colors;
-				mData[i].colors = NULL;
-			}
+			mData[i].block.Reset();
 		}
 	}
 
@@ -217,29 +212,17 @@ public:
 	{
 	}
 
-	void addResult(double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(GeoPatchDataPool::Block &&block_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
-		mData = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData = (SSplitResultData(std::move(block_), v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data() const { return mData; }
+	inline SSplitResultData &data() { return mData; }
 
 	virtual void OnCancel()
 	{
-		{
-			if (mData.heights) {
-				delete[] mData.heights;
-				mData.heights = NULL;
-			}
-			if (mData.normals) {
-				delete[] mData.normals;
-				mData.normals = NULL;
-			}
-			if (mData.colors) {
-				delete[] mData.colors;
-				mData.colors = NULL;
-			}
-		}
+		mData.block.Reset();
 	}
 
 protected:
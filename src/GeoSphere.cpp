@@ -5,10 +5,12 @@
 
 #include "GameConfig.h"
 #include "GeoPatch.h"
+#include "GeoPatchCache.h"
 #include "GeoPatchContext.h"
 #include "GeoPatchJobs.h"
 #include "Pi.h"
 #include "RefCounted.h"
+#include "core/TaskGraph.h"
 #include "galaxy/AtmosphereParameters.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Frustum.h"
@@ -20,12 +22,14 @@
 #include "graphics/TextureBuilder.h"
 #include "graphics/VertexArray.h"
 #include "perlin.h"
+#include "profiler/Profiler.h"
 #include "utils.h"
 #include "vcacheopt/vcacheopt.h"
 #include <algorithm>
 #include <deque>
 
 RefCountedPtr<GeoPatchContext> GeoSphere::s_patchContext;
+RefCountedPtr<GeoPatchCache> GeoSphere::s_patchCache;
 
 // must be odd numbers
 static const int detail_edgeLen[5] = {
@@ -40,15 +44,29 @@ static const int detail_edgeLen[5] = {
 static const double gs_targetPatchTriLength(100.0);
 static std::vector<GeoSphere *> s_allGeospheres;
 
+// per update/frame time limits for applying split results and uploading vertex buffers,
+// at least one of each is always done so the terrain keeps refining however slow things are
+static const double gs_resultBudgetMs(1.0);
+static const double gs_uploadBudgetMs(2.0);
+static Profiler::Clock s_resultTimer;
+static Profiler::Clock s_uploadTimer;
+
 void GeoSphere::Init()
 {
 	s_patchContext.Reset(new GeoPatchContext(detail_edgeLen[Pi::detail.planets > 4 ? 4 : Pi::detail.planets]));
+
+	// in megabytes, zero disables the cache
+	const int cacheSize = Pi::config->Int("GeoPatchCacheSize");
+	if (cacheSize > 0)
+		s_patchCache.Reset(new GeoPatchCache(size_t(cacheSize) * 1024 * 1024));
 }
 
 void GeoSphere::Uninit()
 {
 	assert(s_patchContext.Unique());
 	s_patchContext.Reset();
+	// any jobs still running hold their own reference
+	s_patchCache.Reset();
 }
 
 static void print_info(const SystemBody *sbody, const Terrain *terrain)
@@ -65,9 +83,16 @@ static void print_info(const SystemBody *sbody, const Terrain *terrain)
 void GeoSphere::UpdateAllGeoSpheres()
 {
 	PROFILE_SCOPED()
+	s_resultTimer.SoftReset();
 	for (std::vector<GeoSphere *>::iterator i = s_allGeospheres.begin(); i != s_allGeospheres.end(); ++i) {
 		(*i)->Update();
 	}
+
+	const GeoPatchDataPool *pool = s_patchContext->GetDataPool();
+	const Graphics::Stats &stats = Pi::renderer->GetStats();
+	stats.SetStatCount(Graphics::Stats::STAT_NUM_GEOPATCH_BLOCKS, pool->GetNumBlocksInUse());
+	stats.SetStatCount(Graphics::Stats::STAT_PEAK_GEOPATCH_BLOCKS, pool->GetPeakBlocksInUse());
+	stats.SetStatCount(Graphics::Stats::STAT_MEM_GEOPATCH_POOL, Uint32(pool->GetReservedSize()));
 }
 
 // static
@@ -124,6 +149,10 @@ bool GeoSphere::OnAddSingleSplitResult(const SystemPath &path, SSingleSplitResul
 
 void GeoSphere::Reset()
 {
+	CancelQuadSplitRequests();
+	// any jobs still running will find their patches gone
+	m_numSplitJobsInFlight = 0;
+
 	{
 		std::deque<SSingleSplitResult *>::iterator iter = mSingleSplitResults.begin();
 		while (iter != mSingleSplitResults.end()) {
@@ -174,6 +203,7 @@ void GeoSphere::Reset()
 
 GeoSphere::GeoSphere(const SystemBody *body) :
 	BaseSphere(body),
+	m_numSplitJobsInFlight(0),
 	m_hasTempCampos(false),
 	m_tempCampos(0.0),
 	m_tempFrustum(800, 600, 0.5, 1.0, 1000.0),
@@ -191,6 +221,8 @@ GeoSphere::GeoSphere(const SystemBody *body) :
 
 GeoSphere::~GeoSphere()
 {
+	CancelQuadSplitRequests();
+
 	// update thread should not be able to access us now, so we can safely continue to delete
 	assert(std::count(s_allGeospheres.begin(), s_allGeospheres.end(), this) == 1);
 	s_allGeospheres.erase(std::find(s_allGeospheres.begin(), s_allGeospheres.end(), this));
@@ -247,14 +279,21 @@ void GeoSphere::ProcessSplitResults()
 		mSingleSplitResults.clear();
 	}
 
-	// now handle the quad split results
+	// now handle the quad split results, leaving any that don't fit in the budget until next time
 	{
-		std::deque<SQuadSplitResult *>::iterator iter = mQuadSplitResults.begin();
-		while (iter != mQuadSplitResults.end()) {
+		bool first = true;
+		while (!mQuadSplitResults.empty() && (first || s_resultTimer.currentmilliseconds() < gs_resultBudgetMs)) {
+			first = false;
+
 			// finally pass SplitResults
-			SQuadSplitResult *psr = (*iter);
+			SQuadSplitResult *psr = mQuadSplitResults.front();
+			mQuadSplitResults.pop_front();
 			assert(psr);
 
+			// results waiting here still count against the jobs in flight, which keeps this queue bounded
+			if (m_numSplitJobsInFlight > 0)
+				--m_numSplitJobsInFlight;
+
 			const int32_t faceIdx = psr->face();
 			if (m_patches[faceIdx]) {
 				m_patches[faceIdx]->ReceiveHeightmaps(psr);
@@ -264,11 +303,7 @@ void GeoSphere::ProcessSplitResults()
 
 			// tidyup
 			delete psr;
-
-			// Next!
-			++iter;
 		}
-		mQuadSplitResults.clear();
 	}
 }
 
@@ -353,22 +388,52 @@ void GeoSphere::Update()
 	}
 }
 
-void GeoSphere::AddQuadSplitRequest(double dist, SQuadSplitRequest *pReq, GeoPatch *pPatch)
+void GeoSphere::AddQuadSplitRequest(double priority, SQuadSplitRequest *pReq, GeoPatch *pPatch)
 {
-	mQuadSplitRequests.push_back(TDistanceRequest(dist, pReq, pPatch));
+	mQuadSplitRequests.push_back(TSplitRequest(priority, pReq, pPatch));
 }
 
 void GeoSphere::ProcessQuadSplitRequests()
 {
-	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](TDistanceRequest &a, TDistanceRequest &b) { return a.mDistance < b.mDistance; });
+	PROFILE_SCOPED()
+	// drop anything that has left the view or that the camera has moved away from
+	// since it was requested, and reprioritise the rest for where the camera is now
+	auto end = std::remove_if(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [this](TSplitRequest &req) {
+		if (req.mpRequester->UpdateSplitPriority(m_tempCampos, m_tempFrustum, req.mPriority))
+			return false;
+		req.mpRequester->CancelSplitRequest();
+		delete req.mpRequest;
+		return true;
+	});
+	mQuadSplitRequests.erase(end, mQuadSplitRequests.end());
+
+	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](const TSplitRequest &a, const TSplitRequest &b) { return a.mPriority > b.mPriority; });
+
+	// only keep enough jobs queued to keep the workers busy, so that
+	// the most important patches are always the next ones to be generated
+	const uint32_t maxJobsInFlight = Clamp(Pi::GetApp()->GetTaskGraph()->GetNumWorkerThreads() * 2, 4U, MAX_SPLIT_OPERATIONS / 2);
+	while (!mQuadSplitRequests.empty() && m_numSplitJobsInFlight < maxJobsInFlight) {
+		const TSplitRequest &req = mQuadSplitRequests.front();
+		req.mpRequester->ReceiveJobHandle(Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(req.mpRequest)));
+		++m_numSplitJobsInFlight;
+		mQuadSplitRequests.pop_front();
+	}
+}
 
-	for (auto iter : mQuadSplitRequests) {
-		SQuadSplitRequest *ssrd = iter.mpRequest;
-		iter.mpRequester->ReceiveJobHandle(Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(ssrd)));
+void GeoSphere::CancelQuadSplitRequests()
+{
+	for (TSplitRequest &req : mQuadSplitRequests) {
+		req.mpRequester->CancelSplitRequest();
+		delete req.mpRequest;
 	}
 	mQuadSplitRequests.clear();
 }
 
+bool GeoSphere::HasUploadBudget() const
+{
+	return s_uploadTimer.currentmilliseconds() < gs_uploadBudgetMs;
+}
+
 void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView, vector3d campos, const float radius, const std::vector<Camera::Shadow> &shadows)
 {
 	PROFILE_SCOPED()
@@ -435,6 +500,7 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 
 	renderer->SetTransform(matrix4x4f(modelView));
 
+	s_uploadTimer.SoftReset();
 	for (int i = 0; i < NUM_PATCHES; i++) {
 		m_patches[i]->Render(renderer, campos, modelView, frustum);
 	}
@@ -19,6 +19,7 @@ namespace Graphics {
 
 class SystemBody;
 class GeoPatch;
+class GeoPatchCache;
 class GeoPatchContext;
 class SQuadSplitRequest;
 class SQuadSplitResult;
@@ -56,6 +57,8 @@ public:
 	static void OnChangeDetailLevel();
 	static bool OnAddQuadSplitResult(const SystemPath &path, SQuadSplitResult *res);
 	static bool OnAddSingleSplitResult(const SystemPath &path, SSingleSplitResult *res);
+	// null if the on-disk patch cache is disabled
+	static GeoPatchCache *GetPatchCache() { return s_patchCache.Get(); }
 	// in sbody radii
 	virtual double GetMaxFeatureHeight() const override final { return m_terrain->GetMaxHeight(); }
 
@@ -67,7 +70,10 @@ public:
 
 	inline Sint32 GetMaxDepth() const { return m_maxDepth; }
 
-	void AddQuadSplitRequest(double, SQuadSplitRequest *, GeoPatch *);
+	void AddQuadSplitRequest(double priority, SQuadSplitRequest *, GeoPatch *);
+
+	// false once this frame's share of time for uploading patch vertex buffers is used up
+	bool HasUploadBudget() const;
 
 private:
 	void BuildFirstPatches();
@@ -79,16 +85,21 @@ private:
 	void ProcessQuadSplitRequests();
 
 	std::unique_ptr<GeoPatch> m_patches[6];
-	struct TDistanceRequest {
-		TDistanceRequest(double dist, SQuadSplitRequest *pRequest, GeoPatch *pRequester) :
-			mDistance(dist),
+	void CancelQuadSplitRequests();
+
+	struct TSplitRequest {
+		TSplitRequest(double priority, SQuadSplitRequest *pRequest, GeoPatch *pRequester) :
+			mPriority(priority),
 			mpRequest(pRequest),
 			mpRequester(pRequester) {}
-		double mDistance;
+		double mPriority;
 		SQuadSplitRequest *mpRequest;
 		GeoPatch *mpRequester;
 	};
-	std::deque<TDistanceRequest> mQuadSplitRequests;
+	// requests wait here until there's a free job slot, so they can be
+	// reprioritised or dropped every update as the camera moves
+	std::deque<TSplitRequest> mQuadSplitRequests;
+	uint32_t m_numSplitJobsInFlight;
 
 	static const uint32_t MAX_SPLIT_OPERATIONS = 128;
 	std::deque<SQuadSplitResult *> mQuadSplitResults;
@@ -99,6 +110,7 @@ private:
 	Graphics::Frustum m_tempFrustum;
 
 	static RefCountedPtr<GeoPatchContext> s_patchContext;
+	static RefCountedPtr<GeoPatchCache> s_patchCache;
 
 	virtual void SetUpMaterials() override;
 
@@ -94,3 +94,10 @@ void HudTrail::Reset(FrameId newFrame)
 	m_currentFrame = newFrame;
 	m_trailPoints.clear();
 }
+
+void HudTrail::SetBody(Body *b)
+{
+	m_body = b;
+	m_updateTime = 0.f;
+	Reset(b->GetFrame());
+}
@@ -25,6 +25,8 @@ public:
 	void Update(float time);
 	void Render(Graphics::Renderer *r);
 	void Reset(const FrameId newFrame);
+	// start over following another body
+	void SetBody(Body *b);
 
 	void SetColor(const Color &c) { m_color = c; }
 	void SetTransform(const matrix4x4d &t) { m_transform = t; }
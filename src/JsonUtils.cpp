@@ -8,8 +8,14 @@
 #include "JsonUtils.h"
 #include "FileSystem.h"
 #include "base64/base64.hpp"
+#include "core/ChunkFormat.h"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
+#include "core/TaskGraph.h"
+#include "profiler/Profiler.h"
 #include "utils.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 
 extern "C" {
@@ -38,6 +44,73 @@ namespace {
 	static const vector3d zeroVector3d(0.0);
 	static const Quaternionf identityQuaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	static const Quaterniond identityQuaterniond(1.0, 0.0, 0.0, 0.0);
+
+	// calls fn(i) for every i in [0, count), on the task graph if there is one
+	template <typename F>
+	void ForEachParallel(TaskGraph *graph, uint32_t count, F &&fn)
+	{
+		if (!graph || count < 2) {
+			for (uint32_t i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		TaskSet *set = new TaskSet();
+		for (uint32_t i = 0; i < count; i++) {
+			set->AddTaskLambda({ i, i + 1 }, [&fn](TaskRange r) {
+				fn(r.begin);
+			});
+		}
+		// the calling thread works on the set too until it is done
+		TaskSet::Handle handle = graph->QueueTaskSet(set);
+		graph->WaitForTaskSet(handle);
+	}
+
+	Json LoadChunkedSaveFile(const FileSystem::FileData &file, TaskGraph *graph, const std::vector<std::string> *onlySections)
+	{
+		PROFILE_SCOPED()
+		std::vector<chunk::SectionView> sections;
+		try {
+			sections = chunk::ReadSections(file.GetData(), file.GetSize());
+		} catch (chunk::FormatException &e) {
+			Output("error in save file '%s': %s\n", file.GetInfo().GetPath().c_str(), e.what());
+			return nullptr;
+		}
+
+		if (onlySections) {
+			sections.erase(std::remove_if(sections.begin(), sections.end(), [onlySections](const chunk::SectionView &s) {
+				return !s.name.empty() && std::find(onlySections->begin(), onlySections->end(), s.name) == onlySections->end();
+			}),
+				sections.end());
+		}
+
+		std::vector<Json> parsed(sections.size());
+		std::atomic<bool> failed(false);
+		ForEachParallel(graph, sections.size(), [&](uint32_t i) {
+			try {
+				const std::string plain = chunk::DecompressSection(sections[i]);
+				parsed[i] = Json::from_cbor(plain.begin(), plain.end());
+			} catch (chunk::FormatException &) {
+				failed = true;
+			} catch (Json::parse_error &) {
+				failed = true;
+			}
+		});
+		if (failed) {
+			Output("error in save file '%s': corrupt section\n", file.GetInfo().GetPath().c_str());
+			return nullptr;
+		}
+
+		// the unnamed section holds the top level values which didn't get their own
+		Json rootNode = Json::object();
+		for (size_t i = 0; i < sections.size(); i++) {
+			if (sections[i].name.empty())
+				rootNode.update(parsed[i]);
+			else
+				rootNode[std::string(sections[i].name)] = std::move(parsed[i]);
+		}
+		return rootNode;
+	}
 } // namespace
 
 namespace JsonUtils {
@@ -48,7 +121,7 @@ namespace JsonUtils {
 		Json out;
 
 		try {
-			out = Json::parse(std::string(fd->GetData(), fd->GetSize()));
+			out = Json::parse(fd->GetData(), fd->GetData() + fd->GetSize());
 		} catch (Json::parse_error &e) {
 			Output("error in JSON file '%s': %s\n", fd->GetInfo().GetPath().c_str(), e.what());
 			return nullptr;
@@ -75,27 +148,36 @@ namespace JsonUtils {
 		return out;
 	}
 
-	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source)
+	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source, TaskGraph *graph,
+		const std::vector<std::string> *onlySections)
 	{
-		auto file = source.ReadFile(filename);
+		PROFILE_SCOPED()
+		// saves are replaced by renaming over them, so they can be mapped
+		auto file = source.MapFile(filename);
 		if (!file) return nullptr;
-		const auto file_data = std::string(file->GetData(), file->GetSize());
-		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(&file_data[0]);
+		if (chunk::IsChunkFormat(file->GetData(), file->GetSize()))
+			return LoadChunkedSaveFile(*file, graph, onlySections);
+
+		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(file->GetData());
+		const size_t dataSize = file->GetSize();
+		if (!dataSize) return nullptr;
 		try {
+			// older saves are one gzipped document, only copy it if it has to be inflated
 			std::string plain_data;
-			if (gzip::IsGZipFormat(dataPtr, file_data.size())) {
-				plain_data = gzip::DecompressDeflateOrGZip(dataPtr, file_data.size());
-			} else {
-				plain_data = file_data;
+			if (gzip::IsGZipFormat(dataPtr, dataSize)) {
+				plain_data = gzip::DecompressDeflateOrGZip(dataPtr, dataSize);
+				dataPtr = reinterpret_cast<const unsigned char *>(plain_data.data());
 			}
+			const char *begin = reinterpret_cast<const char *>(dataPtr);
+			const char *end = begin + (plain_data.empty() ? dataSize : plain_data.size());
+			if (begin == end) return nullptr;
 
-			Json rootNode;
 			try {
 				// Allow loading files in JSON format as well as CBOR
-				if (plain_data[0] == '{')
-					return Json::parse(plain_data);
+				if (begin[0] == '{')
+					return Json::parse(begin, end);
 				else
-					return Json::from_cbor(plain_data);
+					return Json::from_cbor(begin, end);
 			} catch (Json::parse_error &e) {
 				Output("error in JSON file '%s': %s\n", file->GetInfo().GetPath().c_str(), e.what());
 				return nullptr;
@@ -104,6 +186,42 @@ namespace JsonUtils {
 			return nullptr;
 		}
 	}
+
+	bool WriteJsonSaveFile(FILE *f, const Json &rootNode, TaskGraph *graph)
+	{
+		PROFILE_SCOPED()
+		// every object or array at the top level (space, lua, the views...) gets a section
+		// of its own, the plain values are gathered up in one unnamed section
+		std::vector<std::string> names;
+		Json values = Json::object();
+		for (auto it = rootNode.begin(); it != rootNode.end(); ++it) {
+			if (it->is_structured())
+				names.push_back(it.key());
+			else
+				values[it.key()] = *it;
+		}
+		names.push_back(std::string());
+
+		std::vector<chunk::Section> sections(names.size());
+		std::atomic<bool> failed(false);
+		ForEachParallel(graph, names.size(), [&](uint32_t i) {
+			const Json &value = names[i].empty() ? values : rootNode[names[i]];
+			std::string cbor;
+			{
+				PROFILE_SCOPED_DESC("json.to_cbor");
+				Json::to_cbor(value, cbor);
+			}
+			try {
+				sections[i] = chunk::MakeSection(names[i], cbor);
+			} catch (lz4::CompressionFailedException &) {
+				failed = true;
+			}
+		});
+		if (failed)
+			return false;
+
+		return chunk::WriteSections(f, sections);
+	}
 } // namespace JsonUtils
 
 #define USE_STRING_VERSIONS
@@ -14,11 +14,15 @@
 #include "matrix4x4.h"
 #include "vector3.h"
 
+#include <cstdio>
+
 namespace FileSystem {
 	class FileSource;
 	class FileData;
 } // namespace FileSystem
 
+class TaskGraph;
+
 namespace JsonUtils {
 	// Low-level load JSON from a file descriptor.
 	Json LoadJson(RefCountedPtr<FileSystem::FileData> fd);
@@ -27,8 +31,17 @@ namespace JsonUtils {
 	// Load a JSON file from the game's data sources, optionally applying all
 	// files with the the name <filename>.patch as Json Merge Patch (RFC 7386) files
 	Json LoadJsonDataFile(const std::string &filename, bool with_merge = true);
-	// Loads an optionally-gzipped, optionally-CBOR encoded JSON file from the specified source.
-	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source);
+	// Loads an optionally-gzipped, optionally-CBOR encoded JSON file or a chunked
+	// save file from the specified source.
+	// Given a task graph, the sections of a chunked save are decoded in parallel.
+	// Given a list of sections, only those and the top level values of a chunked
+	// save are decoded; other files are always loaded whole.
+	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source, TaskGraph *graph = nullptr,
+		const std::vector<std::string> *onlySections = nullptr);
+	// Writes a JSON object as a chunked save file, each top level object or array
+	// CBOR encoded and compressed as its own section, in parallel given a task graph.
+	// Returns false if encoding or writing fails.
+	bool WriteJsonSaveFile(FILE *f, const Json &rootNode, TaskGraph *graph = nullptr);
 } // namespace JsonUtils
 
 // To-JSON functions. These are called explicitly, and are passed a reference to the object to fill.
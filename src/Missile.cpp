@@ -157,6 +157,10 @@ void Missile::TimeStepUpdate(const float timeStep)
 	AddRelTorque(m_propulsion->GetActualAngThrust());
 
 	DynamicBody::TimeStepUpdate(timeStep);
+}
+
+void Missile::PostTimeStepUpdate(const float timeStep)
+{
 	m_propulsion->UpdateFuel(timeStep);
 
 	const float MISSILE_DETECTION_RADIUS = 100.0f;
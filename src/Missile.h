@@ -18,6 +18,7 @@ public:
 	virtual ~Missile();
 	void StaticUpdate(const float timeStep) override;
 	void TimeStepUpdate(const float timeStep) override;
+	void PostTimeStepUpdate(const float timeStep) override;
 	virtual bool OnCollision(Body *o, Uint32 flags, double relVel) override;
 	virtual bool OnDamage(Body *attacker, float kgDamage, const CollisionContact &contactData) override;
 	virtual void NotifyRemoved(const Body *const removedBody) override;
@@ -274,18 +274,17 @@ void ModelBody::MoveGeoms(const matrix4x4d &m, const vector3d &p)
 		m_model->GetRoot()->Accept(dcv);
 	}
 
-	for (auto it = m_dynGeoms.begin(); it != m_dynGeoms.end(); ++it) {
-		//combine orient & pos
-		static matrix4x4d s_tempMat;
-		for (unsigned int i = 0; i < 12; i++)
-			s_tempMat[i] = m[i];
-		s_tempMat[12] = p.x;
-		s_tempMat[13] = p.y;
-		s_tempMat[14] = p.z;
-		s_tempMat[15] = m[15];
-
-		(*it)->MoveTo(s_tempMat * (*it)->m_animTransform);
-	}
+	//combine orient & pos; a local, as bodies are integrated on several threads at once
+	matrix4x4d tempMat;
+	for (unsigned int i = 0; i < 12; i++)
+		tempMat[i] = m[i];
+	tempMat[12] = p.x;
+	tempMat[13] = p.y;
+	tempMat[14] = p.z;
+	tempMat[15] = m[15];
+
+	for (auto it = m_dynGeoms.begin(); it != m_dynGeoms.end(); ++it)
+		(*it)->MoveTo(tempMat * (*it)->m_animTransform);
 }
 
 // Calculates the ambiently and directly lit portions of the lighting model taking into account the atmosphere and sun positions at a given location
@@ -3,10 +3,17 @@
 
 #include "ModelCache.h"
 #include "Shields.h"
+#include "profiler/Profiler.h"
+#include "scenegraph/BinaryConverter.h"
+#include "scenegraph/ModelIndex.h"
 #include "scenegraph/SceneGraph.h"
+#include "utils.h"
 
-ModelCache::ModelCache(Graphics::Renderer *r) :
-	m_renderer(r)
+#include <chrono>
+
+ModelCache::ModelCache(Graphics::Renderer *r, JobQueue *queue) :
+	m_renderer(r),
+	m_jobs(queue)
 {
 }
 
@@ -20,6 +27,14 @@ SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 	ModelMap::iterator it = m_models.find(name);
 
 	if (it == m_models.end()) {
+		// wanted before it was built, so don't wait for it
+		auto req = m_requests.find(name);
+		if (req != m_requests.end()) {
+			SceneGraph::Model *m = Complete(req->second.Get());
+			if (!m) throw ModelNotFoundException();
+			return m;
+		}
+
 		try {
 			SceneGraph::Loader loader(m_renderer);
 			SceneGraph::Model *m = loader.LoadModel(name);
@@ -35,8 +50,121 @@ SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 
 void ModelCache::Flush()
 {
+	// jobs still running find their requests done and drop them
+	for (auto &req : m_requests)
+		req.second->m_done = true;
+	m_requests.clear();
+	m_ready.clear();
+
 	for (ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
 		delete it->second;
 	}
 	m_models.clear();
 }
+
+RefCountedPtr<ModelCache::Request> ModelCache::RequestModel(const std::string &name)
+{
+	auto req = m_requests.find(name);
+	if (req != m_requests.end())
+		return req->second;
+
+	RefCountedPtr<Request> request(new Request(name));
+	ModelMap::iterator it = m_models.find(name);
+	if (it != m_models.end()) {
+		request->m_model = it->second;
+		request->m_done = true;
+		return request;
+	}
+	m_requests[name] = request;
+
+	// Only files straight from disk are read ahead; zip sources aren't safe
+	// to read from more than one thread. Anything else is left to the
+	// loader, still a few at a time in Update.
+	SceneGraph::ModelIndex::Entry entry;
+	if (SceneGraph::ModelIndex::Find("models", name, entry) && entry.sgm.Exists() &&
+		dynamic_cast<const FileSystem::FileSourceFS *>(&entry.sgm.GetSource())) {
+		request->m_dir = entry.sgm.GetDir();
+		if (!request->m_dir.empty() && request->m_dir.back() == '/')
+			request->m_dir.pop_back();
+		m_jobs.Order(new LoadJob(this, request, entry.sgm));
+	} else {
+		m_ready.push_back(request);
+	}
+	return request;
+}
+
+void ModelCache::RequestModels(const std::vector<std::string> &names)
+{
+	PROFILE_SCOPED()
+	for (const std::string &name : names)
+		RequestModel(name);
+}
+
+void ModelCache::Update(double budget)
+{
+	PROFILE_SCOPED()
+	const auto start = std::chrono::steady_clock::now();
+	while (!m_ready.empty() && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < budget) {
+		RefCountedPtr<Request> request = m_ready.front();
+		m_ready.pop_front();
+		if (!request->m_done)
+			Complete(request.Get());
+	}
+}
+
+SceneGraph::Model *ModelCache::Complete(Request *request)
+{
+	PROFILE_SCOPED()
+	assert(!request->m_done);
+	SceneGraph::Model *m = nullptr;
+
+	if (!request->m_data.empty()) {
+		SceneGraph::BinaryConverter bc(m_renderer);
+		m = bc.LoadDecompressed(request->m_name, request->m_dir, request->m_data);
+		std::string().swap(request->m_data);
+	}
+
+	// not read ahead (or not yet), or the .sgm is no good
+	if (!m) {
+		try {
+			SceneGraph::Loader loader(m_renderer);
+			m = loader.LoadModel(request->m_name);
+		} catch (SceneGraph::LoadingError &) {
+			Output("ModelCache: could not load requested model %s\n", request->m_name.c_str());
+		}
+	}
+
+	if (m) {
+		Shields::ReparentShieldNodes(m);
+		m_models[request->m_name] = m;
+	}
+	request->m_model = m;
+	request->m_done = true;
+	// the request may be the last reference to itself
+	RefCountedPtr<Request> keep(request);
+	m_requests.erase(request->m_name);
+	return m;
+}
+
+ModelCache::LoadJob::LoadJob(ModelCache *cache, RefCountedPtr<Request> request, const FileSystem::FileInfo &sgm) :
+	m_cache(cache),
+	m_request(request),
+	m_sgm(sgm)
+{
+}
+
+void ModelCache::LoadJob::OnRun()
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<FileSystem::FileData> binfile = m_sgm.Read();
+	if (binfile.Valid() && !SceneGraph::BinaryConverter::Decompress(binfile->AsByteRange(), m_data))
+		m_data.clear();
+}
+
+void ModelCache::LoadJob::OnFinish()
+{
+	if (m_request->m_done)
+		return;
+	m_request->m_data.swap(m_data);
+	m_cache->m_ready.push_back(m_request);
+}
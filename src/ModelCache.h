@@ -6,8 +6,18 @@
 /*
  * This class is a quick thoughtless hack
  * Also it only deals in New Models
+ *
+ * Models can be requested ahead of use. Their files are read and
+ * decompressed on the job threads, and the models built from them a few
+ * at a time in Update (building creates GPU buffers, so it has to be on
+ * the main thread). FindModel on a model still being requested finishes
+ * it straight away.
  */
+#include "FileSystem.h"
+#include "JobQueue.h"
+#include "RefCounted.h"
 #include "libs.h"
+#include <deque>
 #include <stdexcept>
 
 namespace Graphics {
@@ -23,15 +33,68 @@ public:
 		ModelNotFoundException() :
 			std::runtime_error("Could not find model") {}
 	};
-	ModelCache(Graphics::Renderer *);
+
+	class Request : public RefCounted {
+	public:
+		// the model is in the cache (or failed to load)
+		bool IsDone() const { return m_done; }
+		// nullptr until done, or if the model couldn't be loaded
+		SceneGraph::Model *GetModel() const { return m_model; }
+		const std::string &GetName() const { return m_name; }
+
+	private:
+		friend class ModelCache;
+		explicit Request(const std::string &name) :
+			m_name(name),
+			m_model(nullptr),
+			m_done(false) {}
+
+		std::string m_name;
+		std::string m_dir; // where the .sgm is, for its textures
+		std::string m_data; // the decompressed .sgm, if it could be read ahead
+		SceneGraph::Model *m_model;
+		bool m_done;
+	};
+
+	ModelCache(Graphics::Renderer *, JobQueue *);
 	~ModelCache();
 	SceneGraph::Model *FindModel(const std::string &);
 	void Flush();
 
+	// start loading a model in the background, if it isn't already loaded
+	RefCountedPtr<Request> RequestModel(const std::string &name);
+	void RequestModels(const std::vector<std::string> &names);
+	// build requested models that have been read, starting no more once
+	// budget seconds have gone; a model started is always finished, so one
+	// big model can still take longer
+	void Update(double budget);
+
+	bool HasPendingRequests() const { return !m_requests.empty(); }
+
 private:
+	class LoadJob : public Job {
+	public:
+		LoadJob(ModelCache *cache, RefCountedPtr<Request> request, const FileSystem::FileInfo &sgm);
+		virtual void OnRun() override;
+		virtual void OnFinish() override;
+
+	private:
+		ModelCache *m_cache;
+		RefCountedPtr<Request> m_request;
+		FileSystem::FileInfo m_sgm;
+		std::string m_data;
+	};
+
+	// builds, caches and finishes the request, nullptr if it couldn't be loaded
+	SceneGraph::Model *Complete(Request *request);
+
 	typedef std::map<std::string, SceneGraph::Model *> ModelMap;
 	ModelMap m_models;
 	Graphics::Renderer *m_renderer;
+
+	std::map<std::string, RefCountedPtr<Request>> m_requests;
+	std::deque<RefCountedPtr<Request>> m_ready;
+	JobSet m_jobs;
 };
 
 #endif
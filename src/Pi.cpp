@@ -9,7 +9,6 @@
 #include "BodyComponent.h"
 
 #include "BaseSphere.h"
-#include "Beam.h"
 #include "CityOnPlanet.h"
 #include "DeathView.h"
 #include "EnumStrings.h"
@@ -46,6 +45,7 @@
 #include "ObjectViewerView.h"
 #endif
 
+#include "galaxy/Galaxy.h"
 #include "galaxy/GalaxyGenerator.h"
 
 #include "graphics/Renderer.h"
@@ -427,8 +427,7 @@ void Pi::App::Shutdown()
 	// TODO: connect initializers and deinitializers in a single Module interface
 	// Will need to think about dependency injection for e.g. modules which need a
 	// reference to the renderer
-	Projectile::FreeModel();
-	Beam::FreeModel();
+	ProjectileManager::FreeModel();
 	delete Pi::intro;
 	Pi::luaConsole.reset();
 	NavLights::Uninit();
@@ -555,6 +554,8 @@ void StartupScreen::Start()
 	AddStep("Lua::InitModules()", &Lua::InitModules);
 
 	AddStep("GalaxyGenerator::Init()", []() {
+		GalaxyGenerator::SetCacheBudgets(size_t(std::max(0, Pi::config->Int("SectorCacheSize"))) * 1024 * 1024,
+			size_t(std::max(0, Pi::config->Int("StarSystemCacheSize"))) * 1024 * 1024);
 		if (Pi::config->HasEntry("GalaxyGenerator"))
 			GalaxyGenerator::Init(Pi::config->String("GalaxyGenerator"),
 				Pi::config->Int("GalaxyGeneratorVersion", GalaxyGenerator::LAST_VERSION));
@@ -565,7 +566,7 @@ void StartupScreen::Start()
 	AddStep("FaceParts::Init()", &FaceParts::Init);
 
 	AddStep("new ModelCache", []() {
-		Pi::modelCache = new ModelCache(Pi::renderer);
+		Pi::modelCache = new ModelCache(Pi::renderer, Pi::GetAsyncJobQueue());
 	});
 
 	AddStep("Shields::Init", []() {
@@ -593,6 +594,13 @@ void StartupScreen::Start()
 		Pi::planner = new TransferPlanner();
 
 		perfInfoDisplay.reset(new PiGui::PerfInfo());
+
+		// the intro shows every ship the player can buy, read them ahead
+		// while it starts; only now, as building them needs the shields set up
+		std::vector<std::string> names;
+		for (auto i : ShipType::player_ships)
+			names.push_back(ShipType::types[i].modelName);
+		Pi::modelCache->RequestModels(names);
 	});
 }
 
@@ -861,6 +869,10 @@ void Pi::App::PostUpdate()
 {
 	PROFILE_SCOPED()
 
+	// build some of the models read ahead in the background, for up to 4ms
+	if (Pi::modelCache)
+		Pi::modelCache->Update(0.004);
+
 	HandleRequests();
 }
 
@@ -925,6 +937,10 @@ void GameLoop::Update(float deltaTime)
 	Pi::serverAgent->ProcessResponses();
 #endif
 
+	Game::UpdateSaveGame();
+	Pi::game->GetGalaxy()->UpdateCaches();
+	LuaEvent::FlushStats();
+
 	// TODO: is it necessary to limit frame delta to 1/4th second?
 	// Presumably if we're rendering < 4 FPS, we don't care about physics error either
 	// if (Pi::frameTime > 0.25) Pi::frameTime = 0.25;
@@ -1105,9 +1121,14 @@ void GameLoop::End()
 	Pi::luaConsole->CloseTCPDebugConnection();
 #endif
 
+	// any save still being written has to finish before the autosave starts
+	Game::UpdateSaveGame(true);
+
 	// we have to make sure to autosave the game before the end game process starts
 	LuaEvent::Queue("onAutoSaveBeforeGameEnds");
 	LuaEvent::Emit();
+	// the autosave may itself be async, so wait for it too
+	Game::UpdateSaveGame(true);
 
 	// final event
 	LuaEvent::Queue("onGameEnd");
@@ -3,19 +3,22 @@
 
 #include "Projectile.h"
 
+#include "Camera.h"
 #include "CargoBody.h"
 #include "Frame.h"
 #include "Game.h"
 #include "GameSaveError.h"
 #include "Json.h"
+#include "JsonUtils.h"
+#include "ModelBody.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
 #include "Sfx.h"
 #include "Ship.h"
 #include "Space.h"
-#include "collider/CollisionContact.h"
 #include "collider/CollisionSpace.h"
+#include "core/TaskGraph.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
@@ -26,39 +29,17 @@
 #include "lua/LuaEvent.h"
 #include "lua/LuaUtils.h"
 
-std::unique_ptr<Graphics::MeshObject> Projectile::s_sideMesh;
-std::unique_ptr<Graphics::MeshObject> Projectile::s_glowMesh;
-std::unique_ptr<Graphics::Material> Projectile::s_sideMat;
-std::unique_ptr<Graphics::Material> Projectile::s_glowMat;
+namespace {
+	// beams are only there for a flash
+	static const float BEAM_LIFETIME = 0.1f;
 
-void Projectile::BuildModel()
-{
-	//set up materials
-	Graphics::MaterialDescriptor desc;
-	desc.textures = 1;
+	// below this there isn't enough work to be worth the task overhead
+	static const uint32_t MIN_RAYS_PER_TASK = 64;
 
-	Graphics::RenderStateDesc rsd;
-	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
-	rsd.depthWrite = false;
-	rsd.cullMode = Graphics::CULL_NONE;
+	// keeps each draw within one of the renderer's dynamic draw buffers
+	static const uint32_t MAX_BATCH_VERTICES = 32768;
 
-	s_sideMat.reset(Pi::renderer->CreateMaterial("unlit", desc, rsd));
-	s_sideMat->SetTexture("texture0"_hash,
-		Graphics::TextureBuilder::Billboard("textures/projectile_l.dds").GetOrCreateTexture(Pi::renderer, "billboard"));
-	s_glowMat.reset(Pi::renderer->CreateMaterial("unlit", desc, rsd));
-	s_glowMat->SetTexture("texture0"_hash,
-		Graphics::TextureBuilder::Billboard("textures/projectile_w.dds").GetOrCreateTexture(Pi::renderer, "billboard"));
-
-	//zero at projectile position
-	//+x down
-	//+y right
-	//+z forwards (or projectile direction)
-	const float w = 0.5f;
-
-	vector3f one(0.f, -w, 0.f);	  //top left
-	vector3f two(0.f, w, 0.f);	  //top right
-	vector3f three(0.f, w, -1.f); //bottom right
-	vector3f four(0.f, -w, -1.f); //bottom left
+	const Graphics::AttributeSet BATCH_ATTRIBS = Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0;
 
 	//uv coords
 	const vector2f topLeft(0.f, 1.f);
@@ -66,165 +47,188 @@ void Projectile::BuildModel()
 	const vector2f botLeft(0.f, 0.f);
 	const vector2f botRight(1.f, 0.f);
 
-	Graphics::VertexArray sideVerts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-	Graphics::VertexArray glowVerts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
-	//add four intersecting planes to create a volumetric effect
-	for (int i = 0; i < 4; i++) {
-		sideVerts.Add(one, topLeft);
-		sideVerts.Add(two, topRight);
-		sideVerts.Add(three, botRight);
-
-		sideVerts.Add(three, botRight);
-		sideVerts.Add(four, botLeft);
-		sideVerts.Add(one, topLeft);
-
-		one.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
-		two.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
-		three.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
-		four.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+	//zero at projectile position
+	//+x down
+	//+y right
+	//+z forwards (or projectile direction)
+	void AddSidePlanes(Graphics::VertexArray &sideVerts)
+	{
+		const float w = 0.5f;
+
+		vector3f one(0.f, -w, 0.f);	  //top left
+		vector3f two(0.f, w, 0.f);	  //top right
+		vector3f three(0.f, w, -1.f); //bottom right
+		vector3f four(0.f, -w, -1.f); //bottom left
+
+		//add four intersecting planes to create a volumetric effect
+		for (int i = 0; i < 4; i++) {
+			sideVerts.Add(one, topLeft);
+			sideVerts.Add(two, topRight);
+			sideVerts.Add(three, botRight);
+
+			sideVerts.Add(three, botRight);
+			sideVerts.Add(four, botLeft);
+			sideVerts.Add(one, topLeft);
+
+			one.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+			two.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+			three.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+			four.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+		}
 	}
 
 	//create quads for viewing on end
-	float gw = 0.5f;
-	float gz = -0.1f;
+	void AddGlowQuads(Graphics::VertexArray &glowVerts, int count, float gw, float shrink, float gzStep)
+	{
+		float gz = -0.1f;
 
-	for (int i = 0; i < 4; i++) {
-		glowVerts.Add(vector3f(-gw, -gw, gz), topLeft);
-		glowVerts.Add(vector3f(-gw, gw, gz), topRight);
-		glowVerts.Add(vector3f(gw, gw, gz), botRight);
+		for (int i = 0; i < count; i++) {
+			glowVerts.Add(vector3f(-gw, -gw, gz), topLeft);
+			glowVerts.Add(vector3f(-gw, gw, gz), topRight);
+			glowVerts.Add(vector3f(gw, gw, gz), botRight);
 
-		glowVerts.Add(vector3f(gw, gw, gz), botRight);
-		glowVerts.Add(vector3f(gw, -gw, gz), botLeft);
-		glowVerts.Add(vector3f(-gw, -gw, gz), topLeft);
+			glowVerts.Add(vector3f(gw, gw, gz), botRight);
+			glowVerts.Add(vector3f(gw, -gw, gz), botLeft);
+			glowVerts.Add(vector3f(-gw, -gw, gz), topLeft);
 
-		gw -= 0.1f; // they get smaller
-		gz -= 0.2f; // as they move back
+			gw -= shrink;
+			gz -= gzStep; // as they move back
+		}
 	}
+} // namespace
 
-	s_sideMesh.reset(Pi::renderer->CreateMeshObjectFromArray(&sideVerts));
-	s_glowMesh.reset(Pi::renderer->CreateMeshObjectFromArray(&glowVerts));
-}
+std::unique_ptr<Graphics::VertexArray> ProjectileManager::s_sideVerts[KIND_MAX];
+std::unique_ptr<Graphics::VertexArray> ProjectileManager::s_glowVerts[KIND_MAX];
+std::unique_ptr<Graphics::Material> ProjectileManager::s_sideMat[KIND_MAX];
+std::unique_ptr<Graphics::Material> ProjectileManager::s_glowMat;
+std::unique_ptr<Graphics::VertexArray> ProjectileManager::s_sideBatch[KIND_MAX];
+std::unique_ptr<Graphics::VertexArray> ProjectileManager::s_glowBatch;
 
-void Projectile::FreeModel()
+void ProjectileManager::BuildModel()
 {
-	s_sideMat.reset();
-	s_glowMat.reset();
-	s_sideMesh.reset();
-	s_glowMesh.reset();
-}
+	//set up materials
+	Graphics::MaterialDescriptor desc;
+	desc.textures = 1;
+	desc.vertexColors = true;
 
-Projectile::Projectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel) :
-	Body()
-{
-	if (!s_sideMat) BuildModel();
-	m_flags |= FLAG_DRAW_LAST;
-
-	m_parent = parent;
-	m_lifespan = prData.lifespan;
-	m_baseDam = prData.damage;
-	m_length = prData.length;
-	m_width = prData.width;
-	m_mining = prData.mining;
-	m_color = prData.color;
-	m_age = 0;
-
-	SetFrame(parent->GetFrame());
-
-	SetOrient(parent->GetOrient());
-	SetPosition(pos);
-	m_baseVel = baseVel;
-	m_dirVel = dirVel;
-	SetClipRadius(GetRadius());
-	SetPhysRadius(GetRadius());
-}
+	Graphics::RenderStateDesc rsd;
+	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
+	rsd.depthWrite = false;
+	rsd.cullMode = Graphics::CULL_NONE;
 
-Projectile::Projectile(const Json &jsonObj, Space *space) :
-	Body(jsonObj, space)
-{
-	if (!s_sideMat) BuildModel();
+	// the colour of each projectile is in its vertices
+	s_sideMat[KIND_BOLT].reset(Pi::renderer->CreateMaterial("unlit", desc, rsd));
+	s_sideMat[KIND_BOLT]->diffuse = Color::WHITE;
+	s_sideMat[KIND_BOLT]->SetTexture("texture0"_hash,
+		Graphics::TextureBuilder::Billboard("textures/projectile_l.dds").GetOrCreateTexture(Pi::renderer, "billboard"));
+	s_sideMat[KIND_BEAM].reset(Pi::renderer->CreateMaterial("unlit", desc, rsd));
+	s_sideMat[KIND_BEAM]->diffuse = Color::WHITE;
+	s_sideMat[KIND_BEAM]->SetTexture("texture0"_hash,
+		Graphics::TextureBuilder::Billboard("textures/beam_l.dds").GetOrCreateTexture(Pi::renderer, "billboard"));
+	s_glowMat.reset(Pi::renderer->CreateMaterial("unlit", desc, rsd));
+	s_glowMat->diffuse = Color::WHITE;
+	s_glowMat->SetTexture("texture0"_hash,
+		Graphics::TextureBuilder::Billboard("textures/projectile_w.dds").GetOrCreateTexture(Pi::renderer, "billboard"));
 
-	try {
-		Json projectileObj = jsonObj["projectile"];
-
-		m_baseVel = projectileObj["base_vel"];
-		m_dirVel = projectileObj["dir_vel"];
-		m_age = projectileObj["age"];
-		m_lifespan = projectileObj["life_span"];
-		m_baseDam = projectileObj["base_dam"];
-		m_length = projectileObj["length"];
-		m_width = projectileObj["width"];
-		m_mining = projectileObj["mining"];
-		m_color = projectileObj["color"];
-		m_parentIndex = projectileObj["index_for_body"];
-	} catch (Json::type_error &) {
-		throw SavedGameCorruptException();
+	for (int kind = 0; kind < KIND_MAX; kind++) {
+		s_sideVerts[kind].reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, 24));
+		AddSidePlanes(*s_sideVerts[kind]);
+		s_sideBatch[kind].reset(new Graphics::VertexArray(BATCH_ATTRIBS));
 	}
-}
 
-Projectile::~Projectile()
-{
+	// bolts have a few shrinking quads, beams many more along their length
+	s_glowVerts[KIND_BOLT].reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, 24));
+	AddGlowQuads(*s_glowVerts[KIND_BOLT], 4, 0.5f, 0.1f, 0.2f);
+	s_glowVerts[KIND_BEAM].reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, 240));
+	AddGlowQuads(*s_glowVerts[KIND_BEAM], 40, 0.5f, 0.0f, 0.02f);
+	s_glowBatch.reset(new Graphics::VertexArray(BATCH_ATTRIBS));
 }
 
-void Projectile::SaveToJson(Json &jsonObj, Space *space)
+void ProjectileManager::FreeModel()
 {
-	Body::SaveToJson(jsonObj, space);
-
-	Json projectileObj({}); // Create JSON object to contain projectile data.
-
-	projectileObj["base_vel"] = m_baseVel;
-	projectileObj["dir_vel"] = m_dirVel;
-	projectileObj["age"] = m_age;
-	projectileObj["life_span"] = m_lifespan;
-	projectileObj["base_dam"] = m_baseDam;
-	projectileObj["length"] = m_length;
-	projectileObj["width"] = m_width;
-	projectileObj["mining"] = m_mining;
-	projectileObj["color"] = m_color;
-	projectileObj["index_for_body"] = space->GetIndexForBody(m_parent);
-
-	jsonObj["projectile"] = projectileObj; // Add projectile object to supplied object.
+	for (int kind = 0; kind < KIND_MAX; kind++) {
+		s_sideMat[kind].reset();
+		s_sideVerts[kind].reset();
+		s_glowVerts[kind].reset();
+		s_sideBatch[kind].reset();
+	}
+	s_glowMat.reset();
+	s_glowBatch.reset();
 }
 
-void Projectile::PostLoadFixup(Space *space)
+void ProjectileManager::Pool::Add(Body *parentBody, const ProjectileData &prData, const vector3d &position, const vector3d &baseVelocity, const vector3d &direction)
 {
-	Body::PostLoadFixup(space);
-	m_parent = space->GetBodyByIndex(m_parentIndex);
+	parent.push_back(parentBody);
+	pos.push_back(position);
+	baseVel.push_back(baseVelocity);
+	dir.push_back(direction);
+	age.push_back(0.0f);
+	lifespan.push_back(prData.lifespan);
+	damage.push_back(prData.damage);
+	length.push_back(prData.length);
+	width.push_back(prData.width);
+	color.push_back(prData.color);
+	flags.push_back(FLAG_ACTIVE | (prData.mining ? FLAG_MINING : 0));
 }
 
-void Projectile::UpdateInterpTransform(double alpha)
+void ProjectileManager::Pool::Remove(size_t i)
 {
-	m_interpOrient = GetOrient();
-	const vector3d oldPos = GetPosition() - (m_baseVel + m_dirVel) * Pi::game->GetTimeStep();
-	m_interpPos = alpha * GetPosition() + (1.0 - alpha) * oldPos;
+	const size_t last = Size() - 1;
+	if (i != last) {
+		parent[i] = parent[last];
+		pos[i] = pos[last];
+		baseVel[i] = baseVel[last];
+		dir[i] = dir[last];
+		age[i] = age[last];
+		lifespan[i] = lifespan[last];
+		damage[i] = damage[last];
+		length[i] = length[last];
+		width[i] = width[last];
+		color[i] = color[last];
+		flags[i] = flags[last];
+	}
+	parent.pop_back();
+	pos.pop_back();
+	baseVel.pop_back();
+	dir.pop_back();
+	age.pop_back();
+	lifespan.pop_back();
+	damage.pop_back();
+	length.pop_back();
+	width.pop_back();
+	color.pop_back();
+	flags.pop_back();
 }
 
-void Projectile::NotifyRemoved(const Body *const removedBody)
+ProjectileManager *ProjectileManager::AllocProjectilesInFrame(FrameId fId)
 {
-	if (m_parent == removedBody) m_parent = 0;
-}
+	Frame *f = Frame::GetFrame(fId);
 
-void Projectile::TimeStepUpdate(const float timeStep)
-{
-	m_age += timeStep;
-	SetPosition(GetPosition() + (m_baseVel + m_dirVel) * double(timeStep));
-	if (m_age > m_lifespan) Pi::game->GetSpace()->KillBody(this);
+	if (!f->m_projectiles) {
+		f->m_projectiles.reset(new ProjectileManager);
+	}
+
+	return f->m_projectiles.get();
 }
 
-/* In hull kg */
-float Projectile::GetDamage() const
+void ProjectileManager::AddProjectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
 {
-	return m_baseDam * sqrt((m_lifespan - m_age) / m_lifespan);
-	// TEST
-	//	return 0.01f;
+	if (!s_glowMat) BuildModel();
+	ProjectileManager *pm = AllocProjectilesInFrame(parent->GetFrame());
+	pm->m_pools[KIND_BOLT].Add(parent, prData, pos, baseVel, dirVel);
 }
 
-double Projectile::GetRadius() const
+void ProjectileManager::AddBeam(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dir)
 {
-	return sqrt(m_length * m_length + m_width * m_width);
+	if (!s_glowMat) BuildModel();
+	ProjectileData beamData(prData);
+	beamData.lifespan = BEAM_LIFETIME;
+	beamData.width = 1.0f;
+	ProjectileManager *pm = AllocProjectilesInFrame(parent->GetFrame());
+	pm->m_pools[KIND_BEAM].Add(parent, beamData, pos, baseVel, dir);
 }
 
-void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const vector3d &pos)
+static void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const vector3d &pos)
 {
 	lua_State *l = Lua::manager->GetLuaState();
 
@@ -257,122 +261,337 @@ void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const v
 	Pi::game->GetSpace()->AddBody(cargo);
 }
 
-void Projectile::StaticUpdate(const float timeStep)
+void ProjectileManager::TimeStepAll(const float timeStep, FrameId fId)
 {
 	PROFILE_SCOPED()
-	CollisionContact c;
-	// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
-	vector3d vel = m_dirVel * timeStep;
-	Frame *frame = Frame::GetFrame(GetFrame());
-	frame->GetCollisionSpace()->TraceRay(GetPosition(), vel.Normalized(), vel.Length(), &c);
-
-	if (c.userData1) {
-		Body *hit = static_cast<Body *>(c.userData1);
-		if (hit != m_parent) {
-			hit->OnDamage(m_parent, GetDamage(), c);
-			Pi::game->GetSpace()->KillBody(this);
-			if (hit->IsType(ObjectType::SHIP))
-				LuaEvent::Queue("onShipHit", dynamic_cast<Ship *>(hit), dynamic_cast<Body *>(m_parent));
+
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles)
+		f->m_projectiles->TimeStep(timeStep, fId);
+
+	for (FrameId kid : f->GetChildren()) {
+		TimeStepAll(timeStep, kid);
+	}
+}
+
+// Only reads shared state, so the rays are cast in parallel when there are
+// enough of them.
+void ProjectileManager::CastRays(Kind kind, const float timeStep, FrameId fId)
+{
+	PROFILE_SCOPED()
+	Pool &p = m_pools[kind];
+	const uint32_t count = p.Size();
+	p.contacts.assign(count, CollisionContact());
+	p.terrainHeight.assign(count, 0.0);
+
+	Frame *frame = Frame::GetFrame(fId);
+	CollisionSpace *collisionSpace = frame->GetCollisionSpace();
+	const Planet *planet = frame->GetBody() && frame->GetBody()->IsType(ObjectType::PLANET) ? static_cast<const Planet *>(frame->GetBody()) : nullptr;
+
+	auto castRay = [&](uint32_t i) {
+		if (!(p.flags[i] & FLAG_ACTIVE))
+			return;
+
+		const Body *parent = p.parent[i];
+		const Geom *ignore = parent && parent->IsType(ObjectType::MODELBODY) ? static_cast<const ModelBody *>(parent)->GetGeom() : nullptr;
+		if (kind == KIND_BOLT) {
+			// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
+			const vector3d vel = p.dir[i] * double(timeStep);
+			collisionSpace->TraceRay(p.pos[i], vel.Normalized(), vel.Length(), &p.contacts[i], ignore);
+		} else {
+			collisionSpace->TraceRay(p.pos[i], p.dir[i].Normalized(), p.length[i], &p.contacts[i], ignore);
 		}
+
+		// mining lasers can break off chunks of terrain
+		if (planet && (p.flags[i] & FLAG_MINING))
+			p.terrainHeight[i] = planet->GetTerrainHeight(p.pos[i].Normalized());
+	};
+
+	TaskGraph *graph = Pi::GetApp()->GetTaskGraph();
+	const uint32_t numTasks = std::min(graph->GetNumWorkerThreads() + 1, count / MIN_RAYS_PER_TASK);
+	if (numTasks < 2) {
+		for (uint32_t i = 0; i < count; i++)
+			castRay(i);
+		return;
 	}
-	if (m_mining) // mining lasers can break off chunks of terrain
-	{
-		// need to test for terrain hit
-		Planet *const planet = static_cast<Planet *>(frame->GetBody()); // cache the value even for the if statement
-		if (planet && planet->IsType(ObjectType::PLANET)) {
-			vector3d pos = GetPosition();
-			double terrainHeight = planet->GetTerrainHeight(pos.Normalized());
-			if (terrainHeight > pos.Length()) {
-				const SystemBody *b = planet->GetSystemBody();
-				// hit the fucker
-				if (b->GetType() == SystemBody::TYPE_PLANET_ASTEROID) {
-					vector3d n = GetPosition().Normalized();
-					MiningLaserSpawnTastyStuff(planet->GetFrame(), b, n * terrainHeight + 5.0 * n);
-					SfxManager::Add(this, TYPE_EXPLOSION);
+
+	TaskSet *set = new TaskSet();
+	for (uint32_t t = 0; t < numTasks; t++) {
+		const TaskRange range = { count * t / numTasks, count * (t + 1) / numTasks };
+		set->AddTaskLambda(range, [&castRay](TaskRange r) {
+			for (uint32_t i = r.begin; i < r.end; i++)
+				castRay(i);
+		});
+	}
+
+	TaskSet::Handle handle = graph->QueueTaskSet(set);
+	graph->WaitForTaskSet(handle);
+}
+
+void ProjectileManager::TimeStep(const float timeStep, FrameId fId)
+{
+	Frame *frame = Frame::GetFrame(fId);
+	Planet *planet = frame->GetBody() && frame->GetBody()->IsType(ObjectType::PLANET) ? static_cast<Planet *>(frame->GetBody()) : nullptr;
+
+	for (int kind = 0; kind < KIND_MAX; kind++) {
+		Pool &p = m_pools[kind];
+		if (!p.Size())
+			continue;
+
+		CastRays(Kind(kind), timeStep, fId);
+
+		// hits can call into Lua, so are applied in order
+		const size_t numCast = p.contacts.size();
+		for (size_t i = 0; i < numCast; i++) {
+			if (!(p.flags[i] & FLAG_ACTIVE))
+				continue;
+
+			const CollisionContact &c = p.contacts[i];
+			if (c.userData1) {
+				Body *hit = static_cast<Body *>(c.userData1);
+				if (hit != p.parent[i]) {
+					// bolts lose their punch as they age, in hull kg
+					float damage = p.damage[i];
+					if (kind == KIND_BOLT)
+						damage *= sqrt((p.lifespan[i] - p.age[i]) / p.lifespan[i]);
+
+					hit->OnDamage(p.parent[i], damage, c);
+					// a spent beam is still drawn until it fades
+					p.flags[i] &= ~FLAG_ACTIVE;
+					if (hit->IsType(ObjectType::SHIP))
+						LuaEvent::Queue("onShipHit", static_cast<Ship *>(hit), p.parent[i]);
+				}
+			}
+
+			if (planet && (p.flags[i] & FLAG_ACTIVE) && (p.flags[i] & FLAG_MINING)) {
+				const double terrainHeight = p.terrainHeight[i];
+				if (terrainHeight > p.pos[i].Length()) {
+					const SystemBody *b = planet->GetSystemBody();
+					// hit the fucker
+					if (b->GetType() == SystemBody::TYPE_PLANET_ASTEROID) {
+						const vector3d n = p.pos[i].Normalized();
+						MiningLaserSpawnTastyStuff(planet->GetFrame(), b, n * terrainHeight + 5.0 * n);
+						SfxManager::Add(fId, p.pos[i], vector3d(0.0), TYPE_EXPLOSION);
+					}
+					p.flags[i] &= ~FLAG_ACTIVE;
 				}
-				Pi::game->GetSpace()->KillBody(this);
 			}
+
+			if (kind == KIND_BOLT && !(p.flags[i] & FLAG_ACTIVE))
+				p.flags[i] |= FLAG_DEAD;
+		}
+
+		// move them on and drop the spent ones
+		for (size_t i = 0; i < p.Size();) {
+			p.age[i] += timeStep;
+			const vector3d vel = kind == KIND_BOLT ? p.baseVel[i] + p.dir[i] : p.baseVel[i];
+			p.pos[i] += vel * double(timeStep);
+
+			if ((p.flags[i] & FLAG_DEAD) || p.age[i] > p.lifespan[i])
+				p.Remove(i);
+			else
+				i++;
 		}
 	}
 }
 
-void Projectile::Render(Graphics::Renderer *renderer, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform)
+void ProjectileManager::NotifyRemovedAll(const Body *removedBody, FrameId fId)
+{
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles) {
+		for (Pool &p : f->m_projectiles->m_pools) {
+			for (Body *&parent : p.parent)
+				if (parent == removedBody) parent = nullptr;
+		}
+	}
+
+	for (FrameId kid : f->GetChildren()) {
+		NotifyRemovedAll(removedBody, kid);
+	}
+}
+
+void ProjectileManager::RenderAll(Graphics::Renderer *renderer, const Camera *camera, FrameId fId, FrameId camFrameId)
 {
 	PROFILE_SCOPED()
-	vector3d _from = viewTransform * GetInterpPosition();
-	vector3d _to = viewTransform * (GetInterpPosition() + m_dirVel);
-	vector3d _dir = _to - _from;
-	vector3f from(&_from.x);
-	vector3f dir = vector3f(_dir).Normalized();
-
-	vector3f v1, v2;
-	matrix4x4f m = matrix4x4f::Identity();
-	v1.x = dir.y;
-	v1.y = dir.z;
-	v1.z = dir.x;
-	v2 = v1.Cross(dir).Normalized();
+	if (!s_glowMat)
+		return;
+
+	// everything is batched in camera space
+	renderer->SetTransform(matrix4x4f::Identity());
+	BatchAll(renderer, camera, fId, camFrameId);
+
+	for (int kind = 0; kind < KIND_MAX; kind++)
+		FlushBatch(renderer, *s_sideBatch[kind], s_sideMat[kind].get());
+	FlushBatch(renderer, *s_glowBatch, s_glowMat.get());
+}
+
+void ProjectileManager::BatchAll(Graphics::Renderer *renderer, const Camera *camera, FrameId fId, FrameId camFrameId)
+{
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles) {
+		matrix4x4d viewTransform = f->GetInterpOrientRelTo(camFrameId);
+		viewTransform.SetTranslate(f->GetInterpPositionRelTo(camFrameId));
+		f->m_projectiles->Batch(renderer, camera, viewTransform);
+	}
+
+	for (FrameId kid : f->GetChildren()) {
+		BatchAll(renderer, camera, kid, camFrameId);
+	}
+}
+
+void ProjectileManager::Batch(Graphics::Renderer *renderer, const Camera *camera, const matrix4x4d &viewTransform) const
+{
+	const Graphics::Frustum &frustum = camera->GetContext()->GetFrustum();
+	// how far back from their current position they are drawn
+	const double interpTime = (1.0 - Pi::GetGameTickAlpha()) * Pi::game->GetTimeStep();
+
+	for (int kind = 0; kind < KIND_MAX; kind++) {
+		const Pool &p = m_pools[kind];
+		for (size_t i = 0; i < p.Size(); i++) {
+			const vector3d vel = kind == KIND_BOLT ? p.baseVel[i] + p.dir[i] : p.baseVel[i];
+			const vector3d interpPos = p.pos[i] - vel * interpTime;
+			const vector3d viewCoords = viewTransform * interpPos;
+
+			const double radius = sqrt(p.length[i] * p.length[i] + p.width[i] * p.width[i]);
+			if (!frustum.TestPointInfinite(viewCoords, radius))
+				continue;
+
+			// bolts point along their velocity, beams trail back from their muzzle
+			const vector3d _to = viewTransform * (interpPos + (kind == KIND_BOLT ? p.dir[i] : -p.dir[i]));
+			const vector3f from(viewCoords);
+			const vector3f dir = vector3f(_to - viewCoords).Normalized();
+
+			// increase visible size based on distance from camera, z is always negative
+			// allows them to be smaller while maintaining visibility for game play
+			const float dist_scale = float(viewCoords.z / -500);
+			const float length = p.length[i] + dist_scale;
+			const float width = p.width[i] + dist_scale;
+
+			Color color = p.color[i];
+			// fade them out as they age so they don't suddenly disappear
+			// this matches the damage fall-off calculation
+			const float base_alpha = kind == KIND_BOLT ? sqrt(1.0f - p.age[i] / p.lifespan[i]) : 1.0f;
+			// fade out side quads when viewing nearly edge on
+			const vector3f view_dir = from.Normalized();
+			color.a = (base_alpha * (1.f - powf(fabs(dir.Dot(view_dir)), length))) * 255;
+
+			if (color.a > 3)
+				AddToBatch(renderer, *s_sideBatch[kind], s_sideMat[kind].get(), *s_sideVerts[kind], from, dir, width, length, color);
+
+			// fade out glow quads when viewing nearly edge on
+			// these and the side quads fade at different rates
+			// so that they aren't both at the same alpha as that looks strange
+			color.a = (base_alpha * powf(fabs(dir.Dot(view_dir)), width)) * 255;
+
+			if (color.a > 3)
+				AddToBatch(renderer, *s_glowBatch, s_glowMat.get(), *s_glowVerts[kind], from, dir, width, length, color);
+		}
+	}
+}
+
+void ProjectileManager::AddToBatch(Graphics::Renderer *renderer, Graphics::VertexArray &batch, Graphics::Material *mat, const Graphics::VertexArray &mesh,
+	const vector3f &from, const vector3f &dir, float width, float length, const Color &color)
+{
+	if (batch.GetNumVerts() + mesh.GetNumVerts() > MAX_BATCH_VERTICES)
+		FlushBatch(renderer, batch, mat);
+
+	// the model's axes in camera space, scaled to the projectile
+	vector3f v1(dir.y, dir.z, dir.x);
+	const vector3f v2 = v1.Cross(dir).Normalized();
 	v1 = v2.Cross(dir);
-	m[0] = v1.x;
-	m[4] = v2.x;
-	m[8] = dir.x;
-	m[1] = v1.y;
-	m[5] = v2.y;
-	m[9] = dir.y;
-	m[2] = v1.z;
-	m[6] = v2.z;
-	m[10] = dir.z;
-
-	m[12] = from.x;
-	m[13] = from.y;
-	m[14] = from.z;
-
-	// increase visible size based on distance from camera, z is always negative
-	// allows them to be smaller while maintaining visibility for game play
-	const float dist_scale = float(viewCoords.z / -500);
-	const float length = m_length + dist_scale;
-	const float width = m_width + dist_scale;
-
-	renderer->SetTransform(m * matrix4x4f::ScaleMatrix(width, width, length));
-
-	Color color = m_color;
-	// fade them out as they age so they don't suddenly disappear
-	// this matches the damage fall-off calculation
-	const float base_alpha = sqrt(1.0f - m_age / m_lifespan);
-	// fade out side quads when viewing nearly edge on
-	vector3f view_dir = vector3f(viewCoords).Normalized();
-	color.a = (base_alpha * (1.f - powf(fabs(dir.Dot(view_dir)), length))) * 255;
-
-	if (color.a > 3) {
-		s_sideMat->diffuse = color;
-		renderer->DrawMesh(s_sideMesh.get(), s_sideMat.get());
+	const vector3f x = v1 * width;
+	const vector3f y = v2 * width;
+	const vector3f z = dir * length;
+
+	for (Uint32 v = 0; v < mesh.GetNumVerts(); v++) {
+		const vector3f &p = mesh.position[v];
+		batch.Add(from + x * p.x + y * p.y + z * p.z, color, mesh.uv0[v]);
 	}
+}
 
-	// fade out glow quads when viewing nearly edge on
-	// these and the side quads fade at different rates
-	// so that they aren't both at the same alpha as that looks strange
-	color.a = (base_alpha * powf(fabs(dir.Dot(view_dir)), width)) * 255;
+void ProjectileManager::FlushBatch(Graphics::Renderer *renderer, Graphics::VertexArray &batch, Graphics::Material *mat)
+{
+	if (batch.IsEmpty())
+		return;
+	renderer->DrawBuffer(&batch, mat);
+	batch.Clear();
+}
 
-	if (color.a > 3) {
-		s_glowMat->diffuse = color;
-		renderer->DrawMesh(s_glowMesh.get(), s_glowMat.get());
+void ProjectileManager::ToJson(Json &jsonObj, const FrameId fId, Space *space)
+{
+	Frame *f = Frame::GetFrame(fId);
+	Json projectileArray = Json::array(); // Create JSON array to contain projectile data.
+
+	if (f->m_projectiles) {
+		for (int kind = 0; kind < KIND_MAX; kind++) {
+			const Pool &p = f->m_projectiles->m_pools[kind];
+			for (size_t i = 0; i < p.Size(); i++) {
+				Json projectileObj({}); // Create JSON object to contain projectile data.
+
+				projectileObj["beam"] = (kind == KIND_BEAM);
+				projectileObj["pos"] = p.pos[i];
+				projectileObj["base_vel"] = p.baseVel[i];
+				projectileObj["dir"] = p.dir[i];
+				projectileObj["age"] = p.age[i];
+				projectileObj["life_span"] = p.lifespan[i];
+				projectileObj["base_dam"] = p.damage[i];
+				projectileObj["length"] = p.length[i];
+				projectileObj["width"] = p.width[i];
+				projectileObj["mining"] = bool(p.flags[i] & FLAG_MINING);
+				projectileObj["active"] = bool(p.flags[i] & FLAG_ACTIVE);
+				projectileObj["color"] = p.color[i];
+				projectileObj["index_for_body"] = space->GetIndexForBody(p.parent[i]);
+
+				projectileArray.push_back(projectileObj); // Append projectile object to array.
+			}
+		}
 	}
+
+	jsonObj["projectile_array"] = projectileArray; // Add projectile array to supplied object.
 }
 
-void Projectile::Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+void ProjectileManager::FromJson(const Json &jsonObj, FrameId fId)
 {
-	ProjectileData prData;
-	prData.lifespan = lifespan;
-	prData.damage = dam;
-	prData.length = length;
-	prData.width = width;
-	prData.mining = mining;
-	prData.color = color;
-	Projectile *p = new Projectile(parent, prData, pos, baseVel, dirVel);
-	Pi::game->GetSpace()->AddBody(p);
+	try {
+		const Json &projectileArray = jsonObj["projectile_array"];
+		if (!projectileArray.is_array()) throw SavedGameCorruptException();
+		if (projectileArray.empty()) return;
+
+		if (!s_glowMat) BuildModel();
+		ProjectileManager *pm = AllocProjectilesInFrame(fId);
+		for (const Json &projectileObj : projectileArray) {
+			ProjectileData prData;
+			prData.lifespan = projectileObj["life_span"];
+			prData.damage = projectileObj["base_dam"];
+			prData.length = projectileObj["length"];
+			prData.width = projectileObj["width"];
+			prData.mining = projectileObj["mining"];
+			prData.color = projectileObj["color"].get<Color>();
+
+			Pool &p = pm->m_pools[projectileObj["beam"].get<bool>() ? KIND_BEAM : KIND_BOLT];
+			p.Add(nullptr, prData, projectileObj["pos"].get<vector3d>(), projectileObj["base_vel"].get<vector3d>(), projectileObj["dir"].get<vector3d>());
+			p.age.back() = projectileObj["age"];
+			if (!projectileObj["active"].get<bool>())
+				p.flags.back() &= ~FLAG_ACTIVE;
+			p.parentIndex.push_back(projectileObj["index_for_body"]);
+		}
+	} catch (Json::type_error &) {
+		throw SavedGameCorruptException();
+	}
 }
 
-void Projectile::Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+void ProjectileManager::PostLoadFixup(FrameId fId, Space *space)
 {
-	Projectile *p = new Projectile(parent, prData, pos, baseVel, dirVel);
-	Pi::game->GetSpace()->AddBody(p);
+	Frame *f = Frame::GetFrame(fId);
+	if (!f->m_projectiles)
+		return;
+
+	for (Pool &p : f->m_projectiles->m_pools) {
+		for (size_t i = 0; i < p.parentIndex.size(); i++)
+			p.parent[i] = space->GetBodyByIndex(p.parentIndex[i]);
+		p.parentIndex.clear();
+	}
 }
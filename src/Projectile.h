@@ -4,7 +4,15 @@
 #ifndef _PROJECTILE_H
 #define _PROJECTILE_H
 
-#include "Body.h"
+#include "Color.h"
+#include "FrameId.h"
+#include "JsonFwd.h"
+#include "collider/CollisionContact.h"
+#include "matrix4x4.h"
+#include "vector3.h"
+
+#include <memory>
+#include <vector>
 
 struct ProjectileData {
 	ProjectileData() :
@@ -26,59 +34,102 @@ struct ProjectileData {
 	bool beam;
 };
 
-class Frame;
+class Body;
+class Camera;
+class Space;
 
 namespace Graphics {
 	class Material;
 	class Renderer;
-	class MeshObject;
+	class VertexArray;
 } // namespace Graphics
 
-class Projectile : public Body {
+/*
+ * Laser bolts and beams. There are far too many of them and they live far
+ * too briefly to be bodies, so like sfx each frame keeps its own in a
+ * ProjectileManager, as arrays of their properties.
+ *
+ * Every step a frame's rays are all cast against its collision space at
+ * once (spread over the task graph when there are enough of them), then
+ * the hits are applied in order. Everything in view is drawn with one
+ * draw per material.
+ */
+class ProjectileManager {
 public:
-	OBJDEF(Projectile, Body, PROJECTILE);
-
-	static void Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
-	static void Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
-
-	Projectile() = delete;
-	Projectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
-	Projectile(const Json &jsonObj, Space *space);
-	virtual ~Projectile();
-	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override final;
-	void TimeStepUpdate(const float timeStep) override final;
-	void StaticUpdate(const float timeStep) override final;
-	virtual void NotifyRemoved(const Body *const removedBody) override final;
-	virtual void UpdateInterpTransform(double alpha) override final;
-	virtual void PostLoadFixup(Space *space) override final;
+	static void AddProjectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
+	static void AddBeam(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dir);
 
-	static void FreeModel();
+	static void TimeStepAll(const float timeStep, FrameId f);
+	static void RenderAll(Graphics::Renderer *r, const Camera *camera, FrameId f, FrameId camFrame);
+	// forget the body as the parent of anything it fired
+	static void NotifyRemovedAll(const Body *removedBody, FrameId f);
 
-protected:
-	virtual void SaveToJson(Json &jsonObj, Space *space) override final;
+	static void ToJson(Json &jsonObj, FrameId f, Space *space);
+	static void FromJson(const Json &jsonObj, FrameId f);
+	static void PostLoadFixup(FrameId f, Space *space);
+
+	static void FreeModel();
 
 private:
-	float GetDamage() const;
-	double GetRadius() const;
-	Body *m_parent;
-	vector3d m_baseVel;
-	vector3d m_dirVel;
-	float m_age;
-	float m_lifespan;
-	float m_baseDam;
-	float m_length;
-	float m_width;
-	bool m_mining;
-	Color m_color;
-
-	int m_parentIndex; // deserialisation
+	enum Kind {
+		KIND_BOLT,
+		KIND_BEAM,
+		KIND_MAX
+	};
+
+	enum Flags {
+		FLAG_MINING = 1 << 0,
+		FLAG_ACTIVE = 1 << 1, // can still hit things
+		FLAG_DEAD = 1 << 2
+	};
+
+	struct Pool {
+		std::vector<Body *> parent;
+		std::vector<vector3d> pos;
+		std::vector<vector3d> baseVel;
+		std::vector<vector3d> dir; // velocity for bolts, direction for beams
+		std::vector<float> age;
+		std::vector<float> lifespan;
+		std::vector<float> damage;
+		std::vector<float> length;
+		std::vector<float> width;
+		std::vector<Color> color;
+		std::vector<Uint8> flags;
+
+		// results of the ray casts, reused every step
+		std::vector<CollisionContact> contacts;
+		std::vector<double> terrainHeight;
 
+		std::vector<Uint32> parentIndex; // deserialisation
+
+		size_t Size() const { return pos.size(); }
+		void Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dir);
+		// swaps the last one into its place
+		void Remove(size_t i);
+	};
+
+	static ProjectileManager *AllocProjectilesInFrame(FrameId f);
 	static void BuildModel();
+	static void BatchAll(Graphics::Renderer *r, const Camera *camera, FrameId f, FrameId camFrame);
+
+	void TimeStep(const float timeStep, FrameId f);
+	void CastRays(Kind kind, const float timeStep, FrameId f);
+	void Batch(Graphics::Renderer *r, const Camera *camera, const matrix4x4d &viewTransform) const;
 
-	static std::unique_ptr<Graphics::MeshObject> s_sideMesh;
-	static std::unique_ptr<Graphics::MeshObject> s_glowMesh;
-	static std::unique_ptr<Graphics::Material> s_sideMat;
+	static void AddToBatch(Graphics::Renderer *r, Graphics::VertexArray &batch, Graphics::Material *mat, const Graphics::VertexArray &mesh,
+		const vector3f &from, const vector3f &dir, float width, float length, const Color &color);
+	static void FlushBatch(Graphics::Renderer *r, Graphics::VertexArray &batch, Graphics::Material *mat);
+
+	Pool m_pools[KIND_MAX];
+
+	// shared model, drawn from the batches
+	static std::unique_ptr<Graphics::VertexArray> s_sideVerts[KIND_MAX];
+	static std::unique_ptr<Graphics::VertexArray> s_glowVerts[KIND_MAX];
+	static std::unique_ptr<Graphics::Material> s_sideMat[KIND_MAX];
 	static std::unique_ptr<Graphics::Material> s_glowMat;
+
+	static std::unique_ptr<Graphics::VertexArray> s_sideBatch[KIND_MAX];
+	static std::unique_ptr<Graphics::VertexArray> s_glowBatch;
 };
 
 #endif /* _PROJECTILE_H */
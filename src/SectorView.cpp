@@ -15,6 +15,7 @@
 #include "StringF.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/GalaxyCache.h"
+#include "galaxy/RoutePlanner.h"
 #include "galaxy/Sector.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Graphics.h"
@@ -33,7 +34,6 @@
 #include "utils.h"
 #include <algorithm>
 #include <sstream>
-#include <unordered_set>
 
 SectorView::~SectorView() {}
 
@@ -293,138 +293,22 @@ static const float WHEEL_SENSITIVITY = .03f; // Should be a variable in user set
 
 #define FFRAC(_x) ((_x)-floor(_x))
 
-enum Side {
-	XMIN,
-	XMAX,
-	YMIN,
-	YMAX,
-	ZMIN,
-	ZMAX,
-	SIDES
-};
-
-using box_t = std::array<int, SIDES>;
-
-static bool in_box(int x, int y, int z, const box_t &box)
-{
-	return x >= box[XMIN] && x < box[XMAX] &&
-		y >= box[YMIN] && y < box[YMAX] &&
-		z >= box[ZMIN] && z < box[ZMAX];
-}
-
-static int box_max_size(const box_t &box)
-{
-	return std::max(std::max(box[XMAX] - box[XMIN], box[YMAX] - box[YMIN]), box[ZMAX] - box[ZMIN]);
-}
-
-// helper function
-// cache - source of sector and system data
-// crd - coordinates of the origin point in the sector, l.y.
-// originSector - coordinates of the sector containing the origin point
-// targetSector - coordinates of the sector in which we are looking for the nearest system
-// min_dist_sq - here we will accumulate the minimum distance
-// best_sys - here we will accumulate the nearest system
-static void try_sector_for_nearer_system(SectorCache::Slave *cache, const vector3f &crd, const SystemPath &originSector, const SystemPath &targetSector, float &min_dist_sq, SystemPath &best_sys)
-{
-	RefCountedPtr<Sector> ps = cache->GetCached(targetSector);
-	vector3f base(
-		targetSector.sectorX - originSector.sectorX,
-		targetSector.sectorY - originSector.sectorY,
-		targetSector.sectorZ - originSector.sectorZ);
-	base *= Sector::SIZE;
-	for (unsigned int i = 0; i < ps->m_systems.size(); i++) {
-		Sector::System *ss = &ps->m_systems[i];
-		vector3f dx = crd - (ss->GetPosition() + base);
-		float dist = dx.LengthSqr();
-		if (dist < min_dist_sq) {
-			min_dist_sq = dist;
-			best_sys = ss->GetPath();
-		}
-	}
-}
-
-// helper function
-// return true, if at least one system is found
-// cache - source of sector and system data
-// sectorPos - coordinates of the sector containing the origin point
-// crd - coordinates of the origin point in the sector, l.y.
-// searchBox - we should search inside this box
-// prevSearchBox - we shouldn't search inside this box (because already searched)
-// min_dist_sq - here we will accumulate the minimum distance
-// best_sys - here we will accumulate the nearest system
-static bool search_nearest_in_box(SectorCache::Slave *cache, const SystemPath &sectorPos, const vector3f &crd, box_t &searchBox, box_t &prevSearchBox, float &min_dist_sq, SystemPath &best_sys)
-{
-	for (int x = searchBox[XMIN]; x < searchBox[XMAX]; ++x)
-		for (int y = searchBox[YMIN]; y < searchBox[YMAX]; ++y)
-			for (int z = searchBox[ZMIN]; z < searchBox[ZMAX]; ++z)
-				if (!in_box(x, y, z, prevSearchBox)) // we are not looking where we have already looked
-					try_sector_for_nearer_system(cache, crd, sectorPos, SystemPath(x, y, z), min_dist_sq, best_sys);
-	// we will not search next time where already searched
-	prevSearchBox = searchBox;
-	return min_dist_sq != FLT_MAX;
-}
-
 // the function searches for the closest star to the given coordinates
-// cache - source of sector and system data
+// galaxy - source of sector and system data
 // pos -  absolute coordinates of a point (in sectors, float)
 // returns the found SystemPath, (system closest to the given position)
 // if returned !SystemPath.IsSystemPath(), it means that nothing was found
-static SystemPath nearest_system_to_pos(SectorCache::Slave *cache, const vector3f &pos)
+static SystemPath nearest_system_to_pos(Galaxy *galaxy, const vector3f &pos)
 {
-	// maximum size in sectors of the search box
-	const int MAX_SEARCH_BOX = 10;
+	// maximum distance in sectors to look for a system
+	const float MAX_SEARCH_RADIUS = 5.0f;
 	// extract the coordinates of the sector, and the coordinates of the position within the sector
-	SystemPath sectorPos(floor(pos.x), floor(pos.y), floor(pos.z));
-	vector3f crd(FFRAC(pos.x), FFRAC(pos.y), FFRAC(pos.z));
-	crd *= Sector::SIZE; // convert to l.y.
-	// directions of "growth" of the search box, if necessary
-	box_t enlarge = { -1, 1, -1, 1, -1, 1 };
-	// remember the initial sector coordinates and point coordinates as boxes with size 0, for ease of comparison
-	box_t originBox = {
-		sectorPos.sectorX, sectorPos.sectorX,
-		sectorPos.sectorY, sectorPos.sectorY,
-		sectorPos.sectorZ, sectorPos.sectorZ
-	};
-	std::array<float, SIDES> posBox = { crd.x, crd.x, crd.y, crd.y, crd.z, crd.z };
-	// we will remember in which box we were already looked, so as not to repeat the search
-	box_t prevSearchBox = originBox;
-	// here we will accumulate the minimum distance
-	float min_dist_sq = FLT_MAX;
-	// here we will accumulate the nearest system (this will be the result of the function)
-	SystemPath best_sys;
-
-	// the first iteration of the search - only in the sector where the base point is located
-	box_t searchBox = {
-		sectorPos.sectorX, sectorPos.sectorX + 1,
-		sectorPos.sectorY, sectorPos.sectorY + 1,
-		sectorPos.sectorZ, sectorPos.sectorZ + 1
-	};
-	// scan sectors, and expand the search box until we find at least one nearest system
-	while (!search_nearest_in_box(cache, sectorPos, crd, searchBox, prevSearchBox, min_dist_sq, best_sys)) {
-		// expand the search box
-		for (int side = 0; side < SIDES; ++side) {
-			searchBox[side] += enlarge[side];
-		}
-		// could not find anything, within the maximum search range - we return an empty path
-		if (box_max_size(searchBox) > MAX_SEARCH_BOX)
-			return SystemPath();
-	}
+	const SystemPath sectorPos(floor(pos.x), floor(pos.y), floor(pos.z));
+	const vector3f crd = Sector::SIZE * vector3f(FFRAC(pos.x), FFRAC(pos.y), FFRAC(pos.z));
 
-	// we found a system, but it may not be the closest one - let's check all the
-	// edges of the search box, whether they are closer than the found star
-	bool search_complete = true;
-	for (int side = 0; side < SIDES; ++side) {
-		float dist_to_edge = posBox[side] - (searchBox[side] - originBox[side]) * Sector::SIZE;
-		if (dist_to_edge * dist_to_edge < min_dist_sq) {
-			// the origin is closer to this edge of the search box than to the nearest found - we expand in this direction
-			searchBox[side] += enlarge[side];
-			search_complete = false;
-		}
-	}
-	// if we enlarged the box, we will finally look for the closest system once again
-	if (!search_complete)
-		search_nearest_in_box(cache, sectorPos, crd, searchBox, prevSearchBox, min_dist_sq, best_sys);
-	return best_sys;
+	std::vector<SystemIndex::Result> nearest;
+	galaxy->GetSystemIndex().FindNearest(sectorPos, crd, 1, MAX_SEARCH_RADIUS * Sector::SIZE, nearest);
+	return nearest.empty() ? SystemPath() : nearest[0].path;
 }
 
 REGISTER_INPUT_BINDING(SectorView)
@@ -1039,9 +923,6 @@ std::vector<SystemPath> SectorView::GetRoute()
 
 const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPath &target, std::vector<SystemPath> &outRoute) const
 {
-	const RefCountedPtr<const Sector> start_sec = m_galaxy->GetSector(start);
-	const RefCountedPtr<const Sector> target_sec = m_galaxy->GetSector(target);
-
 	LuaRef try_hdrive = LuaObject<Player>::CallMethod<LuaRef>(Pi::player, "GetEquip", "engine", 1);
 	if (try_hdrive.IsNil())
 		return "NO_DRIVE";
@@ -1049,160 +930,25 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 	const ScopedTable hyperdrive = ScopedTable(try_hdrive);
 	// Cache max range so it doesn't get recalculated every time we call GetDuration
 	const float max_range = hyperdrive.CallMethod<float>("GetMaximumRange", Pi::player);
-	const float max_range_sqr = max_range * max_range;
-
-	// use the square of the distance to avoid doing a sqrt for each sector
-	const float distSqr = Sector::DistanceBetweenSqr(start_sec, start.systemIndex, target_sec, target.systemIndex) * 1.10;
-
-	// the maximum distance that anything can be from the direct line between the start and target systems
-	const float max_dist_from_straight_line = (Sector::SIZE * 3);
-
-	// nodes[0] is always start
-	std::vector<SystemPath> nodes;
-	{
-		// calculate an approximate initial number of nodes
-		const float dist = sqrt(distSqr);
-		// +2 for the sectors near start and target, *9 for the sectors immediately around the path... might want to be bigger but seems to work
-		const size_t num_sectors_covered = (size_t(dist / Sector::SIZE) + 2) * 9;
-		const size_t num_systems_per_sector = 6; // total guess
-		nodes.reserve(num_sectors_covered * num_systems_per_sector);
-	}
-	nodes.push_back(start);
-
-	const Sint32 minX = std::min(start.sectorX, target.sectorX) - 2, maxX = std::max(start.sectorX, target.sectorX) + 2;
-	const Sint32 minY = std::min(start.sectorY, target.sectorY) - 2, maxY = std::max(start.sectorY, target.sectorY) + 2;
-	const Sint32 minZ = std::min(start.sectorZ, target.sectorZ) - 2, maxZ = std::max(start.sectorZ, target.sectorZ) + 2;
-	const vector3f start_pos = start_sec->m_systems[start.systemIndex].GetFullPosition();
-	const vector3f target_pos = target_sec->m_systems[target.systemIndex].GetFullPosition();
-
-	// go sector by sector for the minimum cube of sectors and add systems
-	// if they are within 110% of dist of both start and target
-	size_t secLineToFar = 0u;
-	for (Sint32 sx = minX; sx <= maxX; sx++) {
-		for (Sint32 sy = minY; sy <= maxY; sy++) {
-			for (Sint32 sz = minZ; sz < maxZ; sz++) {
-				const SystemPath sec_path = SystemPath(sx, sy, sz);
-
-				// early out here if the sector is too far from the direct line
-				vector3f sec_centre(Sector::SIZE * vector3f(float(sx) + 0.5f, float(sy) + 0.5f, float(sz) + 0.5f));
-				const float secLineDist = MathUtil::DistanceFromLine(start_pos, target_pos, sec_centre);
-				// this test is deliberately conservative to over include sectors, a better test might use the nearest corner of an AABB to the line - Math hard, Andy tired
-				if ((secLineDist - Sector::SIZE) > max_dist_from_straight_line) {
-					++secLineToFar;
-					continue;
-				}
-
-				// GetSector is very expensive if it's not in the cache
-				RefCountedPtr<const Sector> sec = m_galaxy->GetSector(sec_path);
-				for (std::vector<Sector::System>::size_type s = 0; s < sec->m_systems.size(); s++) {
-					if (start.IsSameSystem(sec->m_systems[s].GetPath()))
-						continue; // start is already nodes[0]
 
-					const float lineDist = MathUtil::DistanceFromLine(start_pos, target_pos, sec->m_systems[s].GetFullPosition());
-
-					if (Sector::DistanceBetweenSqr(start_sec, start.systemIndex, sec, sec->m_systems[s].idx) <= distSqr &&
-						Sector::DistanceBetweenSqr(target_sec, target.systemIndex, sec, sec->m_systems[s].idx) <= distSqr &&
-						lineDist < max_dist_from_straight_line) {
-						nodes.push_back(sec->m_systems[s].GetPath());
-					}
-				}
-			}
-		}
-	}
-	Output("SectorView::AutoRoute, nodes to search = %lu, earlied out sector distance from line: %lu times.\n", nodes.size(), secLineToFar);
-
-	// setup inital values and set everything as unvisited
-	std::vector<float> path_dist;							   // distance from source to node
-	std::vector<std::vector<SystemPath>::size_type> path_prev; // previous node in optimal path
-	std::unordered_set<std::vector<SystemPath>::size_type> unvisited;
-	// we know how big these need to be, to reserve space up front
-	path_dist.reserve(nodes.size());
-	path_prev.reserve(nodes.size());
-	unvisited.reserve(nodes.size());
-	// initialise them
-	for (std::vector<SystemPath>::size_type i = 0; i < nodes.size(); i++) {
-		path_dist.push_back(INFINITY);
-		path_prev.push_back(0);
-		unvisited.insert(i);
-	}
-
-	// distance to the start is 0
-	path_dist[0] = 0.f;
-
-	size_t totalSkipped = 0u;
-	while (unvisited.size() > 0) {
-		// find the closest node (for the first loop this will be start)
-		std::vector<SystemPath>::size_type closest_i = *unvisited.begin();
-		for (auto it : unvisited) {
-			if (path_dist[it] < path_dist[closest_i])
-				closest_i = it;
-		}
-
-		// mark it as visited
-		unvisited.erase(closest_i);
-
-		// if this is the target then we have found the route
-		const SystemPath &closest = nodes[closest_i];
-		if (closest.IsSameSystem(target))
-			break;
-
-		RefCountedPtr<const Sector> closest_sec = m_galaxy->GetSector(closest);
-
-		// if not, loop through all unvisited nodes
-		// since every system is technically reachable from every other system
-		// everything is a neighbor :)
-		for (auto it : unvisited) {
-			const SystemPath &v = nodes[it];
-			// everything is a neighbor isn't quite true as the ship has a max_range for each jump!
-			if ((SystemPath::SectorDistanceSqr(closest, v) * Sector::SIZE) > max_range_sqr) {
-				++totalSkipped;
-				continue;
-			}
-
-			RefCountedPtr<const Sector> v_sec = m_galaxy->GetSector(v); // this causes it to generate a sector (slooooooow)
-
-			const float v_dist_ly = Sector::DistanceBetween(closest_sec, closest.systemIndex, v_sec, v.systemIndex);
-
-			// in this case, duration is used for the distance since that's what we are optimizing
-			float v_dist = hyperdrive.CallMethod<float>("GetDuration", Pi::player, v_dist_ly, max_range);
-
-			v_dist += path_dist[closest_i]; // we want the total duration from start to this node
-			if (v_dist < path_dist[it]) {
-				// if our calculated duration is less than a previous value, this path is more efficent
-				// so store/override it
-				path_dist[it] = v_dist;
-				path_prev[it] = closest_i;
-			}
-		}
-	}
-	Output("SectorView::AutoRoute, total times that nodes were skipped = %lu\n", totalSkipped);
-
-	bool foundRoute = false;
-	std::vector<SystemPath>::size_type u = 0;
-
-	// find the index of our target
-	for (std::vector<SystemPath>::size_type i = 0, numNodes = nodes.size(); i < numNodes; i++) {
-		if (target.IsSameSystem(nodes[i])) {
-			u = i;
-			foundRoute = true;
-			break;
-		}
-	}
+	RoutePlanner planner(m_galaxy.Get(), start, target, max_range);
+	// in this case, duration is used for the distance since that's what we are optimizing
+	planner.SetJumpDuration([&](float dist) {
+		return hyperdrive.CallMethod<float>("GetDuration", Pi::player, dist, max_range);
+	});
+	Output("SectorView::AutoRoute, nodes to search = %lu\n", planner.GetNumCandidates());
 
 	// It's posible that there is no valid route
-	if (foundRoute) {
-		outRoute.reserve(nodes.size());
-		// Build the route, in reverse starting with the target
-		while (u != 0) {
-			outRoute.push_back(m_galaxy->GetStarSystem(nodes[u])->GetStars()[0]->GetPath());
-			u = path_prev[u];
-		}
-		//End at given body in multistar systems
-		outRoute.begin()->bodyIndex = target.bodyIndex;
-		std::reverse(std::begin(outRoute), std::end(outRoute));
-		return "OKAY";
-	}
-	return "NO_VALID_ROUTE";
+	if (!planner.Search())
+		return "NO_VALID_ROUTE";
+
+	outRoute.reserve(planner.GetRoute().size());
+	for (const SystemPath &path : planner.GetRoute())
+		outRoute.push_back(m_galaxy->GetStarSystem(path)->GetStars()[0]->GetPath());
+	//End at given body in multistar systems
+	if (!outRoute.empty())
+		outRoute.back().bodyIndex = target.bodyIndex;
+	return "OKAY";
 }
 
 void SectorView::DrawRouteLines(const matrix4x4f &trans)
@@ -1606,7 +1352,7 @@ void SectorView::Update()
 	}
 
 	if (m_automaticSystemSelection && m_manualMove) {
-		SystemPath new_selected = nearest_system_to_pos(m_sectorCache.Get(), m_pos);
+		SystemPath new_selected = nearest_system_to_pos(m_galaxy.Get(), m_pos);
 		if (new_selected.IsSystemPath() && !m_selected.IsSameSystem(new_selected)) {
 			RefCountedPtr<StarSystem> system = m_galaxy->GetStarSystem(new_selected);
 			SetSelected(CheckPathInRoute(system->GetStars()[0]->GetPath()));
@@ -1717,30 +1463,14 @@ double SectorView::GetCenterDistance()
 
 std::vector<SystemPath> SectorView::GetNearbyStarSystemsByName(std::string pattern)
 {
+	std::vector<SystemNameIndex::Result> matches;
+	m_galaxy->GetSystemNameIndex().Find(pattern, matches);
+
+	// the index covers every cached sector, only offer the ones around the view
 	std::vector<SystemPath> result;
-	for (auto i = m_sectorCache->Begin(); i != m_sectorCache->End(); ++i) {
-		for (unsigned int systemIndex = 0; systemIndex < (*i).second->m_systems.size(); systemIndex++) {
-			const Sector::System *ss = &((*i).second->m_systems[systemIndex]);
-
-			// compare with the start of the current system
-			if (strncasecmp(pattern.c_str(), ss->GetName().c_str(), pattern.size()) == 0
-				// look for the pattern term somewhere within the current system
-				|| pi_strcasestr(ss->GetName().c_str(), pattern.c_str())) {
-				SystemPath match((*i).first);
-				match.systemIndex = systemIndex;
-				result.push_back(match);
-			}
-			// now also check other names of this system, if there are any
-			for (const std::string &other_name : ss->GetOtherNames()) {
-				if (strncasecmp(pattern.c_str(), other_name.c_str(), pattern.size()) == 0
-					// look for the pattern term somewhere within the current system
-					|| pi_strcasestr(other_name.c_str(), pattern.c_str())) {
-					SystemPath match((*i).first);
-					match.systemIndex = systemIndex;
-					result.push_back(match);
-				}
-			}
-		}
+	for (const SystemNameIndex::Result &match : matches) {
+		if (m_sectorCache->GetIfCached(match.path))
+			result.push_back(match.path);
 	}
 	return result;
 }
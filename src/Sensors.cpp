@@ -10,6 +10,13 @@
 #include "Ship.h"
 #include "Space.h"
 
+namespace {
+	// same range as the radar scanner
+	static const double RADAR_RANGE = 100000.0;
+	// how often ships other than the player look around, in seconds
+	static const float NPC_SWEEP_INTERVAL = 0.5f;
+} // namespace
+
 Sensors::RadarContact::RadarContact() :
 	body(0),
 	trail(0),
@@ -28,12 +35,6 @@ Sensors::RadarContact::RadarContact(Body *b) :
 {
 }
 
-Sensors::RadarContact::~RadarContact()
-{
-	body = 0;
-	delete trail;
-}
-
 Color Sensors::IFFColor(IFF iff)
 {
 	switch (iff) {
@@ -54,26 +55,43 @@ bool Sensors::ContactDistanceSort(const RadarContact &a, const RadarContact &b)
 Sensors::Sensors(Ship *owner)
 {
 	m_owner = owner;
+	// spread the sweeps of ships made at the same time over the interval
+	m_sweepTime = NPC_SWEEP_INTERVAL * float((reinterpret_cast<uintptr_t>(owner) >> 4) % 16) / 16.0f;
 }
 
-Body* Sensors::ChooseTarget(TargetingCriteria crit, const Body* oldTarget )
+Sensors::~Sensors()
+{
+}
+
+Body *Sensors::ChooseTarget(TargetingCriteria crit, const Body *oldTarget)
 {
 	PROFILE_SCOPED();
 
-	if(!m_owner->IsType(ObjectType::PLAYER))
-		return nullptr;
-		
-	const Body* currTarget = oldTarget;
+	if (crit == TARGET_NEAREST_HOSTILE) {
+		const RadarContact *nearest = nullptr;
+		for (const RadarContact &rc : m_radarContacts) {
+			if (rc.iff != IFF_HOSTILE || !rc.body->IsType(ObjectType::SHIP)) continue;
+			if (!nearest || rc.distance < nearest->distance)
+				nearest = &rc;
+		}
+		return nearest ? nearest->body : nullptr;
+	}
+
+	const Body *currTarget = oldTarget;
 
-	m_radarContacts.sort(ContactDistanceSort);
+	// cycling goes outwards from the current target
+	std::stable_sort(m_radarContacts.begin(), m_radarContacts.end(), ContactDistanceSort);
+	m_contactIndex.Clear();
+	for (Uint32 i = 0; i < m_radarContacts.size(); i++)
+		m_contactIndex.Insert(m_radarContacts[i].body, i);
 
 	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
 		//match object type
 		//match iff
 		if (it->body->IsType(ObjectType::SHIP)) {
 
-			if(crit == CYCLE_HOSTILE && currTarget) {
-				if(currTarget == it->body) {
+			if (currTarget) {
+				if (currTarget == it->body) {
 					currTarget = nullptr;
 					//next hostile will be selected
 				}
@@ -113,72 +131,136 @@ Sensors::IFF Sensors::CheckIFF(Body *other)
 void Sensors::Update(float time)
 {
 	PROFILE_SCOPED();
-	if (m_owner != Pi::player) return;
+	const bool isPlayer = m_owner->IsType(ObjectType::PLAYER);
+
+	// nothing shows the contacts of other ships, so they can be a little stale
+	m_sweepTime += time;
+	if (!isPlayer && m_sweepTime < NPC_SWEEP_INTERVAL)
+		return;
+	m_sweepTime = 0.0f;
 
-	PopulateStaticContacts(); //no need to do all the time
+	Sweep(isPlayer);
+	UpdateContacts(time);
+}
+
+void Sensors::Sweep(bool withTrails)
+{
+	PROFILE_SCOPED();
+	if (withTrails)
+		PopulateStaticContacts(); //no need to do all the time
 
 	//Find nearby contacts, same range as radar scanner. It should use these
 	//contacts, worldview labels too.
-	Space::BodyNearList nearby = Pi::game->GetSpace()->GetBodiesMaybeNear(m_owner, 100000.0f);
+	Space::BodyNearList nearby = Pi::game->GetSpace()->GetBodiesMaybeNear(m_owner, RADAR_RANGE);
 	for (Body *body : nearby) {
 		if (body == m_owner || !body->IsType(ObjectType::SHIP)) continue;
 		if (body->IsDead()) continue;
 
-		auto cit = m_radarContacts.begin();
-		while (cit != m_radarContacts.end()) {
-			if (cit->body == body) break;
-			++cit;
-		}
-
 		//create new contact or refresh old
-		if (cit == m_radarContacts.end()) {
-			m_radarContacts.push_back(RadarContact());
+		const int idx = m_contactIndex.Find(body);
+		if (idx < 0) {
+			m_contactIndex.Insert(body, m_radarContacts.size());
+			m_radarContacts.push_back(RadarContact(body));
 			RadarContact &rc = m_radarContacts.back();
-			rc.body = body;
 			rc.iff = CheckIFF(rc.body);
-			rc.trail = new HudTrail(rc.body, IFFColor(rc.iff));
+			if (withTrails)
+				rc.trail = AllocTrail(rc.body, IFFColor(rc.iff));
 		} else {
-			cit->fresh = true;
+			m_radarContacts[idx].fresh = true;
 		}
 	}
 
-	//update contacts and delete stale ones
-	auto it = m_radarContacts.begin();
-	while (it != m_radarContacts.end()) {
-		if (!it->fresh) {
-			m_radarContacts.erase(it++);
+	//delete stale contacts
+	for (size_t i = 0; i < m_radarContacts.size();) {
+		if (!m_radarContacts[i].fresh) {
+			RemoveContact(i);
 		} else {
-			const Ship *ship = it->body->IsType(ObjectType::SHIP) ? static_cast<Ship *>(it->body) : nullptr;
-			if (ship && Ship::FLYING == ship->GetFlightState()) {
-				it->distance = m_owner->GetPositionRelTo(it->body).Length();
-				it->iff = CheckIFF(it->body);
-				it->trail->SetColor(IFFColor(it->iff));
-				it->trail->Update(time);
-			} else {
-				it->trail->Reset(FrameId::Invalid);
-			}
-			it->fresh = false;
-			++it;
+			m_radarContacts[i].fresh = false;
+			++i;
 		}
 	}
 }
 
-void Sensors::UpdateIFF(Body *b)
+void Sensors::UpdateContacts(float time)
 {
 	PROFILE_SCOPED();
-	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
-		if (it->body == b) {
-			it->iff = CheckIFF(b);
-			it->trail->SetColor(IFFColor(it->iff));
+	// most contacts share our frame, which saves a frame transform each
+	const FrameId ownerFrame = m_owner->GetFrame();
+	const vector3d ownerPos = m_owner->GetPosition();
+
+	for (RadarContact &rc : m_radarContacts) {
+		// contacts are only ever ships
+		const Ship *ship = static_cast<Ship *>(rc.body);
+		if (Ship::FLYING == ship->GetFlightState()) {
+			if (rc.body->GetFrame() == ownerFrame)
+				rc.distance = (rc.body->GetPosition() - ownerPos).Length();
+			else
+				rc.distance = m_owner->GetPositionRelTo(rc.body).Length();
+			rc.iff = CheckIFF(rc.body);
+			if (rc.trail) {
+				rc.trail->SetColor(IFFColor(rc.iff));
+				rc.trail->Update(time);
+			}
+		} else if (rc.trail) {
+			rc.trail->Reset(FrameId::Invalid);
 		}
 	}
 }
 
+void Sensors::RemoveContact(size_t idx)
+{
+	RadarContact &rc = m_radarContacts[idx];
+	if (rc.trail)
+		m_freeTrails.push_back(rc.trail);
+	m_contactIndex.Erase(rc.body);
+
+	if (idx != m_radarContacts.size() - 1) {
+		rc = m_radarContacts.back();
+		m_contactIndex.Insert(rc.body, idx);
+	}
+	m_radarContacts.pop_back();
+}
+
+HudTrail *Sensors::AllocTrail(Body *b, const Color &c)
+{
+	if (m_freeTrails.empty()) {
+		m_trails.emplace_back(new HudTrail(b, c));
+		return m_trails.back().get();
+	}
+
+	HudTrail *trail = m_freeTrails.back();
+	m_freeTrails.pop_back();
+	trail->SetBody(b);
+	trail->SetColor(c);
+	return trail;
+}
+
+void Sensors::UpdateIFF(Body *b)
+{
+	PROFILE_SCOPED();
+	const int idx = m_contactIndex.Find(b);
+	if (idx < 0)
+		return;
+
+	RadarContact &rc = m_radarContacts[idx];
+	rc.iff = CheckIFF(b);
+	if (rc.trail)
+		rc.trail->SetColor(IFFColor(rc.iff));
+}
+
 void Sensors::ResetTrails()
 {
 	PROFILE_SCOPED();
 	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it)
-		it->trail->Reset(Pi::player->GetFrame());
+		if (it->trail)
+			it->trail->Reset(Pi::player->GetFrame());
+}
+
+void Sensors::NotifyRemoved(const Body *removedBody)
+{
+	const int idx = m_contactIndex.Find(removedBody);
+	if (idx >= 0)
+		RemoveContact(idx);
 }
 
 void Sensors::PopulateStaticContacts()
@@ -200,3 +282,94 @@ void Sensors::PopulateStaticContacts()
 		rc.fresh = true;
 	}
 }
+
+size_t Sensors::ContactIndex::Bucket(const Body *b) const
+{
+	// Fibonacci hashing, as the low bits of a pointer are mostly alignment
+	const uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(b)) * 0x9E3779B97F4A7C15ull;
+	return size_t(h >> 32) & (m_slots.size() - 1);
+}
+
+int Sensors::ContactIndex::Find(const Body *b) const
+{
+	if (m_slots.empty())
+		return -1;
+
+	const size_t mask = m_slots.size() - 1;
+	for (size_t i = Bucket(b);; i = (i + 1) & mask) {
+		const Slot &slot = m_slots[i];
+		if (slot.body == b)
+			return int(slot.idx);
+		if (!slot.body)
+			return -1;
+	}
+}
+
+void Sensors::ContactIndex::Insert(const Body *b, Uint32 idx)
+{
+	assert(b);
+	// keep it at most three quarters full
+	if ((m_size + 1) * 4 > m_slots.size() * 3)
+		Grow();
+
+	const size_t mask = m_slots.size() - 1;
+	for (size_t i = Bucket(b);; i = (i + 1) & mask) {
+		Slot &slot = m_slots[i];
+		if (slot.body == b) {
+			slot.idx = idx;
+			return;
+		}
+		if (!slot.body) {
+			slot.body = b;
+			slot.idx = idx;
+			m_size++;
+			return;
+		}
+	}
+}
+
+void Sensors::ContactIndex::Erase(const Body *b)
+{
+	if (m_slots.empty())
+		return;
+
+	const size_t mask = m_slots.size() - 1;
+	size_t hole = Bucket(b);
+	while (m_slots[hole].body != b) {
+		if (!m_slots[hole].body)
+			return;
+		hole = (hole + 1) & mask;
+	}
+
+	// shift back the slots after it that would no longer be found past the hole
+	for (size_t i = (hole + 1) & mask; m_slots[i].body; i = (i + 1) & mask) {
+		const size_t home = Bucket(m_slots[i].body);
+		// is home cyclically outside (hole, i]?
+		const bool movable = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+		if (movable) {
+			m_slots[hole] = m_slots[i];
+			hole = i;
+		}
+	}
+	m_slots[hole].body = nullptr;
+	m_size--;
+}
+
+void Sensors::ContactIndex::Clear()
+{
+	for (Slot &slot : m_slots)
+		slot.body = nullptr;
+	m_size = 0;
+}
+
+void Sensors::ContactIndex::Grow()
+{
+	std::vector<Slot> old;
+	old.swap(m_slots);
+	m_slots.assign(std::max(size_t(16), old.size() * 2), Slot{ nullptr, 0 });
+	m_size = 0;
+
+	for (const Slot &slot : old)
+		if (slot.body)
+			Insert(slot.body, slot.idx);
+}
@@ -8,12 +8,18 @@
  * and handles IFF
  * Some ideas:
  *  - targeting should be lost when going out of range
- *  - don't run radar sweep every frame (more of an optimization than simulation)
  *  - allow "pinned" radar contacts (visible at all ranges, for missions)
+ *
+ * Every ship has sensors, so the AI can pick targets from them. Only the
+ * player's sweep every step and keep HUD trails; other ships sweep a few
+ * times a second. Contacts are kept in an array, indexed by body.
  */
 #include "Body.h"
 #include "libs.h"
 
+#include <memory>
+#include <vector>
+
 class Body;
 class HudTrail;
 class Ship;
@@ -35,34 +41,76 @@ public:
 	struct RadarContact {
 		RadarContact();
 		RadarContact(Body *);
-		~RadarContact();
 		Body *body;
-		HudTrail *trail;
+		HudTrail *trail; // player only, owned by the sensors
 		double distance;
 		IFF iff;
 		bool fresh;
 	};
 
-	typedef std::list<RadarContact> ContactList;
+	typedef std::vector<RadarContact> ContactList;
 
 	static Color IFFColor(IFF);
 	static bool ContactDistanceSort(const RadarContact &a, const RadarContact &b);
 
 	Sensors(Ship *owner);
-	Body* ChooseTarget(TargetingCriteria, const Body* oldTarget);
+	~Sensors();
+	Body *ChooseTarget(TargetingCriteria, const Body *oldTarget);
 	IFF CheckIFF(Body *other);
 	const ContactList &GetContacts() { return m_radarContacts; }
 	const ContactList &GetStaticContacts() { return m_staticContacts; }
 	void Update(float time);
 	void UpdateIFF(Body *);
 	void ResetTrails();
+	void NotifyRemoved(const Body *removedBody);
+
+	// Open addressing (linear probing) map from a contact's body to where
+	// it is in m_radarContacts. Public for the unit tests.
+	class ContactIndex {
+	public:
+		ContactIndex() :
+			m_size(0) {}
+		// -1 if the body isn't a contact
+		int Find(const Body *b) const;
+		// adds the body, or moves it if already there
+		void Insert(const Body *b, Uint32 idx);
+		void Erase(const Body *b);
+		void Clear();
+
+		Uint32 GetSize() const { return m_size; }
+		size_t GetNumSlots() const { return m_slots.size(); }
+		// the slot probing for the body starts at
+		size_t Bucket(const Body *b) const;
+
+	private:
+		struct Slot {
+			const Body *body; // nullptr when empty
+			Uint32 idx;
+		};
+
+		void Grow();
+
+		std::vector<Slot> m_slots; // always a power of two in size
+		Uint32 m_size;
+	};
 
 private:
+	void Sweep(bool withTrails);
+	void UpdateContacts(float time);
+	void RemoveContact(size_t idx);
+	void PopulateStaticContacts();
+
+	HudTrail *AllocTrail(Body *b, const Color &c);
+
 	Ship *m_owner;
 	ContactList m_radarContacts;
 	ContactList m_staticContacts; //things we know of regardless of range
+	ContactIndex m_contactIndex;
+	float m_sweepTime;
 
-	void PopulateStaticContacts();
+	// trails are kept for reuse, they are slow to make
+	std::vector<std::unique_ptr<HudTrail>> m_trails;
+	std::vector<HudTrail *> m_freeTrails;
 };
 
 #endif
@@ -993,7 +993,11 @@ void Ship::TimeStepUpdate(const float timeStep)
 
 	m_dragCoeff = DynamicBody::DEFAULT_DRAG_COEFF * (1.0 + 0.25 * m_wheelState);
 	DynamicBody::TimeStepUpdate(timeStep);
+}
 
+void Ship::PostTimeStepUpdate(const float timeStep)
+{
+	PROFILE_SCOPED()
 	// fuel use decreases mass, so do this as the last thing in the frame
 	UpdateFuel(timeStep);
 
@@ -1384,6 +1388,7 @@ void Ship::StaticUpdate(const float timeStep)
 void Ship::NotifyRemoved(const Body *const removedBody)
 {
 	if (m_curAICmd) m_curAICmd->OnDeleted(removedBody);
+	if (m_sensors.get()) m_sensors->NotifyRemoved(removedBody);
 }
 
 bool Ship::Undock()
@@ -107,6 +107,7 @@ public:
 	void Blastoff();
 	bool Undock();
 	virtual void TimeStepUpdate(const float timeStep) override;
+	virtual void PostTimeStepUpdate(const float timeStep) override;
 	virtual void StaticUpdate(const float timeStep) override;
 
 	void TimeAccelAdjust(const float timeStep);
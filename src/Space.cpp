@@ -7,6 +7,7 @@
 #include "CityOnPlanet.h"
 #include "Frame.h"
 #include "Game.h"
+#include "GameConfig.h"
 #include "GameSaveError.h"
 #include "HyperspaceCloud.h"
 #include "Lang.h"
@@ -14,11 +15,14 @@
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
+#include "Projectile.h"
 #include "SpaceStation.h"
 #include "Star.h"
 #include "SystemView.h"
 #include "collider/CollisionContact.h"
 #include "collider/CollisionSpace.h"
+#include "core/FNV1a.h"
+#include "core/TaskGraph.h"
 #include "galaxy/Galaxy.h"
 #include "graphics/Graphics.h"
 #include "lua/LuaEvent.h"
@@ -153,15 +157,101 @@ static void RelocateStarportIfNecessary(SystemBody *sbody, Planet *planet, vecto
 	}
 }
 
+size_t Space::BodyNearFinder::CellKeyHash::operator()(const CellKey &k) const
+{
+	return size_t(hash_64_fnv1a(reinterpret_cast<const char *>(&k), sizeof(CellKey)));
+}
+
+Space::BodyNearFinder::CellKey Space::BodyNearFinder::GetCellKey(const vector3d &pos)
+{
+	return CellKey{
+		Sint64(floor(pos.x / CELL_SIZE)),
+		Sint64(floor(pos.y / CELL_SIZE)),
+		Sint64(floor(pos.z / CELL_SIZE))
+	};
+}
+
+void Space::BodyNearFinder::RemoveFromCell(const CellKey &key, Uint32 slot)
+{
+	auto cell = m_cells.find(key);
+	assert(cell != m_cells.end() && slot < cell->second.size());
+	std::vector<CellItem> &items = cell->second;
+	if (slot != items.size() - 1) {
+		items[slot] = items.back();
+		m_entries[items[slot].body].slot = slot;
+	}
+	items.pop_back();
+	if (items.empty())
+		m_cells.erase(cell);
+}
+
 void Space::BodyNearFinder::Prepare()
 {
 	PROFILE_SCOPED()
-	m_bodyDist.clear();
+	const Uint32 stamp = ++m_stamp;
+
+	for (Body *b : m_space->GetBodies()) {
+		const vector3d pos = b->GetPositionRelTo(m_space->GetRootFrame());
+		const CellKey key = GetCellKey(pos);
+
+		auto it = m_entries.find(b);
+		if (it != m_entries.end()) {
+			Entry &entry = it->second;
+			entry.stamp = stamp;
+			if (entry.cell == key) {
+				m_cells[key][entry.slot].pos = pos;
+				continue;
+			}
+			RemoveFromCell(entry.cell, entry.slot);
+		}
 
-	for (Body *b : m_space->GetBodies())
-		m_bodyDist.emplace_back(b, b->GetPositionRelTo(m_space->GetRootFrame()).Length());
+		std::vector<CellItem> &items = m_cells[key];
+		items.push_back({ b, pos });
+		m_entries[b] = Entry{ key, Uint32(items.size() - 1), stamp };
+	}
 
-	std::sort(m_bodyDist.begin(), m_bodyDist.end());
+	// drop bodies which have left the space since the last update
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		if (it->second.stamp != stamp) {
+			RemoveFromCell(it->second.cell, it->second.slot);
+			it = m_entries.erase(it);
+		} else
+			++it;
+	}
+}
+
+template <typename Fn>
+void Space::BodyNearFinder::ForEachNear(const vector3d &pos, double dist, Fn fn) const
+{
+	const double distSqr = dist * dist;
+	const CellKey lo = GetCellKey(pos - vector3d(dist));
+	const CellKey hi = GetCellKey(pos + vector3d(dist));
+
+	auto visit = [&](const std::vector<CellItem> &items) {
+		for (const CellItem &item : items)
+			if ((item.pos - pos).LengthSqr() <= distSqr)
+				fn(item);
+	};
+
+	const double numCells = double(hi.x - lo.x + 1) * double(hi.y - lo.y + 1) * double(hi.z - lo.z + 1);
+	if (numCells > double(m_cells.size())) {
+		// the query covers more cells than are occupied, so walk the occupied ones instead
+		for (const auto &cell : m_cells) {
+			const CellKey &k = cell.first;
+			if (k.x < lo.x || k.x > hi.x || k.y < lo.y || k.y > hi.y || k.z < lo.z || k.z > hi.z)
+				continue;
+			visit(cell.second);
+		}
+		return;
+	}
+
+	for (Sint64 z = lo.z; z <= hi.z; z++)
+		for (Sint64 y = lo.y; y <= hi.y; y++)
+			for (Sint64 x = lo.x; x <= hi.x; x++) {
+				auto cell = m_cells.find(CellKey{ x, y, z });
+				if (cell != m_cells.end())
+					visit(cell->second);
+			}
 }
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, double dist)
@@ -171,27 +261,53 @@ Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, dou
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const vector3d &pos, double dist)
 {
-	if (m_bodyDist.empty()) {
-		m_nearBodies.clear();
-		return std::move(m_nearBodies);
-	}
-
-	const double len = pos.Length();
+	m_nearBodies.clear();
+	ForEachNear(pos, dist, [&](const CellItem &item) { m_nearBodies.push_back(item.body); });
 
-	std::vector<BodyDist>::const_iterator min = std::lower_bound(m_bodyDist.begin(), m_bodyDist.end(), len - dist);
-	std::vector<BodyDist>::const_iterator max = std::upper_bound(min, m_bodyDist.cend(), len + dist);
+	return std::move(m_nearBodies);
+}
 
-	m_nearBodies.clear();
-	m_nearBodies.reserve(max - min);
+bool Space::BodyNearFinder::FindNearest(const vector3d &pos, ObjectType t, Body *&nearest) const
+{
+	// bodies are only ever added between updates, so a count mismatch means some aren't indexed
+	if (m_entries.size() != m_space->GetNumBodies())
+		return false;
+
+	nearest = nullptr;
+	double nearestDistSqr = DBL_MAX;
+	auto consider = [&](const CellItem &item) {
+		if (item.body->IsDead() || !item.body->IsType(t))
+			return;
+		const double distSqr = (item.pos - pos).LengthSqr();
+		if (distSqr < nearestDistSqr) {
+			nearestDistSqr = distSqr;
+			nearest = item.body;
+		}
+	};
+
+	// widen the search until something is found or it would cover every occupied cell
+	for (double dist = CELL_SIZE; dist < DBL_MAX; dist *= 4.0) {
+		const CellKey lo = GetCellKey(pos - vector3d(dist));
+		const CellKey hi = GetCellKey(pos + vector3d(dist));
+		const double numCells = double(hi.x - lo.x + 1) * double(hi.y - lo.y + 1) * double(hi.z - lo.z + 1);
+		if (numCells > double(m_cells.size()))
+			break;
 
-	std::for_each(min, max, [&](BodyDist const &bd) { m_nearBodies.push_back(bd.body); });
+		ForEachNear(pos, dist, consider);
+		if (nearest)
+			return true;
+	}
 
-	return std::move(m_nearBodies);
+	for (const auto &cell : m_cells)
+		for (const CellItem &item : cell.second)
+			consider(item);
+	return true;
 }
 
 Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Space *oldSpace) :
 	m_starSystemCache(oldSpace ? oldSpace->m_starSystemCache : galaxy->NewStarSystemSlaveCache()),
 	m_game(game),
+	m_parallelBodyUpdate(Pi::config->Int("ParallelBodyUpdate")),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
 	m_bodyNearFinder(this)
@@ -211,6 +327,7 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, S
 	m_starSystemCache(oldSpace ? oldSpace->m_starSystemCache : galaxy->NewStarSystemSlaveCache()),
 	m_starSystem(galaxy->GetStarSystem(path)),
 	m_game(game),
+	m_parallelBodyUpdate(Pi::config->Int("ParallelBodyUpdate")),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
 	m_bodyNearFinder(this)
@@ -238,6 +355,7 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, S
 Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json &jsonObj, double at_time) :
 	m_starSystemCache(galaxy->NewStarSystemSlaveCache()),
 	m_game(game),
+	m_parallelBodyUpdate(Pi::config->Int("ParallelBodyUpdate")),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
 	m_bodyNearFinder(this)
@@ -524,7 +642,11 @@ void Space::GetHyperspaceExitParams(const SystemPath &source, const SystemPath &
 
 Body *Space::FindNearestTo(const Body *b, ObjectType t) const
 {
-	Body *nearest = 0;
+	Body *nearest = nullptr;
+	if (m_bodyNearFinder.FindNearest(b->GetPositionRelTo(m_rootFrameId), t, nearest))
+		return nearest;
+
+	// the index is out of date, check everything
 	double dist = FLT_MAX;
 	for (Body *const body : m_bodies) {
 		if (body->IsDead()) continue;
@@ -712,8 +834,8 @@ void Space::UpdateStarSystemCache(const SystemPath *here)
 		for (int y = here_y - sectorRadius; y <= here_y + sectorRadius; y++) {
 			for (int z = here_z - sectorRadius; z <= here_z + sectorRadius; z++) {
 				SystemPath path(x, y, z);
-				RefCountedPtr<Sector> sec(m_sectorCache->GetIfCached(path));
-				assert(sec);
+				// usually cached, unless the budget evicted it since
+				RefCountedPtr<Sector> sec(m_sectorCache->GetCached(path));
 				for (const Sector::System &ss : sec->m_systems)
 					paths.push_back(SystemPath(ss.sx, ss.sy, ss.sz, ss.idx));
 			}
@@ -990,33 +1112,64 @@ static void hitCallback(CollisionContact *c)
 }
 
 // temporary one-point version
-static void CollideWithTerrain(Body *body, float timeStep)
+// Tests a body against the terrain of the planet whose frame it is in.
+// Only reads shared state, so it is safe to run for many bodies at once.
+static bool TestTerrainCollision(Body *body, float timeStep, CollisionContact &contact)
 {
 	PROFILE_SCOPED()
 	if (!body->IsType(ObjectType::DYNAMICBODY))
-		return;
+		return false;
 	DynamicBody *dynBody = static_cast<DynamicBody *>(body);
 	if (!dynBody->IsMoving())
-		return;
+		return false;
 
 	Frame *f = Frame::GetFrame(body->GetFrame());
 	if (!f || !f->GetBody() || f->GetId() != f->GetBody()->GetFrame())
-		return;
+		return false;
 	if (!f->GetBody()->IsType(ObjectType::TERRAINBODY))
-		return;
+		return false;
 	TerrainBody *terrain = static_cast<TerrainBody *>(f->GetBody());
 
 	const Aabb &aabb = dynBody->GetAabb();
 	double altitude = body->GetPosition().Length() + aabb.min.y;
 	if (altitude >= (terrain->GetMaxFeatureRadius() * 2.0))
-		return;
+		return false;
 
 	double terrHeight = terrain->GetTerrainHeight(body->GetPosition().Normalized());
 	if (altitude >= terrHeight)
+		return false;
+
+	contact = CollisionContact(body->GetPosition(), body->GetPosition().Normalized(), terrHeight - altitude, timeStep, static_cast<void *>(body), static_cast<void *>(f->GetBody()));
+	return true;
+}
+
+template <typename Fn>
+void Space::ForEachBodyParallel(Fn &&fn)
+{
+	// below this there isn't enough work to be worth the task overhead
+	static const uint32_t MIN_BODIES_PER_TASK = 32;
+
+	TaskGraph *graph = Pi::GetApp()->GetTaskGraph();
+	const uint32_t numBodies = m_bodies.size();
+	const uint32_t numTasks = std::min(graph->GetNumWorkerThreads() + 1, numBodies / MIN_BODIES_PER_TASK);
+	if (!m_parallelBodyUpdate || numTasks < 2) {
+		for (uint32_t idx = 0; idx < numBodies; idx++)
+			fn(idx, m_bodies[idx]);
 		return;
+	}
+
+	TaskSet *set = new TaskSet();
+	for (uint32_t i = 0; i < numTasks; i++) {
+		const TaskRange range = { numBodies * i / numTasks, numBodies * (i + 1) / numTasks };
+		set->AddTaskLambda(range, [this, &fn](TaskRange r) {
+			for (uint32_t idx = r.begin; idx < r.end; idx++)
+				fn(idx, m_bodies[idx]);
+		});
+	}
 
-	CollisionContact c(body->GetPosition(), body->GetPosition().Normalized(), terrHeight - altitude, timeStep, static_cast<void *>(body), static_cast<void *>(f->GetBody()));
-	hitCallback(&c);
+	// the main thread works on the set too until it is done
+	TaskSet::Handle handle = graph->QueueTaskSet(set);
+	graph->WaitForTaskSet(handle);
 }
 
 void Space::TimeStep(float step)
@@ -1030,8 +1183,15 @@ void Space::TimeStep(float step)
 
 	Frame::CollideFrames(&hitCallback);
 
-	for (Body *b : m_bodies)
-		CollideWithTerrain(b, step);
+	// terrain height queries run in parallel, then the collision responses
+	// (which can call into Lua) are applied in body order
+	m_terrainContacts.assign(m_bodies.size(), CollisionContact());
+	ForEachBodyParallel([&](uint32_t idx, Body *b) {
+		TestTerrainCollision(b, step, m_terrainContacts[idx]);
+	});
+	for (CollisionContact &c : m_terrainContacts)
+		if (c.userData1)
+			hitCallback(&c);
 
 	// update frames of reference
 	for (Body *b : m_bodies)
@@ -1041,11 +1201,24 @@ void Space::TimeStep(float step)
 	for (Body *b : m_bodies)
 		b->StaticUpdate(step);
 
+	ProjectileManager::TimeStepAll(step, m_rootFrameId);
+
 	Frame::UpdateOrbitRails(m_game->GetTime(), m_game->GetTimeStep());
 
+	for (Body *b : m_bodies)
+		if (b->IsType(ObjectType::DYNAMICBODY))
+			static_cast<DynamicBody *>(b)->StoreOldPosition();
+
 	for (Body *b : m_bodies)
 		b->TimeStepUpdate(step);
 
+	ForEachBodyParallel([step](uint32_t, Body *b) {
+		b->TimeStepIntegrate(step);
+	});
+
+	for (Body *b : m_bodies)
+		b->PostTimeStepUpdate(step);
+
 	LuaEvent::Emit();
 	Pi::luaTimer->Tick();
 
@@ -1070,6 +1243,7 @@ void Space::UpdateBodies()
 			else
 				remove_iterator = it;
 		}
+		ProjectileManager::NotifyRemovedAll(b.first, m_rootFrameId);
 		if (remove_iterator != m_bodies.end()) {
 			*remove_iterator = m_bodies.back();
 			m_bodies.pop_back();
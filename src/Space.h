@@ -8,9 +8,12 @@
 #include "FrameId.h"
 #include "IterationProxy.h"
 #include "RefCounted.h"
+#include "collider/CollisionContact.h"
 #include "galaxy/StarSystem.h"
 #include "vector3.h"
 
+#include <unordered_map>
+
 class Body;
 class Frame;
 class Game;
@@ -116,6 +119,11 @@ private:
 
 	void CollideFrame(FrameId fId);
 
+	// runs fn(body) for each body, split across the task graph workers
+	// when parallel updates are enabled. fn must only touch its own body
+	template <typename Fn>
+	void ForEachBodyParallel(Fn &&fn);
+
 	FrameId m_rootFrameId;
 
 	RefCountedPtr<SectorCache::Slave> m_sectorCache;
@@ -128,6 +136,13 @@ private:
 	// all the bodies we know about
 	std::vector<Body *> m_bodies;
 
+	// per-body results of the parallel terrain collision test
+	std::vector<CollisionContact> m_terrainContacts;
+
+	// if false, all per-body update phases run serially on the main thread;
+	// results are identical either way, this is for debugging and profiling
+	bool m_parallelBodyUpdate;
+
 	// bodies that were removed/killed this timestep and need pruning at the end
 	enum class BodyAssignation {
 		KILL = 0,
@@ -150,22 +165,57 @@ private:
 	std::unique_ptr<Background::Container> m_background;
 
 
+	// Hashed uniform grid over the root frame positions of all bodies,
+	// updated in place at the end of each timestep
 	class BodyNearFinder {
 	public:
 		BodyNearFinder(const Space *space) :
-			m_space(space) {}
+			m_space(space),
+			m_stamp(0) {}
 		void Prepare();
 
 		BodyNearList GetBodiesMaybeNear(const Body *b, double dist);
 		BodyNearList GetBodiesMaybeNear(const vector3d &pos, double dist);
 
+		// finds the nearest live body of the given type; returns false if the index
+		// can't answer because bodies have been added since the last Prepare
+		bool FindNearest(const vector3d &pos, ObjectType t, Body *&nearest) const;
+
 	private:
+		// side length of a grid cell in metres
+		static constexpr double CELL_SIZE = 50000.0;
+
+		struct CellKey {
+			Sint64 x, y, z;
+			bool operator==(const CellKey &o) const { return x == o.x && y == o.y && z == o.z; }
+		};
+		struct CellKeyHash {
+			size_t operator()(const CellKey &k) const;
+		};
+		struct CellItem {
+			Body *body;
+			vector3d pos;
+		};
+		struct Entry {
+			CellKey cell;
+			Uint32 slot;
+			Uint32 stamp;
+		};
+		typedef std::unordered_map<CellKey, std::vector<CellItem>, CellKeyHash> CellMap;
+
+		static CellKey GetCellKey(const vector3d &pos);
+		void RemoveFromCell(const CellKey &key, Uint32 slot);
+		// calls fn for every indexed body within dist of pos
+		template <typename Fn>
+		void ForEachNear(const vector3d &pos, double dist, Fn fn) const;
 
 		const Space *m_space;
-		std::vector<BodyDist> m_bodyDist;
+		Uint32 m_stamp;
+		CellMap m_cells;
+		// keyed by pointer only; stale entries are never dereferenced
+		std::unordered_map<const Body *, Entry> m_entries;
 		std::vector<Body *> m_nearBodies;
 	};
-
 	BodyNearFinder m_bodyNearFinder;
 
 #ifndef NDEBUG
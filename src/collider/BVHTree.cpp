@@ -2,150 +2,265 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "BVHTree.h"
-#include "buildopts.h"
+#include "profiler/Profiler.h"
+#include "scenegraph/Serializer.h"
+#include <algorithm>
 #include <float.h>
-#include <stdio.h>
 
-const int MAX_SPLITPOS_RETRIES = 15;
+// binned SAH parameters, costs are relative to a single object intersection
+static const int NUM_BINS = 16;
+static const int MAX_LEAF_OBJS = 4;
+static const double TRAVERSAL_COST = 1.0;
 
-BVHTree::BVHTree(int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
+static double HalfArea(const Aabb &aabb)
 {
-	PROFILE_SCOPED()
-	Profiler::Timer timer;
-	timer.Start();
-
-	std::vector<int> activeObjIdxs(numObjs);
-	for (int i = 0; i < numObjs; i++)
-		activeObjIdxs[i] = i;
+	const vector3d d = aabb.max - aabb.min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
 
-	m_objPtrAlloc = new objPtr_t[numObjs];
-	m_objPtrAllocPos = 0;
-	m_objPtrAllocMax = numObjs;
+static Aabb EmptyAabb()
+{
+	Aabb aabb;
+	aabb.min = vector3d(DBL_MAX, DBL_MAX, DBL_MAX);
+	aabb.max = vector3d(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+	return aabb;
+}
 
-	m_bvhNodes = new BVHNode[numObjs * 2 + 1];
-	m_nodeAllocPos = 0;
-	m_nodeAllocMax = numObjs * 2 + 1;
+static void Grow(Aabb &aabb, const Aabb &other)
+{
+	aabb.Update(other.min);
+	aabb.Update(other.max);
+}
 
-	m_root = AllocNode();
-	BuildNode(m_root, objPtrs, objAabbs, activeObjIdxs);
+static void SetKid(BVHNode &node, int i, int index, int numObjs, const Aabb &aabb)
+{
+	node.kids[i] = index;
+	node.numObjs[i] = numObjs;
+	node.minX[i] = float(aabb.min.x);
+	node.minY[i] = float(aabb.min.y);
+	node.minZ[i] = float(aabb.min.z);
+	node.maxX[i] = float(aabb.max.x);
+	node.maxY[i] = float(aabb.max.y);
+	node.maxZ[i] = float(aabb.max.z);
+}
 
-	timer.Stop();
-	//Output(" - - - BVHTree::BVHTree took: %lf milliseconds\n", timer.millicycles());
+static void ClearKid(BVHNode &node, int i)
+{
+	Aabb zero;
+	zero.min = zero.max = vector3d(0.0);
+	SetKid(node, i, -1, 0, zero);
 }
 
-void BVHTree::MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPtr_t> &objs)
+BVHTree::BVHTree(const int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
 {
-	const size_t numTris = objs.size();
-	if (numTris <= 0) Error("MakeLeaf called with no elements in objs.");
+	PROFILE_SCOPED()
+
+	m_aabb = EmptyAabb();
+	if (numObjs <= 0) {
+		// keep a root so traversal needn't special case empty trees
+		m_aabb.min = m_aabb.max = vector3d(0.0);
+		m_nodes.resize(1);
+		for (int i = 0; i < 4; i++)
+			ClearKid(m_nodes[0], i);
+		return;
+	}
 
-	if (numTris > m_objPtrAllocMax - m_objPtrAllocPos) {
-		Error("Out of space in m_objPtrAlloc. Left: " SIZET_FMT "; required: " SIZET_FMT ".", m_objPtrAllocMax - m_objPtrAllocPos, numTris);
+	std::vector<int> order(numObjs);
+	std::vector<vector3d> centroids(numObjs);
+	for (int i = 0; i < numObjs; i++) {
+		order[i] = i;
+		centroids[i] = 0.5 * (objAabbs[i].min + objAabbs[i].max);
 	}
 
-	node->numTris = numTris;
-	node->triIndicesStart = &m_objPtrAlloc[m_objPtrAllocPos];
-	//if (objs.size()>3) Output("fat node %d\n", objs.size());
+	std::vector<BuildNode> build;
+	build.reserve(numObjs * 2);
+	BuildBinary(build, order, objAabbs, centroids.data(), 0, numObjs, 0);
+	m_aabb = build[0].aabb;
+
+	m_objPtrs.resize(numObjs);
+	for (int i = 0; i < numObjs; i++)
+		m_objPtrs[i] = objPtrs[order[i]];
 
-	// copy tri indices to the stinking flat array
-	for (int i = numTris - 1; i >= 0; i--) {
-		m_objPtrAlloc[m_objPtrAllocPos++] = objPtrs[objs[i]];
+	m_nodes.reserve(build.size() / 2 + 1);
+	if (build[0].kids[0] < 0) {
+		// a lone leaf still gets a root node to live in
+		m_nodes.resize(1);
+		SetKid(m_nodes[0], 0, 0, numObjs, m_aabb);
+		for (int i = 1; i < 4; i++)
+			ClearKid(m_nodes[0], i);
+	} else {
+		BuildWide(build, 0);
 	}
+	m_nodes.shrink_to_fit();
 }
 
-void BVHTree::BuildNode(BVHNode *node,
-	const objPtr_t *objPtrs,
-	const Aabb *objAabbs,
-	std::vector<objPtr_t> &activeObjIdx)
+// the nodes are saved as they are in memory
+static_assert(sizeof(BVHNode) == 128, "BVHNode is padded differently on this platform and will not serialize properly.");
+
+BVHTree::BVHTree(Serializer::Reader &rd)
 {
-	const int numTris = activeObjIdx.size();
-	if (numTris <= 0) Error("BuildNode called with no elements in activeObjIndex.");
+	PROFILE_SCOPED()
+	rd >> m_aabb;
+	const size_t numNodes = rd.ArrayCount<BVHNode>();
+	m_nodes.resize(numNodes);
+	rd.Array(m_nodes.data(), m_nodes.size());
+	const size_t numObjPtrs = rd.ArrayCount<objPtr_t>();
+	m_objPtrs.resize(numObjPtrs);
+	rd.Array(m_objPtrs.data(), m_objPtrs.size());
 
-	if (numTris == 1) {
-		MakeLeaf(node, objPtrs, activeObjIdx);
-		return;
-	}
+	if (m_nodes.empty())
+		throw std::out_of_range("BVHTree has no root node.");
+}
 
-	std::vector<int> splitSides(numTris);
+void BVHTree::Save(Serializer::Writer &wr) const
+{
+	PROFILE_SCOPED()
+	wr << m_aabb;
+	wr.Int32(m_nodes.size());
+	wr.Array(m_nodes.data(), m_nodes.size());
+	wr.Int32(m_objPtrs.size());
+	wr.Array(m_objPtrs.data(), m_objPtrs.size());
+}
 
-	Aabb aabb;
-	aabb.min = vector3d(FLT_MAX, FLT_MAX, FLT_MAX);
-	aabb.max = vector3d(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+// Builds a binary tree over order[first, first + count), partitioning order in place
+int BVHTree::BuildBinary(std::vector<BuildNode> &build, std::vector<int> &order, const Aabb *objAabbs, const vector3d *centroids, int first, int count, int depth)
+{
+	const int nodeIdx = int(build.size());
+	build.emplace_back();
 
-	for (int i = 0; i < numTris; i++) {
-		const int idx = activeObjIdx[i];
-		aabb.Update(objAabbs[idx].min);
-		aabb.Update(objAabbs[idx].max);
+	Aabb aabb = EmptyAabb();
+	Aabb centroidBounds = EmptyAabb();
+	for (int i = first; i < first + count; i++) {
+		Grow(aabb, objAabbs[order[i]]);
+		centroidBounds.Update(centroids[order[i]]);
 	}
-	node->numTris = numTris;
-	node->aabb = aabb;
-
-	Aabb splitBox = aabb;
-	double splitPos;
-	int splitAxis;
-	int s1count, s2count;
-	int attempt = 0;
-
-	for (;;) {
-		splitAxis = 0;
-
-		const vector3d boxSize = splitBox.max - splitBox.min;
-
-		if (boxSize[1] > boxSize[0]) splitAxis = 1;
-		if ((boxSize[2] > boxSize[1]) && (boxSize[2] > boxSize[0])) splitAxis = 2;
-
-		// split pos in middle of splitBox
-		splitPos = 0.5f * (splitBox.min[splitAxis] + splitBox.max[splitAxis]);
-		s1count = 0, s2count = 0;
-
-		for (int i = 0; i < numTris; i++) {
-			const int idx = activeObjIdx[i];
-			const double mid = 0.5 * (objAabbs[idx].min[splitAxis] + objAabbs[idx].max[splitAxis]);
-			if (mid < splitPos) {
-				splitSides[i] = 0;
-				s1count++;
-			} else {
-				splitSides[i] = 1;
-				s2count++;
-			}
+	build[nodeIdx].aabb = aabb;
+	build[nodeIdx].kids[0] = build[nodeIdx].kids[1] = -1;
+	build[nodeIdx].first = first;
+	build[nodeIdx].count = count;
+
+	if (count == 1 || depth >= MAX_DEPTH)
+		return nodeIdx;
+
+	// find the cheapest split between bins along each axis
+	const double area = HalfArea(aabb);
+	double bestCost = DBL_MAX;
+	int bestAxis = -1;
+	int bestBin = 0;
+	for (int axis = 0; axis < 3; axis++) {
+		const double cmin = centroidBounds.min[axis];
+		const double extent = centroidBounds.max[axis] - cmin;
+		if (extent <= 0.0)
+			continue;
+		const double scale = NUM_BINS * (1.0 - 1e-6) / extent;
+
+		int binCounts[NUM_BINS] = {};
+		Aabb binBounds[NUM_BINS];
+		for (int b = 0; b < NUM_BINS; b++)
+			binBounds[b] = EmptyAabb();
+		for (int i = first; i < first + count; i++) {
+			const int b = std::min(NUM_BINS - 1, int((centroids[order[i]][axis] - cmin) * scale));
+			binCounts[b]++;
+			Grow(binBounds[b], objAabbs[order[i]]);
 		}
 
-		if (s1count == numTris) {
-			if (attempt < MAX_SPLITPOS_RETRIES) {
-				// try splitting at average point
-				splitBox.max[splitAxis] = splitPos;
-				attempt++;
-				continue;
-			} else {
-				MakeLeaf(node, objPtrs, activeObjIdx);
-				return;
-			}
-		} else if (s2count == numTris) {
-			if (attempt < MAX_SPLITPOS_RETRIES) {
-				// try splitting at average point
-				splitBox.min[splitAxis] = splitPos;
-				attempt++;
+		// sweep from the right, then from the left
+		double rightCost[NUM_BINS];
+		Aabb bounds = EmptyAabb();
+		int n = 0;
+		for (int b = NUM_BINS - 1; b > 0; b--) {
+			n += binCounts[b];
+			Grow(bounds, binBounds[b]);
+			rightCost[b] = n ? n * HalfArea(bounds) : 0.0;
+		}
+		bounds = EmptyAabb();
+		n = 0;
+		for (int b = 0; b < NUM_BINS - 1; b++) {
+			n += binCounts[b];
+			Grow(bounds, binBounds[b]);
+			if (n == 0 || n == count)
 				continue;
-			} else {
-				MakeLeaf(node, objPtrs, activeObjIdx);
-				return;
+			const double cost = n * HalfArea(bounds) + rightCost[b + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
 			}
 		}
-		break;
 	}
 
-	std::vector<int> side[2];
-	side[0].reserve(numTris);
-	side[1].reserve(numTris);
+	int numLeft = 0;
+	if (bestAxis >= 0) {
+		const double splitCost = TRAVERSAL_COST + (area > 0.0 ? bestCost / area : double(count));
+		if (count <= MAX_LEAF_OBJS && splitCost >= double(count))
+			return nodeIdx;
 
-	for (int i = 0; i < numTris; i++) {
-		side[splitSides[i]].push_back(activeObjIdx[i]);
+		const double cmin = centroidBounds.min[bestAxis];
+		const double scale = NUM_BINS * (1.0 - 1e-6) / (centroidBounds.max[bestAxis] - cmin);
+		auto mid = std::partition(order.begin() + first, order.begin() + first + count, [&](int obj) {
+			return std::min(NUM_BINS - 1, int((centroids[obj][bestAxis] - cmin) * scale)) <= bestBin;
+		});
+		numLeft = int(mid - (order.begin() + first));
+	} else if (count <= MAX_LEAF_OBJS) {
+		// all centroids coincide, nothing to split on
+		return nodeIdx;
 	}
+	if (numLeft == 0 || numLeft == count)
+		numLeft = count / 2;
 
-	// recurse!
-	node->triIndicesStart = 0;
-	node->kids[0] = AllocNode();
-	node->kids[1] = AllocNode();
+	const int left = BuildBinary(build, order, objAabbs, centroids, first, numLeft, depth + 1);
+	const int right = BuildBinary(build, order, objAabbs, centroids, first + numLeft, count - numLeft, depth + 1);
+	build[nodeIdx].kids[0] = left;
+	build[nodeIdx].kids[1] = right;
+	return nodeIdx;
+}
 
-	BuildNode(node->kids[0], objPtrs, objAabbs, side[0]);
-	BuildNode(node->kids[1], objPtrs, objAabbs, side[1]);
+// Collapses an interior binary node and up to two levels below it into one four-wide node
+int BVHTree::BuildWide(const std::vector<BuildNode> &build, int buildIdx)
+{
+	const BuildNode &bn = build[buildIdx];
+	assert(bn.kids[0] >= 0);
+
+	int kids[4] = { bn.kids[0], bn.kids[1], -1, -1 };
+	int numKids = 2;
+	while (numKids < 4) {
+		// open up the largest interior child
+		int best = -1;
+		double bestArea = -1.0;
+		for (int i = 0; i < numKids; i++) {
+			const BuildNode &kid = build[kids[i]];
+			if (kid.kids[0] >= 0 && HalfArea(kid.aabb) > bestArea) {
+				bestArea = HalfArea(kid.aabb);
+				best = i;
+			}
+		}
+		if (best < 0)
+			break;
+		const BuildNode &opened = build[kids[best]];
+		kids[best] = opened.kids[0];
+		kids[numKids++] = opened.kids[1];
+	}
+
+	const int nodeIdx = int(m_nodes.size());
+	m_nodes.emplace_back();
+	for (int i = 0; i < 4; i++) {
+		// m_nodes grows while recursing so don't hold a reference across it
+		if (i >= numKids) {
+			ClearKid(m_nodes[nodeIdx], i);
+			continue;
+		}
+
+		const BuildNode &kid = build[kids[i]];
+		int index, numObjs;
+		if (kid.kids[0] < 0) {
+			index = kid.first;
+			numObjs = kid.count;
+		} else {
+			index = BuildWide(build, kids[i]);
+			numObjs = 0;
+		}
+
+		SetKid(m_nodes[nodeIdx], i, index, numObjs, kid.aabb);
+	}
+	return nodeIdx;
 }
@@ -5,64 +5,88 @@
 #define _BVHTREE_H
 
 #include "../Aabb.h"
-#include "../utils.h"
 #include "../vector3.h"
 #include <assert.h>
 #include <vector>
 
-struct BVHNode {
-	Aabb aabb;
+namespace Serializer {
+	class Reader;
+	class Writer;
+} // namespace Serializer
 
-	/* if triIndicesStart == 0 then not leaf,
-	 * kids[] valid */
-	int numTris;
-	int *triIndicesStart;
+/*
+ * Four-wide BVH node. The bounds of all four children are stored side by
+ * side (structure of arrays) so a ray can be tested against them at once.
+ *
+ * For each child:
+ *  numObjs[i] > 0: leaf, kids[i] is the offset of its first object in BVHTree::GetObjPtrs()
+ *  numObjs[i] == 0 && kids[i] > 0: interior, kids[i] is the index of the child node
+ *  kids[i] < 0: unused
+ */
+struct alignas(64) BVHNode {
+	float minX[4], minY[4], minZ[4];
+	float maxX[4], maxY[4], maxZ[4];
+	int kids[4];
+	int numObjs[4];
 
-	BVHNode *kids[2];
-
-	BVHNode() :
-		numTris(0),
-		triIndicesStart(nullptr)
-	{
-		kids[0] = nullptr;
-		kids[1] = nullptr;
-	}
-	bool IsLeaf() const
+	bool IsUsed(int i) const { return kids[i] >= 0; }
+	bool IsLeaf(int i) const { return numObjs[i] > 0; }
+	Aabb GetKidAabb(int i) const
 	{
-		return triIndicesStart != nullptr;
+		Aabb aabb;
+		aabb.min = vector3d(minX[i], minY[i], minZ[i]);
+		aabb.max = vector3d(maxX[i], maxY[i], maxZ[i]);
+		return aabb;
 	}
 };
 
+/*
+ * Bounding volume hierarchy over a set of objects (triangles or edges),
+ * built with a binned surface area heuristic and then collapsed into a
+ * flat array of BVHNodes in depth-first order. Node 0 is the root.
+ */
 class BVHTree {
 public:
 	typedef int objPtr_t;
+
+	// A subtree: either a node (numObjs == 0) or a leaf range of objects
+	struct NodeRef {
+		int index;
+		int numObjs;
+		bool IsLeaf() const { return numObjs > 0; }
+	};
+
+	// Binary split depth is capped so traversal can use fixed size stacks:
+	// each level of a four-wide node pushes at most three more entries.
+	static constexpr int MAX_DEPTH = 48;
+	static constexpr int MAX_STACK_SIZE = 3 * MAX_DEPTH + 1;
+
 	BVHTree(const int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs);
-	~BVHTree()
-	{
-		delete[] m_objPtrAlloc;
-		delete[] m_bvhNodes;
-	}
-	BVHNode *GetRoot() { return m_root; }
+	// a tree as saved, without building it again
+	explicit BVHTree(Serializer::Reader &rd);
+	void Save(Serializer::Writer &wr) const;
+
+	NodeRef GetRoot() const { return { 0, 0 }; }
+	static NodeRef GetKid(const BVHNode &node, int i) { return { node.kids[i], node.numObjs[i] }; }
+
+	const BVHNode &GetNode(int index) const { return m_nodes[index]; }
+	const objPtr_t *GetObjPtrs() const { return m_objPtrs.data(); }
+	const Aabb &GetAabb() const { return m_aabb; }
+	size_t GetNumNodes() const { return m_nodes.size(); }
 
 private:
-	void BuildNode(BVHNode *node,
-		const objPtr_t *objPtrs,
-		const Aabb *objAabbs,
-		std::vector<objPtr_t> &activeObjIdxs);
-	void MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPtr_t> &objs);
-	BVHNode *AllocNode()
-	{
-		if (m_nodeAllocPos >= m_nodeAllocMax) Error("Out of space in m_bvhNodes.");
-		return &m_bvhNodes[m_nodeAllocPos++];
-	}
-	BVHNode *m_root;
-	objPtr_t *m_objPtrAlloc;
-	size_t m_objPtrAllocPos;
-	size_t m_objPtrAllocMax;
+	struct BuildNode {
+		Aabb aabb;
+		int kids[2]; // -1 for a leaf
+		int first, count;
+	};
+
+	int BuildBinary(std::vector<BuildNode> &build, std::vector<int> &order, const Aabb *objAabbs, const vector3d *centroids, int first, int count, int depth);
+	int BuildWide(const std::vector<BuildNode> &build, int buildIdx);
 
-	BVHNode *m_bvhNodes;
-	size_t m_nodeAllocPos;
-	size_t m_nodeAllocMax;
+	Aabb m_aabb;
+	std::vector<BVHNode> m_nodes;
+	std::vector<objPtr_t> m_objPtrs;
 };
 
 #endif /* _BVHTREE_H */
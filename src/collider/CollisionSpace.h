@@ -5,7 +5,8 @@
 #define _COLLISION_SPACE
 
 #include "../vector3.h"
-#include <list>
+#include "DynamicAabbTree.h"
+#include <vector>
 
 class Geom;
 struct isect_t;
@@ -17,13 +18,11 @@ struct Sphere {
 	void *userData;
 };
 
-class BvhTree;
-
 /*
  * Collision spaces have a bunch of geoms and at most one sphere (for a planet).
+ * Static and dynamic geoms are kept in separate broadphase trees, which are
+ * updated in place as geoms are added, removed and moved.
  */
-// FIXME: CollisionSpace is NOT MOVE/COPY CONSTRUCTIBLE once RebuildObjectTrees
-// has been called. It will cause a double-free due to owning pointers being moved-by-copy.
 class CollisionSpace {
 public:
 	CollisionSpace();
@@ -32,6 +31,11 @@ public:
 	void RemoveGeom(Geom *);
 	void AddStaticGeom(Geom *);
 	void RemoveStaticGeom(Geom *);
+	// Only reads the broadphase, so rays may be cast from several threads at
+	// once. It sees geoms where they were added, or where the last Collide
+	// (or RebuildObjectTrees) found them: Geom::MoveTo doesn't touch the
+	// trees, as it runs on the integration workers. A geom which has moved
+	// further than its fat aabb's margin since then may be missed.
 	void TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore = nullptr);
 	void Collide(void (*callback)(CollisionContact *));
 	void SetSphere(const vector3d &pos, double radius, void *user_data)
@@ -40,7 +44,9 @@ public:
 		sphere.radius = radius;
 		sphere.userData = user_data;
 	}
+	// static geoms are only moved in the broadphase when flagged
 	void FlagRebuildObjectTrees() { m_needStaticGeomRebuild = true; }
+	// bring the broadphase up to date with where the geoms are now
 	void RebuildObjectTrees();
 
 	// Geoms with the same handle will not be collision tested against each other
@@ -54,17 +60,26 @@ public:
 	}
 
 private:
+	struct GeomProxy {
+		Geom *geom;
+		int proxy;
+		// where the broadphase last saw it, to predict its movement
+		vector3d lastPos;
+	};
+
+	static void AddProxy(DynamicAabbTree &tree, std::vector<GeomProxy> &geoms, Geom *geom);
+	static void RemoveProxy(DynamicAabbTree &tree, std::vector<GeomProxy> &geoms, Geom *geom);
+	static void UpdateProxy(DynamicAabbTree &tree, GeomProxy &gp);
+
 	void CollideGeoms(Geom *a, int minMailboxValue, void (*callback)(CollisionContact *));
 	void CollideRaySphere(const vector3d &start, const vector3d &dir, isect_t *isect);
-	std::list<Geom *> m_geoms;
-	std::list<Geom *> m_staticGeoms;
+	std::vector<GeomProxy> m_geoms;
+	std::vector<GeomProxy> m_staticGeoms;
 	bool m_needStaticGeomRebuild;
-	BvhTree *m_staticObjectTree;
-	BvhTree *m_dynamicObjectTree;
+	DynamicAabbTree m_staticObjectTree;
+	DynamicAabbTree m_dynamicObjectTree;
 	Sphere sphere;
 
-	uint32_t m_oldGeomsNumber;
-
 	static int s_nextHandle;
 };
 
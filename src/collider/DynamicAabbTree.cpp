@@ -0,0 +1,240 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DynamicAabbTree.h"
+
+#include <algorithm>
+
+static Aabb Union(const Aabb &a, const Aabb &b)
+{
+	Aabb aabb;
+	aabb.min = vector3d(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z));
+	aabb.max = vector3d(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z));
+	return aabb;
+}
+
+static bool Contains(const Aabb &outer, const Aabb &inner)
+{
+	return (outer.min.x <= inner.min.x) && (outer.min.y <= inner.min.y) && (outer.min.z <= inner.min.z) &&
+		(inner.max.x <= outer.max.x) && (inner.max.y <= outer.max.y) && (inner.max.z <= outer.max.z);
+}
+
+// a fat aabb left much bigger than needed by a fast move has to be shrunk again,
+// or a geom which has stopped would keep overlapping everything along its old path
+static bool IsTooLoose(const Aabb &current, const Aabb &wanted)
+{
+	const vector3d c = current.max - current.min;
+	const vector3d w = wanted.max - wanted.min;
+	return (c.x > 4.0 * w.x) || (c.y > 4.0 * w.y) || (c.z > 4.0 * w.z);
+}
+
+// half the surface area, only ever compared
+static double Area(const Aabb &aabb)
+{
+	const vector3d d = aabb.max - aabb.min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+DynamicAabbTree::DynamicAabbTree() :
+	m_root(NULL_NODE),
+	m_freeList(NULL_NODE)
+{
+}
+
+int DynamicAabbTree::AllocNode()
+{
+	int node;
+	if (m_freeList != NULL_NODE) {
+		node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+	} else {
+		node = int(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	Node &n = m_nodes[node];
+	n.geom = nullptr;
+	n.parent = NULL_NODE;
+	n.kids[0] = n.kids[1] = NULL_NODE;
+	n.height = 0;
+	return node;
+}
+
+void DynamicAabbTree::FreeNode(int node)
+{
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+
+int DynamicAabbTree::CreateProxy(const Aabb &fatAabb, Geom *geom)
+{
+	const int proxy = AllocNode();
+	m_nodes[proxy].aabb = fatAabb;
+	m_nodes[proxy].geom = geom;
+	InsertLeaf(proxy);
+	return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy(int proxy)
+{
+	assert(m_nodes[proxy].IsLeaf() && m_nodes[proxy].height == 0);
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+}
+
+bool DynamicAabbTree::MoveProxy(int proxy, const Aabb &aabb, const Aabb &fatAabb)
+{
+	assert(m_nodes[proxy].IsLeaf() && m_nodes[proxy].height == 0);
+	if (Contains(m_nodes[proxy].aabb, aabb) && !IsTooLoose(m_nodes[proxy].aabb, fatAabb))
+		return false;
+
+	RemoveLeaf(proxy);
+	m_nodes[proxy].aabb = fatAabb;
+	InsertLeaf(proxy);
+	return true;
+}
+
+void DynamicAabbTree::InsertLeaf(int leaf)
+{
+	if (m_root == NULL_NODE) {
+		m_root = leaf;
+		m_nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	// allocate the new parent up front, m_nodes may grow
+	const int newParent = AllocNode();
+
+	// walk down to the sibling which makes for the smallest total area
+	const Aabb leafAabb = m_nodes[leaf].aabb;
+	int index = m_root;
+	while (!m_nodes[index].IsLeaf()) {
+		const Node &node = m_nodes[index];
+		const double area = Area(node.aabb);
+		const double combinedArea = Area(Union(node.aabb, leafAabb));
+
+		// cost of making a new parent for this node and the leaf
+		const double cost = 2.0 * combinedArea;
+		// cost of pushing the leaf further down
+		const double inheritanceCost = 2.0 * (combinedArea - area);
+
+		double kidCost[2];
+		for (int i = 0; i < 2; i++) {
+			const Node &kid = m_nodes[node.kids[i]];
+			const double newArea = Area(Union(leafAabb, kid.aabb));
+			kidCost[i] = (kid.IsLeaf() ? newArea : newArea - Area(kid.aabb)) + inheritanceCost;
+		}
+
+		if (cost < kidCost[0] && cost < kidCost[1])
+			break;
+		index = kidCost[0] < kidCost[1] ? node.kids[0] : node.kids[1];
+	}
+
+	const int sibling = index;
+	const int oldParent = m_nodes[sibling].parent;
+	Node &parent = m_nodes[newParent];
+	parent.parent = oldParent;
+	parent.aabb = Union(leafAabb, m_nodes[sibling].aabb);
+	parent.height = m_nodes[sibling].height + 1;
+	parent.kids[0] = sibling;
+	parent.kids[1] = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE) {
+		Node &op = m_nodes[oldParent];
+		op.kids[op.kids[0] == sibling ? 0 : 1] = newParent;
+	} else {
+		m_root = newParent;
+	}
+
+	Refit(newParent);
+}
+
+void DynamicAabbTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_root) {
+		m_root = NULL_NODE;
+		return;
+	}
+
+	const int parent = m_nodes[leaf].parent;
+	const int grandParent = m_nodes[parent].parent;
+	const int sibling = m_nodes[parent].kids[m_nodes[parent].kids[0] == leaf ? 1 : 0];
+
+	FreeNode(parent);
+	if (grandParent != NULL_NODE) {
+		// the sibling takes the parent's place
+		Node &gp = m_nodes[grandParent];
+		gp.kids[gp.kids[0] == parent ? 0 : 1] = sibling;
+		m_nodes[sibling].parent = grandParent;
+		Refit(grandParent);
+	} else {
+		m_root = sibling;
+		m_nodes[sibling].parent = NULL_NODE;
+	}
+}
+
+// walk from node up to the root fixing bounds and heights, balancing on the way
+void DynamicAabbTree::Refit(int index)
+{
+	while (index != NULL_NODE) {
+		index = Balance(index);
+
+		Node &node = m_nodes[index];
+		const Node &kid0 = m_nodes[node.kids[0]];
+		const Node &kid1 = m_nodes[node.kids[1]];
+		node.height = 1 + std::max(kid0.height, kid1.height);
+		node.aabb = Union(kid0.aabb, kid1.aabb);
+
+		index = node.parent;
+	}
+}
+
+// If one subtree of a is more than one level taller than the other, rotate
+// the taller child up into a's place. Returns the index of the new subtree root.
+int DynamicAabbTree::Balance(int iA)
+{
+	Node &a = m_nodes[iA];
+	if (a.IsLeaf() || a.height < 2)
+		return iA;
+
+	const int iB = a.kids[0];
+	const int iC = a.kids[1];
+	const int balance = m_nodes[iC].height - m_nodes[iB].height;
+	if (balance >= -1 && balance <= 1)
+		return iA;
+
+	// the taller child (up) and the other one (other), and which slot of a each is in
+	const int upSlot = balance > 1 ? 1 : 0;
+	const int iUp = a.kids[upSlot];
+	const int iOther = a.kids[1 - upSlot];
+	Node &up = m_nodes[iUp];
+	const int iF = up.kids[0];
+	const int iG = up.kids[1];
+
+	// up takes a's place
+	up.kids[0] = iA;
+	up.parent = a.parent;
+	a.parent = iUp;
+	if (up.parent != NULL_NODE) {
+		Node &p = m_nodes[up.parent];
+		p.kids[p.kids[0] == iA ? 0 : 1] = iUp;
+	} else {
+		m_root = iUp;
+	}
+
+	// up keeps its taller child, its shorter one goes to a
+	const bool keepF = m_nodes[iF].height > m_nodes[iG].height;
+	const int iKeep = keepF ? iF : iG;
+	const int iGive = keepF ? iG : iF;
+	up.kids[1] = iKeep;
+	a.kids[upSlot] = iGive;
+	m_nodes[iGive].parent = iA;
+
+	a.aabb = Union(m_nodes[iOther].aabb, m_nodes[iGive].aabb);
+	a.height = 1 + std::max(m_nodes[iOther].height, m_nodes[iGive].height);
+	up.aabb = Union(a.aabb, m_nodes[iKeep].aabb);
+	up.height = 1 + std::max(a.height, m_nodes[iKeep].height);
+	return iUp;
+}
@@ -0,0 +1,139 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _DYNAMICAABBTREE_H
+#define _DYNAMICAABBTREE_H
+
+#include "../Aabb.h"
+#include <assert.h>
+#include <vector>
+
+class Geom;
+
+/*
+ * Incrementally updated bounding volume tree of geoms, used as the
+ * CollisionSpace broadphase.
+ *
+ * Each geom (proxy) is stored with a "fat" aabb, larger than the geom so
+ * that it can move a bit without the tree changing. When it moves out of its
+ * fat aabb it is removed and reinserted, with the tree kept balanced by
+ * rotations as it goes. Nodes live in one array and are recycled through a
+ * free list, proxy ids are node indices and stay valid until destroyed.
+ */
+class DynamicAabbTree {
+public:
+	static constexpr int NULL_NODE = -1;
+
+	DynamicAabbTree();
+
+	int CreateProxy(const Aabb &fatAabb, Geom *geom);
+	void DestroyProxy(int proxy);
+	// returns true if the proxy had to be reinserted with the new fat aabb,
+	// false if its current one still contains aabb and isn't far bigger than fatAabb
+	bool MoveProxy(int proxy, const Aabb &aabb, const Aabb &fatAabb);
+
+	Geom *GetGeom(int proxy) const { return m_nodes[proxy].geom; }
+	const Aabb &GetFatAabb(int proxy) const { return m_nodes[proxy].aabb; }
+	int GetHeight() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].height; }
+
+	// calls callback(Geom *) for every proxy whose fat aabb intersects aabb
+	template <typename F>
+	void Query(const Aabb &aabb, F &&callback) const;
+
+	// calls callback(Geom *) for every proxy whose fat aabb the ray enters
+	// before maxDist, which the callback may reduce as it finds hits. The fat
+	// aabbs are as of the last CreateProxy or MoveProxy, the tree doesn't
+	// follow the geoms by itself.
+	template <typename F>
+	void RayCast(const vector3d &start, const vector3d &invDir, const double &maxDist, F &&callback) const;
+
+private:
+	// enough for the height of a balanced tree of more proxies than there is memory for
+	static constexpr int MAX_STACK_SIZE = 64;
+
+	struct Node {
+		Aabb aabb;
+		Geom *geom;
+		// next free node when this one is free
+		int parent;
+		int kids[2];
+		// leaves are 0, free nodes -1
+		int height;
+
+		bool IsLeaf() const { return kids[0] == NULL_NODE; }
+	};
+
+	int AllocNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int node);
+	void Refit(int node);
+
+	std::vector<Node> m_nodes;
+	int m_root;
+	int m_freeList;
+};
+
+template <typename F>
+void DynamicAabbTree::Query(const Aabb &aabb, F &&callback) const
+{
+	if (m_root == NULL_NODE) return;
+
+	int stack[MAX_STACK_SIZE];
+	int stackPos = 0;
+	stack[0] = m_root;
+	while (stackPos >= 0) {
+		const Node &node = m_nodes[stack[stackPos--]];
+		if (!node.aabb.Intersects(aabb)) continue;
+
+		if (node.IsLeaf()) {
+			callback(node.geom);
+		} else {
+			assert(stackPos + 2 < MAX_STACK_SIZE);
+			stack[++stackPos] = node.kids[0];
+			stack[++stackPos] = node.kids[1];
+		}
+	}
+}
+
+template <typename F>
+void DynamicAabbTree::RayCast(const vector3d &start, const vector3d &invDir, const double &maxDist, F &&callback) const
+{
+	if (m_root == NULL_NODE) return;
+
+	int stack[MAX_STACK_SIZE];
+	int stackPos = 0;
+	stack[0] = m_root;
+	while (stackPos >= 0) {
+		const Node &node = m_nodes[stack[stackPos--]];
+
+		double
+			l1 = (node.aabb.min.x - start.x) * invDir.x,
+			l2 = (node.aabb.max.x - start.x) * invDir.x,
+			lmin = std::min(l1, l2),
+			lmax = std::max(l1, l2);
+
+		l1 = (node.aabb.min.y - start.y) * invDir.y;
+		l2 = (node.aabb.max.y - start.y) * invDir.y;
+		lmin = std::max(std::min(l1, l2), lmin);
+		lmax = std::min(std::max(l1, l2), lmax);
+
+		l1 = (node.aabb.min.z - start.z) * invDir.z;
+		l2 = (node.aabb.max.z - start.z) * invDir.z;
+		lmin = std::max(std::min(l1, l2), lmin);
+		lmax = std::min(std::max(l1, l2), lmax);
+
+		if (!((lmax >= 0.0) & (lmax >= lmin) & (lmin < maxDist))) continue;
+
+		if (node.IsLeaf()) {
+			callback(node.geom);
+		} else {
+			assert(stackPos + 2 < MAX_STACK_SIZE);
+			stack[++stackPos] = node.kids[0];
+			stack[++stackPos] = node.kids[1];
+		}
+	}
+}
+
+#endif /* _DYNAMICAABBTREE_H */
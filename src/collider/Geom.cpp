@@ -94,7 +94,8 @@ void Geom::Collide(Geom *b, void (*callback)(CollisionContact *)) const
 	//	Output("%d 'rays' in %dms (%f rps)\n", numEdges, t, 1000.0*numEdges / (double)t);
 }
 
-static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &b)
+// aabb of a, transformed by transA
+static Aabb rotatedAabb(const Aabb &a, const matrix4x4d &transA)
 {
 	Aabb arot;
 	vector3d p[8];
@@ -109,7 +110,7 @@ static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &
 	arot.min = arot.max = p[0];
 	for (int i = 1; i < 8; i++)
 		arot.Update(p[i]);
-	return b.Intersects(arot);
+	return arot;
 }
 
 /*
@@ -119,55 +120,58 @@ static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &
 void Geom::CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact *)) const
 {
 	PROFILE_SCOPED()
+	const BVHTree *edgeTree = GetGeomTree()->GetEdgeTree();
+	const BVHTree *triTree = b->GetGeomTree()->GetTriTree();
 	struct stackobj {
-		BVHNode *edgeNode;
-		BVHNode *triNode;
-	} stack[32];
+		BVHTree::NodeRef edgeNode;
+		Aabb edgeAabb;
+		BVHTree::NodeRef triNode;
+	} stack[BVHTree::MAX_STACK_SIZE];
 	int stackpos = 0;
 
-	stack[0].edgeNode = GetGeomTree()->GetEdgeTree()->GetRoot();
-	stack[0].triNode = b->GetGeomTree()->GetTriTree()->GetRoot();
+	stack[0].edgeNode = edgeTree->GetRoot();
+	stack[0].edgeAabb = edgeTree->GetAabb();
+	stack[0].triNode = triTree->GetRoot();
 
 	while ((stackpos >= 0) && (maxContacts > 0)) {
-		BVHNode *edgeNode = stack[stackpos].edgeNode;
-		BVHNode *triNode = stack[stackpos].triNode;
+		const stackobj top = stack[stackpos];
 		stackpos--;
 
-		// does the edgeNode (with its aabb described in 6 planes transformed and rotated to
-		// b's coordinates) intersect with one or other of b's child nodes?
-		if (triNode->triIndicesStart || edgeNode->triIndicesStart) {
+		if (top.triNode.IsLeaf() || top.edgeNode.IsLeaf()) {
 			// reached triangle leaf node or edge leaf node.
 			// Intersect all edges under edgeNode with this leaf
-			CollideEdgesTris(maxContacts, edgeNode, transTo, b, triNode, callback);
-		} else {
-			BVHNode *left = triNode->kids[0];
-			BVHNode *right = triNode->kids[1];
-			bool edgeNodeIsectsLeftChild = rotatedAabbIsectsNormalOne(edgeNode->aabb, transTo, left->aabb);
-			bool edgeNodeIsectsRightChild = rotatedAabbIsectsNormalOne(edgeNode->aabb, transTo, right->aabb);
-			//edgeNodeIsectsRightChild = edgeNodeIsectsLeftChild = true;
-			if (edgeNodeIsectsRightChild) {
-				if (edgeNodeIsectsLeftChild) {
-					// isects both. split edgeNode and try again
-					++stackpos;
-					stack[stackpos].edgeNode = edgeNode->kids[0];
-					stack[stackpos].triNode = triNode;
-					++stackpos;
-					stack[stackpos].edgeNode = edgeNode->kids[1];
-					stack[stackpos].triNode = triNode;
-				} else {
-					// hits only right child. go down into that
-					// side with same edge node
-					++stackpos;
-					stack[stackpos].edgeNode = edgeNode;
-					stack[stackpos].triNode = triNode->kids[1];
-				}
-			} else if (edgeNodeIsectsLeftChild) {
-				// hits only left child
+			CollideEdgesTris(maxContacts, top.edgeNode, transTo, b, top.triNode, callback);
+			continue;
+		}
+
+		// does the edgeNode (with its aabb transformed and rotated to b's
+		// coordinates) intersect with any of b's child nodes?
+		const Aabb edgeAabb = rotatedAabb(top.edgeAabb, transTo);
+		const BVHNode &triNode = triTree->GetNode(top.triNode.index);
+		int numHits = 0, hitKid = -1;
+		for (int i = 0; i < 4; i++) {
+			if (triNode.IsUsed(i) && triNode.GetKidAabb(i).Intersects(edgeAabb)) {
+				numHits++;
+				hitKid = i;
+			}
+		}
+
+		if (numHits == 1) {
+			// hits only one child. go down into that side with same edge node
+			++stackpos;
+			stack[stackpos].edgeNode = top.edgeNode;
+			stack[stackpos].edgeAabb = top.edgeAabb;
+			stack[stackpos].triNode = BVHTree::GetKid(triNode, hitKid);
+		} else if (numHits > 1) {
+			// isects several. split edgeNode and try again
+			const BVHNode &edgeNode = edgeTree->GetNode(top.edgeNode.index);
+			for (int i = 0; i < 4; i++) {
+				if (!edgeNode.IsUsed(i)) continue;
 				++stackpos;
-				stack[stackpos].edgeNode = edgeNode;
-				stack[stackpos].triNode = triNode->kids[0];
-			} else {
-				// hits none
+				assert(stackpos < BVHTree::MAX_STACK_SIZE);
+				stack[stackpos].edgeNode = BVHTree::GetKid(edgeNode, i);
+				stack[stackpos].edgeAabb = edgeNode.GetKidAabb(i);
+				stack[stackpos].triNode = top.triNode;
 			}
 		}
 	}
@@ -177,36 +181,38 @@ void Geom::CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4
  * Collide one edgeNode (all edges below it) of this Geom with the triangle
  * BVH of another geom (b), starting from btriNode.
  */
-void Geom::CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-	const Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact *)) const
+void Geom::CollideEdgesTris(int &maxContacts, const BVHTree::NodeRef &edgeNode, const matrix4x4d &transToB,
+	const Geom *b, const BVHTree::NodeRef &btriNode, void (*callback)(CollisionContact *)) const
 {
 	// PROFILE_SCOPED() // verbose profiling only, this gets called a LOT
 	if (maxContacts <= 0) return;
-	if (edgeNode->triIndicesStart) {
+	const BVHTree *edgeTree = GetGeomTree()->GetEdgeTree();
+	if (edgeNode.IsLeaf()) {
 		const GeomTree::Edge *edges = this->GetGeomTree()->GetEdges();
+		const BVHTree::objPtr_t *edgeIdxs = edgeTree->GetObjPtrs() + edgeNode.index;
 		int numContacts = 0;
 		vector3f dir;
 		isect_t isect;
 		const std::vector<vector3f> &rVertices = GetGeomTree()->GetVertices();
-		for (int i = 0; i < edgeNode->numTris; i++) {
-			const int vtxNum = edges[edgeNode->triIndicesStart[i]].v1i;
-			const vector3d v1 = transToB * vector3d(rVertices[vtxNum]);
+		for (int i = 0; i < edgeNode.numObjs; i++) {
+			const GeomTree::Edge &edge = edges[edgeIdxs[i]];
+			const vector3d v1 = transToB * vector3d(rVertices[edge.v1i]);
 			const vector3f _from(float(v1.x), float(v1.y), float(v1.z));
 
 			vector3d _dir(
-				double(edges[edgeNode->triIndicesStart[i]].dir.x),
-				double(edges[edgeNode->triIndicesStart[i]].dir.y),
-				double(edges[edgeNode->triIndicesStart[i]].dir.z));
+				double(edge.dir.x),
+				double(edge.dir.y),
+				double(edge.dir.z));
 			_dir = transToB.ApplyRotationOnly(_dir);
 			dir = vector3f(&_dir.x);
-			isect.dist = edges[edgeNode->triIndicesStart[i]].len;
+			isect.dist = edge.len;
 			isect.triIdx = -1;
 
 			b->GetGeomTree()->TraceRay(btriNode, _from, dir, &isect);
 
 			if (isect.triIdx == -1) continue;
 			numContacts++;
-			const double depth = edges[edgeNode->triIndicesStart[i]].len - isect.dist;
+			const double depth = edge.len - isect.dist;
 			// in world coords
 			CollisionContact contact;
 			contact.pos = b->GetTransform() * (v1 + vector3d(&dir.x) * double(isect.dist));
@@ -221,12 +227,15 @@ void Geom::CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const mat
 			contact.userData2 = b->m_data;
 			// contact geomFlag is bitwise OR of triangle's and edge's flags
 			contact.geomFlag = b->m_geomtree->GetTriFlag(isect.triIdx) |
-				edges[edgeNode->triIndicesStart[i]].triFlag;
+				edge.triFlag;
 			callback(&contact);
 			if (--maxContacts <= 0) return;
 		}
 	} else {
-		CollideEdgesTris(maxContacts, edgeNode->kids[0], transToB, b, btriNode, callback);
-		CollideEdgesTris(maxContacts, edgeNode->kids[1], transToB, b, btriNode, callback);
+		const BVHNode &node = edgeTree->GetNode(edgeNode.index);
+		for (int i = 0; i < 4; i++) {
+			if (node.IsUsed(i))
+				CollideEdgesTris(maxContacts, BVHTree::GetKid(node, i), transToB, b, btriNode, callback);
+		}
 	}
 }
@@ -6,12 +6,12 @@
 
 #include "../matrix4x4.h"
 #include "../vector3.h"
+#include "BVHTree.h"
 
 struct CollisionContact;
 class GeomTree;
 struct isect_t;
 struct Sphere;
-struct BVHNode;
 
 class Geom {
 public:
@@ -38,8 +38,8 @@ public:
 
 private:
 	void CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact *)) const;
-	void CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-		const Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact *)) const;
+	void CollideEdgesTris(int &maxContacts, const BVHTree::NodeRef &edgeNode, const matrix4x4d &transToB,
+		const Geom *b, const BVHTree::NodeRef &btriNode, void (*callback)(CollisionContact *)) const;
 
 	// double-buffer position so we can keep previous position
 	matrix4x4d m_orient, m_invOrient;
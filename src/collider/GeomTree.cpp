@@ -9,6 +9,11 @@
 
 #pragma GCC optimize("O3")
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define GEOMTREE_SIMD_SSE 1
+#include <xmmintrin.h>
+#endif
+
 GeomTree::~GeomTree()
 {
 }
@@ -146,128 +151,202 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 GeomTree::GeomTree(Serializer::Reader &rd)
 {
 	PROFILE_SCOPED()
-	m_numVertices = rd.Int32();
-	m_numEdges = rd.Int32();
-	m_numTris = rd.Int32();
+	// the counts are checked against what's left before anything is allocated,
+	// so a corrupt file throws rather than asking for gigabytes
+	const size_t numVertices = rd.ArrayCount<vector3f>();
+	const size_t numEdges = rd.ArrayCount<Edge>();
+	const size_t numTris = rd.ArrayCount<Uint32>();
+	rd.CheckArray<Uint32>(numTris * 3);
+	m_numVertices = int(numVertices);
+	m_numEdges = int(numEdges);
+	m_numTris = int(numTris);
 	m_radius = rd.Double();
 
 	m_aabb.max = rd.Vector3d();
 	m_aabb.min = rd.Vector3d();
 	m_aabb.radius = rd.Double();
 
-	const Uint32 numAabbs = rd.Int32();
+	const size_t numAabbs = rd.ArrayCount<Aabb>();
 	m_aabbs.resize(numAabbs);
-	for (Uint32 iAabb = 0; iAabb < numAabbs; ++iAabb) {
-		rd >> m_aabbs[iAabb];
-	}
+	rd.Array(m_aabbs.data(), m_aabbs.size());
 
-	{
-		PROFILE_SCOPED_DESC("GeomTree::LoadEdges")
-		m_edges.resize(m_numEdges);
-		for (Sint32 iEdge = 0; iEdge < m_numEdges; ++iEdge) {
-			auto &ed = m_edges[iEdge];
-			rd >> ed.v1i >> ed.v2i >> ed.len >> ed.dir >> ed.triFlag;
-		}
-	}
+	rd.CheckArray<Edge>(numEdges);
+	m_edges.resize(numEdges);
+	rd.Array(m_edges.data(), m_edges.size());
 
-	m_vertices.resize(m_numVertices);
-	for (Sint32 iVert = 0; iVert < m_numVertices; ++iVert) {
-		m_vertices[iVert] = rd.Vector3f();
-	}
+	rd.CheckArray<vector3f>(numVertices);
+	m_vertices.resize(numVertices);
+	rd.Array(m_vertices.data(), m_vertices.size());
 
-	const int numIndicies(m_numTris * 3);
-	m_indices.resize(numIndicies);
-	for (Sint32 iIndi = 0; iIndi < numIndicies; ++iIndi) {
-		m_indices[iIndi] = rd.Int32();
-	}
+	rd.CheckArray<Uint32>(numTris * 3);
+	m_indices.resize(numTris * 3);
+	rd.Array(m_indices.data(), m_indices.size());
 
-	m_triFlags.resize(m_numTris);
-	for (Sint32 iTri = 0; iTri < m_numTris; ++iTri) {
-		m_triFlags[iTri] = rd.Int32();
-	}
+	rd.CheckArray<Uint32>(numTris);
+	m_triFlags.resize(numTris);
+	rd.Array(m_triFlags.data(), m_triFlags.size());
 
-	// activeTris = tris we are still trying to put into leaves
-	std::vector<int> activeTris;
-	activeTris.reserve(m_numTris);
-	for (int i = 0; i < m_numTris; i++) {
-		activeTris.push_back(i * 3);
-	}
+	m_triTree.reset(new BVHTree(rd));
+	m_edgeTree.reset(new BVHTree(rd));
+}
 
-	// regenerate the aabb data
-	Aabb *aabbs = new Aabb[activeTris.size()];
-	for (Uint32 i = 0; i < activeTris.size(); i++) {
-		const vector3d v1 = vector3d(m_vertices[m_indices[activeTris[i] + 0]]);
-		const vector3d v2 = vector3d(m_vertices[m_indices[activeTris[i] + 1]]);
-		const vector3d v3 = vector3d(m_vertices[m_indices[activeTris[i] + 2]]);
-		aabbs[i].min = aabbs[i].max = v1;
-		aabbs[i].Update(v2);
-		aabbs[i].Update(v3);
+// Slab test of a ray against all four children of a node at once.
+// Returns a mask of the children hit closer than maxDist, and their entry distances in lmin.
+static int SlabsRayAabbTest(const BVHNode &n, const vector3f &start, const vector3f &invDir, const float maxDist, float *lmin)
+{
+	// PROFILE_SCOPED()
+#ifdef GEOMTREE_SIMD_SSE
+	const __m128 ox = _mm_set1_ps(start.x);
+	const __m128 oy = _mm_set1_ps(start.y);
+	const __m128 oz = _mm_set1_ps(start.z);
+	const __m128 idx = _mm_set1_ps(invDir.x);
+	const __m128 idy = _mm_set1_ps(invDir.y);
+	const __m128 idz = _mm_set1_ps(invDir.z);
+
+	__m128 l1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minX), ox), idx);
+	__m128 l2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxX), ox), idx);
+	__m128 tmin = _mm_min_ps(l1, l2);
+	__m128 tmax = _mm_max_ps(l1, l2);
+
+	l1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minY), oy), idy);
+	l2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxY), oy), idy);
+	tmin = _mm_max_ps(_mm_min_ps(l1, l2), tmin);
+	tmax = _mm_min_ps(_mm_max_ps(l1, l2), tmax);
+
+	l1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minZ), oz), idz);
+	l2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxZ), oz), idz);
+	tmin = _mm_max_ps(_mm_min_ps(l1, l2), tmin);
+	tmax = _mm_min_ps(_mm_max_ps(l1, l2), tmax);
+
+	const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(tmax, _mm_setzero_ps()), _mm_cmpge_ps(tmax, tmin)),
+		_mm_cmplt_ps(tmin, _mm_set1_ps(maxDist)));
+	_mm_storeu_ps(lmin, tmin);
+	int mask = _mm_movemask_ps(hit);
+#else
+	int mask = 0;
+	for (int i = 0; i < 4; i++) {
+		float
+			l1 = (n.minX[i] - start.x) * invDir.x,
+			l2 = (n.maxX[i] - start.x) * invDir.x,
+			tmin = std::min(l1, l2),
+			tmax = std::max(l1, l2);
+
+		l1 = (n.minY[i] - start.y) * invDir.y;
+		l2 = (n.maxY[i] - start.y) * invDir.y;
+		tmin = std::max(std::min(l1, l2), tmin);
+		tmax = std::min(std::max(l1, l2), tmax);
+
+		l1 = (n.minZ[i] - start.z) * invDir.z;
+		l2 = (n.maxZ[i] - start.z) * invDir.z;
+		tmin = std::max(std::min(l1, l2), tmin);
+		tmax = std::min(std::max(l1, l2), tmax);
+
+		lmin[i] = tmin;
+		mask |= int((tmax >= 0.f) & (tmax >= tmin) & (tmin < maxDist)) << i;
 	}
-	m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
-	delete[] aabbs;
-
-	//
-	int *edgeIdxs = new int[m_numEdges];
-	memset(edgeIdxs, 0, sizeof(int) * m_numEdges);
-	for (int i = 0; i < m_numEdges; i++) {
-		edgeIdxs[i] = i;
+#endif
+	// unused children have empty bounds at the origin, mask them out
+	for (int i = 0; i < 4; i++) {
+		if (!n.IsUsed(i)) mask &= ~(1 << i);
 	}
-	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs, &m_aabbs[0]));
+	return mask;
 }
 
-static bool SlabsRayAabbTest(const BVHNode *n, const vector3f &start, const vector3f &invDir, isect_t *isect)
+void GeomTree::TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const
 {
-	// PROFILE_SCOPED()
-	float
-		l1 = (n->aabb.min.x - start.x) * invDir.x,
-		l2 = (n->aabb.max.x - start.x) * invDir.x,
-		lmin = std::min(l1, l2),
-		lmax = std::max(l1, l2);
-
-	l1 = (n->aabb.min.y - start.y) * invDir.y;
-	l2 = (n->aabb.max.y - start.y) * invDir.y;
-	lmin = std::max(std::min(l1, l2), lmin);
-	lmax = std::min(std::max(l1, l2), lmax);
-
-	l1 = (n->aabb.min.z - start.z) * invDir.z;
-	l2 = (n->aabb.max.z - start.z) * invDir.z;
-	lmin = std::max(std::min(l1, l2), lmin);
-	lmax = std::min(std::max(l1, l2), lmax);
-
-	return ((lmax >= 0.f) & (lmax >= lmin) & (lmin < isect->dist));
+	TracePacket(m_triTree->GetRoot(), 1, start, &dir, isect);
 }
 
-void GeomTree::TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const
+void GeomTree::TraceRay(const BVHTree::NodeRef &startNode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const
+{
+	TracePacket(startNode, 1, a_origin, &a_dir, isect);
+}
+
+void GeomTree::TraceRays(int numRays, const vector3f &start, const vector3f *dirs, isect_t *isects) const
 {
-	TraceRay(m_triTree->GetRoot(), start, dir, isect);
+	for (int i = 0; i < numRays; i += MAX_PACKET_SIZE) {
+		TracePacket(m_triTree->GetRoot(), std::min(numRays - i, MAX_PACKET_SIZE), start, dirs + i, isects + i);
+	}
 }
 
-void GeomTree::TraceRay(const BVHNode *currnode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const
+void GeomTree::TracePacket(const BVHTree::NodeRef &startNode, int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const
 {
 	// PROFILE_SCOPED()
-	BVHNode *stack[32];
-	int stackpos = -1;
-	const vector3f invDir( // avoid division by zero please
-		is_zero_exact(a_dir.x) ? 0.0f : (1.0f / a_dir.x),
-		is_zero_exact(a_dir.y) ? 0.0f : (1.0f / a_dir.y),
-		is_zero_exact(a_dir.z) ? 0.0f : (1.0f / a_dir.z));
-
-	for (;;) {
-		while (!currnode->IsLeaf()) {
-			if (!SlabsRayAabbTest(currnode, a_origin, invDir, isect)) goto pop_bstack;
-
-			stackpos++;
-			stack[stackpos] = currnode->kids[1];
-			currnode = currnode->kids[0];
+	assert(numRays > 0 && numRays <= MAX_PACKET_SIZE);
+	const BVHTree::objPtr_t *tris = m_triTree->GetObjPtrs();
+	if (startNode.IsLeaf()) {
+		for (int i = 0; i < startNode.numObjs; i++)
+			RayTriIntersect(numRays, a_origin, a_dirs, tris[startNode.index + i], isects);
+		return;
+	}
+
+	vector3f invDirs[MAX_PACKET_SIZE];
+	for (int r = 0; r < numRays; r++) {
+		const vector3f &dir = a_dirs[r];
+		// avoid division by zero please. A huge (not zero) inverse leaves the slab of
+		// an axis the ray runs parallel to unbounded if it starts inside it, and
+		// missed otherwise
+		invDirs[r] = vector3f(
+			is_zero_exact(dir.x) ? 1e30f : (1.0f / dir.x),
+			is_zero_exact(dir.y) ? 1e30f : (1.0f / dir.y),
+			is_zero_exact(dir.z) ? 1e30f : (1.0f / dir.z));
+	}
+
+	// nodes still to visit, with the distance at which the packet enters them
+	struct stackobj {
+		int node;
+		float dist;
+	} stack[BVHTree::MAX_STACK_SIZE];
+	int stackpos = 0;
+	stack[0].node = startNode.index;
+	stack[0].dist = -FLT_MAX;
+
+	while (stackpos >= 0) {
+		const stackobj top = stack[stackpos];
+		stackpos--;
+
+		float maxDist = isects[0].dist;
+		for (int r = 1; r < numRays; r++)
+			maxDist = std::max(maxDist, isects[r].dist);
+		// skip nodes that are further away than everything hit since they were pushed
+		if (top.dist >= maxDist) continue;
+
+		const BVHNode &node = m_triTree->GetNode(top.node);
+		int mask = 0;
+		float entry[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+		for (int r = 0; r < numRays; r++) {
+			float lmin[4];
+			const int rayMask = SlabsRayAabbTest(node, a_origin, invDirs[r], isects[r].dist, lmin);
+			for (int i = 0; i < 4; i++) {
+				if (rayMask & (1 << i)) entry[i] = std::min(entry[i], lmin[i]);
+			}
+			mask |= rayMask;
+		}
+		if (!mask) continue;
+
+		// triangle intersection jizz, leaves straight away
+		// and child nodes onto the stack furthest first, so the nearest is visited next
+		int kids[4];
+		int numKids = 0;
+		for (int i = 0; i < 4; i++) {
+			if (!(mask & (1 << i))) continue;
+			if (node.IsLeaf(i)) {
+				const BVHTree::objPtr_t *leafTris = tris + node.kids[i];
+				for (int j = 0; j < node.numObjs[i]; j++)
+					RayTriIntersect(numRays, a_origin, a_dirs, leafTris[j], isects);
+			} else {
+				int k = numKids++;
+				for (; k > 0 && entry[kids[k - 1]] < entry[i]; k--)
+					kids[k] = kids[k - 1];
+				kids[k] = i;
+			}
 		}
-		// triangle intersection jizz
-		for (int i = 0; i < currnode->numTris; i++) {
-			RayTriIntersect(1, a_origin, &a_dir, currnode->triIndicesStart[i], isect);
+		for (int k = 0; k < numKids; k++) {
+			++stackpos;
+			assert(stackpos < BVHTree::MAX_STACK_SIZE);
+			stack[stackpos].node = node.kids[kids[k]];
+			stack[stackpos].dist = entry[kids[k]];
 		}
-	pop_bstack:
-		if (stackpos < 0) break;
-		currnode = stack[stackpos];
-		stackpos--;
 	}
 }
 
@@ -323,25 +402,15 @@ void GeomTree::Save(Serializer::Writer &wr) const
 	wr.Vector3d(m_aabb.min);
 	wr.Double(m_aabb.radius);
 
+	// the arrays are written as they are in memory so they can be read back
+	// in one go, see the static_asserts in Serializer.h and GeomTree.h
 	wr.Int32(m_numEdges);
-	for (Sint32 iAabb = 0; iAabb < m_numEdges; ++iAabb) {
-		wr << m_aabbs[iAabb];
-	}
-
-	for (Sint32 iEdge = 0; iEdge < m_numEdges; ++iEdge) {
-		auto &ed = m_edges[iEdge];
-		wr << ed.v1i << ed.v2i << ed.len << ed.dir << ed.triFlag;
-	}
-
-	for (Sint32 iVert = 0; iVert < m_numVertices; ++iVert) {
-		wr.Vector3f(m_vertices[iVert]);
-	}
-
-	for (Sint32 iIndi = 0; iIndi < (m_numTris * 3); ++iIndi) {
-		wr.Int32(m_indices[iIndi]);
-	}
-
-	for (Sint32 iTri = 0; iTri < m_numTris; ++iTri) {
-		wr.Int32(m_triFlags[iTri]);
-	}
+	wr.Array(m_aabbs.data(), m_numEdges);
+	wr.Array(m_edges.data(), m_numEdges);
+	wr.Array(m_vertices.data(), m_numVertices);
+	wr.Array(m_indices.data(), m_numTris * 3);
+	wr.Array(m_triFlags.data(), m_numTris);
+
+	m_triTree->Save(wr);
+	m_edgeTree->Save(wr);
 }
@@ -4,6 +4,7 @@
 #ifndef _GEOMTREE_H
 #define _GEOMTREE_H
 
+#include "BVHTree.h"
 #include "libs.h"
 
 namespace Serializer {
@@ -17,9 +18,6 @@ struct isect_t {
 	float dist;
 };
 
-class BVHTree;
-struct BVHNode;
-
 class GeomTree {
 public:
 	GeomTree(const int numVerts, const int numTris, const std::vector<vector3f> &vertices, const std::vector<Uint32> indices, const std::vector<Uint32> triFlags);
@@ -33,7 +31,9 @@ public:
 	// isect.dist should be ray length
 	// isect.triIdx should be -1 unless repeat calls with same isect_t
 	void TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const;
-	void TraceRay(const BVHNode *startNode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const;
+	void TraceRay(const BVHTree::NodeRef &startNode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const;
+	// trace a packet of rays sharing one origin, cheaper than tracing them one at a time
+	void TraceRays(int numRays, const vector3f &start, const vector3f *dirs, isect_t *isects) const;
 	vector3f GetTriNormal(int triIdx) const;
 	Uint32 GetTriFlag(int triIdx) const { return m_triFlags[triIdx]; }
 	double GetRadius() const { return m_radius; }
@@ -48,6 +48,7 @@ public:
 		int triFlag;
 	};
 #pragma pack()
+	static_assert(sizeof(Edge) == 28, "Edge is padded differently on this platform and will not serialize properly.");
 
 	const Edge *GetEdges() const
 	{
@@ -65,6 +66,8 @@ public:
 	int GetNumTris() const { return m_numTris; }
 
 private:
+	static constexpr int MAX_PACKET_SIZE = 16;
+	void TracePacket(const BVHTree::NodeRef &startNode, int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const;
 	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const;
 
 	int m_numVertices;
@@ -0,0 +1,137 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ChunkFormat.h"
+#include "LZ4Format.h"
+
+#include "profiler/Profiler.h"
+
+static const char CHUNK_MAGIC[4] = { 'P', 'C', 'H', 'K' };
+static const uint32_t CHUNK_VERSION = 1;
+// the fast lz4 preset, saving shouldn't stall the game
+static const int LZ4_PRESET = 0;
+
+template <typename T>
+static void put(std::string &out, T value)
+{
+	for (size_t i = 0; i < sizeof(T); i++) {
+		out.push_back(char(value & 0xff));
+		value >>= 8;
+	}
+}
+
+template <typename T>
+static T get(const char *&pos, const char *end)
+{
+	if (size_t(end - pos) < sizeof(T))
+		throw chunk::FormatException("truncated section table");
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++)
+		value |= T(uint8_t(pos[i])) << (8 * i);
+	pos += sizeof(T);
+	return value;
+}
+
+bool chunk::IsChunkFormat(const char *data, size_t length)
+{
+	return length >= sizeof(CHUNK_MAGIC) + 2 * sizeof(uint32_t) &&
+		std::string_view(data, sizeof(CHUNK_MAGIC)) == std::string_view(CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+}
+
+chunk::Section chunk::MakeSection(std::string name, std::string_view data, Compression compression)
+{
+	PROFILE_SCOPED()
+	Section section;
+	section.name = std::move(name);
+	section.compression = compression;
+	section.plainSize = data.size();
+	if (compression == Compression::LZ4)
+		section.data = lz4::CompressLZ4(data, LZ4_PRESET);
+	else
+		section.data = std::string(data);
+	return section;
+}
+
+bool chunk::WriteSections(FILE *f, const std::vector<Section> &sections)
+{
+	PROFILE_SCOPED()
+	std::string header(CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+	put<uint32_t>(header, CHUNK_VERSION);
+	put<uint32_t>(header, uint32_t(sections.size()));
+	for (const Section &s : sections) {
+		put<uint16_t>(header, uint16_t(s.name.size()));
+		header.append(s.name);
+		put<uint8_t>(header, uint8_t(s.compression));
+		put<uint64_t>(header, s.data.size());
+		put<uint64_t>(header, s.plainSize);
+	}
+
+	if (fwrite(header.data(), header.size(), 1, f) != 1)
+		return false;
+	for (const Section &s : sections) {
+		if (!s.data.empty() && fwrite(s.data.data(), s.data.size(), 1, f) != 1)
+			return false;
+	}
+	return true;
+}
+
+std::vector<chunk::SectionView> chunk::ReadSections(const char *data, size_t length)
+{
+	PROFILE_SCOPED()
+	if (!IsChunkFormat(data, length))
+		throw FormatException("not a chunk file");
+
+	const char *end = data + length;
+	const char *pos = data + sizeof(CHUNK_MAGIC);
+	const uint32_t version = get<uint32_t>(pos, end);
+	if (version != CHUNK_VERSION)
+		throw FormatException("unsupported chunk file version");
+
+	const uint32_t numSections = get<uint32_t>(pos, end);
+	std::vector<SectionView> sections;
+	std::vector<uint64_t> sizes;
+	for (uint32_t i = 0; i < numSections; i++) {
+		const uint16_t nameLen = get<uint16_t>(pos, end);
+		if (size_t(end - pos) < nameLen)
+			throw FormatException("truncated section table");
+		SectionView s;
+		s.name = std::string_view(pos, nameLen);
+		pos += nameLen;
+		s.compression = Compression(get<uint8_t>(pos, end));
+		sizes.push_back(get<uint64_t>(pos, end));
+		s.plainSize = get<uint64_t>(pos, end);
+		sections.push_back(s);
+	}
+
+	for (uint32_t i = 0; i < numSections; i++) {
+		if (uint64_t(end - pos) < sizes[i])
+			throw FormatException("truncated section");
+		sections[i].data = std::string_view(pos, size_t(sizes[i]));
+		pos += sizes[i];
+	}
+	return sections;
+}
+
+std::string chunk::DecompressSection(const SectionView &section)
+{
+	PROFILE_SCOPED()
+	std::string out;
+	switch (section.compression) {
+	case Compression::NONE:
+		out = std::string(section.data);
+		break;
+	case Compression::LZ4:
+		try {
+			out = lz4::DecompressLZ4(section.data);
+		} catch (lz4::DecompressionFailedException &e) {
+			throw FormatException(e.what());
+		}
+		break;
+	default:
+		throw FormatException("unknown section compression");
+	}
+
+	if (out.size() != section.plainSize)
+		throw FormatException("section size mismatch");
+	return out;
+}
@@ -0,0 +1,65 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A simple container of named, independently compressed sections.
+//
+// Layout (all integers little endian):
+//   "PCHK" magic, uint32 version, uint32 section count
+//   per section: uint16 name length, name, uint8 compression,
+//                uint64 payload size, uint64 uncompressed size
+//   the payloads, in the same order as the table
+//
+// Sections can be compressed and decompressed independently (and so in
+// parallel), and the reader only ever hands out views into the file data.
+namespace chunk {
+
+	struct FormatException : public std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+
+	enum class Compression : uint8_t {
+		NONE = 0,
+		LZ4 = 1,
+	};
+
+	struct Section {
+		std::string name;
+		Compression compression;
+		uint64_t plainSize;
+		std::string data;
+	};
+
+	struct SectionView {
+		std::string_view name;
+		Compression compression;
+		uint64_t plainSize;
+		std::string_view data;
+	};
+
+	// Checks for the magic bytes and a basic length check.
+	bool IsChunkFormat(const char *data, size_t length);
+
+	// Compresses a block of data into a section. Thread safe.
+	// If compression fails it throws lz4::CompressionFailedException.
+	Section MakeSection(std::string name, std::string_view data, Compression compression = Compression::LZ4);
+
+	// Writes the header and all sections, returns false on a write error.
+	bool WriteSections(FILE *f, const std::vector<Section> &sections);
+
+	// Parses the header. The views point into data, which must outlive them.
+	// Throws FormatException if the header is truncated or inconsistent.
+	std::vector<SectionView> ReadSections(const char *data, size_t length);
+
+	// Thread safe. Throws FormatException if the payload is corrupt.
+	std::string DecompressSection(const SectionView &section);
+
+} // namespace chunk
@@ -192,6 +192,7 @@ Graphics::Renderer *GuiApplication::StartupRenderer(IniConfig *config, bool hidd
 	videoSettings.useAnisotropicFiltering = (config->Int("UseAnisotropicFiltering") != 0);
 	videoSettings.enableDebugMessages = (config->Int("EnableGLDebug") != 0);
 	videoSettings.gl3ForwardCompatible = (config->Int("GL3ForwardCompatible") != 0);
+	videoSettings.sortDrawCommands = (config->Int("SortDrawCommands") != 0);
 	videoSettings.iconFile = OS::GetIconFilename();
 	videoSettings.title = m_applicationTitle.c_str();
 
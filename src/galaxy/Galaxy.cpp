@@ -18,6 +18,7 @@ Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, flo
 	m_initialized(false),
 	m_stats(),
 	m_galaxyGenerator(galaxyGenerator),
+	m_systemIndex(this),
 	m_sectorCache(this),
 	m_starSystemCache(this),
 	m_factions(this, factionsDir),
@@ -82,8 +83,27 @@ void Galaxy::FlushCaches()
 	m_starSystemCache.OutputCacheStatistics();
 	m_starSystemCache.ClearCache();
 	m_sectorCache.OutputCacheStatistics();
+	Output("SystemNameIndex: " SIZET_FMT " names, " SIZET_FMT " suffixes, " SIZET_FMT " KB\n",
+		m_systemNameIndex.GetNumNames(), m_systemNameIndex.GetNumSuffixes(), m_systemNameIndex.GetMemoryUsage() / 1024);
 	m_sectorCache.ClearCache();
 	assert(m_sectorCache.IsEmpty());
+	m_systemIndex.Clear();
+	m_systemNameIndex.Clear();
+}
+
+void Galaxy::SetCacheBudgets(size_t sectorBytes, size_t starSystemBytes)
+{
+	m_sectorCache.SetMemoryBudget(sectorBytes);
+	m_starSystemCache.SetMemoryBudget(starSystemBytes);
+}
+
+void Galaxy::UpdateCaches()
+{
+	PROFILE_SCOPED()
+	// star systems first, they hold on to their sectors
+	m_starSystemCache.Update();
+	m_sectorCache.Update();
+	m_stats.FlushFrame();
 }
 
 void Galaxy::Dump(FILE *file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius)
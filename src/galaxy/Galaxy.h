@@ -10,6 +10,8 @@
 #include "JsonFwd.h"
 #include "PerfStats.h"
 #include "RefCounted.h"
+#include "SystemIndex.h"
+#include "SystemNameIndex.h"
 #include <cstdio>
 
 struct SDL_Surface;
@@ -47,7 +49,19 @@ public:
 	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath &path) { return m_starSystemCache.GetCached(path); }
 	RefCountedPtr<StarSystemCache::Slave> NewStarSystemSlaveCache() { return m_starSystemCache.NewSlaveCache(); }
 
+	// for finding the systems near a point
+	SystemIndex &GetSystemIndex() { return m_systemIndex; }
+	// for searching the cached systems by name
+	const SystemNameIndex &GetSystemNameIndex() const { return m_systemNameIndex; }
+	SystemNameIndex &GetSystemNameIndex() { return m_systemNameIndex; }
+
 	void FlushCaches();
+	// memory budgets for the sector and star system caches, in bytes, 0 for no limit
+	void SetCacheBudgets(size_t sectorBytes, size_t starSystemBytes);
+	// once a frame, keeps the caches within budget and updates their statistics
+	void UpdateCaches();
+	SectorCache::Statistics GetSectorCacheStatistics() const { return m_sectorCache.GetStatistics(); }
+	StarSystemCache::Statistics GetStarSystemCacheStatistics() const { return m_starSystemCache.GetStatistics(); }
 	void Dump(FILE *file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius);
 
 	RefCountedPtr<GalaxyGenerator> GetGenerator() const;
@@ -61,6 +75,9 @@ private:
 	bool m_initialized;
 	Perf::Stats m_stats;
 	RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
+	// before the sector cache, which updates them until it's gone
+	SystemIndex m_systemIndex;
+	SystemNameIndex m_systemNameIndex;
 	SectorCache m_sectorCache;
 	StarSystemCache m_starSystemCache;
 	FactionsDatabase m_factions;
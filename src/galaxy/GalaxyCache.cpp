@@ -10,97 +10,212 @@
 #include "galaxy/Sector.h"
 #include "galaxy/StarSystem.h"
 #include "utils.h"
+#include <algorithm>
+#include <chrono>
 #include <utility>
 
 //#define DEBUG_CACHE
 
+template <typename T, typename HashT, typename EqualT>
+GalaxyObjectCache<T, HashT, EqualT>::GalaxyObjectCache(Galaxy *galaxy) :
+	m_galaxy(galaxy),
+	m_bytes(0),
+	m_budget(0),
+	m_frame(0),
+	m_nextEvictionScan(0),
+	m_cacheHits(0),
+	m_cacheHitsSlave(0),
+	m_cacheMisses(0),
+	m_evictions(0),
+	m_generationTime(0.0),
+	m_entriesCounter(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " Entries", false)),
+	m_memoryCounter(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " Memory (KB)", false)),
+	m_hitRateCounter(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " Hit Rate (%)", false)),
+	m_generationTimeCounter(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " Generation Time (ms)", false))
+{
+}
+
 //virtual
 
-template <typename T, typename CompareT>
-GalaxyObjectCache<T, CompareT>::~GalaxyObjectCache()
+template <typename T, typename HashT, typename EqualT>
+GalaxyObjectCache<T, HashT, EqualT>::~GalaxyObjectCache()
 {
 	for (Slave *s : m_slaves)
 		s->MasterDeleted();
 	assert(m_attic.empty()); // otherwise the objects will deregister at a cache that no longer exists
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::AddToCache(std::vector<RefCountedPtr<T>> &objects)
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Insert(T *object)
+{
+	const size_t bytes = object->GetMemoryUsage();
+	m_attic.emplace(object->GetPath(), AtticEntry{ object, bytes, m_frame });
+	m_bytes += bytes;
+	m_nextEvictionScan = 0;
+	OnAdded(object);
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::AddToCache(std::vector<RefCountedPtr<T>> &objects)
 {
 	PROFILE_SCOPED()
 	for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
-		auto inserted = m_attic.insert(std::make_pair(it->Get()->GetPath(), it->Get()));
-		if (!inserted.second) {
-			it->Reset(inserted.first->second);
+		auto found = m_attic.find(it->Get()->GetPath());
+		if (found != m_attic.end()) {
+			found->second.lastUsed = m_frame;
+			it->Reset(found->second.object);
 		} else {
 			(*it)->SetCache(this);
+			Insert(it->Get());
 		}
 	}
 }
 
-template <typename T, typename CompareT>
-RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetIfCached(const SystemPath &path)
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<T> GalaxyObjectCache<T, HashT, EqualT>::GetIfCached(const SystemPath &path)
 {
 	RefCountedPtr<T> s;
 	typename AtticMap::iterator i = m_attic.find(path);
 	if (i != m_attic.end()) {
-		s.Reset(i->second);
+		i->second.lastUsed = m_frame;
+		s.Reset(i->second.object);
 	}
 
 	return s;
 }
 
-template <typename T, typename CompareT>
-RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetCached(const SystemPath &path)
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<T> GalaxyObjectCache<T, HashT, EqualT>::GetCached(const SystemPath &path)
 {
 	RefCountedPtr<T> s = this->GetIfCached(path);
 	if (!s) {
 		++m_cacheMisses;
-		s = m_galaxy->GetGenerator()->Generate<T, GalaxyObjectCache<T, CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
-		m_attic.insert(std::make_pair(path, s.Get()));
+		const auto start = std::chrono::steady_clock::now();
+		s = m_galaxy->GetGenerator()->Generate<T, GalaxyObjectCache<T, HashT, EqualT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
+		m_generationTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		Insert(s.Get());
 	} else {
 		++m_cacheHits;
 	}
 	return s;
 }
 
-template <typename T, typename CompareT>
-bool GalaxyObjectCache<T, CompareT>::HasCached(const SystemPath &path) const
+template <typename T, typename HashT, typename EqualT>
+bool GalaxyObjectCache<T, HashT, EqualT>::HasCached(const SystemPath &path) const
 {
 	PROFILE_SCOPED()
 
 	return (m_attic.find(path) != m_attic.end());
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::RemoveFromAttic(const SystemPath &path)
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::RemoveFromAttic(const SystemPath &path)
+{
+	auto it = m_attic.find(path);
+	if (it == m_attic.end())
+		return;
+	m_bytes -= it->second.bytes;
+	m_attic.erase(it);
+	m_nextEvictionScan = 0;
+	OnRemoved(path);
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::OnAdded(T *object)
+{
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::OnRemoved(const SystemPath &path)
 {
-	m_attic.erase(path);
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::ClearCache()
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Update()
+{
+	PROFILE_SCOPED()
+	++m_frame;
+
+	if (m_budget && m_bytes > m_budget && m_frame >= m_nextEvictionScan) {
+		// the least recently used first, anything used too recently is
+		// likely to be wanted again straight away
+		std::vector<std::pair<Uint32, SystemPath>> candidates;
+		for (const auto &entry : m_attic) {
+			if (m_frame - entry.second.lastUsed > MIN_EVICTION_AGE)
+				candidates.emplace_back(entry.second.lastUsed, entry.first);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		// objects only go once nothing else holds on to them, which takes them
+		// out of the attic (so don't iterate that while doing this)
+		const size_t startEntries = m_attic.size();
+		for (const auto &candidate : candidates) {
+			if (m_bytes <= m_budget)
+				break;
+			const size_t entries = m_attic.size();
+			for (Slave *s : m_slaves)
+				s->Erase(candidate.second);
+			if (m_attic.size() < entries)
+				++m_evictions;
+		}
+
+		// If nothing could be freed, everything left is held elsewhere or too
+		// young, and scanning again every frame won't change that. Look again
+		// once something is inserted or released, or after MIN_EVICTION_AGE
+		// frames, when objects that were too young have aged into candidates.
+		if (m_attic.size() == startEntries)
+			m_nextEvictionScan = m_frame + MIN_EVICTION_AGE;
+	}
+
+	const Statistics stats = GetStatistics();
+	Perf::Stats &perf = m_galaxy->GetStats();
+	perf.CounterSet(m_entriesCounter, Uint32(stats.entries));
+	perf.CounterSet(m_memoryCounter, Uint32(stats.bytes / 1024));
+	perf.CounterSet(m_hitRateCounter, (stats.hits + stats.misses) ? Uint32(100 * stats.hits / (stats.hits + stats.misses)) : 0);
+	perf.CounterSet(m_generationTimeCounter, Uint32(stats.generationTime * 1000.0));
+}
+
+template <typename T, typename HashT, typename EqualT>
+typename GalaxyObjectCache<T, HashT, EqualT>::Statistics GalaxyObjectCache<T, HashT, EqualT>::GetStatistics() const
+{
+	Statistics stats;
+	stats.entries = m_attic.size();
+	stats.bytes = m_bytes;
+	stats.budget = m_budget;
+	stats.hits = m_cacheHits + m_cacheHitsSlave;
+	stats.misses = m_cacheMisses;
+	stats.evictions = m_evictions;
+	stats.generationTime = m_generationTime;
+	return stats;
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::ClearCache()
 {
 	for (auto it = m_slaves.begin(), itEnd = m_slaves.end(); it != itEnd; ++it)
 		(*it)->ClearCache();
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::OutputCacheStatistics(bool reset)
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::OutputCacheStatistics(bool reset)
 {
-	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits);
-	if (reset)
-		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = 0;
+	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu, evictions: %llu\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits, m_evictions);
+	Output("%s: " SIZET_FMT " entries, " SIZET_FMT " KB (budget " SIZET_FMT " KB), %.1f ms generating\n", CACHE_NAME.c_str(),
+		m_attic.size(), m_bytes / 1024, m_budget / 1024, m_generationTime * 1000.0);
+	if (reset) {
+		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = m_evictions = 0;
+		m_generationTime = 0.0;
+	}
 }
 
-template <typename T, typename CompareT>
-RefCountedPtr<typename GalaxyObjectCache<T, CompareT>::Slave> GalaxyObjectCache<T, CompareT>::NewSlaveCache()
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<typename GalaxyObjectCache<T, HashT, EqualT>::Slave> GalaxyObjectCache<T, HashT, EqualT>::NewSlaveCache()
 {
 	return RefCountedPtr<Slave>(new Slave(this, RefCountedPtr<Galaxy>(m_galaxy), Pi::GetAsyncJobQueue()));
 }
 
-template <typename T, typename CompareT>
-GalaxyObjectCache<T, CompareT>::Slave::Slave(GalaxyObjectCache<T, CompareT> *master, RefCountedPtr<Galaxy> galaxy, JobQueue *jobQueue) :
+template <typename T, typename HashT, typename EqualT>
+GalaxyObjectCache<T, HashT, EqualT>::Slave::Slave(GalaxyObjectCache<T, HashT, EqualT> *master, RefCountedPtr<Galaxy> galaxy, JobQueue *jobQueue) :
 	m_master(master),
 	m_galaxy(galaxy),
 	m_jobs(Pi::GetAsyncJobQueue())
@@ -108,14 +223,14 @@ GalaxyObjectCache<T, CompareT>::Slave::Slave(GalaxyObjectCache<T, CompareT> *mas
 	m_master->m_slaves.insert(this);
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::MasterDeleted()
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::MasterDeleted()
 {
 	m_master = nullptr;
 }
 
-template <typename T, typename CompareT>
-RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetIfCached(const SystemPath &path)
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<T> GalaxyObjectCache<T, HashT, EqualT>::Slave::GetIfCached(const SystemPath &path)
 {
 	typename CacheMap::iterator i = m_cache.find(path);
 	if (i != m_cache.end())
@@ -123,15 +238,20 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetIfCached(const System
 	return RefCountedPtr<T>();
 }
 
-template <typename T, typename CompareT>
-RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetCached(const SystemPath &path)
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<T> GalaxyObjectCache<T, HashT, EqualT>::Slave::GetCached(const SystemPath &path)
 {
 	PROFILE_SCOPED()
 
 	typename CacheMap::iterator i = m_cache.find(path);
 	if (i != m_cache.end()) {
-		if (m_master)
+		if (m_master) {
 			++m_master->m_cacheHitsSlave;
+			// keep it from being evicted
+			auto entry = m_master->m_attic.find(path);
+			if (entry != m_master->m_attic.end())
+				entry->second.lastUsed = m_master->m_frame;
+		}
 		return (*i).second;
 	}
 
@@ -143,17 +263,17 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetCached(const SystemPa
 	}
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::Erase(const SystemPath &path) { m_cache.erase(path); }
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::Erase(const SystemPath &path) { m_cache.erase(path); }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::Erase(const typename CacheMap::const_iterator &it) { m_cache.erase(it); }
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::Erase(const typename CacheMap::const_iterator &it) { m_cache.erase(it); }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::ClearCache() { m_cache.clear(); }
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::ClearCache() { m_cache.clear(); }
 
-template <typename T, typename CompareT>
-GalaxyObjectCache<T, CompareT>::Slave::~Slave()
+template <typename T, typename HashT, typename EqualT>
+GalaxyObjectCache<T, HashT, EqualT>::Slave::~Slave()
 {
 #ifdef DEBUG_CACHE
 	unsigned unique = 0;
@@ -166,8 +286,8 @@ GalaxyObjectCache<T, CompareT>::Slave::~Slave()
 		m_master->m_slaves.erase(this);
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr<T>> &objects)
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::AddToCache(std::vector<RefCountedPtr<T>> &objects)
 {
 	if (m_master) {
 		m_master->AddToCache(objects); // This modifies the vector to the sectors already in the master cache
@@ -177,9 +297,9 @@ void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr
 	}
 }
 
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjectCache<T, CompareT>::PathVector &paths,
-	typename GalaxyObjectCache<T, CompareT>::CacheFilledCallback callback)
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::Slave::FillCache(const typename GalaxyObjectCache<T, HashT, EqualT>::PathVector &paths,
+	typename GalaxyObjectCache<T, HashT, EqualT>::CacheFilledCallback callback)
 {
 	// allocate some space for what we're about to chunk up
 	std::vector<std::unique_ptr<PathVector>> vec_paths;
@@ -230,38 +350,62 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 	} else {
 		// now add the batched jobs
 		for (auto it = vec_paths.begin(), itEnd = vec_paths.end(); it != itEnd; ++it)
-			m_jobs.Order(new GalaxyObjectCache<T, CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback));
+			m_jobs.Order(new GalaxyObjectCache<T, HashT, EqualT>::CacheJob(std::move(*it), this, m_galaxy, callback));
 	}
 }
 
-template <typename T, typename CompareT>
-GalaxyObjectCache<T, CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath>> path,
-	typename GalaxyObjectCache<T, CompareT>::Slave *slaveCache, RefCountedPtr<Galaxy> galaxy,
-	typename GalaxyObjectCache<T, CompareT>::CacheFilledCallback callback) :
+template <typename T, typename HashT, typename EqualT>
+GalaxyObjectCache<T, HashT, EqualT>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath>> path,
+	typename GalaxyObjectCache<T, HashT, EqualT>::Slave *slaveCache, RefCountedPtr<Galaxy> galaxy,
+	typename GalaxyObjectCache<T, HashT, EqualT>::CacheFilledCallback callback) :
 	Job(),
 	m_paths(std::move(path)),
+	m_generationTime(0.0),
 	m_slaveCache(slaveCache),
 	m_galaxy(galaxy),
 	m_galaxyGenerator(galaxy->GetGenerator()),
 	m_callback(callback)
 {
 	m_objects.reserve(m_paths->size());
+	Prepare();
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::CacheJob::Prepare()
+{
+}
+
+template <typename T, typename HashT, typename EqualT>
+RefCountedPtr<T> GalaxyObjectCache<T, HashT, EqualT>::CacheJob::Generate(size_t i)
+{
+	return m_galaxyGenerator->Generate<T, GalaxyObjectCache<T, HashT, EqualT>>(m_galaxy, (*m_paths)[i], nullptr);
+}
+
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::CacheJob::Finish(size_t i)
+{
 }
 
 //virtual
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::CacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::CacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 {
 	PROFILE_SCOPED()
-	for (auto it = m_paths->begin(), itEnd = m_paths->end(); it != itEnd; ++it)
-		m_objects.push_back(m_galaxyGenerator->Generate<T, GalaxyObjectCache<T, CompareT>>(m_galaxy, *it, nullptr));
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < m_paths->size(); i++)
+		m_objects.push_back(Generate(i));
+	m_generationTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 //virtual
-template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::CacheJob::OnFinish() // runs in primary thread of the context
+template <typename T, typename HashT, typename EqualT>
+void GalaxyObjectCache<T, HashT, EqualT>::CacheJob::OnFinish() // runs in primary thread of the context
 {
 	PROFILE_SCOPED()
+	if (m_slaveCache->m_master)
+		m_slaveCache->m_master->m_generationTime += m_generationTime;
+	for (size_t i = 0; i < m_objects.size(); i++)
+		Finish(i);
 	m_slaveCache->AddToCache(m_objects);
 	if (m_slaveCache->m_jobs.IsEmpty() && m_callback)
 		m_callback();
@@ -270,22 +414,65 @@ void GalaxyObjectCache<T, CompareT>::CacheJob::OnFinish() // runs in primary thr
 /****** SectorCache ******/
 
 template <>
-const std::string GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::CACHE_NAME("SectorCache");
+const std::string GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>::CACHE_NAME("SectorCache");
+
+template <>
+const unsigned GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>::CACHE_JOB_SIZE = 100;
+
+template <>
+void GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>::OnAdded(Sector *sector)
+{
+	m_galaxy->GetSystemIndex().AddSector(sector);
+	m_galaxy->GetSystemNameIndex().AddSector(sector);
+}
+
+template <>
+void GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>::OnRemoved(const SystemPath &path)
+{
+	m_galaxy->GetSystemIndex().RemoveSector(path);
+	m_galaxy->GetSystemNameIndex().RemoveSector(path);
+}
 
-template class GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>;
+template class GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>;
 
 /****** StarSystemCache ******/
 
 template <>
-GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::Slave::Slave(GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly> *master, RefCountedPtr<Galaxy> galaxy, JobQueue *jobQueue) :
-	m_master(master),
-	m_galaxy(galaxy),
-	m_jobs(Pi::GetSyncJobQueue())
+const std::string GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>::CACHE_NAME("StarSystemCache");
+
+template <>
+const unsigned GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>::CACHE_JOB_SIZE = 8;
+
+// The sector cache and the factions are main thread only, so the sectors and
+// the systems' factions are fetched as the job is ordered. Cache jobs are only
+// ordered once the factions are set up. Every
+// system is seeded from its path alone, so it doesn't matter which thread
+// generates it or in what order.
+template <>
+void GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>::CacheJob::Prepare()
 {
-	m_master->m_slaves.insert(this);
+	PROFILE_SCOPED()
+	m_sectors.reserve(m_paths->size());
+	m_factions.reserve(m_paths->size());
+	for (const SystemPath &path : *m_paths) {
+		RefCountedPtr<const Sector> sector = m_galaxy->GetSector(path);
+		assert(path.systemIndex < sector->m_systems.size());
+		m_factions.push_back(sector->m_systems[path.systemIndex].GetFaction());
+		m_sectors.push_back(sector);
+	}
+	m_names.resize(m_paths->size());
 }
 
 template <>
-const std::string GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CACHE_NAME("StarSystemCache");
+RefCountedPtr<StarSystem> GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>::CacheJob::Generate(size_t i)
+{
+	return m_galaxyGenerator->GenerateStarSystemAsync(m_galaxy, (*m_paths)[i], m_sectors[i], m_factions[i], m_names[i]);
+}
+
+template <>
+void GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>::CacheJob::Finish(size_t i)
+{
+	GalaxyGenerator::NameBodies(m_objects[i].Get(), m_names[i]);
+}
 
-template class GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>;
+template class GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>;
@@ -5,29 +5,29 @@
 #define SECTORCACHE_H
 
 #include "JobQueue.h"
+#include "PerfStats.h"
 #include "RefCounted.h"
 #include "galaxy/SystemPath.h"
 #include <functional>
-#include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
+class Faction;
 class GalaxyGenerator;
 class Galaxy;
+class Sector;
+struct DeferredBodyName;
 
-template <typename T, typename CompareT>
+template <typename T, typename HashT, typename EqualT>
 class GalaxyObjectCache {
 	friend T;
 
 public:
 	static const std::string CACHE_NAME;
 
-	GalaxyObjectCache(Galaxy *galaxy) :
-		m_galaxy(galaxy),
-		m_cacheHits(0),
-		m_cacheHitsSlave(0),
-		m_cacheMisses(0) {}
+	GalaxyObjectCache(Galaxy *galaxy);
 	~GalaxyObjectCache();
 
 	RefCountedPtr<T> GetCached(const SystemPath &path);
@@ -36,15 +36,35 @@ public:
 	void ClearCache(); // Completely clear slave caches
 	bool IsEmpty() { return m_attic.empty(); }
 
+	// Memory the objects in the cache may use, in bytes, 0 for no limit.
+	// Enforced by Update, which drops the least recently used objects from
+	// the slave caches until the cache is back under budget.
+	void SetMemoryBudget(size_t bytes)
+	{
+		m_budget = bytes;
+		m_nextEvictionScan = 0;
+	}
+	// once a frame
+	void Update();
+
+	struct Statistics {
+		size_t entries;
+		size_t bytes;
+		size_t budget;
+		unsigned long long hits; // in the master, or a slave
+		unsigned long long misses;
+		unsigned long long evictions; // objects actually freed to stay in budget
+		double generationTime; // seconds spent generating objects
+	};
+	Statistics GetStatistics() const;
 	void OutputCacheStatistics(bool reset = true);
 
 	typedef std::vector<SystemPath> PathVector;
-	typedef std::map<SystemPath, RefCountedPtr<T>, CompareT> CacheMap;
-	typedef std::map<SystemPath, T *, CompareT> AtticMap;
+	typedef std::unordered_map<SystemPath, RefCountedPtr<T>, HashT, EqualT> CacheMap;
 	typedef std::function<void()> CacheFilledCallback;
 
 	class Slave : public RefCounted {
-		friend class GalaxyObjectCache<T, CompareT>;
+		friend class GalaxyObjectCache<T, HashT, EqualT>;
 
 	public:
 		RefCountedPtr<T> GetCached(const SystemPath &path);
@@ -73,11 +93,26 @@ public:
 	RefCountedPtr<Slave> NewSlaveCache();
 
 private:
-	static const unsigned CACHE_JOB_SIZE = 100;
+	// objects generated per job, fewer for more expensive objects so the
+	// job threads share them out evenly and results arrive sooner
+	static const unsigned CACHE_JOB_SIZE;
+	// objects used this recently are never evicted, whatever the budget
+	static const Uint32 MIN_EVICTION_AGE = 60; // frames
+
+	struct AtticEntry {
+		T *object;
+		size_t bytes;
+		Uint32 lastUsed; // frame
+	};
+	typedef std::unordered_map<SystemPath, AtticEntry, HashT, EqualT> AtticMap;
 
 	void AddToCache(std::vector<RefCountedPtr<T>> &objects);
 	bool HasCached(const SystemPath &path) const;
 	void RemoveFromAttic(const SystemPath &path);
+	void Insert(T *object);
+	// tell the rest of the galaxy about objects entering and leaving the cache
+	void OnAdded(T *object);
+	void OnRemoved(const SystemPath &path);
 
 	// ********************************************************************************
 	// Overloaded Job class to handle generating a collection of sectors
@@ -91,12 +126,24 @@ private:
 		virtual void OnCancel() {} // runs in primary thread of the context
 
 	protected:
+		// the parts of generation needing the main thread, before and after
+		// the rest of it in OnRun; only star systems have any
+		void Prepare();
+		RefCountedPtr<T> Generate(size_t i);
+		void Finish(size_t i);
+
 		std::unique_ptr<std::vector<SystemPath>> m_paths;
 		std::vector<RefCountedPtr<T>> m_objects;
+		double m_generationTime;
 		Slave *m_slaveCache;
 		RefCountedPtr<Galaxy> m_galaxy;
 		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 		CacheFilledCallback m_callback;
+
+		// star systems: their sectors and factions, and the body names left for Finish
+		std::vector<RefCountedPtr<const Sector>> m_sectors;
+		std::vector<const Faction *> m_factions;
+		std::vector<std::vector<DeferredBodyName>> m_names;
 	};
 
 	Galaxy *m_galaxy;
@@ -105,15 +152,28 @@ private:
 		// or elsewhere. The Sector destructor ensures that it is removed from here.
 		// This ensures, that there is only ever one object for each Sector.
 
+	size_t m_bytes;
+	size_t m_budget;
+	Uint32 m_frame;
+	// after an eviction pass that freed nothing, the frame to try again;
+	// any insert or release brings it forward to now
+	Uint32 m_nextEvictionScan;
+
 	unsigned long long m_cacheHits;
 	unsigned long long m_cacheHitsSlave;
 	unsigned long long m_cacheMisses;
+	unsigned long long m_evictions;
+	double m_generationTime;
+
+	Perf::Stats::CounterRef m_entriesCounter;
+	Perf::Stats::CounterRef m_memoryCounter;
+	Perf::Stats::CounterRef m_hitRateCounter;
+	Perf::Stats::CounterRef m_generationTimeCounter;
 };
 
-class Sector;
-typedef GalaxyObjectCache<Sector, SystemPath::LessSectorOnly> SectorCache;
+typedef GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> SectorCache;
 
 class StarSystem;
-typedef GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly> StarSystemCache;
+typedef GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly> StarSystemCache;
 
 #endif
@@ -15,6 +15,8 @@ static const GalaxyGenerator::Version LAST_VERSION_LEGACY = 1;
 std::string GalaxyGenerator::s_defaultGenerator = "legacy";
 GalaxyGenerator::Version GalaxyGenerator::s_defaultVersion = LAST_VERSION_LEGACY;
 RefCountedPtr<Galaxy> GalaxyGenerator::s_galaxy;
+size_t GalaxyGenerator::s_sectorCacheBudget = 0;
+size_t GalaxyGenerator::s_starSystemCacheBudget = 0;
 
 //static
 void GalaxyGenerator::Init(const std::string &name, Version version)
@@ -32,6 +34,15 @@ void GalaxyGenerator::Uninit()
 	s_galaxy.Reset();
 }
 
+//static
+void GalaxyGenerator::SetCacheBudgets(size_t sectorBytes, size_t starSystemBytes)
+{
+	s_sectorCacheBudget = sectorBytes;
+	s_starSystemCacheBudget = starSystemBytes;
+	if (s_galaxy)
+		s_galaxy->SetCacheBudgets(sectorBytes, starSystemBytes);
+}
+
 //static
 GalaxyGenerator::Version GalaxyGenerator::GetLastVersion(const std::string &name)
 {
@@ -74,6 +85,7 @@ RefCountedPtr<Galaxy> GalaxyGenerator::Create(const std::string &name, Version v
 		assert(name == "legacy"); // Once whe have have more, this will become an if switch
 		// NB : The galaxy density image MUST be in BMP format due to OSX failing to load pngs the same as Linux/Windows
 		s_galaxy = RefCountedPtr<Galaxy>(new DensityMapGalaxy(galgen, "galaxy_dense.bmp", 50000.0, 25000.0, 0.0, "factions", "systems"));
+		s_galaxy->SetCacheBudgets(s_sectorCacheBudget, s_starSystemCacheBudget);
 		s_galaxy->Init();
 		return s_galaxy;
 	} else {
@@ -183,16 +195,39 @@ RefCountedPtr<Sector> GalaxyGenerator::GenerateSector(RefCountedPtr<Galaxy> gala
 RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(path);
+	StarSystemConfig config;
+	config.sector = galaxy->GetSector(path);
+	return RunStarSystemStages(galaxy, path, cache, config);
+}
+
+RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystemAsync(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, RefCountedPtr<const Sector> sector, const Faction *faction, std::vector<DeferredBodyName> &names)
+{
+	PROFILE_SCOPED()
+	StarSystemConfig config;
+	config.sector = sector;
+	config.hasFaction = true;
+	config.faction = faction;
+	config.deferredNames = &names;
+	return RunStarSystemStages(galaxy, path, nullptr, config);
+}
+
+RefCountedPtr<StarSystem> GalaxyGenerator::RunStarSystemStages(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache, StarSystemConfig &config)
+{
+	const Sector *sec = config.sector.Get();
 	assert(path.systemIndex < sec->m_systems.size());
 	Uint32 seed = sec->m_systems[path.systemIndex].GetSeed();
-	std::string name = sec->m_systems[path.systemIndex].GetName();
 	Uint32 _init[6] = { path.systemIndex, Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED, Uint32(seed) };
 	Random rng(_init, 6);
-	StarSystemConfig config;
 	RefCountedPtr<StarSystem::GeneratorAPI> system(new StarSystem::GeneratorAPI(path, galaxy, cache, rng));
 	for (StarSystemGeneratorStage *sysgen : m_starSystemStage)
 		if (!sysgen->Apply(rng, galaxy, system, &config))
 			break;
 	return system;
 }
+
+//static
+void GalaxyGenerator::NameBodies(StarSystem *system, const std::vector<DeferredBodyName> &names)
+{
+	PROFILE_SCOPED()
+	PopulateStarSystemGenerator::NameDeferredBodies(system, names);
+}
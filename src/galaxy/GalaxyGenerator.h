@@ -10,10 +10,20 @@
 #include "SystemPath.h"
 #include <list>
 #include <string>
+#include <vector>
 
 class SectorGeneratorStage;
 class StarSystemGeneratorStage;
 
+// A body name to get from the Lua name generator, once back on the main
+// thread. The bodies around one parent share a random number generator, so
+// the names have to be asked for in the order they were put off.
+struct DeferredBodyName {
+	SystemBody *body;
+	RefCountedPtr<Random> rand;
+	bool uniqueStation; // retried until no other station in the system has it
+};
+
 class GalaxyGenerator : public RefCounted {
 public:
 	typedef int Version;
@@ -33,6 +43,9 @@ public:
 	static Version GetDefaultGeneratorVersion() { return s_defaultVersion; }
 	static Version GetLastVersion(const std::string &name);
 
+	// memory budgets for the caches of every galaxy created, in bytes, 0 for no limit
+	static void SetCacheBudgets(size_t sectorBytes, size_t starSystemBytes);
+
 	virtual ~GalaxyGenerator();
 
 	const std::string &GetName() const { return m_name; }
@@ -47,6 +60,13 @@ public:
 	template <typename T, typename Cache>
 	RefCountedPtr<T> Generate(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, Cache *cache);
 
+	// Generates a star system away from the main thread. Its sector and
+	// faction have to be fetched beforehand, and the names Lua is needed for
+	// are left in names, for NameBodies to fill in on the main thread
+	// afterwards.
+	RefCountedPtr<StarSystem> GenerateStarSystemAsync(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, RefCountedPtr<const Sector> sector, const Faction *faction, std::vector<DeferredBodyName> &names);
+	static void NameBodies(StarSystem *system, const std::vector<DeferredBodyName> &names);
+
 	GalaxyGenerator *AddSectorStage(SectorGeneratorStage *sectorGenerator);
 	GalaxyGenerator *AddStarSystemStage(StarSystemGeneratorStage *starSystemGenerator);
 
@@ -59,9 +79,18 @@ public:
 
 	struct StarSystemConfig {
 		bool isCustomOnly;
+		RefCountedPtr<const Sector> sector;
+		// worked out on the main thread beforehand, otherwise the stages ask the factions
+		bool hasFaction;
+		const Faction *faction;
+		// if set, names from Lua are put off until later and added here
+		std::vector<DeferredBodyName> *deferredNames;
 
 		StarSystemConfig() :
-			isCustomOnly(false) {}
+			isCustomOnly(false),
+			hasFaction(false),
+			faction(nullptr),
+			deferredNames(nullptr) {}
 	};
 
 private:
@@ -71,6 +100,7 @@ private:
 
 	virtual RefCountedPtr<Sector> GenerateSector(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, SectorCache *cache);
 	virtual RefCountedPtr<StarSystem> GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache);
+	RefCountedPtr<StarSystem> RunStarSystemStages(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache, StarSystemConfig &config);
 
 	const std::string m_name;
 	const Version m_version;
@@ -81,6 +111,8 @@ private:
 	static RefCountedPtr<Galaxy> s_galaxy;
 	static std::string s_defaultGenerator;
 	static Version s_defaultVersion;
+	static size_t s_sectorCacheBudget;
+	static size_t s_starSystemCacheBudget;
 };
 
 template <>
@@ -0,0 +1,231 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RoutePlanner.h"
+#include "Galaxy.h"
+#include "MathUtil.h"
+#include "Sector.h"
+#include "profiler/Profiler.h"
+
+#include <cmath>
+#include <queue>
+
+RoutePlanner::RoutePlanner(Galaxy *galaxy, const SystemPath &start, const SystemPath &target, float maxRange) :
+	m_maxRange(maxRange),
+	m_duration(0.0f)
+{
+	PROFILE_SCOPED()
+	const RefCountedPtr<const Sector> start_sec = galaxy->GetSector(start);
+	const RefCountedPtr<const Sector> target_sec = galaxy->GetSector(target);
+	const vector3f start_pos = start_sec->m_systems[start.systemIndex].GetFullPosition();
+	const vector3f target_pos = target_sec->m_systems[target.systemIndex].GetFullPosition();
+
+	m_paths.push_back(start.SystemOnly());
+	m_positions.push_back(start_pos);
+	if (start.IsSameSystem(target))
+		return;
+	m_paths.push_back(target.SystemOnly());
+	m_positions.push_back(target_pos);
+
+	// anything worth stopping at is within 110% of the direct distance of both ends,
+	// and not too far from the direct line
+	const float distSqr = (target_pos - start_pos).LengthSqr() * 1.10;
+	const float max_dist_from_straight_line = (Sector::SIZE * 3);
+
+	const Sint32 minX = std::min(start.sectorX, target.sectorX) - 2, maxX = std::max(start.sectorX, target.sectorX) + 2;
+	const Sint32 minY = std::min(start.sectorY, target.sectorY) - 2, maxY = std::max(start.sectorY, target.sectorY) + 2;
+	const Sint32 minZ = std::min(start.sectorZ, target.sectorZ) - 2, maxZ = std::max(start.sectorZ, target.sectorZ) + 2;
+
+	for (Sint32 sx = minX; sx <= maxX; sx++) {
+		for (Sint32 sy = minY; sy <= maxY; sy++) {
+			for (Sint32 sz = minZ; sz <= maxZ; sz++) {
+				// early out here if the sector is too far from the direct line, deliberately
+				// conservative as GetSector is very expensive if it's not in the cache
+				const vector3f sec_centre(Sector::SIZE * vector3f(float(sx) + 0.5f, float(sy) + 0.5f, float(sz) + 0.5f));
+				if ((MathUtil::DistanceFromLine(start_pos, target_pos, sec_centre) - Sector::SIZE) > max_dist_from_straight_line)
+					continue;
+
+				RefCountedPtr<const Sector> sec = galaxy->GetSector(SystemPath(sx, sy, sz));
+				for (const Sector::System &sys : sec->m_systems) {
+					const SystemPath path = sys.GetPath();
+					if (start.IsSameSystem(path) || target.IsSameSystem(path))
+						continue;
+
+					const vector3f pos = sys.GetFullPosition();
+					if ((pos - start_pos).LengthSqr() <= distSqr &&
+						(pos - target_pos).LengthSqr() <= distSqr &&
+						MathUtil::DistanceFromLine(start_pos, target_pos, pos) < max_dist_from_straight_line) {
+						m_paths.push_back(path);
+						m_positions.push_back(pos);
+					}
+				}
+			}
+		}
+	}
+}
+
+RoutePlanner::RoutePlanner(const std::vector<SystemPath> &paths, const std::vector<vector3f> &positions, float maxRange) :
+	m_maxRange(maxRange),
+	m_paths(paths),
+	m_positions(positions),
+	m_duration(0.0f)
+{
+	assert(!m_paths.empty() && m_paths.size() == m_positions.size());
+}
+
+float RoutePlanner::JumpDuration(float dist) const
+{
+	const float x = dist * NUM_DURATION_SAMPLES / m_maxRange;
+	const int i = std::min(int(x), NUM_DURATION_SAMPLES - 1);
+	const float t = x - float(i);
+	return m_durations[i] + (m_durations[i + 1] - m_durations[i]) * t;
+}
+
+// The lowest duration per light year any jump of at least minJump can have.
+// The durations are linear between samples, where duration / distance is
+// monotonic, so checking minJump and every sample after it is enough.
+float RoutePlanner::MinDurationPerLy(float minJump) const
+{
+	if (minJump <= 0.0f)
+		return 0.0f;
+
+	float minPerLy = JumpDuration(minJump) / minJump;
+	const int first = int(std::ceil(minJump * NUM_DURATION_SAMPLES / m_maxRange));
+	for (int i = std::max(first, 1); i <= NUM_DURATION_SAMPLES; i++)
+		minPerLy = std::min(minPerLy, m_durations[i] / (m_maxRange * i / NUM_DURATION_SAMPLES));
+	return minPerLy;
+}
+
+void RoutePlanner::GetCell(const vector3f &pos, int cell[3]) const
+{
+	cell[0] = int(std::floor(pos.x / m_maxRange));
+	cell[1] = int(std::floor(pos.y / m_maxRange));
+	cell[2] = int(std::floor(pos.z / m_maxRange));
+}
+
+uint64_t RoutePlanner::CellKey(int x, int y, int z)
+{
+	// 21 bits a side is over a million jumps across
+	const uint64_t mask = (1 << 21) - 1;
+	return ((uint64_t(x) & mask) << 42) | ((uint64_t(y) & mask) << 21) | (uint64_t(z) & mask);
+}
+
+void RoutePlanner::BuildGrid()
+{
+	PROFILE_SCOPED()
+	m_grid.clear();
+	m_grid.reserve(m_positions.size());
+	int cell[3];
+	for (Uint32 i = 0; i < m_positions.size(); i++) {
+		GetCell(m_positions[i], cell);
+		m_grid.emplace_back(CellKey(cell[0], cell[1], cell[2]), i);
+	}
+	std::sort(m_grid.begin(), m_grid.end());
+}
+
+// calls fn(node, distance) for every candidate other than node within a jump of it
+template <typename F>
+void RoutePlanner::ForEachNeighbour(Uint32 node, F &&fn) const
+{
+	const vector3f &pos = m_positions[node];
+	const float maxRangeSqr = m_maxRange * m_maxRange;
+	int cell[3];
+	GetCell(pos, cell);
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dz = -1; dz <= 1; dz++) {
+				const uint64_t key = CellKey(cell[0] + dx, cell[1] + dy, cell[2] + dz);
+				auto it = std::lower_bound(m_grid.begin(), m_grid.end(), std::make_pair(key, Uint32(0)));
+				for (; it != m_grid.end() && it->first == key; ++it) {
+					const float distSqr = (m_positions[it->second] - pos).LengthSqr();
+					if (it->second != node && distSqr <= maxRangeSqr)
+						fn(it->second, std::sqrt(distSqr));
+				}
+			}
+		}
+	}
+}
+
+// The distance between the closest two candidates, or the jump range if
+// that's shorter. Sweeping them in x order, only the few within the closest
+// distance so far along x have to be checked, rather than every jump.
+float RoutePlanner::ShortestJump() const
+{
+	PROFILE_SCOPED()
+	std::vector<Uint32> order(m_positions.size());
+	for (Uint32 i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [this](Uint32 a, Uint32 b) { return m_positions[a].x < m_positions[b].x; });
+
+	float shortest = m_maxRange;
+	for (size_t i = 0; i < order.size(); i++) {
+		const vector3f &pos = m_positions[order[i]];
+		for (size_t j = i + 1; j < order.size() && m_positions[order[j]].x - pos.x < shortest; j++)
+			shortest = std::min(shortest, (m_positions[order[j]] - pos).Length());
+	}
+	return shortest;
+}
+
+bool RoutePlanner::Search(bool useHeuristic)
+{
+	PROFILE_SCOPED()
+	m_route.clear();
+	m_duration = 0.0f;
+
+	if (m_paths.size() == 1)
+		return true;
+	if (m_maxRange <= 0.0f || m_durations.empty())
+		return false;
+
+	BuildGrid();
+
+	// The heuristic is the straight line distance to the target at the lowest
+	// duration per light year of any jump in the candidate set. The duration
+	// of a direct jump can't be used: it grows faster than the distance, so
+	// it's more than a series of shorter jumps takes and A* would miss routes.
+	const float minPerLy = useHeuristic ? MinDurationPerLy(ShortestJump()) : 0.0f;
+	const vector3f &target_pos = m_positions[1];
+	auto heuristic = [&](Uint32 node) { return minPerLy * (m_positions[node] - target_pos).Length(); };
+
+	const Uint32 numNodes = Uint32(m_paths.size());
+	std::vector<float> cost(numNodes, INFINITY);
+	std::vector<Uint32> prev(numNodes, 0);
+	std::vector<bool> closed(numNodes, false);
+
+	// (estimated total duration, node), stale entries are skipped when popped
+	typedef std::pair<float, Uint32> OpenEntry;
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+	cost[0] = 0.0f;
+	open.emplace(heuristic(0), 0);
+
+	while (!open.empty()) {
+		const Uint32 node = open.top().second;
+		open.pop();
+		if (closed[node])
+			continue;
+		closed[node] = true;
+
+		if (node == 1)
+			break;
+
+		ForEachNeighbour(node, [&](Uint32 next, float dist) {
+			if (closed[next])
+				return;
+			const float nextCost = cost[node] + JumpDuration(dist);
+			if (nextCost < cost[next]) {
+				cost[next] = nextCost;
+				prev[next] = node;
+				open.emplace(nextCost + heuristic(next), next);
+			}
+		});
+	}
+
+	if (!closed[1])
+		return false;
+
+	m_duration = cost[1];
+	for (Uint32 node = 1; node != 0; node = prev[node])
+		m_route.push_back(m_paths[node]);
+	std::reverse(m_route.begin(), m_route.end());
+	return true;
+}
@@ -0,0 +1,85 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ROUTEPLANNER_H
+#define _ROUTEPLANNER_H
+
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+#include <algorithm>
+#include <vector>
+
+class Galaxy;
+
+/*
+ * Finds the quickest series of hyperjumps between two systems.
+ *
+ * Construction gathers the candidate systems (those in a corridor around the
+ * straight line from start to target) out of the galaxy into flat arrays, and
+ * SetJumpDuration samples the duration of a jump over its possible lengths.
+ * Both have to happen on the main thread, as the sector cache and the
+ * hyperdrive scripts live there. Search only uses the gathered data, so it
+ * can be run from a job.
+ *
+ * The search is A* over a binary heap, with neighbours found through a grid
+ * of cells one jump range across.
+ */
+class RoutePlanner {
+public:
+	RoutePlanner(Galaxy *galaxy, const SystemPath &start, const SystemPath &target, float maxRange);
+	// from candidates gathered elsewhere, [0] the start and [1] the target
+	RoutePlanner(const std::vector<SystemPath> &paths, const std::vector<vector3f> &positions, float maxRange);
+
+	// duration(float lightYears) gives the time a jump of that length takes,
+	// it's sampled over [0, maxRange] and interpolated from then on
+	template <typename F>
+	void SetJumpDuration(F &&duration);
+
+	// Returns false if the target can't be reached. Without the heuristic
+	// it's a plain Dijkstra search, which should find the same route.
+	bool Search(bool useHeuristic = true);
+
+	// the systems jumped to in order, ending with the target and not
+	// including the start; only valid after a successful Search
+	const std::vector<SystemPath> &GetRoute() const { return m_route; }
+	// total duration of the route found
+	float GetDuration() const { return m_duration; }
+	size_t GetNumCandidates() const { return m_paths.size(); }
+
+private:
+	static constexpr int NUM_DURATION_SAMPLES = 128;
+
+	float JumpDuration(float dist) const;
+	float MinDurationPerLy(float minJump) const;
+	void GetCell(const vector3f &pos, int cell[3]) const;
+	static uint64_t CellKey(int x, int y, int z);
+	void BuildGrid();
+	float ShortestJump() const;
+
+	template <typename F>
+	void ForEachNeighbour(Uint32 node, F &&fn) const;
+
+	float m_maxRange;
+	// candidate systems, [0] is the start and [1] the target
+	std::vector<SystemPath> m_paths;
+	std::vector<vector3f> m_positions;
+	// candidates sorted by the grid cell they are in
+	std::vector<std::pair<uint64_t, Uint32>> m_grid;
+
+	std::vector<float> m_durations;
+
+	std::vector<SystemPath> m_route;
+	float m_duration;
+};
+
+template <typename F>
+void RoutePlanner::SetJumpDuration(F &&duration)
+{
+	m_durations.resize(NUM_DURATION_SAMPLES + 1);
+	for (int i = 0; i <= NUM_DURATION_SAMPLES; i++) {
+		// the search relies on durations never being negative
+		m_durations[i] = std::max(0.0f, float(duration(m_maxRange * i / NUM_DURATION_SAMPLES)));
+	}
+}
+
+#endif /* _ROUTEPLANNER_H */
@@ -27,6 +27,18 @@ Sector::~Sector()
 		m_cache->RemoveFromAttic(SystemPath(sx, sy, sz));
 }
 
+size_t Sector::GetMemoryUsage() const
+{
+	size_t bytes = sizeof(Sector) + m_systems.capacity() * sizeof(System);
+	for (const System &sys : m_systems) {
+		bytes += sys.m_name.capacity();
+		bytes += sys.m_other_names.capacity() * sizeof(std::string);
+		for (const std::string &name : sys.m_other_names)
+			bytes += name.capacity();
+	}
+	return bytes;
+}
+
 float Sector::DistanceBetween(RefCountedPtr<const Sector> a, int sysIdxA, RefCountedPtr<const Sector> b, int sysIdxB)
 {
 	PROFILE_SCOPED()
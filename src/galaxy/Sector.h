@@ -17,7 +17,7 @@ class Faction;
 class Galaxy;
 
 class Sector : public RefCounted {
-	friend class GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>;
+	friend class GalaxyObjectCache<Sector, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly>;
 	friend class GalaxyGenerator;
 
 public:
@@ -35,6 +35,9 @@ public:
 	// get the SystemPath for this sector
 	SystemPath GetPath() const { return SystemPath(sx, sy, sz); }
 
+	// approximate heap and object size in bytes, for the sector cache budget
+	size_t GetMemoryUsage() const;
+
 	class System {
 	public:
 		System(Sector *sector, int x, int y, int z, Uint32 si) :
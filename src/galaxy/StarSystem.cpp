@@ -344,6 +344,22 @@ StarSystem::~StarSystem()
 		m_cache->RemoveFromAttic(m_path);
 }
 
+size_t StarSystem::GetMemoryUsage() const
+{
+	size_t bytes = sizeof(StarSystem) + m_name.capacity() + m_shortDesc.capacity() + m_longDesc.capacity();
+	bytes += m_other_names.capacity() * sizeof(std::string);
+	for (const std::string &name : m_other_names)
+		bytes += name.capacity();
+	bytes += m_tradeLevel.capacity() * sizeof(int) + m_commodityLegal.capacity() / 8;
+	bytes += m_bodies.capacity() * sizeof(RefCountedPtr<SystemBody>);
+	bytes += (m_spaceStations.capacity() + m_stars.capacity()) * sizeof(SystemBody *);
+	for (const RefCountedPtr<SystemBody> &body : m_bodies) {
+		bytes += sizeof(SystemBody) + body->GetNumChildren() * sizeof(SystemBody *);
+		bytes += body->GetName().capacity() + body->GetHeightMapFilename().capacity() + body->GetSpaceStationType().capacity();
+	}
+	return bytes;
+}
+
 void StarSystem::ToJson(Json &jsonObj, StarSystem *s)
 {
 	if (s) {
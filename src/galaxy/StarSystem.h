@@ -27,7 +27,7 @@ class CustomSystem;
 class StarSystem : public RefCounted {
 public:
 	friend class SystemBody;
-	friend class GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>;
+	friend class GalaxyObjectCache<StarSystem, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly>;
 	class GeneratorAPI; // Complete definition below
 
 	enum ExplorationState {
@@ -93,6 +93,9 @@ public:
 
 	void Dump(FILE *file, const char *indent = "", bool suppressSectorData = false) const;
 
+	// approximate heap and object size in bytes, for the star system cache budget
+	size_t GetMemoryUsage() const;
+
 	const RefCountedPtr<Galaxy> m_galaxy;
 
 protected:
@@ -185,11 +185,14 @@ const StarSystemLegacyGeneratorBase::StarTypeInfo StarSystemLegacyGeneratorBase:
 bool StarSystemFromSectorGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	const Sector *sec = config->sector.Get();
 	assert(system->GetPath().systemIndex < sec->m_systems.size());
 	const Sector::System &secSys = sec->m_systems[system->GetPath().systemIndex];
 
-	system->SetFaction(galaxy->GetFactions()->GetNearestClaimant(&secSys));
+	// GetFaction would cache the claimant in the sector, which mustn't happen
+	// while the factions are still being set up (their homeworlds are looked
+	// up through here)
+	system->SetFaction(config->hasFaction ? config->faction : galaxy->GetFactions()->GetNearestClaimant(&secSys));
 	system->SetSeed(secSys.GetSeed());
 	system->SetName(secSys.GetName());
 	system->SetOtherNames(secSys.GetOtherNames());
@@ -501,7 +504,7 @@ void StarSystemCustomGenerator::CustomGetKidsOf(RefCountedPtr<StarSystem::Genera
 bool StarSystemCustomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	const Sector *sec = config->sector.Get();
 	system->SetCustom(false, false);
 	if (const CustomSystem *customSys = sec->m_systems[system->GetPath().systemIndex].GetCustomSystem()) {
 		system->SetCustom(true, false);
@@ -1159,7 +1162,7 @@ void StarSystemRandomGenerator::MakeBinaryPair(SystemBody *a, SystemBody *b, fix
 bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	const Sector *sec = config->sector.Get();
 	const Sector::System &secSys = sec->m_systems[system->GetPath().systemIndex];
 
 	if (config->isCustomOnly)
@@ -1327,11 +1330,11 @@ void PopulateStarSystemGenerator::PositionSettlementOnPlanet(SystemBody *sbody,
 /*
  * Set natural resources, tech level, industry strengths and population levels
  */
-void PopulateStarSystemGenerator::PopulateStage1(SystemBody *sbody, StarSystem::GeneratorAPI *system, fixed &outTotalPop)
+void PopulateStarSystemGenerator::PopulateStage1(SystemBody *sbody, StarSystem::GeneratorAPI *system, GalaxyGenerator::StarSystemConfig *config, fixed &outTotalPop)
 {
 	PROFILE_SCOPED()
 	for (auto *child : sbody->GetChildren()) {
-		PopulateStage1(child, system, outTotalPop);
+		PopulateStage1(child, system, config, outTotalPop);
 	}
 
 	// unexplored systems have no population (that we know about)
@@ -1449,7 +1452,7 @@ void PopulateStarSystemGenerator::PopulateStage1(SystemBody *sbody, StarSystem::
 	sbody->m_population += workforce;
 
 	if (!system->HasCustomBodies() && sbody->GetPopulationAsFixed() > 0)
-		sbody->m_name = Pi::luaNameGen->BodyName(sbody, namerand);
+		NameBody(sbody, system, namerand, false, config);
 
 	// Add a bunch of things people consume
 	for (const auto &pair : GalacticEconomy::Consumables()) {
@@ -1498,11 +1501,37 @@ static std::string gen_unique_station_name(SystemBody *sp, const StarSystem *sys
 	return name;
 }
 
-void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system)
+// Lua is main thread only, elsewhere the name has to wait until later
+void PopulateStarSystemGenerator::NameBody(SystemBody *sbody, const StarSystem *system, RefCountedPtr<Random> &namerand, bool uniqueStation, GalaxyGenerator::StarSystemConfig *config)
+{
+	if (config->deferredNames)
+		config->deferredNames->push_back({ sbody, namerand, uniqueStation });
+	else if (uniqueStation)
+		sbody->m_name = gen_unique_station_name(sbody, system, namerand);
+	else
+		sbody->m_name = Pi::luaNameGen->BodyName(sbody, namerand);
+}
+
+//static
+void PopulateStarSystemGenerator::NameDeferredBodies(const StarSystem *system, const std::vector<DeferredBodyName> &names)
+{
+	// the same calls in the same order as NameBody would have made, the
+	// names depend only on body types, which are settled by now, and the
+	// stations not yet named can't clash with a generated name
+	for (const DeferredBodyName &deferred : names) {
+		RefCountedPtr<Random> rand = deferred.rand;
+		if (deferred.uniqueStation)
+			deferred.body->m_name = gen_unique_station_name(deferred.body, system, rand);
+		else
+			deferred.body->m_name = Pi::luaNameGen->BodyName(deferred.body, rand);
+	}
+}
+
+void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
 	for (auto *child : sbody->GetChildren())
-		PopulateAddStations(child, system);
+		PopulateAddStations(child, system, config);
 
 	Uint32 _init[6] = { system->GetPath().systemIndex, Uint32(system->GetPath().sectorX),
 		Uint32(system->GetPath().sectorY), Uint32(system->GetPath().sectorZ), sbody->GetSeed(), UNIVERSE_SEED };
@@ -1603,7 +1632,7 @@ void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSys
 				sp->m_orbMin = sp->GetSemiMajorAxisAsFixed();
 				sp->m_orbMax = sp->GetSemiMajorAxisAsFixed();
 
-				sp->m_name = gen_unique_station_name(sp, system, namerand);
+				NameBody(sp, system, namerand, true, config);
 			}
 		}
 	}
@@ -1623,7 +1652,7 @@ void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSys
 		sp->m_parent = sbody;
 		sp->m_averageTemp = sbody->GetAverageTemp();
 		sp->m_mass = 0;
-		sp->m_name = gen_unique_station_name(sp, system, namerand);
+		NameBody(sp, system, namerand, true, config);
 		sp->m_orbit = Orbit();
 		PositionSettlementOnPlanet(sp, previousOrbits);
 		sbody->m_children.insert(sbody->m_children.begin(), sp);
@@ -1638,7 +1667,7 @@ void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSys
 		sp->m_parent = sbody;
 		sp->m_averageTemp = sbody->m_averageTemp;
 		sp->m_mass = 0;
-		sp->m_name = gen_unique_station_name(sp, system, namerand);
+		NameBody(sp, system, namerand, true, config);
 		sp->m_orbit = Orbit();
 		PositionSettlementOnPlanet(sp, previousOrbits);
 		sbody->m_children.insert(sbody->m_children.begin(), sp);
@@ -1646,13 +1675,12 @@ void PopulateStarSystemGenerator::PopulateAddStations(SystemBody *sbody, StarSys
 	}
 }
 
-void PopulateStarSystemGenerator::SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, const fixed &human_infestedness)
+void PopulateStarSystemGenerator::SetSysPolit(RefCountedPtr<StarSystem::GeneratorAPI> system, const Sector *sec, const fixed &human_infestedness)
 {
 	SystemPath path = system->GetPath();
 	const Uint32 _init[5] = { Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), path.systemIndex, POLIT_SEED };
 	Random rand(_init, 5);
 
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(path);
 	const CustomSystem *customSystem = sec->m_systems[path.systemIndex].GetCustomSystem();
 	SysPolit sysPolit;
 	sysPolit.govType = Polit::GOV_INVALID;
@@ -1739,7 +1767,7 @@ bool PopulateStarSystemGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galax
 
 	/* system attributes */
 	fixed totalPop = fixed();
-	PopulateStage1(system->GetRootBody().Get(), system.Get(), totalPop);
+	PopulateStage1(system->GetRootBody().Get(), system.Get(), config, totalPop);
 	system->SetTotalPop(totalPop);
 
 	//	Output("Trading rates:\n");
@@ -1763,11 +1791,11 @@ bool PopulateStarSystemGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galax
 	//		Output("%s: %d%%\n", type.name, m_tradeLevel[t]);
 	//	}
 	//	Output("System total population %.3f billion\n", m_totalPop.ToFloat());
-	SetSysPolit(galaxy, system, system->GetTotalPop());
+	SetSysPolit(system, config->sector.Get(), system->GetTotalPop());
 	SetCommodityLegality(system);
 
 	if (addSpaceStations) {
-		PopulateAddStations(system->GetRootBody().Get(), system.Get());
+		PopulateAddStations(system->GetRootBody().Get(), system.Get(), config);
 	}
 
 	if (!system->GetShortDescription().size()) {
@@ -55,14 +55,18 @@ class PopulateStarSystemGenerator : public StarSystemLegacyGeneratorBase {
 public:
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config);
 
+	// fill in the names put off while generating away from the main thread
+	static void NameDeferredBodies(const StarSystem *system, const std::vector<DeferredBodyName> &names);
+
 private:
-	void SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, const fixed &human_infestedness);
+	void SetSysPolit(RefCountedPtr<StarSystem::GeneratorAPI> system, const Sector *sec, const fixed &human_infestedness);
 	void SetCommodityLegality(RefCountedPtr<StarSystem::GeneratorAPI> system);
 	void SetEconType(RefCountedPtr<StarSystem::GeneratorAPI> system);
 
-	void PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system);
+	void PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system, GalaxyGenerator::StarSystemConfig *config);
 	void PositionSettlementOnPlanet(SystemBody *sbody, std::vector<double> &prevOrbits);
-	void PopulateStage1(SystemBody *sbody, StarSystem::GeneratorAPI *system, fixed &outTotalPop);
+	void PopulateStage1(SystemBody *sbody, StarSystem::GeneratorAPI *system, GalaxyGenerator::StarSystemConfig *config, fixed &outTotalPop);
+	void NameBody(SystemBody *sbody, const StarSystem *system, RefCountedPtr<Random> &namerand, bool uniqueStation, GalaxyGenerator::StarSystemConfig *config);
 };
 
 #endif
@@ -0,0 +1,200 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SystemIndex.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// moves pos into [0, Sector::SIZE) on every axis, adjusting the sector to match
+static void Normalise(SystemPath &sector, vector3f &pos)
+{
+	const Sint32 dx = Sint32(std::floor(pos.x / Sector::SIZE));
+	const Sint32 dy = Sint32(std::floor(pos.y / Sector::SIZE));
+	const Sint32 dz = Sint32(std::floor(pos.z / Sector::SIZE));
+	sector = SystemPath(sector.sectorX + dx, sector.sectorY + dy, sector.sectorZ + dz);
+	pos -= Sector::SIZE * vector3f(float(dx), float(dy), float(dz));
+}
+
+static bool ResultNearer(const SystemIndex::Result &a, const SystemIndex::Result &b)
+{
+	return a.distance < b.distance;
+}
+
+SystemIndex::SystemIndex(Galaxy *galaxy) :
+	m_galaxy(galaxy)
+{
+}
+
+uint64_t SystemIndex::CellKey(Sint32 x, Sint32 y, Sint32 z)
+{
+	// sector coordinates are well within 21 bits
+	const uint64_t mask = (1 << 21) - 1;
+	return ((uint64_t(x) & mask) << 42) | ((uint64_t(y) & mask) << 21) | (uint64_t(z) & mask);
+}
+
+void SystemIndex::AddSector(const Sector *sector)
+{
+	std::vector<vector3f> positions;
+	positions.reserve(sector->m_systems.size());
+	for (const Sector::System &sys : sector->m_systems)
+		positions.push_back(sys.GetPosition());
+	AddSector(sector->GetPath(), positions);
+}
+
+void SystemIndex::AddSector(const SystemPath &path, const std::vector<vector3f> &positions)
+{
+	// forget the sectors which left the cache longest ago; done here rather
+	// than in RemoveSector so a cell never goes while a query is reading it
+	while (m_dormant.size() > MAX_DORMANT_SECTORS) {
+		auto old = m_cells.find(m_dormant.front());
+		if (old != m_cells.end() && !old->second.alive)
+			m_cells.erase(old);
+		m_dormant.pop_front();
+	}
+
+	Cell &cell = m_cells[CellKey(path.sectorX, path.sectorY, path.sectorZ)];
+	cell.alive = true;
+	if (cell.positions.empty())
+		cell.positions = positions;
+}
+
+void SystemIndex::RemoveSector(const SystemPath &path)
+{
+	const uint64_t key = CellKey(path.sectorX, path.sectorY, path.sectorZ);
+	auto it = m_cells.find(key);
+	if (it == m_cells.end())
+		return;
+	it->second.alive = false;
+	m_dormant.push_back(key);
+}
+
+void SystemIndex::Clear()
+{
+	m_cells.clear();
+	m_dormant.clear();
+}
+
+const SystemIndex::Cell &SystemIndex::GetCell(Sint32 x, Sint32 y, Sint32 z)
+{
+	const uint64_t key = CellKey(x, y, z);
+	auto it = m_cells.find(key);
+	if (it == m_cells.end()) {
+		// the sector cache adds it as it's generated
+		m_galaxy->GetSector(SystemPath(x, y, z));
+		it = m_cells.find(key);
+		assert(it != m_cells.end());
+	}
+	return it->second;
+}
+
+vector3f SystemIndex::GetPosition(const SystemPath &system)
+{
+	const Cell &cell = GetCell(system.sectorX, system.sectorY, system.sectorZ);
+	assert(system.systemIndex < cell.positions.size());
+	return cell.positions[system.systemIndex];
+}
+
+template <typename F>
+void SystemIndex::SearchCell(const SystemPath &sector, const vector3f &pos, Sint32 x, Sint32 y, Sint32 z, float radius, F &&fn)
+{
+	const vector3f offset = Sector::SIZE * vector3f(float(x - sector.sectorX), float(y - sector.sectorY), float(z - sector.sectorZ));
+
+	// skip (and don't generate) sectors entirely out of range
+	const vector3f nearest(
+		std::max(offset.x, std::min(pos.x, offset.x + Sector::SIZE)),
+		std::max(offset.y, std::min(pos.y, offset.y + Sector::SIZE)),
+		std::max(offset.z, std::min(pos.z, offset.z + Sector::SIZE)));
+	if ((nearest - pos).LengthSqr() > radius * radius)
+		return;
+
+	const Cell &cell = GetCell(x, y, z);
+	for (Uint32 i = 0; i < cell.positions.size(); i++) {
+		const float dist = (cell.positions[i] + offset - pos).Length();
+		if (dist <= radius)
+			fn(i, dist);
+	}
+}
+
+void SystemIndex::FindInRadius(const SystemPath &sector_, const vector3f &pos_, float radius, std::vector<Result> &out)
+{
+	PROFILE_SCOPED()
+	// the number of sectors visited grows with the cube of the radius
+	assert(!std::isnan(radius));
+	if (!(radius >= 0.0f))
+		return;
+	radius = std::min(radius, MAX_SEARCH_RADIUS);
+
+	SystemPath sector = sector_;
+	vector3f pos = pos_;
+	Normalise(sector, pos);
+
+	const Sint32 minX = sector.sectorX + Sint32(std::floor((pos.x - radius) / Sector::SIZE));
+	const Sint32 maxX = sector.sectorX + Sint32(std::floor((pos.x + radius) / Sector::SIZE));
+	const Sint32 minY = sector.sectorY + Sint32(std::floor((pos.y - radius) / Sector::SIZE));
+	const Sint32 maxY = sector.sectorY + Sint32(std::floor((pos.y + radius) / Sector::SIZE));
+	const Sint32 minZ = sector.sectorZ + Sint32(std::floor((pos.z - radius) / Sector::SIZE));
+	const Sint32 maxZ = sector.sectorZ + Sint32(std::floor((pos.z + radius) / Sector::SIZE));
+
+	for (Sint32 x = minX; x <= maxX; x++) {
+		for (Sint32 y = minY; y <= maxY; y++) {
+			for (Sint32 z = minZ; z <= maxZ; z++) {
+				SearchCell(sector, pos, x, y, z, radius, [&](Uint32 idx, float dist) {
+					out.push_back({ SystemPath(x, y, z, idx), dist });
+				});
+			}
+		}
+	}
+}
+
+void SystemIndex::FindNearest(const SystemPath &sector_, const vector3f &pos_, size_t count, float maxRadius, std::vector<Result> &out)
+{
+	PROFILE_SCOPED()
+	assert(!std::isnan(maxRadius));
+	if (count == 0 || !(maxRadius >= 0.0f))
+		return;
+	maxRadius = std::min(maxRadius, MAX_SEARCH_RADIUS);
+	// each shell generates every sector in it, so however far the bound
+	// says to go, don't go further than the largest radius allowed
+	const Sint32 maxShell = Sint32(std::ceil(MAX_SEARCH_RADIUS / Sector::SIZE)) + 1;
+
+	SystemPath sector = sector_;
+	vector3f pos = pos_;
+	Normalise(sector, pos);
+
+	// a max heap of the nearest found so far
+	std::vector<Result> nearest;
+	nearest.reserve(count + 1);
+	auto bound = [&]() { return nearest.size() < count ? maxRadius : nearest.front().distance; };
+
+	// grow the search a shell of sectors at a time, until nothing in the
+	// next shell (at least shell - 1 sectors away) could be nearer
+	for (Sint32 shell = 0; shell <= maxShell && float(shell - 1) * Sector::SIZE <= bound(); shell++) {
+		for (Sint32 dx = -shell; dx <= shell; dx++) {
+			for (Sint32 dy = -shell; dy <= shell; dy++) {
+				for (Sint32 dz = -shell; dz <= shell; dz++) {
+					if (std::max(std::abs(dx), std::max(std::abs(dy), std::abs(dz))) != shell)
+						continue;
+
+					const Sint32 x = sector.sectorX + dx, y = sector.sectorY + dy, z = sector.sectorZ + dz;
+					SearchCell(sector, pos, x, y, z, bound(), [&](Uint32 idx, float dist) {
+						if (dist > bound())
+							return;
+						nearest.push_back({ SystemPath(x, y, z, idx), dist });
+						std::push_heap(nearest.begin(), nearest.end(), ResultNearer);
+						if (nearest.size() > count) {
+							std::pop_heap(nearest.begin(), nearest.end(), ResultNearer);
+							nearest.pop_back();
+						}
+					});
+				}
+			}
+		}
+	}
+
+	std::sort_heap(nearest.begin(), nearest.end(), ResultNearer);
+	out.insert(out.end(), nearest.begin(), nearest.end());
+}
@@ -0,0 +1,81 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SYSTEMINDEX_H
+#define _SYSTEMINDEX_H
+
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+class Galaxy;
+class Sector;
+
+/*
+ * Spatial index of the positions of every system in the sectors generated
+ * so far, for "which systems are near here" queries.
+ *
+ * It's a hashed grid with one cell per sector, kept up to date by the sector
+ * cache. Sectors never change once generated, so the positions of a sector
+ * are kept after it leaves the cache and only forgotten once there are many
+ * such sectors. Queries generate sectors that haven't been seen yet.
+ *
+ * Points are given as a sector and a position within it, and distances
+ * worked out like Sector::DistanceBetween, to stay precise far from the
+ * origin. Main thread only, like the sector cache.
+ */
+class SystemIndex {
+public:
+	struct Result {
+		SystemPath path;
+		float distance;
+	};
+
+	// the furthest either search looks, in light years, whatever it's asked
+	static constexpr float MAX_SEARCH_RADIUS = 250.0f;
+
+	explicit SystemIndex(Galaxy *galaxy);
+
+	void AddSector(const Sector *sector);
+	// as above, given the sector's system positions in system index order
+	void AddSector(const SystemPath &path, const std::vector<vector3f> &positions);
+	// the sector left the cache
+	void RemoveSector(const SystemPath &path);
+	void Clear();
+
+	// All systems within radius (at most MAX_SEARCH_RADIUS), in sector
+	// (x, y, z) then system index order.
+	void FindInRadius(const SystemPath &sector, const vector3f &pos, float radius, std::vector<Result> &out);
+	// Up to count systems nearest the point and within maxRadius (at most
+	// MAX_SEARCH_RADIUS), nearest first.
+	void FindNearest(const SystemPath &sector, const vector3f &pos, size_t count, float maxRadius, std::vector<Result> &out);
+
+	// position of a system within its sector, to search around it
+	vector3f GetPosition(const SystemPath &system);
+
+	size_t GetNumSectors() const { return m_cells.size(); }
+
+private:
+	// how many sectors to remember after they leave the cache
+	static constexpr size_t MAX_DORMANT_SECTORS = 8192;
+
+	struct Cell {
+		// positions within the sector, in system index order
+		std::vector<vector3f> positions;
+		bool alive;
+	};
+
+	static uint64_t CellKey(Sint32 x, Sint32 y, Sint32 z);
+	const Cell &GetCell(Sint32 x, Sint32 y, Sint32 z);
+	// calls fn(systemIndex, distance) for the systems of a cell within radius
+	template <typename F>
+	void SearchCell(const SystemPath &sector, const vector3f &pos, Sint32 x, Sint32 y, Sint32 z, float radius, F &&fn);
+
+	Galaxy *m_galaxy;
+	std::unordered_map<uint64_t, Cell> m_cells;
+	std::deque<uint64_t> m_dormant;
+};
+
+#endif /* _SYSTEMINDEX_H */
@@ -0,0 +1,194 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SystemNameIndex.h"
+#include "Sector.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+
+// below this many pending or dead suffixes, adding and removing never touch the sorted array
+static const size_t MIN_FLUSH = 4096;
+
+static bool ResultBetter(const SystemNameIndex::Result &a, const SystemNameIndex::Result &b)
+{
+	if (a.match != b.match) return a.match < b.match;
+	if (a.nameLength != b.nameLength) return a.nameLength < b.nameLength;
+	return a.path < b.path;
+}
+
+// static
+std::string SystemNameIndex::Fold(const std::string &name)
+{
+	std::string folded(name);
+	for (char &c : folded)
+		c = char(std::tolower(static_cast<unsigned char>(c)));
+	return folded;
+}
+
+std::string_view SystemNameIndex::GetSuffix(const Suffix &suffix) const
+{
+	const Name &name = m_names[suffix.name];
+	return std::string_view(m_pool).substr(name.start + suffix.offset, name.length - suffix.offset);
+}
+
+bool SystemNameIndex::SuffixLess(const Suffix &a, const Suffix &b) const
+{
+	const int order = GetSuffix(a).compare(GetSuffix(b));
+	if (order != 0) return order < 0;
+	if (a.name != b.name) return a.name < b.name;
+	return a.offset < b.offset;
+}
+
+size_t SystemNameIndex::GetMemoryUsage() const
+{
+	return m_pool.capacity() + m_names.capacity() * sizeof(Name) + (m_suffixes.capacity() + m_pending.capacity()) * sizeof(Suffix);
+}
+
+void SystemNameIndex::AddName(const SystemPath &path, const std::string &name, std::vector<Uint32> &names)
+{
+	const std::string folded = Fold(name);
+	const Uint32 id = m_names.size();
+	m_names.push_back({ path, Uint32(m_pool.size()), Uint32(folded.size()), true });
+	m_pool += folded;
+	names.push_back(id);
+	for (Uint32 i = 0; i < folded.size(); i++)
+		m_pending.push_back({ id, i });
+}
+
+void SystemNameIndex::AddSector(const Sector *sector)
+{
+	PROFILE_SCOPED()
+	std::vector<Uint32> &names = m_sectors[sector->GetPath()];
+	if (!names.empty())
+		return;
+
+	for (const Sector::System &sys : sector->m_systems) {
+		AddName(sys.GetPath(), sys.GetName(), names);
+		for (const std::string &name : sys.GetOtherNames())
+			AddName(sys.GetPath(), name, names);
+	}
+
+	// don't let the pending list grow without bound if nobody searches
+	if (m_pending.size() > m_suffixes.size() / 4 + MIN_FLUSH)
+		Flush();
+}
+
+void SystemNameIndex::RemoveSector(const SystemPath &path)
+{
+	PROFILE_SCOPED()
+	auto it = m_sectors.find(path);
+	if (it == m_sectors.end())
+		return;
+	for (const Uint32 id : it->second) {
+		m_names[id].alive = false;
+		m_deadNames++;
+		m_deadBytes += m_names[id].length;
+		m_deadSuffixes += m_names[id].length;
+	}
+	m_sectors.erase(it);
+
+	if (m_deadSuffixes > (m_suffixes.size() + m_pending.size()) / 4 + MIN_FLUSH)
+		Flush();
+}
+
+void SystemNameIndex::Flush()
+{
+	PROFILE_SCOPED()
+	auto less = [this](const Suffix &a, const Suffix &b) { return SuffixLess(a, b); };
+	if (!m_pending.empty()) {
+		// sort everything added since the last query by itself, then merge it in once
+		std::sort(m_pending.begin(), m_pending.end(), less);
+		const size_t middle = m_suffixes.size();
+		m_suffixes.insert(m_suffixes.end(), m_pending.begin(), m_pending.end());
+		std::inplace_merge(m_suffixes.begin(), m_suffixes.begin() + middle, m_suffixes.end(), less);
+		m_pending.clear();
+	}
+
+	// a sweep costs as much as a full pass, so wait until it removes a good part of the array
+	if (m_deadSuffixes > m_suffixes.size() / 4) {
+		// removing keeps the rest in order
+		m_suffixes.erase(std::remove_if(m_suffixes.begin(), m_suffixes.end(),
+							 [this](const Suffix &s) { return !m_names[s.name].alive; }),
+			m_suffixes.end());
+		m_deadSuffixes = 0;
+
+		if (m_deadBytes > m_pool.size() / 2)
+			Compact();
+	}
+}
+
+void SystemNameIndex::Compact()
+{
+	PROFILE_SCOPED()
+	std::string pool;
+	pool.reserve(m_pool.size() - m_deadBytes);
+	std::vector<Name> names;
+	names.reserve(m_names.size() - m_deadNames);
+	std::vector<Uint32> remap(m_names.size(), ~0u);
+	for (Uint32 i = 0; i < m_names.size(); i++) {
+		const Name &name = m_names[i];
+		if (!name.alive)
+			continue;
+		remap[i] = names.size();
+		names.push_back({ name.path, Uint32(pool.size()), name.length, true });
+		pool.append(m_pool, name.start, name.length);
+	}
+
+	// the live names keep their relative order, so the suffixes stay sorted
+	for (Suffix &suffix : m_suffixes)
+		suffix.name = remap[suffix.name];
+	for (auto &sector : m_sectors)
+		for (Uint32 &id : sector.second)
+			id = remap[id];
+
+	m_pool.swap(pool);
+	m_names.swap(names);
+	m_deadNames = m_deadBytes = 0;
+}
+
+void SystemNameIndex::Clear()
+{
+	m_pool.clear();
+	m_names.clear();
+	m_suffixes.clear();
+	m_pending.clear();
+	m_sectors.clear();
+	m_deadNames = m_deadBytes = m_deadSuffixes = 0;
+}
+
+void SystemNameIndex::Find(const std::string &pattern, std::vector<Result> &out)
+{
+	PROFILE_SCOPED()
+	Flush();
+	const std::string folded = Fold(pattern);
+
+	// the best match of each system
+	std::map<SystemPath, Result> best;
+	auto it = std::lower_bound(m_suffixes.begin(), m_suffixes.end(), folded,
+		[this](const Suffix &s, const std::string &p) { return GetSuffix(s).compare(p) < 0; });
+	for (; it != m_suffixes.end(); ++it) {
+		if (GetSuffix(*it).compare(0, folded.size(), folded) != 0)
+			break;
+
+		const Name &name = m_names[it->name];
+		if (!name.alive)
+			continue;
+
+		Result r{ name.path, MATCH_SUBSTRING, name.length };
+		if (it->offset == 0)
+			r.match = name.length == folded.size() ? MATCH_EXACT : MATCH_PREFIX;
+		else if (!std::isalnum(static_cast<unsigned char>(m_pool[name.start + it->offset - 1])))
+			r.match = MATCH_WORD;
+
+		auto inserted = best.emplace(name.path, r);
+		if (!inserted.second && ResultBetter(r, inserted.first->second))
+			inserted.first->second = r;
+	}
+
+	const size_t first = out.size();
+	for (const auto &entry : best)
+		out.push_back(entry.second);
+	std::sort(out.begin() + first, out.end(), ResultBetter);
+}
@@ -0,0 +1,99 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SYSTEMNAMEINDEX_H
+#define _SYSTEMNAMEINDEX_H
+
+#include "galaxy/SystemPath.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Sector;
+
+/*
+ * Search index over the names (and other names) of the systems in the
+ * sectors currently in the sector cache, kept up to date by the cache.
+ *
+ * The case folded names are kept in one pool, and every suffix of every name
+ * as a (name, offset) pair into it, sorted by the text from there to the end
+ * of the name. Both prefix and substring queries are a binary search for a
+ * range of that array, and cost only as much as the number of matches rather
+ * than the number of names. Main thread only, like the sector cache.
+ *
+ * The cache adds and removes sectors in bursts, so neither touches the whole
+ * array: added suffixes wait in a pending list that the next query sorts and
+ * merges in at once, and removed names stay in the array as tombstones that
+ * queries skip, until there are enough of them to be worth sweeping out.
+ */
+class SystemNameIndex {
+public:
+	// how a name matched, best first
+	enum MatchType {
+		MATCH_EXACT,
+		MATCH_PREFIX,
+		MATCH_WORD, // the start of a word within the name
+		MATCH_SUBSTRING,
+	};
+
+	struct Result {
+		SystemPath path;
+		MatchType match;
+		Uint32 nameLength;
+	};
+
+	void AddSector(const Sector *sector);
+	void RemoveSector(const SystemPath &path);
+	void Clear();
+
+	// Every system with a name containing pattern, case insensitively, once
+	// each with its best match. Ordered by match type, then shorter names
+	// first, then by path. Not const, it merges in what was added before.
+	void Find(const std::string &pattern, std::vector<Result> &out);
+
+	size_t GetNumNames() const { return m_names.size() - m_deadNames; }
+	size_t GetNumSuffixes() const { return m_suffixes.size() + m_pending.size() - m_deadSuffixes; }
+	// approximately, in bytes
+	size_t GetMemoryUsage() const;
+
+	static std::string Fold(const std::string &name);
+
+private:
+	struct Name {
+		SystemPath path;
+		Uint32 start; // in m_pool
+		Uint32 length;
+		bool alive;
+	};
+
+	struct Suffix {
+		Uint32 name; // in m_names
+		Uint32 offset; // where in the name the suffix starts
+	};
+
+	std::string_view GetSuffix(const Suffix &suffix) const;
+	bool SuffixLess(const Suffix &a, const Suffix &b) const;
+	void AddName(const SystemPath &path, const std::string &name, std::vector<Uint32> &names);
+	// merges the pending suffixes in, and sweeps out the dead ones if there are enough
+	void Flush();
+	// drops the names of removed sectors from the pool, once no suffix refers to them
+	void Compact();
+
+	// the folded names, back to back
+	std::string m_pool;
+	std::vector<Name> m_names;
+	// every suffix of every name, in SuffixLess order, including dead ones
+	std::vector<Suffix> m_suffixes;
+	// suffixes of added sectors not merged into m_suffixes yet, unordered
+	std::vector<Suffix> m_pending;
+	// each sector's names, to take them out again
+	std::map<SystemPath, std::vector<Uint32>, SystemPath::LessSectorOnly> m_sectors;
+	// names of removed sectors still in m_pool and m_names
+	size_t m_deadNames = 0;
+	size_t m_deadBytes = 0;
+	// suffixes of those names still in m_suffixes or m_pending
+	size_t m_deadSuffixes = 0;
+};
+
+#endif /* _SYSTEMNAMEINDEX_H */
@@ -8,6 +8,7 @@
 #include "lua/LuaWrappable.h"
 #include <SDL_stdinc.h>
 #include <cassert>
+#include <functional>
 #include <stdexcept>
 
 class SystemPath : public LuaWrappable {
@@ -118,6 +119,44 @@ public:
 		}
 	};
 
+	// hashing and equality to go with the above, for unordered containers
+	class HashSectorOnly {
+	public:
+		size_t operator()(const SystemPath &a) const
+		{
+			size_t h = std::hash<Sint32>()(a.sectorX);
+			h ^= std::hash<Sint32>()(a.sectorY) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			h ^= std::hash<Sint32>()(a.sectorZ) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h;
+		}
+	};
+
+	class EqualSectorOnly {
+	public:
+		bool operator()(const SystemPath &a, const SystemPath &b) const
+		{
+			return a.sectorX == b.sectorX && a.sectorY == b.sectorY && a.sectorZ == b.sectorZ;
+		}
+	};
+
+	class HashSystemOnly {
+	public:
+		size_t operator()(const SystemPath &a) const
+		{
+			size_t h = HashSectorOnly()(a);
+			h ^= std::hash<Uint32>()(a.systemIndex) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h;
+		}
+	};
+
+	class EqualSystemOnly {
+	public:
+		bool operator()(const SystemPath &a, const SystemPath &b) const
+		{
+			return EqualSectorOnly()(a, b) && a.systemIndex == b.systemIndex;
+		}
+	};
+
 	bool IsSectorPath() const
 	{
 		return (systemIndex == Uint32(-1) && bodyIndex == Uint32(-1));
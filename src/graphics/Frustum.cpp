@@ -92,6 +92,14 @@ namespace Graphics {
 		return true;
 	}
 
+	bool Frustum::TestPointInside(const vector3d &p, double radius) const
+	{
+		for (int i = 0; i < 6; i++)
+			if (m_planes[i].DistanceToPoint(p) - radius < 0)
+				return false;
+		return true;
+	}
+
 	// Returns a vector3d in the range { 0..1, 0..1, 1..0 }
 	bool Frustum::ProjectPoint(const vector3d &in, vector3d &out) const
 	{
@@ -24,6 +24,8 @@ namespace Graphics {
 		bool TestPoint(const vector3d &p, double radius) const;
 		// test if point (sphere) is in the frustum, ignoring the far plane
 		bool TestPointInfinite(const vector3d &p, double radius) const;
+		// test if point (sphere) is entirely inside the frustum
+		bool TestPointInside(const vector3d &p, double radius) const;
 
 		// project a point onto the near plane (typically the screen)
 		bool ProjectPoint(const vector3d &in, vector3d &out) const;
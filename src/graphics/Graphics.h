@@ -32,6 +32,7 @@ namespace Graphics {
 		bool useAnisotropicFiltering;
 		bool enableDebugMessages;
 		bool gl3ForwardCompatible;
+		bool sortDrawCommands;
 		int vsync;
 		int requestedSamples;
 		int height;
@@ -30,6 +30,9 @@ namespace Graphics {
 			GetOrCreateCounter("Num Cached Render States"),
 			GetOrCreateCounter("Num Cached Shader Programs"),
 			GetOrCreateCounter("Num CommandList Flushes"),
+			GetOrCreateCounter("Num Render State Changes"),
+			GetOrCreateCounter("Num Shader Program Changes"),
+			GetOrCreateCounter("Num Texture Changes"),
 
 			GetOrCreateCounter("Num Buildings"),
 			GetOrCreateCounter("Num Cities"),
@@ -49,7 +52,10 @@ namespace Graphics {
 			GetOrCreateCounter("TextureCube Count", false),
 			GetOrCreateCounter("TextureCube Memory Used", false),
 			GetOrCreateCounter("TextureArray2D Count", false),
-			GetOrCreateCounter("TextureArray2D Memory Used", false)
+			GetOrCreateCounter("TextureArray2D Memory Used", false),
+			GetOrCreateCounter("GeoPatch Blocks In Use", false),
+			GetOrCreateCounter("GeoPatch Blocks Peak", false),
+			GetOrCreateCounter("GeoPatch Pool Memory Reserved", false)
 		};
 	}
 
@@ -38,6 +38,9 @@ namespace Graphics {
 			STAT_NUM_RENDER_STATES,
 			STAT_NUM_SHADER_PROGRAMS,
 			STAT_NUM_CMDLIST_FLUSHES,
+			STAT_NUM_RENDER_STATE_CHANGES,
+			STAT_NUM_PROGRAM_CHANGES,
+			STAT_NUM_TEXTURE_CHANGES,
 
 			// objects
 			STAT_BUILDINGS,
@@ -61,6 +64,9 @@ namespace Graphics {
 			STAT_MEM_TEXTURECUBE,
 			STAT_NUM_TEXTUREARRAY2D,
 			STAT_MEM_TEXTUREARRAY2D,
+			STAT_NUM_GEOPATCH_BLOCKS,
+			STAT_PEAK_GEOPATCH_BLOCKS,
+			STAT_MEM_GEOPATCH_POOL,
 
 			MAX_STAT
 		};
@@ -13,6 +13,9 @@
 
 #include "graphics/VertexBuffer.h"
 
+#include <algorithm>
+#include <tuple>
+
 using namespace Graphics::OGL;
 
 void CommandList::AddDrawCmd(Graphics::MeshObject *mesh, Graphics::Material *material, Graphics::InstanceBuffer *inst)
@@ -135,6 +138,67 @@ void CommandList::Reset()
 	m_drawCmds.clear();
 }
 
+bool CommandList::SortKey::operator<(const SortKey &rhs) const
+{
+	return std::tie(renderStateHash, program, textureHash, mesh, inst, index) <
+		std::tie(rhs.renderStateHash, rhs.program, rhs.textureHash, rhs.mesh, rhs.inst, rhs.index);
+}
+
+bool CommandList::IsSortable(const Cmd &cmd) const
+{
+	const DrawCmd *drawCmd = std::get_if<DrawCmd>(&cmd);
+	if (!drawCmd)
+		return false;
+
+	// with depth writes on, the depth test decides what's visible whatever the
+	// order, except between draws at exactly the same depth (see SortDrawCmds)
+	const RenderStateDesc &rsd = m_renderer->GetStateCache()->GetRenderState(drawCmd->renderStateHash);
+	return rsd.blendMode == BLEND_SOLID && rsd.depthTest && rsd.depthWrite;
+}
+
+void CommandList::SortDrawCmds()
+{
+	PROFILE_SCOPED()
+	assert(!m_executing && "Attempt to sort a command list while it's being executed!");
+
+	size_t begin = 0;
+	for (size_t idx = 0; idx <= m_drawCmds.size(); idx++) {
+		if (idx < m_drawCmds.size() && IsSortable(m_drawCmds[idx]))
+			continue;
+
+		if (idx - begin > 1)
+			SortRange(begin, idx);
+		begin = idx + 1;
+	}
+}
+
+void CommandList::SortRange(size_t begin, size_t end)
+{
+	m_sortKeys.clear();
+	for (size_t idx = begin; idx < end; idx++) {
+		const DrawCmd &cmd = std::get<DrawCmd>(m_drawCmds[idx]);
+
+		size_t textureHash = 0;
+		TextureGL **textures = getTextureBindings(cmd.shader, cmd.drawData);
+		for (size_t index = 0; index < cmd.shader->GetNumTextureBindings(); index++)
+			textureHash = textureHash * 31 + reinterpret_cast<uintptr_t>(textures[index]);
+
+		m_sortKeys.push_back({ cmd.renderStateHash,
+			reinterpret_cast<uintptr_t>(cmd.program),
+			textureHash,
+			reinterpret_cast<uintptr_t>(cmd.mesh),
+			reinterpret_cast<uintptr_t>(cmd.inst),
+			idx });
+	}
+
+	std::sort(m_sortKeys.begin(), m_sortKeys.end());
+
+	m_sortedCmds.clear();
+	for (const SortKey &key : m_sortKeys)
+		m_sortedCmds.push_back(m_drawCmds[key.index]);
+	std::copy(m_sortedCmds.begin(), m_sortedCmds.end(), m_drawCmds.begin() + begin);
+}
+
 template <size_t I>
 size_t align(size_t t)
 {
@@ -83,6 +83,20 @@ namespace Graphics {
 			bool IsEmpty() const { return m_drawCmds.empty(); }
 			void Reset();
 
+			// Reorder each run of opaque draws between other commands to group
+			// draws by render state, program, textures and mesh, so the state
+			// cache can skip most of the changes between them. Draws which
+			// blend or don't write depth keep their place, as their order matters.
+			//
+			// Draws with equal keys keep their submission order, but otherwise
+			// this assumes no two opaque draws in a run cover the same pixels
+			// at exactly the same depth. With the GL_GEQUAL depth test the later
+			// of two such draws wins, so sorting can change which one is seen.
+			// Coplanar geometry (decals and the like) has to be drawn without
+			// depth writes or with blending, which keeps its order, or sorting
+			// turned off with the SortDrawCommands setting.
+			void SortDrawCmds();
+
 		private:
 			friend class Graphics::RendererOGL;
 			CommandList(Graphics::RendererOGL *r) :
@@ -106,6 +120,20 @@ namespace Graphics {
 			static BufferBinding<UniformBuffer> *getBufferBindings(const Shader *shader, char *data);
 			static TextureGL **getTextureBindings(const Shader *shader, char *data);
 
+			struct SortKey {
+				size_t renderStateHash;
+				uintptr_t program;
+				size_t textureHash;
+				uintptr_t mesh;
+				uintptr_t inst;
+				size_t index; // submission order, among equal keys
+
+				bool operator<(const SortKey &rhs) const;
+			};
+
+			bool IsSortable(const Cmd &cmd) const;
+			void SortRange(size_t begin, size_t end);
+
 			// 16k-sized buckets; we're not likely to have 100s of command lists
 			// (and if we do it's still a drop in the bucket)
 			static constexpr size_t BUCKET_SIZE = 1UL << 14;
@@ -128,6 +156,9 @@ namespace Graphics {
 			Graphics::RendererOGL *m_renderer;
 			std::vector<Cmd> m_drawCmds;
 			std::vector<DataBucket> m_dataBuckets;
+			// scratch space for SortDrawCmds
+			std::vector<SortKey> m_sortKeys;
+			std::vector<Cmd> m_sortedCmds;
 			bool m_executing = false;
 		};
 
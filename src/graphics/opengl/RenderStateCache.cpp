@@ -35,6 +35,7 @@ void RenderStateCache::SetRenderState(size_t hash)
 
 	ApplyRenderState(GetRenderState(hash));
 	m_activeRenderStateHash = hash;
+	m_changeCounts.renderStates++;
 }
 
 void RenderStateCache::ApplyRenderState(const RenderStateDesc &rsd)
@@ -182,6 +183,7 @@ void RenderStateCache::ResetFrame()
 
 	m_activeRenderStateHash = 0;
 	m_activeProgram = 0;
+	m_changeCounts = {};
 }
 
 void RenderStateCache::SetTexture(uint32_t index, TextureGL *texture)
@@ -200,8 +202,10 @@ void RenderStateCache::SetTexture(uint32_t index, TextureGL *texture)
 	if (current && (!texture || texture->GetTarget() != current->GetTarget()))
 		current->Unbind();
 
-	if (texture)
+	if (texture) {
 		texture->Bind();
+		m_changeCounts.textures++;
+	}
 
 	m_textureCache[index] = texture;
 }
@@ -228,6 +232,7 @@ void RenderStateCache::SetProgram(Program *program)
 
 	m_activeProgram = newProgram;
 	glUseProgram(m_activeProgram);
+	m_changeCounts.programs++;
 }
 
 void RenderStateCache::SetRenderTarget(RenderTarget *target)
@@ -25,6 +25,15 @@ namespace Graphics {
 
 		class RenderStateCache {
 		public:
+			// how many times state actually changed, since the last ResetFrame
+			struct ChangeCounts {
+				uint32_t renderStates = 0;
+				uint32_t programs = 0;
+				uint32_t textures = 0;
+			};
+
+			const ChangeCounts &GetChangeCounts() const { return m_changeCounts; }
+
 			size_t GetActiveRenderStateHash() const { return m_activeRenderStateHash; }
 			const RenderStateDesc &GetActiveRenderState() const { return m_activeRenderState; }
 
@@ -45,6 +54,7 @@ namespace Graphics {
 
 		private:
 			friend class Graphics::RendererOGL;
+			friend class CommandList;
 			RenderStateCache() = default;
 
 			const RenderStateDesc &GetRenderState(size_t hash) const;
@@ -71,6 +81,8 @@ namespace Graphics {
 			// contains a mapping of hash->VAO on a per-vertex-format basis
 			std::vector<std::pair<size_t, GLuint>> m_vtxDescObjectCache;
 
+			ChangeCounts m_changeCounts;
+
 			GLuint m_activeProgram = 0;
 			RenderTarget *m_activeRT = 0;
 			ViewportExtents m_currentExtents;
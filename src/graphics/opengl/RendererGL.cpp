@@ -157,6 +157,7 @@ namespace Graphics {
 		m_minZNear(0.001f),
 		m_maxZFar(100000000.0f),
 		m_useCompressedTextures(false),
+		m_sortDrawCmds(vs.sortDrawCommands),
 		m_activeRenderTarget(0),
 		m_glContext(glContext)
 	{
@@ -553,6 +554,11 @@ namespace Graphics {
 		stat.SetStatCount(Stats::STAT_NUM_RENDER_STATES, m_renderStateCache->m_stateDescCache.size());
 		stat.SetStatCount(Stats::STAT_NUM_SHADER_PROGRAMS, numShaderPrograms);
 
+		const OGL::RenderStateCache::ChangeCounts &changes = m_renderStateCache->GetChangeCounts();
+		stat.SetStatCount(Stats::STAT_NUM_RENDER_STATE_CHANGES, changes.renderStates);
+		stat.SetStatCount(Stats::STAT_NUM_PROGRAM_CHANGES, changes.programs);
+		stat.SetStatCount(Stats::STAT_NUM_TEXTURE_CHANGES, changes.textures);
+
 		return true;
 	}
 
@@ -849,6 +855,9 @@ namespace Graphics {
 		for (auto &buffer : s_DynamicDrawBufferMap)
 			buffer.vtxBuffer->Flush();
 
+		if (m_sortDrawCmds)
+			m_drawCommandList->SortDrawCmds();
+
 		m_drawCommandList->m_executing = true;
 
 		for (const auto &cmd : m_drawCommandList->GetDrawCmds()) {
@@ -6,9 +6,30 @@
 #include "LuaObject.h"
 #include "LuaUtils.h"
 #include "libs.h"
+#include "profiler/Profiler.h"
+
+#include <chrono>
+#include <unordered_map>
 
 namespace LuaEvent {
 
+	// registry key of the table of events queued since the last Emit, each an
+	// array of the event name and its arguments, with the count in n
+	static const char QUEUE_KEY[] = "PiLuaEventQueue";
+
+	static bool s_emitting = false;
+
+	static Perf::Stats s_stats;
+	static std::unordered_map<const char *, Perf::Stats::CounterRef> s_eventCounters;
+
+	static Perf::Stats::CounterRef GetEventCounter(const char *event)
+	{
+		auto it = s_eventCounters.find(event);
+		if (it == s_eventCounters.end())
+			it = s_eventCounters.emplace(event, s_stats.GetOrCreateCounter(std::string("Queued ") + event)).first;
+		return it->second;
+	}
+
 	static bool _get_method_onto_stack(lua_State *l, const char *method)
 	{
 		LUA_DEBUG_START(l);
@@ -33,11 +54,34 @@ namespace LuaEvent {
 		return true;
 	}
 
+	// (queue, Event.Queue): calls Event.Queue for each queued event in order
+	static int _forward_events(lua_State *l)
+	{
+		const int count = int(lua_rawlen(l, 1));
+		for (int i = 1; i <= count; i++) {
+			lua_rawgeti(l, 1, i);
+			const int entry = lua_gettop(l);
+			lua_getfield(l, entry, "n");
+			const int n = int(lua_tointeger(l, -1));
+			lua_pop(l, 1);
+
+			lua_pushvalue(l, 2);
+			for (int arg = 1; arg <= n; arg++)
+				lua_rawgeti(l, entry, arg);
+			lua_call(l, n, 0);
+			lua_pop(l, 1);
+		}
+		return 0;
+	}
+
 	void Clear()
 	{
 		lua_State *l = Lua::manager->GetLuaState();
 
 		LUA_DEBUG_START(l);
+		lua_pushnil(l);
+		lua_setfield(l, LUA_REGISTRYINDEX, QUEUE_KEY);
+
 		if (!_get_method_onto_stack(l, "_Clear")) return;
 		pi_lua_protected_call(l, 0, 0);
 		LUA_DEBUG_END(l, 0);
@@ -45,25 +89,92 @@ namespace LuaEvent {
 
 	void Emit()
 	{
+		PROFILE_SCOPED()
+		static const Perf::Stats::CounterRef emitTime = s_stats.GetOrCreateCounter("Emit Time (us)");
+		const auto start = std::chrono::steady_clock::now();
+
 		lua_State *l = Lua::manager->GetLuaState();
 
 		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "_Emit")) return;
-		pi_lua_protected_call(l, 0, 0);
+
+		lua_getfield(l, LUA_REGISTRYINDEX, QUEUE_KEY);
+		if (lua_istable(l, -1) && lua_rawlen(l, -1) > 0) {
+			lua_pushnil(l);
+			lua_setfield(l, LUA_REGISTRYINDEX, QUEUE_KEY);
+
+			if (_get_method_onto_stack(l, "Queue")) {
+				lua_pushcfunction(l, _forward_events);
+				lua_insert(l, -3);
+				pi_lua_protected_call(l, 2, 0);
+			} else
+				lua_pop(l, 1);
+		} else
+			lua_pop(l, 1);
+
+		if (_get_method_onto_stack(l, "_Emit")) {
+			const bool wasEmitting = s_emitting;
+			s_emitting = true;
+			pi_lua_protected_call(l, 0, 0);
+			s_emitting = wasEmitting;
+		}
+
 		LUA_DEBUG_END(l, 0);
+
+		s_stats.CounterAdd(emitTime, uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+	}
+
+	const Perf::Stats &GetStats()
+	{
+		return s_stats;
+	}
+
+	void FlushStats()
+	{
+		s_stats.FlushFrame();
 	}
 
 	void QueueInternal(const char *event, const ArgsBase &args)
 	{
+		s_stats.CounterAdd(GetEventCounter(event));
+
 		lua_State *l = Lua::manager->GetLuaState();
 
 		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "Queue")) return;
 
-		int top = lua_gettop(l);
+		if (s_emitting) {
+			if (!_get_method_onto_stack(l, "Queue")) return;
+
+			int top = lua_gettop(l);
+			lua_pushstring(l, event);
+			args.PrepareStack(l);
+			pi_lua_protected_call(l, lua_gettop(l) - top, 0);
+
+			LUA_DEBUG_END(l, 0);
+			return;
+		}
+
+		lua_getfield(l, LUA_REGISTRYINDEX, QUEUE_KEY);
+		if (!lua_istable(l, -1)) {
+			lua_pop(l, 1);
+			lua_newtable(l);
+			lua_pushvalue(l, -1);
+			lua_setfield(l, LUA_REGISTRYINDEX, QUEUE_KEY);
+		}
+		const int queue = lua_gettop(l);
+
+		lua_createtable(l, 4, 1);
+		const int entry = lua_gettop(l);
 		lua_pushstring(l, event);
 		args.PrepareStack(l);
-		pi_lua_protected_call(l, lua_gettop(l) - top, 0);
+		// arguments may be nil, so they're stored by index with the count
+		const int n = lua_gettop(l) - entry;
+		for (int i = n; i > 0; i--)
+			lua_rawseti(l, entry, i);
+		lua_pushinteger(l, n);
+		lua_setfield(l, entry, "n");
+
+		lua_rawseti(l, queue, int(lua_rawlen(l, queue)) + 1);
+		lua_pop(l, 1);
 
 		LUA_DEBUG_END(l, 0);
 	}
@@ -8,6 +8,7 @@
 #include "Lua.h"
 #include "LuaObject.h"
 #include "LuaPushPull.h"
+#include "PerfStats.h"
 #include "Pi.h"
 
 namespace LuaEvent {
@@ -80,9 +81,23 @@ namespace LuaEvent {
 		}
 	};
 
+	/*
+	 * Events queued from C++ are pushed straight into a table of pending
+	 * events, and only handed to the Lua Event module (in one call) by Emit,
+	 * which then dispatches them. Events queued while Emit is dispatching go
+	 * to the Event module directly, so they're dispatched in the same pass
+	 * as they always were.
+	 *
+	 * Event names must be string literals (or otherwise live forever), as
+	 * the per-event stats are kept by name pointer.
+	 */
 	void Clear();
 	void Emit();
 
+	// number of each event queued and time spent emitting, since FlushStats
+	const Perf::Stats &GetStats();
+	void FlushStats();
+
 	void QueueInternal(const char *event, const ArgsBase &args);
 
 	template <typename... TArgs>
@@ -7,6 +7,7 @@
 #include "FileSystem.h"
 #include "Game.h"
 #include "GameSaveError.h"
+#include "JobQueue.h"
 #include "Lang.h"
 #include "LuaObject.h"
 #include "LuaTable.h"
@@ -20,6 +21,7 @@
 #include "WorldView.h"
 #include "core/GZipFormat.h"
 #include "galaxy/Galaxy.h"
+#include "galaxy/RoutePlanner.h"
 #include "pigui/LuaPiGui.h"
 
 /*
@@ -101,7 +103,9 @@ static int l_game_savegame_stats(lua_State *l)
 	std::string filename = LuaPull<std::string>(l, 1);
 
 	try {
-		Json rootNode = Game::LoadGameToJson(filename);
+		// no need to decode the whole of space for the preview
+		static const std::vector<std::string> statsSections = { "game_info" };
+		Json rootNode = Game::LoadGameToJson(filename, &statsSections);
 
 		LuaTable t(l, 0, 3);
 
@@ -266,6 +270,156 @@ static int l_game_save_game(lua_State *l)
 	}
 }
 
+/*
+ * Function: SaveGameAsync
+ *
+ * Save the current game without stalling it. Only the game state is captured
+ * straight away, it is written to disk in the background.
+ *
+ * > path = Game.SaveGameAsync(filename)
+ *
+ * Parameters:
+ *
+ *   filename - Filename to save to. The file will be placed the 'savefiles'
+ *              directory in the user's game directory.
+ *
+ * Return:
+ *
+ *   path - the full path the game will be saved to
+ *
+ * Once the file is written, an onGameSaved(filename, path) event follows, or
+ * an onGameSaveFailed(filename, message) event if it could not be.
+ *
+ * Availability:
+ *
+ *   2023
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_save_game_async(lua_State *l)
+{
+	if (!Pi::game) {
+		return luaL_error(l, "can't save when no game is running");
+	}
+
+	const std::string filename(luaL_checkstring(l, 1));
+	const std::string path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), filename);
+
+	try {
+		Game::SaveGameAsync(filename, Pi::game);
+		lua_pushlstring(l, path.c_str(), path.size());
+		return 1;
+	} catch (CannotSaveInHyperspace) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_IN_HYPERSPACE);
+	} catch (CannotSaveDeadPlayer) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_DEAD_PLAYER);
+	} catch (CouldNotOpenFileException) {
+		const std::string message = stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path));
+		lua_pushlstring(l, message.c_str(), message.size());
+		return lua_error(l);
+	}
+}
+
+class PlanRouteJob : public Job {
+public:
+	PlanRouteJob(std::unique_ptr<RoutePlanner> planner, const LuaRef &callback) :
+		m_planner(std::move(planner)),
+		m_callback(callback),
+		m_found(false) {}
+
+	virtual void OnRun() override
+	{
+		m_found = m_planner->Search();
+	}
+
+	virtual void OnFinish() override
+	{
+		lua_State *l = m_callback.GetLua();
+		m_callback.PushCopyToStack();
+		if (m_found) {
+			lua_newtable(l);
+			int i = 1;
+			for (const SystemPath &path : m_planner->GetRoute()) {
+				lua_pushinteger(l, i++);
+				LuaObject<SystemPath>::PushToLua(path);
+				lua_settable(l, -3);
+			}
+			lua_pushnumber(l, m_planner->GetDuration());
+		} else {
+			lua_pushnil(l);
+			lua_pushnil(l);
+		}
+		pi_lua_protected_call(l, 2, 0);
+	}
+
+private:
+	std::unique_ptr<RoutePlanner> m_planner;
+	LuaRef m_callback;
+	bool m_found;
+};
+
+/*
+ * Function: PlanRoute
+ *
+ * Find the quickest series of hyperjumps from one system to another, in
+ * the background.
+ *
+ * > Game.PlanRoute(from, to, range, duration, callback)
+ *
+ * Parameters:
+ *
+ *   from, to - the <SystemPaths> of the start and end of the route
+ *
+ *   range - the longest jump the drive can make, in light years
+ *
+ *   duration - a function(distance) returning the time a jump of the given
+ *              length takes, for example calling HyperdriveType.GetDuration.
+ *              It's called a fixed number of times before PlanRoute returns.
+ *
+ *   callback - a function(route, duration) called once the search is done.
+ *              route is a table of the <SystemPaths> jumped to, ending with
+ *              the destination, and duration the time the jumps take in
+ *              total. Both are nil if there is no route.
+ *
+ * The callback is never called if the game ends first.
+ *
+ * Availability:
+ *
+ *   2023
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_plan_route(lua_State *l)
+{
+	if (!Pi::game) {
+		return luaL_error(l, "can't plan a route when no game is running");
+	}
+
+	const SystemPath *from = LuaObject<SystemPath>::CheckFromLua(1);
+	const SystemPath *to = LuaObject<SystemPath>::CheckFromLua(2);
+	const float range = luaL_checknumber(l, 3);
+	luaL_checktype(l, 4, LUA_TFUNCTION);
+	luaL_checktype(l, 5, LUA_TFUNCTION);
+
+	// gathering the systems and the durations has to happen here, only the search runs in the job
+	std::unique_ptr<RoutePlanner> planner(new RoutePlanner(Pi::game->GetGalaxy().Get(), *from, *to, range));
+	planner->SetJumpDuration([l](float dist) {
+		lua_pushvalue(l, 4);
+		lua_pushnumber(l, dist);
+		pi_lua_protected_call(l, 1, 1);
+		const float duration = luaL_checknumber(l, -1);
+		lua_pop(l, 1);
+		return duration;
+	});
+
+	Pi::game->GetJobs()->Order(new PlanRouteJob(std::move(planner), LuaRef(l, 5)));
+	return 0;
+}
+
 /*
  * Function: EndGame
  *
@@ -643,6 +797,65 @@ static int l_game_get_parts_from_date_time(lua_State *l)
 	return 6;
 }
 
+template <typename Stats>
+static void push_cache_statistics(lua_State *l, const Stats &stats)
+{
+	lua_newtable(l);
+	pi_lua_settable(l, "entries", double(stats.entries));
+	pi_lua_settable(l, "bytes", double(stats.bytes));
+	pi_lua_settable(l, "budget", double(stats.budget));
+	pi_lua_settable(l, "hits", double(stats.hits));
+	pi_lua_settable(l, "misses", double(stats.misses));
+	pi_lua_settable(l, "hitRate", (stats.hits + stats.misses) ? double(stats.hits) / double(stats.hits + stats.misses) : 0.0);
+	pi_lua_settable(l, "evictions", double(stats.evictions));
+	pi_lua_settable(l, "generationTime", stats.generationTime);
+}
+
+/*
+ * Function: GetGalaxyCacheStats
+ *
+ * Get statistics about the caches of generated sectors and star systems
+ *
+ * > stats = Game.GetGalaxyCacheStats()
+ *
+ * Return:
+ *
+ *   stats - a table with a 'sectors' and a 'starSystems' table, each with
+ *           the fields 'entries', 'bytes', 'budget' (in bytes, 0 if
+ *           unlimited), 'hits', 'misses', 'hitRate' (0 to 1), 'evictions'
+ *           and 'generationTime' (in seconds), and a 'nameIndex' table, for
+ *           the index used to search the cached sectors by name, with the
+ *           fields 'names', 'suffixes' and 'bytes'
+ *
+ * Availability:
+ *
+ *   2023
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_get_galaxy_cache_stats(lua_State *l)
+{
+	if (!Pi::game)
+		return luaL_error(l, "can't get galaxy cache statistics when no game is running");
+
+	RefCountedPtr<Galaxy> galaxy = Pi::game->GetGalaxy();
+	lua_newtable(l);
+	push_cache_statistics(l, galaxy->GetSectorCacheStatistics());
+	lua_setfield(l, -2, "sectors");
+	push_cache_statistics(l, galaxy->GetStarSystemCacheStatistics());
+	lua_setfield(l, -2, "starSystems");
+
+	const SystemNameIndex &nameIndex = galaxy->GetSystemNameIndex();
+	lua_newtable(l);
+	pi_lua_settable(l, "names", double(nameIndex.GetNumNames()));
+	pi_lua_settable(l, "suffixes", double(nameIndex.GetNumSuffixes()));
+	pi_lua_settable(l, "bytes", double(nameIndex.GetMemoryUsage()));
+	lua_setfield(l, -2, "nameIndex");
+	return 1;
+}
+
 void LuaGame::Register()
 {
 	lua_State *l = Lua::manager->GetLuaState();
@@ -654,6 +867,9 @@ void LuaGame::Register()
 		{ "LoadGame", l_game_load_game },
 		{ "CanLoadGame", l_game_can_load_game },
 		{ "SaveGame", l_game_save_game },
+		{ "SaveGameAsync", l_game_save_game_async },
+		{ "PlanRoute", l_game_plan_route },
+		{ "GetGalaxyCacheStats", l_game_get_galaxy_cache_stats },
 		{ "EndGame", l_game_end_game },
 		{ "InHyperspace", l_game_in_hyperspace },
 		{ "SaveGameStats", l_game_savegame_stats },
@@ -241,6 +241,8 @@ static int l_ship_set_fuel_percent(lua_State *l)
 	// anything. This is a workaround - the proper fix is to prevent interactions
 	// with stations while the game is paused.
 	s->TimeStepUpdate(0.0);
+	s->TimeStepIntegrate(0.0);
+	s->PostTimeStepUpdate(0.0);
 
 	LUA_DEBUG_END(l, 0);
 
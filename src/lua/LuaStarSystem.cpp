@@ -208,7 +208,7 @@ static int l_starsystem_is_commodity_legal(lua_State *l)
  *
  * Parameters:
  *
- *   range - distance from this system to search, in light years
+ *   range - distance from this system to search, in light years (no more than 250 is searched)
  *
  *   filter - an optional function. If specified the function will be called
  *            once for each candidate system with the <StarSystem> object
@@ -246,45 +246,29 @@ static int l_starsystem_get_nearby_systems(lua_State *l)
 	lua_newtable(l);
 
 	const SystemPath &here = s->GetPath();
-
-	const int here_x = here.sectorX;
-	const int here_y = here.sectorY;
-	const int here_z = here.sectorZ;
-	const Uint32 here_idx = here.systemIndex;
-	RefCountedPtr<const Sector> here_sec = s->m_galaxy->GetSector(here);
-
-	const int diff_sec = int(ceil(dist_ly / Sector::SIZE));
-
-	for (int x = here_x - diff_sec; x <= here_x + diff_sec; x++) {
-		for (int y = here_y - diff_sec; y <= here_y + diff_sec; y++) {
-			for (int z = here_z - diff_sec; z <= here_z + diff_sec; z++) {
-				RefCountedPtr<const Sector> sec = s->m_galaxy->GetSector(SystemPath(x, y, z));
-
-				for (unsigned int idx = 0; idx < sec->m_systems.size(); idx++) {
-					if (x == here_x && y == here_y && z == here_z && idx == here_idx)
-						continue;
-
-					if (Sector::DistanceBetween(here_sec, here_idx, sec, idx) > dist_ly)
-						continue;
-
-					RefCountedPtr<StarSystem> sys = s->m_galaxy->GetStarSystem(SystemPath(x, y, z, idx));
-					if (filter) {
-						lua_pushvalue(l, 3);
-						LuaObject<StarSystem>::PushToLua(sys.Get());
-						lua_call(l, 1, 1);
-						if (!lua_toboolean(l, -1)) {
-							lua_pop(l, 1);
-							continue;
-						}
-						lua_pop(l, 1);
-					}
-
-					lua_pushinteger(l, lua_rawlen(l, -1) + 1);
-					LuaObject<StarSystem>::PushToLua(sys.Get());
-					lua_rawset(l, -3);
-				}
+	SystemIndex &index = s->m_galaxy->GetSystemIndex();
+	std::vector<SystemIndex::Result> nearby;
+	index.FindInRadius(here, index.GetPosition(here), dist_ly, nearby);
+
+	for (const SystemIndex::Result &found : nearby) {
+		if (found.path.IsSameSystem(here))
+			continue;
+
+		RefCountedPtr<StarSystem> sys = s->m_galaxy->GetStarSystem(found.path);
+		if (filter) {
+			lua_pushvalue(l, 3);
+			LuaObject<StarSystem>::PushToLua(sys.Get());
+			lua_call(l, 1, 1);
+			if (!lua_toboolean(l, -1)) {
+				lua_pop(l, 1);
+				continue;
 			}
+			lua_pop(l, 1);
 		}
+
+		lua_pushinteger(l, lua_rawlen(l, -1) + 1);
+		LuaObject<StarSystem>::PushToLua(sys.Get());
+		lua_rawset(l, -3);
 	}
 
 	LUA_DEBUG_END(l, 1);
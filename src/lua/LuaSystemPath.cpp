@@ -12,6 +12,8 @@
 #include "galaxy/StarSystem.h"
 #include "galaxy/SystemPath.h"
 
+#include <cmath>
+
 /*
  * Class: SystemPath
  *
@@ -320,6 +322,117 @@ static int l_sbodypath_distance_to(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetNearbySystems
+ *
+ * Find the systems within a distance of this one, without having to
+ * generate them.
+ *
+ * > paths = path:GetNearbySystems(range)
+ *
+ * Parameters:
+ *
+ *   range - distance from this system to search, in light years, up to 250
+ *
+ * Return:
+ *
+ *   paths - an array of the <SystemPaths> in range, not including this one
+ *
+ * Availability:
+ *
+ *   2023
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_sbodypath_get_nearby_systems(lua_State *l)
+{
+	PROFILE_SCOPED()
+	const SystemPath *path = LuaObject<SystemPath>::CheckFromLua(1);
+	const double range = luaL_checknumber(l, 2);
+	luaL_argcheck(l, std::isfinite(range) && range > 0.0 && range <= SystemIndex::MAX_SEARCH_RADIUS, 2,
+		"range must be a positive number of light years, up to 250");
+	if (!path->HasValidSystem())
+		return luaL_error(l, "SystemPath:GetNearbySystems() self argument does not refer to a system");
+
+	SystemIndex &index = Pi::game->GetGalaxy()->GetSystemIndex();
+	std::vector<SystemIndex::Result> nearby;
+	index.FindInRadius(*path, index.GetPosition(*path), range, nearby);
+
+	lua_newtable(l);
+	int i = 1;
+	for (const SystemIndex::Result &found : nearby) {
+		if (found.path.IsSameSystem(*path))
+			continue;
+		lua_pushinteger(l, i++);
+		LuaObject<SystemPath>::PushToLua(found.path);
+		lua_rawset(l, -3);
+	}
+	return 1;
+}
+
+/*
+ * Method: GetNearestSystems
+ *
+ * Find the systems closest to this one.
+ *
+ * > paths, distances = path:GetNearestSystems(count, range)
+ *
+ * Parameters:
+ *
+ *   count - the most systems to return
+ *
+ *   range - the furthest to look, in light years, up to 250
+ *
+ * Return:
+ *
+ *   paths - an array of up to count <SystemPaths> within range, nearest
+ *           first, not including this one
+ *
+ *   distances - an array of their distances from this system
+ *
+ * Availability:
+ *
+ *   2023
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_sbodypath_get_nearest_systems(lua_State *l)
+{
+	PROFILE_SCOPED()
+	const SystemPath *path = LuaObject<SystemPath>::CheckFromLua(1);
+	const int count = luaL_checkinteger(l, 2);
+	const double range = luaL_checknumber(l, 3);
+	luaL_argcheck(l, std::isfinite(range) && range > 0.0 && range <= SystemIndex::MAX_SEARCH_RADIUS, 3,
+		"range must be a positive number of light years, up to 250");
+	if (!path->HasValidSystem())
+		return luaL_error(l, "SystemPath:GetNearestSystems() self argument does not refer to a system");
+
+	SystemIndex &index = Pi::game->GetGalaxy()->GetSystemIndex();
+	std::vector<SystemIndex::Result> nearest;
+	// one more, as this system is always the nearest
+	index.FindNearest(*path, index.GetPosition(*path), std::max(count, 0) + 1, range, nearest);
+
+	lua_newtable(l);
+	lua_newtable(l);
+	int i = 1;
+	for (const SystemIndex::Result &found : nearest) {
+		if (found.path.IsSameSystem(*path) || i > count)
+			continue;
+		lua_pushinteger(l, i);
+		LuaObject<SystemPath>::PushToLua(found.path);
+		lua_rawset(l, -4);
+		lua_pushinteger(l, i);
+		lua_pushnumber(l, found.distance);
+		lua_rawset(l, -3);
+		i++;
+	}
+	return 2;
+}
+
 /*
  * Method: GetStarSystem
  *
@@ -632,6 +745,8 @@ void LuaObject<SystemPath>::RegisterClass()
 		{ "SectorOnly", l_sbodypath_sector_only },
 
 		{ "DistanceTo", l_sbodypath_distance_to },
+		{ "GetNearbySystems", l_sbodypath_get_nearby_systems },
+		{ "GetNearestSystems", l_sbodypath_get_nearest_systems },
 
 		{ "GetStarSystem", l_sbodypath_get_star_system },
 		{ "GetSystemBody", l_sbodypath_get_system_body },
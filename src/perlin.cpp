@@ -4,6 +4,13 @@
 #include "perlin.h"
 #include <math.h>
 
+// The batched kernel uses SSE2 on x86-64 only, where scalar double maths is
+// also SSE2 and the two paths round identically.
+#if defined(__x86_64__) || defined(_M_X64)
+#define PERLIN_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
 /* Simplex.cpp
  *
  * Copyright 2007 Eliot Eshelman
@@ -248,6 +255,110 @@ double noise(const vector3d &p)
 	return 32.0 * (n0 + n1 + n2 + n3);
 }
 
+#ifdef PERLIN_SIMD_SSE2
+// Two points at a time; mirrors noise(const vector3d &) operation for operation
+static inline void noise_sse2(const double *px, const double *py, const double *pz, double *out)
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d x = _mm_loadu_pd(px);
+	const __m128d y = _mm_loadu_pd(py);
+	const __m128d z = _mm_loadu_pd(pz);
+
+	// Skew the input space to determine which simplex cell we're in
+	const __m128d s = _mm_mul_pd(_mm_add_pd(_mm_add_pd(x, y), z), _mm_set1_pd(F3));
+
+	// fastfloor: long(x > 0 ? x : x - 1)
+	auto floor2 = [&](const __m128d v) {
+		const __m128d gt = _mm_cmpgt_pd(v, zero);
+		return _mm_cvttpd_epi32(_mm_or_pd(_mm_and_pd(gt, v), _mm_andnot_pd(gt, _mm_sub_pd(v, one))));
+	};
+	const __m128i i = floor2(_mm_add_pd(x, s));
+	const __m128i j = floor2(_mm_add_pd(y, s));
+	const __m128i k = floor2(_mm_add_pd(z, s));
+
+	const __m128d t = _mm_mul_pd(_mm_cvtepi32_pd(_mm_add_epi32(_mm_add_epi32(i, j), k)), _mm_set1_pd(G3));
+	const __m128d x0 = _mm_sub_pd(x, _mm_sub_pd(_mm_cvtepi32_pd(i), t));
+	const __m128d y0 = _mm_sub_pd(y, _mm_sub_pd(_mm_cvtepi32_pd(j), t));
+	const __m128d z0 = _mm_sub_pd(z, _mm_sub_pd(_mm_cvtepi32_pd(k), t));
+
+	// The branches of the scalar version reduce to these three comparisons
+	const __m128d xy = _mm_cmpge_pd(x0, y0);
+	const __m128d yz = _mm_cmpge_pd(y0, z0);
+	const __m128d xz = _mm_cmpge_pd(x0, z0);
+	const __m128d i1 = _mm_and_pd(_mm_and_pd(xy, xz), one);
+	const __m128d j1 = _mm_and_pd(_mm_andnot_pd(xy, yz), one);
+	const __m128d k1 = _mm_andnot_pd(_mm_or_pd(yz, xz), one);
+	const __m128d i2 = _mm_and_pd(_mm_or_pd(xy, xz), one);
+	const __m128d j2 = _mm_sub_pd(one, _mm_and_pd(_mm_andnot_pd(yz, xy), one));
+	const __m128d k2 = _mm_sub_pd(one, _mm_and_pd(_mm_and_pd(yz, xz), one));
+
+	const __m128d g3 = _mm_set1_pd(G3);
+	const __m128d g3mul2 = _mm_set1_pd(G3mul2);
+	const __m128d g3mul3 = _mm_set1_pd(G3mul3);
+	const __m128d x1 = _mm_add_pd(_mm_sub_pd(x0, i1), g3);
+	const __m128d y1 = _mm_add_pd(_mm_sub_pd(y0, j1), g3);
+	const __m128d z1 = _mm_add_pd(_mm_sub_pd(z0, k1), g3);
+	const __m128d x2 = _mm_add_pd(_mm_sub_pd(x0, i2), g3mul2);
+	const __m128d y2 = _mm_add_pd(_mm_sub_pd(y0, j2), g3mul2);
+	const __m128d z2 = _mm_add_pd(_mm_sub_pd(z0, k2), g3mul2);
+	const __m128d x3 = _mm_add_pd(_mm_sub_pd(x0, one), g3mul3);
+	const __m128d y3 = _mm_add_pd(_mm_sub_pd(y0, one), g3mul3);
+	const __m128d z3 = _mm_add_pd(_mm_sub_pd(z0, one), g3mul3);
+
+	// The permutation table lookups have no SSE2 gather, so do them per lane
+	alignas(16) int ijk[3][4];
+	_mm_store_si128(reinterpret_cast<__m128i *>(ijk[0]), i);
+	_mm_store_si128(reinterpret_cast<__m128i *>(ijk[1]), j);
+	_mm_store_si128(reinterpret_cast<__m128i *>(ijk[2]), k);
+	const int mxy = _mm_movemask_pd(xy), myz = _mm_movemask_pd(yz), mxz = _mm_movemask_pd(xz);
+
+	int gi[4][2];
+	for (int lane = 0; lane < 2; lane++) {
+		const int a = (mxy >> lane) & 1, b = (myz >> lane) & 1, c = (mxz >> lane) & 1;
+		const int ii = ijk[0][lane] & 255;
+		const int jj = ijk[1][lane] & 255;
+		const int kk = ijk[2][lane] & 255;
+		gi[0][lane] = mod12[perm[ii + perm[jj + perm[kk]]]];
+		gi[1][lane] = mod12[perm[ii + (a & c) + perm[jj + (b & ~a) + perm[kk + (1 & ~(b | c))]]]];
+		gi[2][lane] = mod12[perm[ii + (a | c) + perm[jj + (1 & ~(a & ~b)) + perm[kk + (1 & ~(b & c))]]]];
+		gi[3][lane] = mod12[perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]]];
+	}
+
+	// Calculate the contribution from each corner, zeroed where t < 0
+	const __m128d point6 = _mm_set1_pd(0.6);
+	auto corner = [&](const int c, const __m128d cx, const __m128d cy, const __m128d cz) {
+		const double *g0 = grad3[gi[c][0]];
+		const double *g1 = grad3[gi[c][1]];
+		__m128d tc = _mm_sub_pd(_mm_sub_pd(_mm_sub_pd(point6, _mm_mul_pd(cx, cx)), _mm_mul_pd(cy, cy)), _mm_mul_pd(cz, cz));
+		const __m128d negative = _mm_cmplt_pd(tc, zero);
+		const __m128d d = _mm_add_pd(_mm_add_pd(
+										 _mm_mul_pd(_mm_set_pd(g1[0], g0[0]), cx),
+										 _mm_mul_pd(_mm_set_pd(g1[1], g0[1]), cy)),
+			_mm_mul_pd(_mm_set_pd(g1[2], g0[2]), cz));
+		tc = _mm_mul_pd(tc, tc);
+		return _mm_andnot_pd(negative, _mm_mul_pd(_mm_mul_pd(tc, tc), d));
+	};
+	const __m128d n0 = corner(0, x0, y0, z0);
+	const __m128d n1 = corner(1, x1, y1, z1);
+	const __m128d n2 = corner(2, x2, y2, z2);
+	const __m128d n3 = corner(3, x3, y3, z3);
+
+	_mm_storeu_pd(out, _mm_mul_pd(_mm_set1_pd(32.0), _mm_add_pd(_mm_add_pd(_mm_add_pd(n0, n1), n2), n3)));
+}
+#endif
+
+void noise(const double *x, const double *y, const double *z, double *out, size_t count)
+{
+	size_t n = 0;
+#ifdef PERLIN_SIMD_SSE2
+	for (; n + 2 <= count; n += 2)
+		noise_sse2(x + n, y + n, z + n, out + n);
+#endif
+	for (; n < count; n++)
+		out[n] = noise(vector3d(x[n], y[n], z[n]));
+}
+
 #ifdef UNIT_TEST
 #include <stdio.h>
 #include <stdlib.h>
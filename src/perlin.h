@@ -6,6 +6,12 @@
 
 #include "vector3.h"
 
+#include <cstddef>
+
 double noise(const vector3d &p);
 
+// Batched 3D simplex noise over structure-of-arrays input.
+// Each out[n] is bit-identical to noise(vector3d(x[n], y[n], z[n])).
+void noise(const double *x, const double *y, const double *z, double *out, size_t count);
+
 #endif /* _PERLIN_H */
@@ -8,10 +8,12 @@
 #include "Pi.h"
 #include "Player.h"
 #include "Space.h"
+#include "galaxy/Galaxy.h"
 #include "graphics/Renderer.h"
 #include "graphics/Stats.h"
 #include "graphics/Texture.h"
 #include "lua/Lua.h"
+#include "lua/LuaEvent.h"
 #include "lua/LuaManager.h"
 #include "scenegraph/Model.h"
 
@@ -235,6 +237,16 @@ void PerfInfo::DrawPerfWindow()
 					DrawWorldViewStats();
 					ImGui::EndTabItem();
 				}
+
+				if (ImGui::BeginTabItem("Galaxy")) {
+					DrawStatList(Pi::game->GetGalaxy()->GetStats().GetFrameStats());
+					ImGui::EndTabItem();
+				}
+
+				if (ImGui::BeginTabItem("Lua Events")) {
+					DrawStatList(LuaEvent::GetStats().GetFrameStats());
+					ImGui::EndTabItem();
+				}
 			}
 
 			PiGui::RunHandler(Pi::GetFrameTime(), "debug-tabs");
@@ -256,6 +268,9 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 numLines = stats.m_stats[Graphics::Stats::STAT_NUM_LINES];
 	const Uint32 numPoints = stats.m_stats[Graphics::Stats::STAT_NUM_POINTS];
 	const Uint32 numCmdListFlushes = stats.m_stats[Graphics::Stats::STAT_NUM_CMDLIST_FLUSHES];
+	const Uint32 numRenderStateChanges = stats.m_stats[Graphics::Stats::STAT_NUM_RENDER_STATE_CHANGES];
+	const Uint32 numProgramChanges = stats.m_stats[Graphics::Stats::STAT_NUM_PROGRAM_CHANGES];
+	const Uint32 numTextureChanges = stats.m_stats[Graphics::Stats::STAT_NUM_TEXTURE_CHANGES];
 	const Uint32 numBuffersCreated = stats.m_stats[Graphics::Stats::STAT_CREATE_BUFFER];
 	const Uint32 numBuffersInUse = stats.m_stats[Graphics::Stats::STAT_BUFFER_INUSE];
 	const Uint32 numDynamicBuffersCreated = stats.m_stats[Graphics::Stats::STAT_DYNAMIC_DRAW_BUFFER_CREATED];
@@ -282,12 +297,17 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 texCubeMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_TEXTURECUBE];
 	const Uint32 numTexArray2ds = stats.m_stats[Graphics::Stats::STAT_NUM_TEXTUREARRAY2D];
 	const Uint32 texArray2dMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_TEXTUREARRAY2D];
+	const Uint32 numGeoPatchBlocks = stats.m_stats[Graphics::Stats::STAT_NUM_GEOPATCH_BLOCKS];
+	const Uint32 peakGeoPatchBlocks = stats.m_stats[Graphics::Stats::STAT_PEAK_GEOPATCH_BLOCKS];
+	const Uint32 geoPatchPoolMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_GEOPATCH_POOL];
 	const Uint32 numCachedTextures = numTex2ds + numTexCubemaps + numTexArray2ds;
 	const Uint32 cachedTextureMemUsage = tex2dMemUsage + texCubeMemUsage + texArray2dMemUsage;
 
 	ImGui::Text("Renderer:");
 	ImGui::Text("%u Draw calls, %u CommandList flushes",
 		numDrawCalls, numCmdListFlushes);
+	ImGui::Text("%u render state, %u shader program, %u texture changes",
+		numRenderStateChanges, numProgramChanges, numTextureChanges);
 
 	ImGui::Indent();
 	ImGui::Text("%u points", numPoints);
@@ -302,6 +322,8 @@ void PerfInfo::DrawRendererStats()
 		numDrawAtmospheres, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips);
 	ImGui::Text("%u Billboards, %u GeoPatches (%d tris)",
 		numDrawBillBoards, Pi::statNumPatches, Pi::statSceneTris);
+	ImGui::Text("%u GeoPatch data blocks in use (%u peak, %.3f MB reserved)",
+		numGeoPatchBlocks, peakGeoPatchBlocks, double(geoPatchPoolMemUsage) / scale_MB);
 	ImGui::Text("%u Buffers Created (%u in use)", numBuffersCreated, numBuffersInUse);
 	ImGui::Text("%u Dynamic Draw Buffers Created (%u in use)", numDynamicBuffersCreated, numDynamicBuffersInUse);
 	ImGui::Text("%u Draw Uniform Buffers (%u allocations)", numDrawBuffers, numDrawBufferAllocs);
@@ -6,6 +6,8 @@
 #include "libs.h"
 #include "utils.h"
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -123,8 +125,9 @@ namespace FileSystem {
 		return data_path;
 	}
 
-	FileSourceFS::FileSourceFS(const std::string &root, bool trusted) :
-		FileSource(absolute_path(root), trusted) {}
+	FileSourceFS::FileSourceFS(const std::string &root, bool trusted, bool mapFiles) :
+		FileSource(absolute_path(root), trusted),
+		m_mapFiles(mapFiles) {}
 
 	FileSourceFS::~FileSourceFS() {}
 
@@ -167,7 +170,46 @@ namespace FileSystem {
 		return MakeFileInfo(path, ty, mtime);
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data) :
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { munmap(m_data, m_size); }
+	};
+
 	RefCountedPtr<FileData> FileSourceFS::ReadFile(const std::string &path)
+	{
+		return m_mapFiles ? MapFile(path) : ReadFileCopy(path);
+	}
+
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		const int fd = open(fullpath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return RefCountedPtr<FileData>(0);
+
+		struct stat info;
+		Time::DateTime mtime;
+		if (fstat(fd, &info) != 0 || interpret_stat(info, mtime) != FileInfo::FT_FILE || size_t(info.st_size) < MAP_MIN_SIZE) {
+			close(fd);
+			return ReadFileCopy(path);
+		}
+
+		const size_t sz = size_t(info.st_size);
+		void *data = mmap(0, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED)
+			return ReadFileCopy(path);
+
+		// files are read whole and front to back, so start reading all of it now
+		madvise(data, sz, MADV_SEQUENTIAL);
+		madvise(data, sz, MADV_WILLNEED);
+
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, mtime), sz, static_cast<char *>(data)));
+	}
+
+	RefCountedPtr<FileData> FileSourceFS::ReadFileCopy(const std::string &path)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
 		Time::DateTime mtime;
@@ -271,6 +313,19 @@ namespace FileSystem {
 		return make_directory_raw(fullpath);
 	}
 
+	bool FileSourceFS::RemoveFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		return (remove(fullpath.c_str()) == 0);
+	}
+
+	bool FileSourceFS::RenameFile(const std::string &oldPath, const std::string &newPath)
+	{
+		const std::string fullOldPath = JoinPathBelow(GetRoot(), oldPath);
+		const std::string fullNewPath = JoinPathBelow(GetRoot(), newPath);
+		return (rename(fullOldPath.c_str(), fullNewPath.c_str()) == 0);
+	}
+
 	FILE *FileSourceFS::OpenReadStream(const std::string &path)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
@@ -3,6 +3,8 @@
 
 #include "FileSystem.h"
 #include "Json.h"
+#include "JsonUtils.h"
+#include "core/ChunkFormat.h"
 #include "core/GZipFormat.h"
 #include <SDL.h>
 
@@ -33,31 +35,39 @@ extern "C" int main(int argc, char **argv)
 
 	const auto compressed_data = file->AsByteRange();
 	Json rootNode;
-	try {
-		std::string plain_data;
-		if (gzip::IsGZipFormat(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size()))
-			plain_data = gzip::DecompressDeflateOrGZip(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size());
-		else
-			plain_data = std::string(compressed_data.begin, compressed_data.Size());
-
-		try {
-			// Allow loading files in JSON format as well as CBOR
-			if (plain_data[0] == '{')
-				rootNode = Json::parse(plain_data);
-			else
-				rootNode = Json::from_cbor(plain_data);
-		} catch (Json::parse_error &e) {
-			printf("Saved game is not a valid JSON object: %s.\n", e.what());
+	if (chunk::IsChunkFormat(compressed_data.begin, compressed_data.Size())) {
+		rootNode = JsonUtils::LoadJsonSaveFile(filename, FileSystem::userFiles);
+		if (!rootNode.is_object()) {
+			printf("Saved game is not a valid chunked save.\n");
 			return 2;
 		}
+	} else {
+		try {
+			std::string plain_data;
+			if (gzip::IsGZipFormat(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size()))
+				plain_data = gzip::DecompressDeflateOrGZip(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size());
+			else
+				plain_data = std::string(compressed_data.begin, compressed_data.Size());
 
-		if (!rootNode.is_object()) {
-			printf("Saved game's root is not a JSON object.\n");
-			return 2;
+			try {
+				// Allow loading files in JSON format as well as CBOR
+				if (plain_data[0] == '{')
+					rootNode = Json::parse(plain_data);
+				else
+					rootNode = Json::from_cbor(plain_data);
+			} catch (Json::parse_error &e) {
+				printf("Saved game is not a valid JSON object: %s.\n", e.what());
+				return 2;
+			}
+
+			if (!rootNode.is_object()) {
+				printf("Saved game's root is not a JSON object.\n");
+				return 2;
+			}
+		} catch (gzip::DecompressionFailedException) {
+			printf("Decompressing saved data failed - saved game is corrupt.\n");
+			return 3;
 		}
-	} catch (gzip::DecompressionFailedException) {
-		printf("Decompressing saved data failed - saved game is corrupt.\n");
-		return 3;
 	}
 
 	auto outFile = FileSystem::userFiles.OpenWriteStream(outname);
@@ -3,6 +3,7 @@
 
 #include "BaseLoader.h"
 #include "FileSystem.h"
+#include "ModelIndex.h"
 #include "graphics/RenderState.h"
 #include "graphics/TextureBuilder.h"
 #include "graphics/Types.h"
@@ -118,14 +119,19 @@ RefCountedPtr<Graphics::Material> BaseLoader::GetDecalMaterial(unsigned int inde
 
 void BaseLoader::FindPatterns(PatternContainer &output)
 {
-	for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, m_curPath); !files.Finished(); files.Next()) {
-		const FileSystem::FileInfo &info = files.Current();
-		if (info.IsFile()) {
-			const std::string &name = info.GetName();
-			if (starts_with(name, "pattern")) {
-				if (ends_with_ci(name, ".png") || ends_with_ci(name, ".dds"))
-					output.push_back(Pattern(name, m_curPath, m_renderer));
-			}
+	std::vector<FileSystem::FileInfo> textures;
+	if (!ModelIndex::FindTextures(m_curPath, textures)) {
+		for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, m_curPath); !files.Finished(); files.Next()) {
+			if (files.Current().IsFile())
+				textures.push_back(files.Current());
+		}
+	}
+
+	for (const FileSystem::FileInfo &info : textures) {
+		const std::string &name = info.GetName();
+		if (starts_with(name, "pattern")) {
+			if (ends_with_ci(name, ".png") || ends_with_ci(name, ".dds"))
+				output.push_back(Pattern(name, m_curPath, m_renderer));
 		}
 	}
 }
@@ -10,6 +10,7 @@
 #include "scenegraph/Animation.h"
 #include "scenegraph/Label3D.h"
 #include "scenegraph/MatrixTransform.h"
+#include "scenegraph/ModelIndex.h"
 #include "scenegraph/Serializer.h"
 #include "utils.h"
 
@@ -138,6 +139,7 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 		Output("Compressed model (%s): %.2f KB -> %.2f KB\n", filename.c_str(), data.size() / 1024.f, outSize / 1024.f);
 		fwrite(compressedData.data(), outSize, 1, f);
 		fclose(f);
+		ModelIndex::Invalidate();
 	} catch (std::runtime_error &e) {
 		Warning("Error saving SGM model: %s\n", e.what());
 		throw CouldNotWriteToFileException();
@@ -152,64 +154,69 @@ Model *BinaryConverter::Load(const std::string &filename)
 Model *BinaryConverter::Load(const std::string &name, RefCountedPtr<FileSystem::FileData> binfile)
 {
 	PROFILE_SCOPED()
-	Model *model(nullptr);
-	// decompress the loaded ByteRange in memory
-	const ByteRange bin = binfile->AsByteRange();
+	std::string data;
+	if (!Decompress(binfile->AsByteRange(), data)) {
+		Warning("Error loading SGM model: could not decompress %s\n", name.c_str());
+		return nullptr;
+	}
+	return LoadDecompressed(name, m_curPath, data);
+}
+
+Model *BinaryConverter::LoadDecompressed(const std::string &name, const std::string &curPath, const std::string &data)
+{
+	PROFILE_SCOPED()
+	m_curPath = curPath;
+	try {
+		Serializer::Reader rd(ByteRange(data.data(), data.size()));
+		return CreateModel(name, rd);
+	} catch (std::runtime_error &e) {
+		Warning("Error loading SGM model: %s\n", e.what());
+	}
+	return nullptr;
+}
+
+//static
+bool BinaryConverter::Decompress(const ByteRange &bin, std::string &out)
+{
+	PROFILE_SCOPED()
 	if (lz4::IsLZ4Format(bin.begin, bin.Size())) {
 		try {
-			std::string decompressedData = lz4::DecompressLZ4({ bin.begin, bin.Size() });
-			// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, decompressedData.size() / 1024.f);
-			Serializer::Reader rd(ByteRange(decompressedData.data(), decompressedData.size()));
-			model = CreateModel(name, rd);
-		} catch (std::runtime_error &e) {
-			Warning("Error loading SGM model: %s\n", e.what());
-		}
-	} else {
-		void *pDecompressedData;
-		size_t outSize(0);
-		{
-			PROFILE_SCOPED_DESC("tinfl_decompress_mem_to_heap")
-			pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
-		}
-		// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, outSize / 1024.f);
-		if (pDecompressedData) {
-			// now parse in-memory representation as new ByteRange.
-			Serializer::Reader rd(ByteRange(static_cast<char *>(pDecompressedData), outSize));
-			model = CreateModel(name, rd);
-			mz_free(pDecompressedData);
-		} else {
-			Error("BinaryConverter failed to load old-style SGM called: %s", name.c_str());
+			out = lz4::DecompressLZ4({ bin.begin, bin.Size() });
+		} catch (std::runtime_error &) {
+			return false;
 		}
+		return true;
 	}
 
-	return model;
+	// old-style SGM
+	size_t outSize(0);
+	void *pDecompressedData;
+	{
+		PROFILE_SCOPED_DESC("tinfl_decompress_mem_to_heap")
+		pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
+	}
+	if (!pDecompressedData)
+		return false;
+	out.assign(static_cast<char *>(pDecompressedData), outSize);
+	mz_free(pDecompressedData);
+	return true;
 }
 
 Model *BinaryConverter::Load(const std::string &shortname, const std::string &basepath)
 {
 	PROFILE_SCOPED()
-	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
-	for (FileSystem::FileEnumerator files(fileSource, basepath, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
-		const FileSystem::FileInfo &info = files.Current();
-		const std::string &fpath = info.GetPath();
-
-		//check it's the expected type
-		if (info.IsFile() && ends_with_ci(fpath, SGM_EXTENSION)) {
-			//check it's the wanted name & load it
-			const std::string name = info.GetName();
-
-			if (shortname == name.substr(0, name.length() - SGM_EXTENSION.length())) {
-				//curPath is used to find textures, patterns,
-				//possibly other data files for this model.
-				//Strip trailing slash
-				m_curPath = info.GetDir();
-				if (m_curPath[m_curPath.length() - 1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
-
-				RefCountedPtr<FileSystem::FileData> binfile = info.Read();
-				if (binfile.Valid()) return Load(name, binfile);
-			}
-		}
+	ModelIndex::Entry entry;
+	if (ModelIndex::Find(basepath, shortname, entry) && entry.sgm.Exists()) {
+		const FileSystem::FileInfo &info = entry.sgm;
+		//curPath is used to find textures, patterns,
+		//possibly other data files for this model.
+		//Strip trailing slash
+		m_curPath = info.GetDir();
+		if (m_curPath[m_curPath.length() - 1] == '/')
+			m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
+
+		RefCountedPtr<FileSystem::FileData> binfile = info.Read();
+		if (binfile.Valid()) return Load(info.GetName(), binfile);
 	}
 
 	throw(LoadingError("File not found"));
@@ -383,35 +390,25 @@ ModelDefinition BinaryConverter::FindModelDefinition(const std::string &shortnam
 	PROFILE_SCOPED()
 	const std::string basepath = "models";
 
-	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
-	for (FileSystem::FileEnumerator files(fileSource, basepath, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
-		const FileSystem::FileInfo &info = files.Current();
-		const std::string &fpath = info.GetPath();
-
-		//check it's the expected type
-		if (info.IsFile() && ends_with_ci(fpath, ".model")) {
-			//check it's the wanted name & load it
-			const std::string name = info.GetName();
-
-			if (shortname == name.substr(0, name.length() - 6)) {
-				ModelDefinition modelDefinition;
-				try {
-					//curPath is used to find textures, patterns,
-					//possibly other data files for this model.
-					//Strip trailing slash
-					m_curPath = info.GetDir();
-					assert(!m_curPath.empty());
-					if (m_curPath[m_curPath.length() - 1] == '/')
-						m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
-
-					Parser p(fileSource, fpath, m_curPath);
-					p.Parse(&modelDefinition);
-					return modelDefinition;
-				} catch (ParseError &err) {
-					Output("%s\n", err.what());
-					throw LoadingError(err.what());
-				}
-			}
+	ModelIndex::Entry entry;
+	if (ModelIndex::Find(basepath, shortname, entry) && entry.model.Exists()) {
+		const FileSystem::FileInfo &info = entry.model;
+		ModelDefinition modelDefinition;
+		try {
+			//curPath is used to find textures, patterns,
+			//possibly other data files for this model.
+			//Strip trailing slash
+			m_curPath = info.GetDir();
+			assert(!m_curPath.empty());
+			if (m_curPath[m_curPath.length() - 1] == '/')
+				m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
+
+			Parser p(FileSystem::gameDataFiles, info.GetPath(), m_curPath);
+			p.Parse(&modelDefinition);
+			return modelDefinition;
+		} catch (ParseError &err) {
+			Output("%s\n", err.what());
+			throw LoadingError(err.what());
 		}
 	}
 	throw(LoadingError("File not found"));
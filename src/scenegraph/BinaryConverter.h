@@ -38,7 +38,9 @@ namespace SceneGraph {
 	// 6:	32-bit indicies
 	// 6.1:	rewrote serialization, use lz4 compression instead of INFLATE/DEFLATE. Still compatible.
 	// 6.2: ignored StaticGeometry::m_blendMode in files. Still write blank value.
-	constexpr Uint32 SGM_VERSION = 6;
+	// 7:	store the collision mesh BVHs rather than rebuilding them, read its arrays in bulk.
+	//	Dropped the StaticGeometry::m_blendMode placeholder.
+	constexpr Uint32 SGM_VERSION = 7;
 
 	class BinaryConverter : public BaseLoader {
 	public:
@@ -48,6 +50,12 @@ namespace SceneGraph {
 		Model *Load(const std::string &filename);
 		Model *Load(const std::string &filename, const std::string &path);
 		Model *Load(const std::string &filename, RefCountedPtr<FileSystem::FileData> binfile);
+		// a model from the decompressed contents of an .sgm file in curPath
+		Model *LoadDecompressed(const std::string &filename, const std::string &curPath, const std::string &data);
+
+		// The contents of an .sgm file out of its compression. Doesn't touch
+		// the renderer, so can be done on a job thread ahead of loading.
+		static bool Decompress(const ByteRange &bin, std::string &out);
 
 		//if you implement any new node types, you must also register a loader function
 		//before calling Load.
@@ -15,6 +15,7 @@
 #include "graphics/TextureBuilder.h"
 #include "scenegraph/Animation.h"
 #include "scenegraph/LoaderDefinitions.h"
+#include "scenegraph/ModelIndex.h"
 #include "utils.h"
 #include <assimp/material.h>
 #include <assimp/postprocess.h>
@@ -136,67 +137,46 @@ namespace SceneGraph {
 		PROFILE_SCOPED()
 		m_logMessages.clear();
 
-		std::vector<std::string> list_model;
-		std::vector<std::string> list_sgm;
-		FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
-		for (FileSystem::FileEnumerator files(fileSource, basepath, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
-			const FileSystem::FileInfo &info = files.Current();
-			const std::string &fpath = info.GetPath();
-
-			//check it's the expected type
-			if (info.IsFile()) {
-				if (ends_with_ci(fpath, ".model")) { // store the path for ".model" files
-					list_model.push_back(fpath);
-				} else if (m_loadSGMs & ends_with_ci(fpath, ".sgm")) { // store only the shortname for ".sgm" files.
-					list_sgm.push_back(info.GetName().substr(0, info.GetName().size() - 4));
-				}
-			}
-		}
-
-		if (m_loadSGMs) {
-			for (auto &sgmname : list_sgm) {
-				if (sgmname == shortname) {
-					//binary loader expects extension-less name. Might want to change this.
-					SceneGraph::BinaryConverter bc(m_renderer);
-					m_model = bc.Load(shortname);
-					if (m_model)
-						return m_model;
-					else
-						break; // we'll have to load the non-sgm file
-				}
-			}
+		ModelIndex::Entry entry;
+		if (!ModelIndex::Find(basepath, shortname, entry))
+			throw(LoadingError("File not found"));
+
+		if (m_loadSGMs && entry.sgm.Exists()) {
+			//binary loader expects extension-less name. Might want to change this.
+			SceneGraph::BinaryConverter bc(m_renderer);
+			m_model = bc.Load(shortname, basepath);
+			if (m_model)
+				return m_model;
+			// otherwise we'll have to load the non-sgm file
 		}
 
-		for (auto &fpath : list_model) {
-			RefCountedPtr<FileSystem::FileData> filedata = FileSystem::gameDataFiles.ReadFile(fpath);
+		if (entry.model.Exists()) {
+			const std::string &fpath = entry.model.GetPath();
+			RefCountedPtr<FileSystem::FileData> filedata = entry.model.Read();
 			if (!filedata) {
 				Output("LoadModel: %s: could not read file\n", fpath.c_str());
 				return nullptr;
 			}
 
-			//check it's the wanted name & load it
 			const FileSystem::FileInfo &info = filedata->GetInfo();
-			const std::string name = info.GetName();
-			if (name.substr(0, name.length() - 6) == shortname) {
-				ModelDefinition modelDefinition;
-				try {
-					//curPath is used to find textures, patterns,
-					//possibly other data files for this model.
-					//Strip trailing slash
-					m_curPath = info.GetDir();
-					assert(!m_curPath.empty());
-					if (m_curPath[m_curPath.length() - 1] == '/')
-						m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
-
-					Parser p(fileSource, fpath, m_curPath);
-					p.Parse(&modelDefinition);
-				} catch (ParseError &err) {
-					Output("%s\n", err.what());
-					throw LoadingError(err.what());
-				}
-				modelDefinition.name = shortname;
-				return CreateModel(modelDefinition);
+			ModelDefinition modelDefinition;
+			try {
+				//curPath is used to find textures, patterns,
+				//possibly other data files for this model.
+				//Strip trailing slash
+				m_curPath = info.GetDir();
+				assert(!m_curPath.empty());
+				if (m_curPath[m_curPath.length() - 1] == '/')
+					m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
+
+				Parser p(FileSystem::gameDataFiles, fpath, m_curPath);
+				p.Parse(&modelDefinition);
+			} catch (ParseError &err) {
+				Output("%s\n", err.what());
+				throw LoadingError(err.what());
 			}
+			modelDefinition.name = shortname;
+			return CreateModel(modelDefinition);
 		}
 		throw(LoadingError("File not found"));
 	}
@@ -0,0 +1,113 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ModelIndex.h"
+
+#include "profiler/Profiler.h"
+#include "utils.h"
+
+#include <map>
+#include <mutex>
+
+namespace {
+	struct Index {
+		unsigned generation;
+		std::map<std::string, SceneGraph::ModelIndex::Entry> models;
+		// by directory, without the trailing slash
+		std::map<std::string, std::vector<FileSystem::FileInfo>> textures;
+	};
+
+	std::mutex s_mutex;
+	std::map<std::string, Index> s_indices; // by base path
+
+	std::string strip_extension(const std::string &name, size_t length)
+	{
+		return name.substr(0, name.size() - length);
+	}
+
+	std::string strip_slash(std::string dir)
+	{
+		if (!dir.empty() && dir.back() == '/')
+			dir.pop_back();
+		return dir;
+	}
+
+	void build_index(const std::string &basepath, Index &index)
+	{
+		PROFILE_SCOPED()
+		index.generation = FileSystem::gameDataFiles.GetGeneration();
+		index.models.clear();
+		index.textures.clear();
+
+		// enumerated in path order, so the first model of a name wins as it
+		// did when searching for it
+		for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, basepath, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
+			const FileSystem::FileInfo &info = files.Current();
+			if (!info.IsFile())
+				continue;
+
+			const std::string &fpath = info.GetPath();
+			if (ends_with_ci(fpath, ".sgm")) {
+				FileSystem::FileInfo &sgm = index.models[strip_extension(info.GetName(), 4)].sgm;
+				if (!sgm.Exists())
+					sgm = info;
+			} else if (ends_with_ci(fpath, ".model")) {
+				FileSystem::FileInfo &model = index.models[strip_extension(info.GetName(), 6)].model;
+				if (!model.Exists())
+					model = info;
+			} else if (ends_with_ci(fpath, ".png") || ends_with_ci(fpath, ".dds")) {
+				index.textures[strip_slash(info.GetDir())].push_back(info);
+			}
+		}
+	}
+
+	// call with s_mutex held
+	const Index &get_index(const std::string &basepath)
+	{
+		auto it = s_indices.find(basepath);
+		if (it == s_indices.end() || it->second.generation != FileSystem::gameDataFiles.GetGeneration()) {
+			Index &index = s_indices[basepath];
+			build_index(basepath, index);
+			return index;
+		}
+		return it->second;
+	}
+} // namespace
+
+namespace SceneGraph {
+
+	bool ModelIndex::Find(const std::string &basepath, const std::string &shortname, Entry &out)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		const Index &index = get_index(basepath);
+		auto it = index.models.find(shortname);
+		if (it == index.models.end())
+			return false;
+		out = it->second;
+		return true;
+	}
+
+	bool ModelIndex::FindTextures(const std::string &dir, std::vector<FileSystem::FileInfo> &out)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for (auto &entry : s_indices) {
+			const std::string &basepath = entry.first;
+			if (dir != basepath && !starts_with(dir, basepath + "/"))
+				continue;
+
+			const Index &index = get_index(basepath);
+			auto it = index.textures.find(dir);
+			if (it != index.textures.end())
+				out.insert(out.end(), it->second.begin(), it->second.end());
+			return true;
+		}
+		return false;
+	}
+
+	void ModelIndex::Invalidate()
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_indices.clear();
+	}
+
+} // namespace SceneGraph
@@ -0,0 +1,40 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MODELINDEX_H
+#define _SCENEGRAPH_MODELINDEX_H
+/*
+ * Index of the model files (.sgm and .model, by short name) and textures
+ * (by directory) below a base path of the game data, so loading a model
+ * doesn't walk the whole tree each time.
+ *
+ * An index is built the first time a base path is asked about, and again
+ * once the sources of the game data change (when mods are added, say).
+ * Anything writing model files there has to call Invalidate. Safe to use
+ * from any thread.
+ */
+#include "FileSystem.h"
+
+#include <string>
+#include <vector>
+
+namespace SceneGraph {
+
+	class ModelIndex {
+	public:
+		struct Entry {
+			FileSystem::FileInfo sgm; // non-existent if there isn't one
+			FileSystem::FileInfo model;
+		};
+
+		// the files of the model called shortname, false if it has none
+		static bool Find(const std::string &basepath, const std::string &shortname, Entry &out);
+		// the .png and .dds files directly in dir, false if dir is not below
+		// a base path that has been indexed
+		static bool FindTextures(const std::string &dir, std::vector<FileSystem::FileInfo> &out);
+		static void Invalidate();
+	};
+
+} // namespace SceneGraph
+
+#endif
@@ -9,8 +9,10 @@
 #include "Color.h"
 #include "Quaternion.h"
 #include "vector3.h"
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #if (__GNUC__ && (__BYTE_ORDER_ == __ORDER_BIG_ENDIAN__)) || (__clang__ && __BIG_ENDIAN__)
 #error Serializer.h is incompatible with big-endian architectures!
@@ -85,6 +87,15 @@ namespace Serializer {
 				m_str.append(range.begin, range.Size());
 			}
 		}
+		// count objects as they are in memory, in one go, see Reader::Array
+		template <typename T>
+		void Array(const T *objs, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "only plain data can be written as an array");
+			if (count)
+				m_str.append(reinterpret_cast<const char *>(objs), count * sizeof(T));
+		}
+
 		void Byte(Uint8 x) { *this << x; }
 		void Bool(bool x) { *this << x; }
 		void Int16(Uint16 x) { *this << x; }
@@ -130,7 +141,7 @@ namespace Serializer {
 
 		bool Check(std::size_t needed_size)
 		{
-			return m_data.end >= m_at + needed_size;
+			return needed_size <= Remaining();
 		}
 
 		void Seek(int pos)
@@ -189,6 +200,39 @@ namespace Serializer {
 			return range;
 		}
 
+		// throws if there isn't room left for count objects, to check counts
+		// read from the stream before allocating anything that size
+		template <typename T>
+		void CheckArray(size_t count)
+		{
+			if (count > Remaining() / sizeof(T))
+				throw std::out_of_range("Serializer::Reader encountered truncated stream.");
+		}
+
+		// an Int32 count of objects, checked as for CheckArray
+		template <typename T>
+		size_t ArrayCount()
+		{
+			if (!Check(sizeof(Uint32)))
+				throw std::out_of_range("Serializer::Reader encountered truncated stream.");
+			const size_t count = Int32();
+			CheckArray<T>(count);
+			return count;
+		}
+
+		// count objects written by Writer::Array, copied straight into out
+		template <typename T>
+		void Array(T *out, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read as an array");
+			const size_t size = count * sizeof(T);
+			if (!Check(size))
+				throw std::out_of_range("Serializer::Reader encountered truncated stream.");
+			if (size)
+				memcpy(out, m_at, size);
+			m_at += size;
+		}
+
 		// Prefer using Reader::operator>> instead; these functions involve creating an unnessesary temporary variable.
 		bool Bool() { return obj<bool>(); }
 		Uint8 Byte() { return obj<Uint8>(); }
@@ -214,6 +258,9 @@ namespace Serializer {
 		void SetStreamVersion(int x) { m_streamVersion = x; }
 
 	private:
+		// readObject only checks in debug builds, so m_at can be past the end
+		std::size_t Remaining() const { return m_at < m_data.end ? std::size_t(m_data.end - m_at) : 0; }
+
 		ByteRange m_data;
 		const char *m_at;
 		int m_streamVersion;
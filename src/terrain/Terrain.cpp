@@ -7,6 +7,7 @@
 #include "FloatComparison.h"
 #include "GameConfig.h"
 #include "perlin.h"
+#include "core/FNV1a.h"
 #include "../utils.h"
 #include "../galaxy/SystemBody.h"
 
@@ -387,6 +388,7 @@ Terrain::Terrain(const SystemBody *body) :
 	m_minh(0),
 	m_minBody(body)
 {
+	Uint64 heightMapHash = 0;
 
 	// load the heightmap
 	if (!body->GetHeightMapFilename().empty()) {
@@ -396,6 +398,7 @@ Terrain::Terrain(const SystemBody *body) :
 			abort();
 		}
 
+		heightMapHash = hash_64_fnv1a(fdata->GetData(), fdata->GetSize());
 		ByteRange databuf = fdata->AsByteRange();
 
 		Sint16 minHMap = INT16_MAX, maxHMap = INT16_MIN;
@@ -471,6 +474,29 @@ Terrain::Terrain(const SystemBody *body) :
 	m_volcanic = Clamp(body->GetVolcanicity(), 0.0, 1.0); // height scales with volcanicity as well
 	m_surfaceEffects = 0;
 
+	{
+		// everything below is derived from these, so they identify the generated terrain
+		std::string params;
+		auto append = [&params](const auto &value) {
+			params.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		};
+		append(heightMapHash);
+		append(body->GetSeed());
+		append(body->GetType());
+		append(body->GetRadiusAsFixed().v);
+		append(body->GetAspectRatio());
+		append(body->GetMassAsFixed().v);
+		append(body->GetAverageTemp());
+		append(body->GetVolatileGas());
+		append(body->GetVolatileLiquid());
+		append(body->GetVolatileIces());
+		append(body->GetVolcanicity());
+		append(body->GetMetallicity());
+		append(body->GetLife());
+		append(body->GetHeightMapFractal());
+		m_paramsHash = hash_64_fnv1a(params.data(), params.size());
+	}
+
 	const double rad = m_minBody.m_radius;
 
 	// calculate max height
@@ -46,10 +46,19 @@ public:
 	virtual double GetHeight(const vector3d &p) const = 0;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const = 0;
 
+	// batched versions of the above, one virtual call for a whole run of points
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const = 0;
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const = 0;
+
 	virtual const char *GetHeightFractalName() const = 0;
 	virtual const char *GetColorFractalName() const = 0;
 
 	double GetMaxHeight() const { return m_maxHeight; }
+	double GetMaxHeightInMeters() const { return m_maxHeightInMeters; }
+	double GetPlanetEarthRadii() const { return m_planetEarthRadii; }
+	Uint32 GetSeed() const { return m_seed; }
+	// digest of every body parameter (and the heightmap file) the terrain is generated from
+	Uint64 GetParamsHash() const { return m_paramsHash; }
 
 	Uint32 GetSurfaceEffects() const { return m_surfaceEffects; }
 
@@ -68,6 +77,7 @@ protected:
 
 	Uint32 m_seed;
 	Random m_rand;
+	Uint64 m_paramsHash;
 
 	double m_sealevel; // 0 - no water, 1 - 100% coverage
 	double m_icyness; // 0 - 1 (0% to 100% cover)
@@ -125,6 +135,7 @@ class TerrainHeightFractal : virtual public Terrain {
 public:
 	TerrainHeightFractal() = delete;
 	virtual double GetHeight(const vector3d &p) const;
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const;
 	virtual const char *GetHeightFractalName() const;
 
 protected:
@@ -138,6 +149,7 @@ class TerrainColorFractal : virtual public Terrain {
 public:
 	TerrainColorFractal() = delete;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const;
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
 	virtual const char *GetColorFractalName() const;
 
 protected:
@@ -146,6 +158,22 @@ protected:
 private:
 };
 
+// The default batched implementations call the concrete fractal directly rather than
+// through the vtable. Fractals may specialise these to use the batched noise functions.
+template <typename HeightFractal>
+void TerrainHeightFractal<HeightFractal>::GetHeights(const vector3d *p, double *heights, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		heights[i] = TerrainHeightFractal::GetHeight(p[i]);
+}
+
+template <typename ColorFractal>
+void TerrainColorFractal<ColorFractal>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		colors[i] = TerrainColorFractal::GetColor(p[i], heights[i], norms[i]);
+}
+
 template <typename HeightFractal, typename ColorFractal>
 class TerrainGenerator : public TerrainHeightFractal<HeightFractal>, public TerrainColorFractal<ColorFractal> {
 public:
@@ -222,6 +250,11 @@ only terrain to use the much neglected impact crater function
 class TerrainHeightWaterSolidCanyons;
 class TerrainHeightWaterSolid;
 
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid>::GetHeights(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid3>::GetHeights(const vector3d *p, double *heights, size_t count) const;
+
 class TerrainColorAsteroid;
 class TerrainColorBandedRock;
 class TerrainColorBlack;
@@ -29,3 +29,18 @@ double TerrainHeightFractal<TerrainHeightAsteroid>::GetHeight(const vector3d &p)
 
 	return (n > 0.0 ? m_maxHeight * n : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid>::GetHeights(const vector3d *p, double *heights, size_t count) const
+{
+	double detail[NOISE_BATCH];
+	for (size_t base = 0; base < count; base += NOISE_BATCH) {
+		const size_t num = std::min(count - base, NOISE_BATCH);
+		octavenoise(GetFracDef(0), 0.4, p + base, heights + base, num);
+		dunes_octavenoise(GetFracDef(1), 0.5, p + base, detail, num);
+		for (size_t i = 0; i < num; i++) {
+			const double n = heights[base + i] * detail[i];
+			heights[base + i] = (n > 0.0 ? m_maxHeight * n : 0.0);
+		}
+	}
+}
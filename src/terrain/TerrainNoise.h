@@ -96,6 +96,80 @@ namespace TerrainNoise {
 		return 1.0 - fabs(n);
 	}
 
+	// Batched versions of the fracdef octave functions, evaluating count points at once
+	// through the SoA noise kernel. Results match the single point versions exactly.
+	static constexpr size_t NOISE_BATCH = 64;
+
+	// n[i] = sum over octaves of amplitude * shape(noise(frequency * p[i]))
+	template <typename Shape>
+	inline void octave_sum(const fracdef_t &def, const int octaves, const double persistence, const vector3d *p, double *n, const size_t count, Shape shape)
+	{
+		double x[NOISE_BATCH], y[NOISE_BATCH], z[NOISE_BATCH], r[NOISE_BATCH];
+		for (size_t base = 0; base < count; base += NOISE_BATCH) {
+			const size_t num = std::min(count - base, NOISE_BATCH);
+			double *nb = n + base;
+			std::fill(nb, nb + num, 0.0);
+			double amplitude = persistence;
+			double frequency = def.frequency;
+			for (int i = 0; i < octaves; i++) {
+				for (size_t k = 0; k < num; k++) {
+					x[k] = p[base + k].x * frequency;
+					y[k] = p[base + k].y * frequency;
+					z[k] = p[base + k].z * frequency;
+				}
+				noise(x, y, z, r, num);
+				for (size_t k = 0; k < num; k++)
+					nb[k] += amplitude * shape(r[k]);
+				amplitude *= persistence;
+				frequency *= def.lacunarity;
+			}
+		}
+	}
+
+	inline void octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, p, out, count, [](double v) { return v; });
+		for (size_t k = 0; k < count; k++)
+			out[k] = (out[k] + 1.0) * 0.5;
+	}
+
+	inline void river_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, p, out, count, [](double v) { return fabs(v); });
+		for (size_t k = 0; k < count; k++)
+			out[k] = fabs(out[k]);
+	}
+
+	inline void ridged_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, p, out, count, [](double v) { return v; });
+		for (size_t k = 0; k < count; k++) {
+			const double n = 1.0 - fabs(out[k]);
+			out[k] = n * n;
+		}
+	}
+
+	inline void billow_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, p, out, count, [](double v) { return v; });
+		for (size_t k = 0; k < count; k++)
+			out[k] = (2.0 * fabs(out[k]) - 1.0) + 1.0;
+	}
+
+	inline void voronoiscam_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, p, out, count, [](double v) { return v; });
+		for (size_t k = 0; k < count; k++)
+			out[k] = sqrt(10.0 * fabs(out[k]));
+	}
+
+	inline void dunes_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def, 3, persistence, p, out, count, [](double v) { return v; });
+		for (size_t k = 0; k < count; k++)
+			out[k] = 1.0 - fabs(out[k]);
+	}
+
 	// XXX merge these with their fracdef versions
 	inline double octavenoise(int octaves, const double persistence, const double lacunarity, const vector3d &p)
 	{
@@ -0,0 +1,154 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "collider/DynamicAabbTree.h"
+#include "doctest.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+
+// the tree never looks at the geoms, only their addresses
+static Geom *FakeGeom(uintptr_t n)
+{
+	return reinterpret_cast<Geom *>(0x10000 + n * 16);
+}
+
+// brute force reference, the same slab test as DynamicAabbTree::RayCast
+static bool RayHitsAabb(const Aabb &aabb, const vector3d &start, const vector3d &invDir, double maxDist)
+{
+	double
+		l1 = (aabb.min.x - start.x) * invDir.x,
+		l2 = (aabb.max.x - start.x) * invDir.x,
+		lmin = std::min(l1, l2),
+		lmax = std::max(l1, l2);
+
+	l1 = (aabb.min.y - start.y) * invDir.y;
+	l2 = (aabb.max.y - start.y) * invDir.y;
+	lmin = std::max(std::min(l1, l2), lmin);
+	lmax = std::min(std::max(l1, l2), lmax);
+
+	l1 = (aabb.min.z - start.z) * invDir.z;
+	l2 = (aabb.max.z - start.z) * invDir.z;
+	lmin = std::max(std::min(l1, l2), lmin);
+	lmax = std::min(std::max(l1, l2), lmax);
+
+	return (lmax >= 0.0) & (lmax >= lmin) & (lmin < maxDist);
+}
+
+TEST_CASE("DynamicAabbTree")
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> pos(-1000.0, 1000.0);
+	std::uniform_real_distribution<double> size(1.0, 50.0);
+	std::uniform_real_distribution<double> step(-30.0, 30.0);
+
+	auto randomAabb = [&](const vector3d &centre) {
+		const vector3d half(size(rng), size(rng), size(rng));
+		Aabb aabb;
+		aabb.min = centre - half;
+		aabb.max = centre + half;
+		return aabb;
+	};
+
+	DynamicAabbTree tree;
+	// proxy of each live geom
+	std::map<uintptr_t, int> live;
+	uintptr_t nextGeom = 0;
+
+	auto check = [&]() {
+		// balanced: a tree of n leaves kept within a level of balance is no taller than ~1.44 log2(n)
+		if (!live.empty())
+			CHECK(tree.GetHeight() <= int(std::ceil(1.45 * std::log2(double(live.size()) + 2.0))));
+
+		for (int q = 0; q < 50; q++) {
+			const Aabb box = randomAabb(vector3d(pos(rng), pos(rng), pos(rng)));
+			std::set<Geom *> expected, found;
+			for (const auto &entry : live)
+				if (tree.GetFatAabb(entry.second).Intersects(box))
+					expected.insert(FakeGeom(entry.first));
+			tree.Query(box, [&](Geom *g) { CHECK(found.insert(g).second); });
+			CHECK(found == expected);
+		}
+
+		for (int r = 0; r < 50; r++) {
+			const vector3d start(pos(rng), pos(rng), pos(rng));
+			vector3d dir = vector3d(pos(rng), pos(rng), pos(rng)).Normalized();
+			if (r % 10 == 0) dir.y = 0.0; // axis aligned components take the infinite inverse path
+			const vector3d invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+			const double maxDist = 1500.0;
+			std::set<Geom *> expected, found;
+			for (const auto &entry : live)
+				if (RayHitsAabb(tree.GetFatAabb(entry.second), start, invDir, maxDist))
+					expected.insert(FakeGeom(entry.first));
+			tree.RayCast(start, invDir, maxDist, [&](Geom *g) { CHECK(found.insert(g).second); });
+			CHECK(found == expected);
+		}
+	};
+
+	SUBCASE("insertion and removal")
+	{
+		for (int i = 0; i < 500; i++) {
+			const uintptr_t id = nextGeom++;
+			live[id] = tree.CreateProxy(randomAabb(vector3d(pos(rng), pos(rng), pos(rng))), FakeGeom(id));
+		}
+		check();
+
+		for (int round = 0; round < 20; round++) {
+			// remove about a third, then add as many back, reusing the freed nodes
+			for (auto it = live.begin(); it != live.end();) {
+				if (rng() % 3 == 0) {
+					tree.DestroyProxy(it->second);
+					it = live.erase(it);
+				} else {
+					++it;
+				}
+			}
+			while (live.size() < 500) {
+				const uintptr_t id = nextGeom++;
+				live[id] = tree.CreateProxy(randomAabb(vector3d(pos(rng), pos(rng), pos(rng))), FakeGeom(id));
+			}
+			for (const auto &entry : live)
+				CHECK(tree.GetGeom(entry.second) == FakeGeom(entry.first));
+			check();
+		}
+
+		for (const auto &entry : live)
+			tree.DestroyProxy(entry.second);
+		live.clear();
+		CHECK(tree.GetHeight() == 0);
+		check();
+	}
+
+	SUBCASE("moving")
+	{
+		std::map<uintptr_t, vector3d> centres;
+		for (int i = 0; i < 300; i++) {
+			const uintptr_t id = nextGeom++;
+			centres[id] = vector3d(pos(rng), pos(rng), pos(rng));
+			live[id] = tree.CreateProxy(randomAabb(centres[id]), FakeGeom(id));
+		}
+
+		for (int round = 0; round < 20; round++) {
+			for (auto &entry : centres) {
+				entry.second += vector3d(step(rng), step(rng), step(rng));
+				Aabb aabb;
+				aabb.min = entry.second - vector3d(5.0);
+				aabb.max = entry.second + vector3d(5.0);
+				Aabb fat = aabb;
+				fat.min -= vector3d(2.0);
+				fat.max += vector3d(2.0);
+				const int proxy = live[entry.first];
+				tree.MoveProxy(proxy, aabb, fat);
+				// whether it was reinserted or not, the proxy still covers where it is now
+				const Aabb &now = tree.GetFatAabb(proxy);
+				CHECK(now.min.x <= aabb.min.x);
+				CHECK(now.max.x >= aabb.max.x);
+				CHECK(now.min.z <= aabb.min.z);
+				CHECK(now.max.z >= aabb.max.z);
+			}
+			check();
+		}
+	}
+}
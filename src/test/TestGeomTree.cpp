@@ -0,0 +1,153 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "collider/GeomTree.h"
+#include "doctest.h"
+#include "scenegraph/Serializer.h"
+
+#include <random>
+
+// brute force reference, the same test as GeomTree applies at its leaves
+static isect_t TraceRayAllTris(const GeomTree &tree, const vector3f &origin, const vector3f &dir, float length)
+{
+	isect_t best = { -1, length };
+	const std::vector<vector3f> &verts = tree.GetVertices();
+	const Uint32 *indices = tree.GetIndices();
+	for (int t = 0; t < tree.GetNumTris(); t++) {
+		const vector3f &a = verts[indices[t * 3 + 0]];
+		const vector3f &b = verts[indices[t * 3 + 1]];
+		const vector3f &c = verts[indices[t * 3 + 2]];
+		const vector3f n = (c - a).Cross(b - a);
+		const float v0d = (c - origin).Cross(b - origin).Dot(dir);
+		const float v1d = (b - origin).Cross(a - origin).Dot(dir);
+		const float v2d = (a - origin).Cross(c - origin).Dot(dir);
+		if (((v0d > 0) && (v1d > 0) && (v2d > 0)) || ((v0d < 0) && (v1d < 0) && (v2d < 0))) {
+			const float dist = n.Dot(a - origin) / dir.Dot(n);
+			if ((dist > 0) && (dist < best.dist)) {
+				best.dist = dist;
+				best.triIdx = t;
+			}
+		}
+	}
+	return best;
+}
+
+TEST_CASE("GeomTree ray queries")
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-50.f, 50.f);
+	std::uniform_real_distribution<float> offset(-4.f, 4.f);
+
+	// a soup of small scattered triangles, some of them sharing a plane
+	static const int NUM_TRIS = 2000;
+	std::vector<vector3f> verts;
+	std::vector<Uint32> indices;
+	for (int t = 0; t < NUM_TRIS; t++) {
+		const vector3f centre(pos(rng), (t % 5 == 0) ? 0.f : pos(rng), pos(rng));
+		for (int v = 0; v < 3; v++) {
+			indices.push_back(verts.size());
+			verts.push_back(centre + vector3f(offset(rng), (t % 5 == 0) ? 0.f : offset(rng), offset(rng)));
+		}
+	}
+	const GeomTree tree(verts.size(), NUM_TRIS, verts, indices, std::vector<Uint32>(NUM_TRIS, 0));
+
+	static const int NUM_RAYS = 500;
+	const vector3f origin(3.f, 70.f, -20.f);
+	std::vector<vector3f> dirs;
+	for (int r = 0; r < NUM_RAYS; r++) {
+		vector3f target(pos(rng), pos(rng), pos(rng));
+		if (r % 10 == 0) target.x = origin.x; // axis aligned components take the zero inverse path
+		dirs.push_back((target - origin).Normalized());
+	}
+
+	int misses = 0;
+	std::vector<isect_t> packet(NUM_RAYS);
+	for (int r = 0; r < NUM_RAYS; r++) {
+		const isect_t expected = TraceRayAllTris(tree, origin, dirs[r], 200.f);
+
+		isect_t isect = { -1, 200.f };
+		tree.TraceRay(origin, dirs[r], &isect);
+		// triangles at exactly the same distance may be reported in either order
+		if ((isect.triIdx < 0) != (expected.triIdx < 0) || isect.dist != expected.dist)
+			misses++;
+
+		packet[r] = { -1, 200.f };
+	}
+	CHECK(misses == 0);
+
+	tree.TraceRays(NUM_RAYS, origin, dirs.data(), packet.data());
+	misses = 0;
+	for (int r = 0; r < NUM_RAYS; r++) {
+		isect_t isect = { -1, 200.f };
+		tree.TraceRay(origin, dirs[r], &isect);
+		if (isect.triIdx != packet[r].triIdx || isect.dist != packet[r].dist)
+			misses++;
+	}
+	CHECK(misses == 0);
+}
+
+TEST_CASE("GeomTree save and load")
+{
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> pos(-20.f, 20.f);
+
+	static const int NUM_TRIS = 300;
+	std::vector<vector3f> verts;
+	std::vector<Uint32> indices;
+	for (int t = 0; t < NUM_TRIS * 3; t++) {
+		indices.push_back(verts.size());
+		verts.push_back(vector3f(pos(rng), pos(rng), pos(rng)));
+	}
+	const GeomTree tree(verts.size(), NUM_TRIS, verts, indices, std::vector<Uint32>(NUM_TRIS, 7));
+
+	Serializer::Writer wr;
+	tree.Save(wr);
+	const std::string data = wr.GetData();
+	Serializer::Reader rd(ByteRange(data.data(), data.data() + data.size()));
+	const GeomTree loaded(rd);
+	CHECK(rd.Pos() == data.size());
+
+	CHECK(loaded.GetNumTris() == tree.GetNumTris());
+	CHECK(loaded.GetNumEdges() == tree.GetNumEdges());
+	CHECK(loaded.GetTriTree()->GetNumNodes() == tree.GetTriTree()->GetNumNodes());
+	CHECK(loaded.GetEdgeTree()->GetNumNodes() == tree.GetEdgeTree()->GetNumNodes());
+	CHECK(loaded.GetTriFlag(NUM_TRIS - 1) == 7);
+
+	int misses = 0;
+	const vector3f origin(0.f, 30.f, 0.f);
+	for (int r = 0; r < 200; r++) {
+		const vector3f dir = (vector3f(pos(rng), pos(rng), pos(rng)) - origin).Normalized();
+		isect_t a = { -1, 100.f }, b = { -1, 100.f };
+		tree.TraceRay(origin, dir, &a);
+		loaded.TraceRay(origin, dir, &b);
+		if (a.triIdx != b.triIdx || a.dist != b.dist)
+			misses++;
+	}
+	CHECK(misses == 0);
+}
+
+TEST_CASE("GeomTree rejects damaged data")
+{
+	std::vector<vector3f> verts = { vector3f(0.f, 0.f, 0.f), vector3f(1.f, 0.f, 0.f), vector3f(0.f, 1.f, 0.f) };
+	std::vector<Uint32> indices = { 0, 1, 2 };
+	const GeomTree tree(3, 1, verts, indices, std::vector<Uint32>(1, 0));
+
+	Serializer::Writer wr;
+	tree.Save(wr);
+	std::string data = wr.GetData();
+
+	SUBCASE("truncated")
+	{
+		data.resize(data.size() / 2);
+	}
+
+	SUBCASE("huge count")
+	{
+		// the vertex count comes first
+		const Uint32 huge = 0xffffffff;
+		memcpy(&data[0], &huge, sizeof(huge));
+	}
+
+	Serializer::Reader rd(ByteRange(data.data(), data.data() + data.size()));
+	CHECK_THROWS_AS(GeomTree loaded(rd), std::out_of_range);
+}
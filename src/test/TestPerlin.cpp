@@ -0,0 +1,30 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "perlin.h"
+
+#include <cstring>
+
+TEST_CASE("Batched noise")
+{
+	// odd count so the scalar tail is exercised too
+	static const size_t NUM_POINTS = 1023;
+	double x[NUM_POINTS], y[NUM_POINTS], z[NUM_POINTS], out[NUM_POINTS];
+	for (size_t i = 0; i < NUM_POINTS; i++) {
+		x[i] = double(i) * 0.731 - 300.0;
+		y[i] = double(i * 7 % 101) * -1.37;
+		// exact integers and equal coordinates hit the edge cases of the simplex ordering
+		z[i] = (i % 3 == 0) ? y[i] : double(i % 17) - 8.0;
+	}
+
+	noise(x, y, z, out, NUM_POINTS);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < NUM_POINTS; i++) {
+		const double expected = noise(vector3d(x[i], y[i], z[i]));
+		if (memcmp(&expected, &out[i], sizeof(double)) != 0)
+			mismatches++;
+	}
+	CHECK(mismatches == 0);
+}
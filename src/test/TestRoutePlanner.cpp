@@ -0,0 +1,68 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "galaxy/RoutePlanner.h"
+
+#include <random>
+
+// a corridor of random systems from the start at one end to the target at the other
+static RoutePlanner MakePlanner(unsigned seed, size_t numSystems, float maxRange)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> along(0.f, 100.f);
+	std::uniform_real_distribution<float> across(-10.f, 10.f);
+
+	std::vector<SystemPath> paths;
+	std::vector<vector3f> positions;
+	paths.push_back(SystemPath(0, 0, 0, 0));
+	positions.push_back(vector3f(0.f, 0.f, 0.f));
+	paths.push_back(SystemPath(0, 0, 0, 1));
+	positions.push_back(vector3f(100.f, 0.f, 0.f));
+	for (size_t i = 0; i < numSystems; i++) {
+		paths.push_back(SystemPath(0, 0, 0, i + 2));
+		positions.push_back(vector3f(along(rng), across(rng), across(rng)));
+	}
+	return RoutePlanner(paths, positions, maxRange);
+}
+
+TEST_CASE("RoutePlanner A* and Dijkstra agree")
+{
+	const float maxRange = 12.f;
+	// durations growing faster than the distance, as hyperdrives' do, and one
+	// with a fixed cost per jump as well
+	auto quadratic = [](float dist) { return dist * dist; };
+	auto withOverhead = [](float dist) { return 5.f + dist * dist; };
+
+	for (unsigned seed = 1; seed <= 20; seed++) {
+		CAPTURE(seed);
+		for (int overhead = 0; overhead < 2; overhead++) {
+			RoutePlanner astar = MakePlanner(seed, 300, maxRange);
+			RoutePlanner dijkstra = MakePlanner(seed, 300, maxRange);
+			if (overhead) {
+				astar.SetJumpDuration(withOverhead);
+				dijkstra.SetJumpDuration(withOverhead);
+			} else {
+				astar.SetJumpDuration(quadratic);
+				dijkstra.SetJumpDuration(quadratic);
+			}
+
+			const bool found = astar.Search(true);
+			REQUIRE(found == dijkstra.Search(false));
+			if (!found)
+				continue;
+			CHECK(astar.GetDuration() == doctest::Approx(dijkstra.GetDuration()));
+			CHECK(astar.GetRoute() == dijkstra.GetRoute());
+		}
+	}
+}
+
+TEST_CASE("RoutePlanner unreachable target")
+{
+	std::vector<SystemPath> paths = { SystemPath(0, 0, 0, 0), SystemPath(0, 0, 0, 1) };
+	std::vector<vector3f> positions = { vector3f(0.f, 0.f, 0.f), vector3f(50.f, 0.f, 0.f) };
+	RoutePlanner planner(paths, positions, 10.f);
+	planner.SetJumpDuration([](float dist) { return dist; });
+	CHECK(!planner.Search());
+	CHECK(planner.GetRoute().empty());
+}
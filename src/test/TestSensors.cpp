@@ -0,0 +1,151 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Sensors.h"
+#include "doctest.h"
+
+#include <random>
+#include <unordered_map>
+
+// the index never looks at the bodies, only their addresses
+static const Body *FakeBody(uintptr_t n)
+{
+	return reinterpret_cast<const Body *>(0x10000 + n * 16);
+}
+
+// the next body after *n that starts probing at slot
+static const Body *BodyInBucket(const Sensors::ContactIndex &index, size_t slot, uintptr_t &n)
+{
+	for (;; n++) {
+		const Body *b = FakeBody(n);
+		if (index.Bucket(b) == slot) {
+			n++;
+			return b;
+		}
+	}
+}
+
+TEST_CASE("Sensors::ContactIndex")
+{
+	Sensors::ContactIndex index;
+	CHECK(index.Find(FakeBody(0)) == -1);
+	index.Erase(FakeBody(0));
+
+	SUBCASE("insert, find and erase")
+	{
+		for (Uint32 i = 0; i < 100; i++)
+			index.Insert(FakeBody(i), i);
+		CHECK(index.GetSize() == 100);
+		for (Uint32 i = 0; i < 100; i++)
+			CHECK(index.Find(FakeBody(i)) == int(i));
+		CHECK(index.Find(FakeBody(100)) == -1);
+
+		// inserting again moves it
+		index.Insert(FakeBody(7), 1000);
+		CHECK(index.Find(FakeBody(7)) == 1000);
+		CHECK(index.GetSize() == 100);
+
+		for (Uint32 i = 0; i < 100; i += 2)
+			index.Erase(FakeBody(i));
+		CHECK(index.GetSize() == 50);
+		for (Uint32 i = 1; i < 100; i += 2)
+			CHECK(index.Find(FakeBody(i)) == (i == 7 ? 1000 : int(i)));
+		for (Uint32 i = 0; i < 100; i += 2)
+			CHECK(index.Find(FakeBody(i)) == -1);
+
+		// erasing something that isn't there changes nothing
+		index.Erase(FakeBody(0));
+		CHECK(index.GetSize() == 50);
+
+		index.Clear();
+		CHECK(index.GetSize() == 0);
+		CHECK(index.Find(FakeBody(1)) == -1);
+	}
+
+	SUBCASE("erase shifts back a cluster wrapping past the end")
+	{
+		// make the table, then lay out the slots by hand
+		index.Insert(FakeBody(0), 0);
+		index.Erase(FakeBody(0));
+		const size_t last = index.GetNumSlots() - 1;
+
+		uintptr_t n = 1;
+		// three starting at the last slot fill it and the first two, and one
+		// starting at the first slot is pushed along to the third
+		const Body *a = BodyInBucket(index, last, n);
+		const Body *b = BodyInBucket(index, last, n);
+		const Body *c = BodyInBucket(index, last, n);
+		const Body *d = BodyInBucket(index, 0, n);
+		index.Insert(a, 1);
+		index.Insert(b, 2);
+		index.Insert(c, 3);
+		index.Insert(d, 4);
+
+		// each of the others has to move back across the end of the table
+		index.Erase(a);
+		CHECK(index.Find(a) == -1);
+		CHECK(index.Find(b) == 2);
+		CHECK(index.Find(c) == 3);
+		CHECK(index.Find(d) == 4);
+
+		index.Erase(c);
+		CHECK(index.Find(b) == 2);
+		CHECK(index.Find(c) == -1);
+		CHECK(index.Find(d) == 4);
+		CHECK(index.GetSize() == 2);
+	}
+
+	SUBCASE("erase leaves slots already at their start")
+	{
+		index.Insert(FakeBody(0), 0);
+		index.Erase(FakeBody(0));
+		const size_t last = index.GetNumSlots() - 1;
+
+		uintptr_t n = 1;
+		// a in the second last slot, b in the last, and c, which also starts
+		// at the second last slot, wrapped round to the first
+		const Body *a = BodyInBucket(index, last - 1, n);
+		const Body *b = BodyInBucket(index, last, n);
+		const Body *c = BodyInBucket(index, last - 1, n);
+		index.Insert(a, 1);
+		index.Insert(b, 2);
+		index.Insert(c, 3);
+
+		// b mustn't move before its start, c has to come back across the end
+		index.Erase(a);
+		CHECK(index.Find(b) == 2);
+		CHECK(index.Find(c) == 3);
+
+		index.Erase(b);
+		CHECK(index.Find(c) == 3);
+		CHECK(index.GetSize() == 1);
+	}
+
+	SUBCASE("random inserts and erases")
+	{
+		// few enough bodies to collide a lot, against a reference map
+		std::mt19937 rng(99);
+		std::uniform_int_distribution<int> pick(0, 63);
+		std::unordered_map<const Body *, Uint32> reference;
+		int mismatches = 0;
+		for (Uint32 step = 0; step < 5000; step++) {
+			const Body *body = FakeBody(pick(rng));
+			if (rng() % 3 == 0) {
+				index.Erase(body);
+				reference.erase(body);
+			} else {
+				index.Insert(body, step);
+				reference[body] = step;
+			}
+
+			if (index.GetSize() != reference.size())
+				mismatches++;
+			for (int i = 0; i < 64; i++) {
+				auto it = reference.find(FakeBody(i));
+				if (index.Find(FakeBody(i)) != (it == reference.end() ? -1 : int(it->second)))
+					mismatches++;
+			}
+		}
+		CHECK(mismatches == 0);
+	}
+}
@@ -0,0 +1,58 @@
+// Copyright © 2008-2023 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "galaxy/Sector.h"
+#include "galaxy/SystemIndex.h"
+
+// Without a galaxy every sector the search reaches has to be added up front,
+// or the index would try to generate it.
+static void AddEmptySectors(SystemIndex &index, Sint32 radius)
+{
+	for (Sint32 x = -radius; x <= radius; x++)
+		for (Sint32 y = -radius; y <= radius; y++)
+			for (Sint32 z = -radius; z <= radius; z++)
+				index.AddSector(SystemPath(x, y, z), {});
+}
+
+TEST_CASE("SystemIndex FindNearest")
+{
+	SystemIndex index(nullptr);
+	const SystemPath origin(0, 0, 0);
+	const vector3f centre(0.5f * Sector::SIZE);
+	// further than any search here reaches
+	const Sint32 extent = 3;
+
+	SUBCASE("nothing in range")
+	{
+		AddEmptySectors(index, extent);
+
+		std::vector<SystemIndex::Result> nearest;
+		index.FindNearest(origin, centre, 5, Sector::SIZE, nearest);
+		CHECK(nearest.empty());
+	}
+
+	SUBCASE("fewer systems in range than asked for")
+	{
+		// one in the same sector, one in the next, one just out of range
+		index.AddSector(origin, { centre + vector3f(1.0f, 0.0f, 0.0f) });
+		index.AddSector(SystemPath(1, 0, 0), { centre + vector3f(6.0f - Sector::SIZE, 0.0f, 0.0f) });
+		index.AddSector(SystemPath(0, 1, 0), { centre + vector3f(0.0f, 8.0f - Sector::SIZE, 0.0f) });
+		AddEmptySectors(index, extent);
+
+		std::vector<SystemIndex::Result> nearest;
+		index.FindNearest(origin, centre, 5, 7.0f, nearest);
+		REQUIRE(nearest.size() == 2);
+		CHECK(nearest[0].path == SystemPath(0, 0, 0, 0));
+		CHECK(nearest[0].distance == doctest::Approx(1.0f));
+		CHECK(nearest[1].path == SystemPath(1, 0, 0, 0));
+		CHECK(nearest[1].distance == doctest::Approx(6.0f));
+	}
+
+	SUBCASE("count of zero")
+	{
+		std::vector<SystemIndex::Result> nearest;
+		index.FindNearest(origin, centre, 0, Sector::SIZE, nearest);
+		CHECK(nearest.empty());
+	}
+}
@@ -88,8 +88,9 @@ namespace FileSystem {
 		return data_path;
 	}
 
-	FileSourceFS::FileSourceFS(const std::string &root, bool trusted) :
-		FileSource((root == "/") ? "" : absolute_path(root), trusted) {}
+	FileSourceFS::FileSourceFS(const std::string &root, bool trusted, bool mapFiles) :
+		FileSource((root == "/") ? "" : absolute_path(root), trusted),
+		m_mapFiles(mapFiles) {}
 
 	FileSourceFS::~FileSourceFS() {}
 
@@ -154,7 +155,48 @@ namespace FileSystem {
 		return MakeFileInfo(path, ty, modtime);
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data) :
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { UnmapViewOfFile(m_data); }
+	};
+
 	RefCountedPtr<FileData> FileSourceFS::ReadFile(const std::string &path)
+	{
+		return m_mapFiles ? MapFile(path) : ReadFileCopy(path);
+	}
+
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);
+		// the sequential scan hint gets the cache manager reading ahead
+		HANDLE filehandle = CreateFileW(wfullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+		if (filehandle == INVALID_HANDLE_VALUE)
+			return RefCountedPtr<FileData>(0);
+
+		const Time::DateTime modtime = file_modtime_for_handle(filehandle);
+		LARGE_INTEGER large_size;
+		if (!GetFileSizeEx(filehandle, &large_size) || size_t(large_size.QuadPart) < MAP_MIN_SIZE) {
+			CloseHandle(filehandle);
+			return ReadFileCopy(path);
+		}
+
+		// the view keeps the mapping (and the file) open until it's unmapped
+		HANDLE mapping = CreateFileMappingW(filehandle, 0, PAGE_READONLY, 0, 0, 0);
+		CloseHandle(filehandle);
+		if (!mapping)
+			return ReadFileCopy(path);
+		void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!data)
+			return ReadFileCopy(path);
+
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, modtime), size_t(large_size.QuadPart), static_cast<char *>(data)));
+	}
+
+	RefCountedPtr<FileData> FileSourceFS::ReadFileCopy(const std::string &path)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
 		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);
@@ -273,6 +315,21 @@ namespace FileSystem {
 		return make_directory_raw(wfullpath);
 	}
 
+	bool FileSourceFS::RemoveFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);
+		return (_wremove(wfullpath.c_str()) == 0);
+	}
+
+	bool FileSourceFS::RenameFile(const std::string &oldPath, const std::string &newPath)
+	{
+		const std::wstring wfullOldPath = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), oldPath));
+		const std::wstring wfullNewPath = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), newPath));
+		// _wrename won't replace an existing file
+		return MoveFileExW(wfullOldPath.c_str(), wfullNewPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+
 	static FILE *open_file_raw(const std::string &fullpath, const wchar_t *mode)
 	{
 		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);